@@ -33,6 +33,7 @@
 #include <chrono>
 #include <optional>
 #include <string_view>
+#include <charconv>
 #include <string.h>
 #include <stdexcept>
 #include <vector>
@@ -208,22 +209,63 @@ namespace pipedal
     {
     };
 
+    // Perfect hash of json member names: maps each name to a slot in a small table, with no collisions between members.
+    class json_member_hash
+    {
+    public:
+        void build(const std::vector<const char *> &names);
+        // false if no perfect hash could be found, in which case callers should fall back to a linear search.
+        bool valid() const { return !slots_.empty(); }
+        // The index of the only member that can have this name, or -1. Callers must still compare names.
+        int find(std::string_view name) const
+        {
+            return slots_[hash(name.data(), name.length(), seed_) & mask_];
+        }
+
+    private:
+        static uint32_t hash(const char *name, size_t length, uint32_t seed)
+        {
+            uint32_t h = 2166136261U ^ seed;
+            for (size_t i = 0; i < length; ++i)
+            {
+                h = (h ^ (uint8_t)name[i]) * 16777619U;
+            }
+            return h ^ (h >> 15);
+        }
+        std::vector<int16_t> slots_; // empty if no perfect hash was found; use linear search.
+        uint32_t seed_ = 0;
+        uint32_t mask_ = 0;
+    };
+
     template <typename CLASS>
     class json_map_impl : public json_map_base
     {
     private:
         std::vector<json_member_reference_base<CLASS> *> members_;
+        json_member_hash hash_;
         json_map_impl(const json_map_impl &) {} // disable copy constructor.
+
+        void build_hash()
+        {
+            std::vector<const char *> names;
+            for (auto member : members_)
+            {
+                names.push_back(member->name());
+            }
+            hash_.build(names);
+        }
     public:
         using members_t = std::vector<json_member_reference_base<CLASS> *>;
 
         json_map_impl(const members_t &members)
             : members_(members)
         {
+            build_hash();
         }
         json_map_impl(members_t &&members)
             : members_(std::forward<members_t>(members))
         {
+            build_hash();
         }
         virtual ~json_map_impl()
         {
@@ -233,7 +275,11 @@ namespace pipedal
             }
             members_.resize(0);
         }
-        void read_property(json_reader *reader, const char *memberName, CLASS *pObject);
+        void read_property(json_reader *reader, const char *memberName, CLASS *pObject)
+        {
+            read_property(reader, std::string_view(memberName), pObject);
+        }
+        void read_property(json_reader *reader, std::string_view memberName, CLASS *pObject);
         void write_members(json_writer *writer, const CLASS *pObject);
     };
 
@@ -317,6 +363,54 @@ namespace pipedal
 
     //----------------------------------------------------------------------------------
 
+    // An output stream that writes to a growable buffer. Unlike std::stringstream, the result can be read without
+    // a copy, and clear() keeps the storage, so one buffer can be reused for any number of documents.
+    class json_output_buffer : public std::ostream
+    {
+    public:
+        json_output_buffer();
+        json_output_buffer(const json_output_buffer &) = delete;
+        json_output_buffer &operator=(const json_output_buffer &) = delete;
+
+        std::string_view view() const { return buffer_.view(); }
+        size_t size() const { return buffer_.view().size(); }
+        void clear();
+
+    private:
+        class buffer_t : public std::streambuf
+        {
+        public:
+            std::string_view view() const { return std::string_view(pbase(), (size_t)(pptr() - pbase())); }
+            void clear(bool releaseStorage);
+
+        protected:
+            int_type overflow(int_type c) override;
+            std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+        private:
+            void grow(size_t minimumSize);
+            std::string data_;
+        };
+        buffer_t buffer_;
+    };
+
+    // Borrows this thread's json_output_buffer for the lifetime of the lease, so that messages formatted on
+    // the same thread share one allocation. Nested leases get a private buffer.
+    class json_buffer_lease
+    {
+    public:
+        json_buffer_lease();
+        ~json_buffer_lease();
+        json_buffer_lease(const json_buffer_lease &) = delete;
+        json_buffer_lease &operator=(const json_buffer_lease &) = delete;
+
+        json_output_buffer &buffer() { return *buffer_; }
+
+    private:
+        json_output_buffer *buffer_;
+        std::unique_ptr<json_output_buffer> privateBuffer_;
+    };
+
     class json_writer;
 
     class json_writer
@@ -369,47 +463,54 @@ namespace pipedal
 
         void write(uint8_t value)
         {
-            os << value;
+            write_number(value);
         }
         void write(int8_t value)
         {
-            os << value;
+            write_number(value);
         }
         void write(short value)
         {
-            os << value;
+            write_number(value);
         }
         void write(unsigned short value)
         {
-            os << value;
+            write_number(value);
         }
         void write(long long value)
         {
-            os << value;
+            write_number(value);
         }
         void write(unsigned long long value)
         {
-            os << value;
+            write_number(value);
         }
         void write(long value)
         {
-            os << value;
+            write_number(value);
         }
         void write(unsigned long value)
         {
-            os << value;
+            write_number(value);
         }
         void write(int value)
         {
-            os << value;
+            write_number(value);
         }
         void write(unsigned int value)
         {
-            os << value;
+            write_number(value);
         }
         void write (const std::chrono::system_clock::time_point &time);
 
     private:
+        template <typename T>
+        void write_number(T value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            os.write(buffer, result.ptr - buffer);
+        }
         static void throw_encoding_error();
 
         static uint32_t continuation_byte(std::string_view::iterator &p, std::string_view::const_iterator end);
@@ -448,12 +549,12 @@ namespace pipedal
                 {
                     os << "NaN";
                 } else {
-                    os << std::numeric_limits<float>::max();
+                    write_number(std::numeric_limits<float>::max());
                 }
             }
             else
             {
-                os << std::setprecision(std::numeric_limits<float>::max_digits10) << f; // round-trip format
+                write_number(f); // shortest round-trip format
             }
         }
         void write(float f) {
@@ -468,12 +569,12 @@ namespace pipedal
                 {
                     os << "NaN";
                 } else {
-                    os << std::numeric_limits<float>::max();
+                    write_number(std::numeric_limits<float>::max());
                 }
             }
             else
             {
-                os << std::setprecision(std::numeric_limits<double>::max_digits10) << f; // round-trip format
+                write_number(f); // shortest round-trip format
             }
         }
         void write(double d)
@@ -747,7 +848,10 @@ namespace pipedal
     class json_reader
     {
     private:
-        std::istream &is_;
+        // Either a stream, or (if is_ is null) the unread part of a contiguous buffer.
+        std::istream *is_ = nullptr;
+        const char *p_ = nullptr;
+        const char *end_ = nullptr;
 
         const uint16_t UTF16_SURROGATE_1_BASE = 0xD800U;
         const uint16_t UTF16_SURROGATE_2_BASE = 0xDC00U;
@@ -756,7 +860,13 @@ namespace pipedal
 
     public:
         json_reader(std::istream &input, bool allowNaN = true)
-            : is_(input)
+            : is_(&input)
+        {
+            this->allowNaN_ = allowNaN;
+        }
+        // Parse directly from a buffer, which must outlive the reader. Much faster than parsing from a stream.
+        json_reader(std::string_view text, bool allowNaN = true)
+            : p_(text.data()), end_(text.data() + text.size())
         {
             this->allowNaN_ = allowNaN;
         }
@@ -785,13 +895,92 @@ namespace pipedal
                 return false;
             }
         }
+        int peek_char()
+        {
+            if (is_)
+                return is_->peek();
+            return p_ != end_ ? (unsigned char)*p_ : -1;
+        }
+        int get_char()
+        {
+            if (is_)
+                return is_->get();
+            return p_ != end_ ? (unsigned char)*p_++ : -1;
+        }
         char get()
         {
-            int ic = is_.get();
+            int ic = get_char();
             if (ic == -1)
                 throw_format_error("Unexpected end of file");
             return (char)ic;
         }
+        void read_escape(std::string &s);
+        std::string read_buffered_string(char startingCharacter);
+
+        // Integers are read the same way from streams and buffers: an optional sign followed by decimal digits.
+        // As with istream extraction, a negative value wraps for unsigned types.
+        template <std::integral T>
+        void read_number(T *value)
+        {
+            using unsigned_t = std::make_unsigned_t<T>;
+            skip_whitespace();
+            bool negative = false;
+            int c = peek_char();
+            if (c == '-' || c == '+')
+            {
+                negative = c == '-';
+                get_char();
+            }
+            char digits[std::numeric_limits<unsigned_t>::digits10 + 2];
+            size_t length = 0;
+            while (true)
+            {
+                c = peek_char();
+                if (c < '0' || c > '9')
+                    break;
+                if (length == sizeof(digits))
+                    throw JsonException("Invalid format.");
+                digits[length++] = (char)get_char();
+            }
+            unsigned_t magnitude = 0;
+            auto result = std::from_chars(digits, digits + length, magnitude);
+            if (length == 0 || result.ec != std::errc())
+                throw JsonException("Invalid format.");
+            if constexpr (std::is_signed_v<T>)
+            {
+                unsigned_t limit = (unsigned_t)std::numeric_limits<T>::max() + (negative ? 1 : 0);
+                if (magnitude > limit)
+                    throw JsonException("Invalid format.");
+            }
+            *value = (T)(negative ? (unsigned_t)(unsigned_t(0) - magnitude) : magnitude);
+        }
+        template <std::floating_point T>
+        void read_number(T *value)
+        {
+            skip_whitespace();
+            if (is_)
+            {
+                *is_ >> *value;
+                if (is_->fail())
+                    throw JsonException("Invalid format.");
+            }
+            else
+            {
+                // from_chars doesn't take a leading '+', but does take "inf" and "nan", which istream does not.
+                const char *p = p_;
+                if (p != end_ && *p == '+')
+                {
+                    ++p;
+                }
+                const char *start = (p != end_ && *p == '-') ? p + 1 : p;
+                if (start == end_ || !((*start >= '0' && *start <= '9') || *start == '.') || (p != p_ && p != start))
+                    throw JsonException("Invalid format.");
+                auto result = std::from_chars(p, end_, *value);
+                if (result.ec != std::errc())
+                    throw JsonException("Invalid format.");
+                p_ = result.ptr;
+            }
+        }
 
         void skip_whitespace();
 
@@ -814,7 +1003,7 @@ namespace pipedal
         int peek()
         {
             skip_whitespace();
-            return is_.peek();
+            return peek_char();
         }
         template<typename U>
         void read_member(const std::string&name,U *value)
@@ -858,10 +1047,10 @@ namespace pipedal
                 consume(':');
                 skip_whitespace();
 
-                map.read_property(this, memberName.c_str(), pObject);
+                map.read_property(this, memberName, pObject);
 
                 skip_whitespace();
-                if (is_.peek() == ',')
+                if (peek_char() == ',')
                 {
                     c = get();
                 }
@@ -985,65 +1174,45 @@ namespace pipedal
         }
         void read(uint8_t*value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
+        }
+        void read(int8_t *value)
+        {
+            read_number(value);
         }
         void read(short * value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
 
         void read(unsigned short * value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
 
         void read(int *value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(long *value)
         {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(long long *value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(unsigned int *value)
         {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(unsigned long *value)
         {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(unsigned long long *value)
         {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
 
         void read(float *value)
@@ -1058,9 +1227,7 @@ namespace pipedal
                     return;
                 }
             }
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(double *value)
         {
@@ -1076,9 +1243,7 @@ namespace pipedal
                 }
             }
 
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(std::chrono::system_clock::time_point *value);
 
@@ -1155,13 +1320,25 @@ namespace pipedal
     }
 
     template <typename CLASS>
-    void json_map_impl<CLASS>::read_property(json_reader *reader, const char *memberName, CLASS *pObject)
+    void json_map_impl<CLASS>::read_property(json_reader *reader, std::string_view memberName, CLASS *pObject)
     {
-        for (json_member_reference_base<CLASS> *member : members_)
+        if (!hash_.valid())
+        {
+            for (json_member_reference_base<CLASS> *member : members_)
+            {
+                if (memberName == member->name())
+                {
+                    member->read_value(*reader, pObject);
+                    return;
+                }
+            }
+        }
+        else
         {
-            if (strcmp(member->name(), memberName) == 0)
+            int index = hash_.find(memberName);
+            if (index != -1 && memberName == members_[index]->name())
             {
-                member->read_value(*reader, pObject);
+                members_[index]->read_value(*reader, pObject);
                 return;
             }
         }
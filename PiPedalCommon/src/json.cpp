@@ -20,14 +20,202 @@
 #include "json.hpp"
 #include <string_view>
 #include <cctype>
+#include <cstring>
 #include "json_variant.hpp"
 #include "util.hpp"
 #include <string_view>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 using namespace pipedal;
 
+// Scan helpers for buffer-backed readers. Pretty-printed files are mostly indentation, and strings are mostly
+// plain text, so both get scanned 16 bytes at a time where the CPU allows it.
+
+static inline bool is_json_whitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static const char *skip_json_whitespace(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(ws) & 0xFFFFu;
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#elif defined(__aarch64__)
+    while (end - p >= 16)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p);
+        uint8x16_t ws = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\n'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')), vceqq_u8(v, vdupq_n_u8('\t'))));
+        if (vminvq_u8(ws) == 0)
+        {
+            break; // finish with the scalar loop.
+        }
+        p += 16;
+    }
+#endif
+    while (p != end && is_json_whitespace(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+// The first quote or backslash at or after p, or end.
+static const char *find_string_special(const char *p, const char *end, char quote)
+{
+#if defined(__SSE2__)
+    __m128i q = _mm_set1_epi8(quote);
+    __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, backslash)));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#elif defined(__aarch64__)
+    uint8x16_t q = vdupq_n_u8((uint8_t)quote);
+    uint8x16_t backslash = vdupq_n_u8('\\');
+    while (end - p >= 16)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p);
+        if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, q), vceqq_u8(v, backslash))) != 0)
+        {
+            break; // finish with the scalar loop.
+        }
+        p += 16;
+    }
+#endif
+    while (p != end && *p != quote && *p != '\\')
+    {
+        ++p;
+    }
+    return p;
+}
+
+
+
+
+// Buffers bigger than this (e.g. after sending a large preset) are released instead of being kept for reuse.
+static constexpr size_t MAX_RETAINED_BUFFER_SIZE = 256 * 1024;
+
+json_output_buffer::json_output_buffer()
+    : std::ostream(nullptr)
+{
+    rdbuf(&buffer_);
+}
+
+void json_output_buffer::clear()
+{
+    buffer_.clear(buffer_.view().size() > MAX_RETAINED_BUFFER_SIZE);
+    std::ostream::clear();
+}
+
+void json_output_buffer::buffer_t::clear(bool releaseStorage)
+{
+    if (releaseStorage)
+    {
+        data_ = std::string();
+    }
+    setp(data_.data(), data_.data() + data_.size());
+}
 
+void json_output_buffer::buffer_t::grow(size_t minimumSize)
+{
+    size_t used = (size_t)(pptr() - pbase());
+    size_t newSize = std::max(data_.size() * 2, (size_t)1024);
+    while (newSize < minimumSize)
+    {
+        newSize *= 2;
+    }
+    data_.resize(newSize);
+    setp(data_.data(), data_.data() + data_.size());
+    // pbump takes an int.
+    while (used > (size_t)std::numeric_limits<int>::max())
+    {
+        pbump(std::numeric_limits<int>::max());
+        used -= (size_t)std::numeric_limits<int>::max();
+    }
+    pbump((int)used);
+}
 
+json_output_buffer::buffer_t::int_type json_output_buffer::buffer_t::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        return traits_type::not_eof(c);
+    }
+    grow((size_t)(pptr() - pbase()) + 1);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+std::streamsize json_output_buffer::buffer_t::xsputn(const char *s, std::streamsize n)
+{
+    if (epptr() - pptr() < n)
+    {
+        grow((size_t)(pptr() - pbase()) + (size_t)n);
+    }
+    std::memcpy(pptr(), s, (size_t)n);
+    pbump((int)n);
+    return n;
+}
+
+namespace
+{
+    struct ThreadJsonBuffer
+    {
+        json_output_buffer buffer;
+        bool inUse = false;
+    };
+    thread_local ThreadJsonBuffer threadJsonBuffer;
+}
+
+json_buffer_lease::json_buffer_lease()
+{
+    if (!threadJsonBuffer.inUse)
+    {
+        threadJsonBuffer.inUse = true;
+        buffer_ = &threadJsonBuffer.buffer;
+    }
+    else
+    {
+        privateBuffer_ = std::make_unique<json_output_buffer>();
+        buffer_ = privateBuffer_.get();
+    }
+    buffer_->clear();
+}
+
+json_buffer_lease::~json_buffer_lease()
+{
+    if (!privateBuffer_)
+    {
+        threadJsonBuffer.buffer.clear();
+        threadJsonBuffer.inUse = false;
+    }
+}
 
 uint32_t json_writer::continuation_byte(std::string_view::iterator &p, std::string_view::const_iterator end)
 {
@@ -212,12 +400,63 @@ void json_writer::end_array()
 }
 
 
+void json_member_hash::build(const std::vector<const char *> &names)
+{
+    slots_.clear();
+    if (names.empty() || names.size() > 0x7FFF)
+    {
+        return;
+    }
+    size_t size = 4;
+    while (size < names.size() * 2)
+    {
+        size *= 2;
+    }
+    // Only done once per class, so a brute-force search for a collision-free seed is affordable. Tables stay
+    // small for typical member counts (a few dozen at most); very large maps fall back to linear search.
+    for (; size <= names.size() * 32; size *= 2)
+    {
+        std::vector<int16_t> slots(size, -1);
+        for (uint32_t seed = 0; seed < 1024; ++seed)
+        {
+            std::fill(slots.begin(), slots.end(), -1);
+            bool collision = false;
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                size_t slot = hash(names[i], strlen(names[i]), seed) & (size - 1);
+                if (slots[slot] != -1)
+                {
+                    collision = true;
+                    break;
+                }
+                slots[slot] = (int16_t)i;
+            }
+            if (!collision)
+            {
+                slots_ = std::move(slots);
+                seed_ = seed;
+                mask_ = (uint32_t)(size - 1);
+                return;
+            }
+        }
+    }
+}
+
 void json_reader::skip_whitespace()
 {
     char c;
+    if (!is_)
+    {
+        p_ = skip_json_whitespace(p_, end_);
+        if (p_ == end_ || *p_ != '/')
+        {
+            return;
+        }
+        // comments take the slow path.
+    }
     while (true)
     {
-        int ic = is_.peek();
+        int ic = peek_char();
         if (ic == -1)
             break;
         if (is_whitespace((char)ic))
@@ -227,12 +466,12 @@ void json_reader::skip_whitespace()
         else if (ic == '/')
         {
             get();
-            int c2 = is_.peek();
+            int c2 = peek_char();
             if (c2 == '/') {
                 // skip to end of line.
                 get();
                 while (true) {
-                    c2 = is_.peek();
+                    c2 = peek_char();
                     if (c2 == '\r' || c2 == '\n')
                     {
                         get(); // and continue.
@@ -250,7 +489,7 @@ void json_reader::skip_whitespace()
                 while (true)
                 {
                     c = get();
-                    if (c == '*' && is_.peek() == '/')
+                    if (c == '*' && peek_char() == '/')
                     {
                         get();
                         if (--level == 0)
@@ -258,7 +497,7 @@ void json_reader::skip_whitespace()
                             break;
                         }
                     }
-                    if (c == '/' && is_.peek() == '*')
+                    if (c == '/' && peek_char() == '*')
                     {
                         get();
                         ++level;
@@ -276,34 +515,112 @@ void json_reader::skip_whitespace()
     }
 }
 
-static void utf32_to_utf8_stream(std::ostream &s, uint32_t uc)
+static void utf32_to_utf8(std::string &s, uint32_t uc)
 {
     if (uc < 0x80u)
     {
-        s << (char)uc;
+        s += (char)uc;
     } else if (uc < 0x800u) {
-        s << (char)(0xC0 + (uc >> 6));
-        s << (char)(0x80 + (uc & 0x3F));
+        s += (char)(0xC0 + (uc >> 6));
+        s += (char)(0x80 + (uc & 0x3F));
 
     } else if (uc < 0x10000u) {
-        s << (char)(0xE0 + (uc >> 12));
-        s << (char)(0x80 + ((uc >> 6) & 0x3F));
-        s << (char)(0x80 + (uc & 0x3F));
+        s += (char)(0xE0 + (uc >> 12));
+        s += (char)(0x80 + ((uc >> 6) & 0x3F));
+        s += (char)(0x80 + (uc & 0x3F));
     } else if (uc < 0x0110000) {
-        s << (char)(0xF0 + (uc >> 18));
-        s << (char)(0x80 + ((uc >> 12) & 0x3F));
-        s << (char)(0x80 + ((uc >> 6) & 0x3F));
-        s << (char)(0x80 + (uc & 0x3F));
+        s += (char)(0xF0 + (uc >> 18));
+        s += (char)(0x80 + ((uc >> 12) & 0x3F));
+        s += (char)(0x80 + ((uc >> 6) & 0x3F));
+        s += (char)(0x80 + (uc & 0x3F));
     } else {
         throw std::range_error("Illegal UTF-32 character.");
     }
 }
 
-std::string json_reader::read_string()
+void json_reader::read_escape(std::string &s)
 {
     // To completely normalize UTF-32 values we must covert to UTF-16, resolve surrogate pairs, and then convert UTF-32 to UTF-8.
+    char c = get();
+    switch (c)
+    {
+    case '"':
+    case '\\':
+    default:
+        s += c;
+        break;
+    case 'r':
+        s += '\r';
+        break;
+    case 'b':
+        s += '\b';
+        break;
+    case 'f':
+        s += '\f';
+        break;
+    case 'n':
+        s += '\n';
+        break;
+    case 't':
+        s += '\t';
+        break;
+    case 'u':
+    {
+        uint32_t uc = read_u_escape();
+        if (uc >= UTF16_SURROGATE_1_BASE && uc <= UTF16_SURROGATE_1_BASE + UTF16_SURROGATE_MASK)
+        {
+            // MUST be a UTF16_SURROGATE 2 to be legal.
+            c = get();
+            if (c != '\\')
+                throw_format_error("Invalid UTF16 surrogate pair");
+            c = get();
+            if (c != 'u')
+                throw_format_error("Invalid UTF16 surrogate pair");
+            uint16_t uc2 = read_u_escape();
+            if (uc2 < UTF16_SURROGATE_2_BASE || uc2 > UTF16_SURROGATE_2_BASE + UTF16_SURROGATE_MASK)
+            {
+                throw_format_error("Invalid UTF16 surrogate pair");
+            }
+            uc = ((uc & UTF16_SURROGATE_MASK) << 10) + (uc2 & UTF16_SURROGATE_MASK) + 0x10000U;
+        }
+        utf32_to_utf8(s, uc);
+    }
+    break;
+    }
+}
 
+std::string json_reader::read_buffered_string(char startingCharacter)
+{
+    std::string s;
+    while (true)
+    {
+        const char *special = find_string_special(p_, end_, startingCharacter);
+        s.append(p_, special);
+        p_ = special;
+        char c = get();
+        if (c == startingCharacter)
+        {
+            if (peek_char() == startingCharacter) //  "" -> "
+            {
+                get();
+                s += c;
+                s += c;
+            }
+            else
+            {
+                break;
+            }
+        }
+        else
+        {
+            read_escape(s);
+        }
+    }
+    return s;
+}
 
+std::string json_reader::read_string()
+{
     skip_whitespace();
     char c;
     char startingCharacter;
@@ -312,76 +629,35 @@ std::string json_reader::read_string()
     {
         throw_format_error();
     }
-    std::stringstream s;
+    if (!is_)
+    {
+        return read_buffered_string(startingCharacter);
+    }
+    std::string s;
 
     while (true)
     {
         c = get();
         if (c == startingCharacter)
         {
-            if (is_.peek() == startingCharacter) //  "" -> "
+            if (peek_char() == startingCharacter) //  "" -> "
             {
                 get();
-                s.put(c);
+                s += c;
             } else {
                 break;
             }
         }
         if (c != '\\')
         {
-            s << (char)c;
+            s += c;
         }
         else
         {
-            c = get();
-            switch (c)
-            {
-            case '"':
-            case '\\':
-            default:
-                s << c;
-                break;
-            case 'r':
-                s << '\r';
-                break;
-            case 'b':
-                s << '\b';
-                break;
-            case 'f':
-                s << '\f';
-                break;
-            case 'n':
-                s << '\n';
-                break;
-            case 't':
-                s << '\t';
-                break;
-            case 'u':
-            {
-                uint32_t uc = read_u_escape();
-                if (uc >= UTF16_SURROGATE_1_BASE && uc <= UTF16_SURROGATE_1_BASE + UTF16_SURROGATE_MASK)
-                {
-                    // MUST be a UTF16_SURROGATE 2 to be legal.
-                    c = get();
-                    if (c != '\\')
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    c = get();
-                    if (c != 'u')
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    uint16_t uc2 = read_u_escape();
-                    if (uc2 < UTF16_SURROGATE_2_BASE || uc2 > UTF16_SURROGATE_2_BASE + UTF16_SURROGATE_MASK)
-                    {
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    }
-                    uc = ((uc & UTF16_SURROGATE_MASK) << 10) + (uc2 & UTF16_SURROGATE_MASK) + 0x10000U;
-                }
-                utf32_to_utf8_stream(s, uc);
-            }
-            break;
-            }
+            read_escape(s);
         }
     }
-    return s.str();
+    return s;
 }
 uint16_t json_reader::read_hex()
 {
@@ -410,7 +686,7 @@ uint16_t json_reader::read_u_escape()
 bool json_reader::is_complete()
 {
     skip_whitespace();
-    return is_.peek() == -1;
+    return peek_char() == -1;
 }
 
 void json_reader::consumeToken(const char*expectedToken, const char*errorMessage)
@@ -421,7 +697,7 @@ void json_reader::consumeToken(const char*expectedToken, const char*errorMessage
     while (*p != '\0')
     {
         char expectedChar = *p++;
-        int c = is_.get();
+        int c = get_char();
         if (expectedChar != c) {
             this->throw_format_error(errorMessage);
         }
@@ -444,7 +720,7 @@ void json_reader::consume(char expected)
 void json_reader::skip_property()
 {
     skip_whitespace();
-    int c = is_.peek();
+    int c = peek_char();
     switch (c)
     {
     case -1:
@@ -500,36 +776,36 @@ void json_reader::skip_number()
 {
     skip_whitespace();
     int c;
-    if (is_.peek() == '-')
+    if (peek_char() == '-')
     {
         get();
     }
-    if (!std::isdigit(is_.peek()))
+    if (!std::isdigit(peek_char()))
     {
         throw_format_error("Expecting a number.");
     }
-    while (std::isdigit(is_.peek()))
+    while (std::isdigit(peek_char()))
     {
         get();
     }
-    if (is_.peek() == '.')
+    if (peek_char() == '.')
     {
         get();
     }
-    while (std::isdigit(is_.peek()))
+    while (std::isdigit(peek_char()))
     {
         get();
     }
-    c = is_.peek();
+    c = peek_char();
     if (c == 'e' || c == 'E')
     {
         get();
-        c = is_.peek();
+        c = peek_char();
         if (c == '+' || c == 'i')
         {
             get();
         }
-        while (std::isdigit(is_.peek()))
+        while (std::isdigit(peek_char()))
         {
             get();
         }
@@ -553,7 +829,7 @@ void json_reader::skip_array()
         }
         skip_property();
         skip_whitespace();
-        if (is_.peek() == ',')
+        if (peek_char() == ',')
         {
             c = get();
         }
@@ -600,13 +876,13 @@ std::string json_reader::readToken()
     std::stringstream s;
     while (true)
     {
-        int ic = is_.peek();
+        int ic = peek_char();
         if (ic == -1)
             break;
         char c = (char)ic;
         if (!std::isalpha(c))
             break;
-        is_.get();
+        get_char();
         s << c;
     }
     return s.str();
@@ -640,7 +916,7 @@ void json_reader::throw_format_error(const char*error)
     s << error;
     s << ", near: '";
     skip_whitespace();
-    if (is_.peek() == -1) {
+    if (peek_char() == -1) {
         s << "<eof>";
     } else {
         for (int i = 0; i < 40; ++i)
@@ -44,6 +44,9 @@
 #include "ChannelRouterSettings.hpp"
 
 #include "CpuUse.hpp"
+#include "AlsaFormatConversion.hpp"
+#include "AlsaOutputStage.hpp"
+#include "FlightRecorder.hpp"
 
 #include <alsa/asoundlib.h>
 
@@ -497,7 +500,8 @@ namespace pipedal
             snd_pcm_sw_params_t *swParams,
             int *channels,
             unsigned int *periods,
-            unsigned int *hwPeriodSize)
+            unsigned int *hwPeriodSize,
+            bool *useMmap)
         {
             int err;
             snd_pcm_uframes_t stop_th;
@@ -509,10 +513,24 @@ namespace pipedal
                 AlsaError(SS("No playback configurations available (" << snd_strerror(err) << ")"));
             }
 
-            err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
-            if (err < 0)
+            // *useMmap: in, whether mmap access was requested; out, whether it is in use.
+            if (*useMmap)
             {
-                AlsaError("snd_pcm_hw_params_set_access failed.");
+                *useMmap =
+                    snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0 ||
+                    snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_MMAP_NONINTERLEAVED) >= 0;
+                if (!*useMmap)
+                {
+                    Lv2Log::info(SS("ALSA " << streamType << " device " << alsa_device_name << " does not support mmap access. Using read/write access instead."));
+                }
+            }
+            if (!*useMmap)
+            {
+                err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+                if (err < 0)
+                {
+                    AlsaError("snd_pcm_hw_params_set_access failed.");
+                }
             }
 
             SetPreferredAlsaFormat(alsa_device_name, streamType, handle, hwParams);
@@ -695,9 +713,15 @@ namespace pipedal
             this->numberOfBuffers = numberOfBuffers;
             this->sampleRate = sampleRate;
 
+            // The dummy device has no DMA buffers worth mapping.
+            bool mmapRequested = this->jackServerSettings.GetAlsaMmapAccess() && !this->isDummyDriver;
+            captureMmap = false;
+            playbackMmap = false;
+
             if (this->captureHandle)
             {
                 this->alsa_device_name = this->jackServerSettings.GetAlsaInputDevice();
+                captureMmap = mmapRequested;
                 AlsaConfigureStream(
                     this->alsa_device_name,
                     "capture",
@@ -706,11 +730,13 @@ namespace pipedal
                     captureSwParams,
                     &captureChannels,
                     &this->capturePeriods,
-                    &this->captureHardwarePeriodSize);
+                    &this->captureHardwarePeriodSize,
+                    &this->captureMmap);
             }
             if (this->playbackHandle)
             {
                 this->alsa_device_name = this->jackServerSettings.GetAlsaOutputDevice();
+                playbackMmap = mmapRequested;
                 AlsaConfigureStream(
                     this->alsa_device_name,
                     "playback",
@@ -719,7 +745,8 @@ namespace pipedal
                     playbackSwParams,
                     &playbackChannels,
                     &this->playbackPeriods,
-                    &this->playbackHardwarePeriodSize);
+                    &this->playbackHardwarePeriodSize,
+                    &this->playbackMmap);
             }
 
 #ifdef ALSADRIVER_CONFIG_DBG
@@ -728,398 +755,177 @@ namespace pipedal
 #endif
         }
 
-        int32_t EndianSwap(int32_t v)
-        {
-            int32_t b0 = v & 0xFF;
-            int32_t b1 = (v >> 8) & 0xFF;
-            int32_t b2 = (v >> 16) & 0xFF;
-            int32_t b3 = (v >> 24) & 0xFF;
+        // Sample format conversion. Raw device samples are converted to and from an interleaved float
+        // buffer by SIMD kernels selected at runtime, and then (de)interleaved into the device buffers.
+        SimdLevel simdLevel = GetBestSimdLevel();
+        AlsaFormatConverter captureConverter;
+        AlsaFormatConverter playbackConverter;
+        std::vector<float> interleavedCaptureBuffer;
+        std::vector<float> interleavedPlaybackBuffer;
 
-            return (b0 << 24) | (b1 << 16) | (b2 << 8) | (b3);
-        }
-        int16_t EndianSwap(int16_t v)
+        static bool GetAlsaSampleFormat(snd_pcm_format_t format, AlsaSampleFormat *pResult)
         {
-            int16_t b0 = v & 0xFF;
-            int16_t b1 = (v >> 8) & 0xFF;
-
-            return (b0 << 8) | (b1);
-        }
-        void EndianSwap(float *p, float v_)
-        {
-            int32_t v = EndianSwap(*(int32_t *)&v_);
-            *(int32_t *)p = v;
-        }
-        template <typename T>
-        static T *getCaptureBuffer(std::vector<uint8_t> &buffer) { return (T *)(buffer.data()); }
-
-        void CopyCaptureFloatBe(size_t frames)
-        {
-            int32_t *p = getCaptureBuffer<int32_t>(rawCaptureBuffer);
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            for (size_t frame = 0; frame < frames; ++frame)
+            switch (format)
             {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int32_t v = EndianSwap(*p);
-                    ++p;
-
-                    *(int32_t *)(buffers[channel] + frame) = v;
-                }
+            case SND_PCM_FORMAT_S16_LE:
+                *pResult = AlsaSampleFormat::S16Le;
+                return true;
+            case SND_PCM_FORMAT_S16_BE:
+                *pResult = AlsaSampleFormat::S16Be;
+                return true;
+            case SND_PCM_FORMAT_S24_LE:
+                *pResult = AlsaSampleFormat::S24Le;
+                return true;
+            case SND_PCM_FORMAT_S24_BE:
+                *pResult = AlsaSampleFormat::S24Be;
+                return true;
+            case SND_PCM_FORMAT_S24_3LE:
+                *pResult = AlsaSampleFormat::S24_3Le;
+                return true;
+            case SND_PCM_FORMAT_S24_3BE:
+                *pResult = AlsaSampleFormat::S24_3Be;
+                return true;
+            case SND_PCM_FORMAT_S32_LE:
+                *pResult = AlsaSampleFormat::S32Le;
+                return true;
+            case SND_PCM_FORMAT_S32_BE:
+                *pResult = AlsaSampleFormat::S32Be;
+                return true;
+            case SND_PCM_FORMAT_FLOAT_LE:
+                *pResult = AlsaSampleFormat::FloatLe;
+                return true;
+            case SND_PCM_FORMAT_FLOAT_BE:
+                *pResult = AlsaSampleFormat::FloatBe;
+                return true;
+            default:
+                return false;
             }
         }
 
-        void CopyCaptureFloatLe(size_t frames)
+        void CopyCapture(size_t frames)
         {
-            float *p = getCaptureBuffer<float>(rawCaptureBuffer);
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            for (size_t frame = 0; frame < frames; ++frame)
+            const uint8_t *raw = rawCaptureBuffer.data();
+            if (captureChannels == 1)
             {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    float v = *p++;
-                    buffers[channel][frame] = v;
-                }
+                captureConverter.decode(raw, deviceCaptureBuffers[0], frames);
+                return;
             }
+            captureConverter.decode(raw, interleavedCaptureBuffer.data(), frames * captureChannels);
+            captureConverter.deinterleave(interleavedCaptureBuffer.data(), deviceCaptureBuffers.data(), captureChannels, frames);
         }
 
-        void CopyCaptureS16Le(size_t frames)
-        {
-            int16_t *p = getCaptureBuffer<int16_t>(rawCaptureBuffer);
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr double scale = 1.0f / (std::numeric_limits<int16_t>::max() + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int16_t v = *p++;
-                    buffers[channel][frame] = scale * v;
-                }
-            }
-        }
-        void CopyCaptureS16Be(size_t frames)
+        void CopyPlayback(size_t frames)
         {
-            int16_t *p = getCaptureBuffer<int16_t>(rawCaptureBuffer);
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (std::numeric_limits<int16_t>::max() + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
+            uint8_t *raw = rawPlaybackBuffer.data();
+            if (playbackChannels == 1)
             {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int16_t v = EndianSwap(*p++);
-                    buffers[channel][frame] = scale * v;
-                }
+                playbackConverter.encode(devicePlaybackBuffers[0], raw, frames);
+                return;
             }
+            playbackConverter.interleave(devicePlaybackBuffers.data(), interleavedPlaybackBuffer.data(), playbackChannels, frames);
+            playbackConverter.encode(interleavedPlaybackBuffer.data(), raw, frames * playbackChannels);
         }
 
-        void CopyCaptureS32Le(size_t frames)
-        {
-            int32_t *p = getCaptureBuffer<int32_t>(rawCaptureBuffer);
+        // mmap access. Samples are converted directly from and to the DMA buffer areas returned by
+        // snd_pcm_mmap_begin, bypassing rawCaptureBuffer and rawPlaybackBuffer.
+        bool captureMmap = false;
+        bool playbackMmap = false;
+        std::vector<float *> mmapChannelBuffers;
 
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (std::numeric_limits<int32_t>::max() + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int32_t v = *p++;
-                    buffers[channel][frame] = scale * v;
-                }
-            }
-        }
-        void CopyCaptureS24_3Le(size_t frames)
+        static uint8_t *GetAreaAddress(const snd_pcm_channel_area_t &area, snd_pcm_uframes_t offset)
         {
-            uint8_t *p = getCaptureBuffer<uint8_t>(rawCaptureBuffer);
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (std::numeric_limits<int32_t>::max() + 1LL);
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int32_t v = (p[0] << 8) + (p[1] << 16) | (p[2] << 24);
-                    p += 3;
-                    buffers[channel][frame] = scale * v;
-                }
-            }
-        }
-        void CopyCaptureS24_3Be(size_t frames)
-        {
-            uint8_t *p = (uint8_t *)rawCaptureBuffer.data();
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (std::numeric_limits<int32_t>::max() + 1LL);
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int32_t v = (p[2] << 8) + (p[1] << 16) | (p[0] << 24);
-                    p += 3;
-                    buffers[channel][frame] = scale * v;
-                }
-            }
+            return (uint8_t *)area.addr + area.first / 8 + offset * (area.step / 8);
         }
-        void CopyCaptureS24Le(size_t frames)
+        static bool IsInterleavedArea(const snd_pcm_channel_area_t *areas, size_t channels, size_t sampleSize)
         {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (0x00FFFFFFL + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
+            for (size_t c = 0; c < channels; ++c)
             {
-                for (int channel = 0; channel < channels; ++channel)
+                if (areas[c].addr != areas[0].addr ||
+                    areas[c].step != channels * sampleSize * 8 ||
+                    areas[c].first != areas[0].first + c * sampleSize * 8)
                 {
-                    int32_t v = *p++;
-                    buffers[channel][frame] = scale * v;
+                    return false;
                 }
             }
+            return true;
         }
-        void CopyCaptureS24Be(size_t frames)
-        {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
 
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (0x00FFFFFFL + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    int32_t v = EndianSwap(*p++);
-                    buffers[channel][frame] = scale * v;
-                }
-            }
-        }
-        void CopyCaptureS32Be(size_t frames)
+        // Decode frames from the capture areas at offset into the device capture buffers at position.
+        void DecodeMmapAreas(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset, size_t position, size_t frames)
         {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
-
-            std::vector<float *> &buffers = this->deviceCaptureBuffers;
-            int channels = this->captureChannels;
-            constexpr float scale = 1.0f / (std::numeric_limits<int32_t>::max() + 1L);
-            for (size_t frame = 0; frame < frames; ++frame)
+            size_t channels = captureChannels;
+            if (IsInterleavedArea(areas, channels, captureSampleSize))
             {
-                for (int channel = 0; channel < channels; ++channel)
+                const uint8_t *p = GetAreaAddress(areas[0], offset);
+                if (channels == 1)
                 {
-                    int32_t v = EndianSwap(*p++);
-                    buffers[channel][frame] = scale * v;
+                    captureConverter.decode(p, deviceCaptureBuffers[0] + position, frames);
+                    return;
                 }
-            }
-        }
-        void CopyPlaybackS16Le(size_t frames)
-        {
-            int16_t *p = (int16_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr float scale = std::numeric_limits<int16_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
+                mmapChannelBuffers.resize(channels);
+                for (size_t c = 0; c < channels; ++c)
                 {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = (int16_t)(scale * v);
-                }
-            }
-        }
-        void CopyPlaybackS16Be(size_t frames)
-        {
-            int16_t *p = (int16_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr float scale = std::numeric_limits<int16_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = EndianSwap((int16_t)(scale * v));
+                    mmapChannelBuffers[c] = deviceCaptureBuffers[c] + position;
                 }
+                captureConverter.decode(p, interleavedCaptureBuffer.data(), frames * channels);
+                captureConverter.deinterleave(interleavedCaptureBuffer.data(), mmapChannelBuffers.data(), channels, frames);
+                return;
             }
-        }
-        void CopyPlaybackS32Le(size_t frames)
-        {
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = std::numeric_limits<int32_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
+            for (size_t c = 0; c < channels; ++c)
             {
-                for (int channel = 0; channel < channels; ++channel)
+                const uint8_t *p = GetAreaAddress(areas[c], offset);
+                float *output = deviceCaptureBuffers[c] + position;
+                size_t stride = areas[c].step / 8;
+                if (stride == captureSampleSize)
                 {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = (int32_t)(scale * v);
+                    captureConverter.decode(p, output, frames);
                 }
-            }
-        }
-        void CopyPlaybackS24Le(size_t frames)
-        {
-            // 24 bits in low bits of an int32_t.
-
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = 0x00FFFFFF;
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = (int32_t)(scale * v);
-                }
-            }
-        }
-        void CopyPlaybackS24Be(size_t frames)
-        {
-            // 24 bits in low bits of an int32_t.
-
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = 0x00FFFFFF;
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
+                else
                 {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = EndianSwap((int32_t)(scale * v));
+                    for (size_t i = 0; i < frames; ++i)
+                    {
+                        captureConverter.decode(p + i * stride, output + i, 1);
+                    }
                 }
             }
         }
-        void CopyPlaybackS32Be(size_t frames)
-        {
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
 
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = std::numeric_limits<int32_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
-                {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    *p++ = EndianSwap((int32_t)(scale * v));
-                }
-            }
-        }
-        void CopyPlaybackS24_3Be(size_t frames)
+        // Encode frames from the device playback buffers at position into the playback areas at offset.
+        void EncodeMmapAreas(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset, size_t position, size_t frames)
         {
-            uint8_t *p = (uint8_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = std::numeric_limits<int32_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
+            size_t channels = playbackChannels;
+            if (IsInterleavedArea(areas, channels, playbackSampleSize))
             {
-                for (int channel = 0; channel < channels; ++channel)
+                uint8_t *p = GetAreaAddress(areas[0], offset);
+                if (channels == 1)
                 {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    int32_t iValue = (int32_t)(scale * v);
-                    p[0] = (uint8_t)(iValue >> 24);
-                    p[1] = (uint8_t)(iValue >> 16);
-                    p[2] = (uint8_t)(iValue >> 8);
-
-                    p += 3;
+                    playbackConverter.encode(devicePlaybackBuffers[0] + position, p, frames);
+                    return;
                 }
-            }
-        }
-        void CopyPlaybackS24_3Le(size_t frames)
-        {
-            uint8_t *p = (uint8_t *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            constexpr double scale = std::numeric_limits<int32_t>::max();
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
+                mmapChannelBuffers.resize(channels);
+                for (size_t c = 0; c < channels; ++c)
                 {
-                    float v = buffers[channel][frame];
-                    if (v > 1.0f)
-                        v = 1.0f;
-                    else if (v < -1.0f)
-                        v = -1.0f;
-                    int32_t iValue = (int32_t)(scale * v);
-                    p[0] = (uint8_t)(iValue >> 8);
-                    p[1] = (uint8_t)(iValue >> 16);
-                    p[2] = (uint8_t)(iValue >> 24);
-
-                    p += 3;
+                    mmapChannelBuffers[c] = devicePlaybackBuffers[c] + position;
                 }
+                playbackConverter.interleave(mmapChannelBuffers.data(), interleavedPlaybackBuffer.data(), channels, frames);
+                playbackConverter.encode(interleavedPlaybackBuffer.data(), p, frames * channels);
+                return;
             }
-        }
-
-        void CopyPlaybackFloatLe(size_t frames)
-        {
-            float *p = (float *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            for (size_t frame = 0; frame < frames; ++frame)
+            for (size_t c = 0; c < channels; ++c)
             {
-                for (int channel = 0; channel < channels; ++channel)
+                uint8_t *p = GetAreaAddress(areas[c], offset);
+                const float *input = devicePlaybackBuffers[c] + position;
+                size_t stride = areas[c].step / 8;
+                if (stride == playbackSampleSize)
                 {
-                    float v = buffers[channel][frame];
-                    *p++ = v;
+                    playbackConverter.encode(input, p, frames);
                 }
-            }
-        }
-        void CopyPlaybackFloatBe(size_t frames)
-        {
-            float *p = (float *)rawPlaybackBuffer.data();
-
-            std::vector<float *> &buffers = this->devicePlaybackBuffers;
-            int channels = this->playbackChannels;
-            for (size_t frame = 0; frame < frames; ++frame)
-            {
-                for (int channel = 0; channel < channels; ++channel)
+                else
                 {
-                    float v = buffers[channel][frame];
-                    EndianSwap(p, v);
-                    p++;
+                    for (size_t i = 0; i < frames; ++i)
+                    {
+                        playbackConverter.encode(input + i, p + i * stride, 1);
+                    }
                 }
             }
         }
@@ -1211,60 +1017,20 @@ namespace pipedal
         {
             this->captureFormat = captureFormat;
 
-            switch (captureFormat)
-            {
-            case SND_PCM_FORMAT_FLOAT_LE:
-                captureSampleSize = 4;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureFloatLe;
-                break;
-            case SND_PCM_FORMAT_S24_3LE:
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS24_3Le;
-                captureSampleSize = 3;
-                break;
-            case SND_PCM_FORMAT_S32_LE:
-                captureSampleSize = 4;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS32Le;
-                break;
-            case SND_PCM_FORMAT_S24_LE:
-                captureSampleSize = 4;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS24Le;
-                break;
-            case SND_PCM_FORMAT_S16_LE:
-                captureSampleSize = 2;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS16Le;
-                break;
-            case SND_PCM_FORMAT_FLOAT_BE:
-                captureSampleSize = 4;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureFloatBe;
-                captureSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S24_3BE:
-                captureSampleSize = 3;
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS24_3Be;
-                break;
-            case SND_PCM_FORMAT_S32_BE:
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS32Be;
-                captureSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S24_BE:
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS24Be;
-                captureSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S16_BE:
-                copyInputFn = &AlsaDriverImpl::CopyCaptureS16Be;
-                captureSampleSize = 2;
-                break;
-            default:
-                break;
-            }
-            if (copyInputFn == nullptr)
+            AlsaSampleFormat sampleFormat;
+            if (!GetAlsaSampleFormat(captureFormat, &sampleFormat))
             {
                 throw PiPedalStateException(SS("Audio input format not supported. (" << captureFormat << ")"));
             }
+            captureConverter = GetAlsaFormatConverter(sampleFormat, simdLevel);
+            captureSampleSize = (uint32_t)GetAlsaSampleSize(sampleFormat);
+            copyInputFn = &AlsaDriverImpl::CopyCapture;
 
             captureFrameSize = captureSampleSize * captureChannels;
             rawCaptureBuffer.resize(captureFrameSize * bufferSize * 2);
             memset(rawCaptureBuffer.data(), 0, rawCaptureBuffer.size());
+            interleavedCaptureBuffer.resize(captureChannels * bufferSize * 2);
+            mmapChannelBuffers.reserve(std::max(captureChannels, playbackChannels));
 
             AllocateBuffers(deviceCaptureBuffers, captureChannels);
         }
@@ -1275,6 +1041,7 @@ namespace pipedal
                 "ALSA, "
                 << this->alsa_device_name
                 << ", " << GetAlsaFormatDescription(this->captureFormat)
+                << (this->captureMmap && this->playbackMmap ? " (mmap)" : "")
                 << ", " << this->sampleRate
                 << ", " << this->bufferSize << "x" << this->numberOfBuffers
                 << ", " << "device: " << this->DeviceInputBufferCount() << "/" << this->DeviceOutputBufferCount()
@@ -1285,60 +1052,20 @@ namespace pipedal
         }
         void PreparePlaybackFunctions(snd_pcm_format_t playbackFormat)
         {
-            copyOutputFn = nullptr;
-            switch (playbackFormat)
-            {
-            case SND_PCM_FORMAT_FLOAT_LE:
-                playbackSampleSize = 4;
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackFloatLe;
-                break;
-            case SND_PCM_FORMAT_S24_3LE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS24_3Le;
-                playbackSampleSize = 3;
-                break;
-            case SND_PCM_FORMAT_S32_LE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS32Le;
-                playbackSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S24_LE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS24Le;
-                playbackSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S16_LE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS16Le;
-                playbackSampleSize = 2;
-                break;
-            case SND_PCM_FORMAT_FLOAT_BE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackFloatBe;
-                playbackSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S24_3BE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS24_3Be;
-                playbackSampleSize = 3;
-                break;
-            case SND_PCM_FORMAT_S32_BE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS32Be;
-                playbackSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S24_BE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS24Be;
-                playbackSampleSize = 4;
-                break;
-            case SND_PCM_FORMAT_S16_BE:
-                copyOutputFn = &AlsaDriverImpl::CopyPlaybackS16Be;
-                playbackSampleSize = 2;
-                break;
-            default:
-                break;
-            }
-            if (copyOutputFn == nullptr)
+            AlsaSampleFormat sampleFormat;
+            if (!GetAlsaSampleFormat(playbackFormat, &sampleFormat))
             {
                 throw PiPedalStateException(SS("Unsupported audio output format. (" << playbackFormat << ")"));
             }
+            playbackConverter = GetAlsaFormatConverter(sampleFormat, simdLevel);
+            playbackSampleSize = (uint32_t)GetAlsaSampleSize(sampleFormat);
+            copyOutputFn = &AlsaDriverImpl::CopyPlayback;
 
             playbackFrameSize = playbackSampleSize * playbackChannels;
             rawPlaybackBuffer.resize(playbackFrameSize * bufferSize);
             memset(rawPlaybackBuffer.data(), 0, playbackFrameSize * bufferSize);
+            interleavedPlaybackBuffer.resize(playbackChannels * bufferSize);
+            mmapChannelBuffers.reserve(std::max(captureChannels, playbackChannels));
 
             AllocateBuffers(devicePlaybackBuffers, playbackChannels);
         }
@@ -1702,6 +1429,49 @@ namespace pipedal
             return framesRead;
         }
 
+        // Read frames directly from the capture DMA buffer into the device capture buffers, starting at position.
+        snd_pcm_sframes_t ReadBufferMmap(snd_pcm_t *handle, size_t position, snd_pcm_uframes_t frames)
+        {
+            snd_pcm_uframes_t framesRead = 0;
+            while (framesRead < frames)
+            {
+                snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+                if (avail < 0)
+                {
+                    return avail;
+                }
+                if (avail == 0)
+                {
+                    int err = snd_pcm_wait(handle, 1000);
+                    if (err < 0)
+                    {
+                        return err;
+                    }
+                    continue;
+                }
+                const snd_pcm_channel_area_t *areas;
+                snd_pcm_uframes_t offset;
+                snd_pcm_uframes_t thisTime = frames - framesRead;
+                int err = snd_pcm_mmap_begin(handle, &areas, &offset, &thisTime);
+                if (err < 0)
+                {
+                    return err;
+                }
+                DecodeMmapAreas(areas, offset, position + framesRead, thisTime);
+                snd_pcm_sframes_t committed = snd_pcm_mmap_commit(handle, offset, thisTime);
+                if (committed < 0)
+                {
+                    return committed;
+                }
+                if ((snd_pcm_uframes_t)committed != thisTime)
+                {
+                    return -EPIPE;
+                }
+                framesRead += thisTime;
+            }
+            return (snd_pcm_sframes_t)framesRead;
+        }
+
     protected:
         void ReadMidiData(uint32_t audioFrame)
         {
@@ -1757,7 +1527,8 @@ namespace pipedal
 
             while (frames > 0)
             {
-                framesRead = snd_pcm_writei(handle, buf, frames);
+                // (a stream with mmap access can't use snd_pcm_writei.)
+                framesRead = playbackMmap ? snd_pcm_mmap_writei(handle, buf, frames) : snd_pcm_writei(handle, buf, frames);
                 if (framesRead == -EAGAIN)
                     continue;
                 if (framesRead < 0)
@@ -1767,6 +1538,49 @@ namespace pipedal
             }
             return 0;
         }
+
+        // Write frames directly from the device playback buffers into the playback DMA buffer.
+        long WriteBufferMmap(snd_pcm_t *handle, size_t frames)
+        {
+            size_t framesWritten = 0;
+            while (framesWritten < frames)
+            {
+                snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+                if (avail < 0)
+                {
+                    return avail;
+                }
+                if (avail == 0)
+                {
+                    int err = snd_pcm_wait(handle, 1000);
+                    if (err < 0)
+                    {
+                        return err;
+                    }
+                    continue;
+                }
+                const snd_pcm_channel_area_t *areas;
+                snd_pcm_uframes_t offset;
+                snd_pcm_uframes_t thisTime = std::min((snd_pcm_uframes_t)avail, (snd_pcm_uframes_t)(frames - framesWritten));
+                int err = snd_pcm_mmap_begin(handle, &areas, &offset, &thisTime);
+                if (err < 0)
+                {
+                    return err;
+                }
+                EncodeMmapAreas(areas, offset, framesWritten, thisTime);
+                snd_pcm_sframes_t committed = snd_pcm_mmap_commit(handle, offset, thisTime);
+                if (committed < 0)
+                {
+                    return committed;
+                }
+                if ((snd_pcm_uframes_t)committed != thisTime)
+                {
+                    return -EPIPE;
+                }
+                framesWritten += thisTime;
+            }
+            return 0;
+        }
         PIPEDAL_NON_INLINE void AudioThread()
         {
             SetThreadName("alsaDriver");
@@ -1789,6 +1603,12 @@ namespace pipedal
 
                 CrashGuardLock crashGuardLock;
 
+                FlightRecorder *flightRecorder = driverHost->GetFlightRecorder();
+                if (flightRecorder)
+                {
+                    flightRecorder->Reset();
+                }
+
                 cpuUse.SetStartTime(cpuUse.Now());
                 while (true)
                 {
@@ -1799,6 +1619,10 @@ namespace pipedal
                     {
                         break;
                     }
+                    if (flightRecorder)
+                    {
+                        flightRecorder->BeginPeriod((uint32_t)bufferSize);
+                    }
                     this->midiEventCount = 0;
                     this->midiEventMemoryIndex = 0;
 
@@ -1814,12 +1638,30 @@ namespace pipedal
 
                         ssize_t thisTime = framesToRead;
                         ssize_t nFrames;
-                        if ((nFrames = ReadBuffer(
-                                 captureHandle,
-                                 this->rawCaptureBuffer.data() + this->captureFrameSize * framesRead,
-                                 framesToRead)) < 0)
+                        if (captureMmap)
+                        {
+                            nFrames = ReadBufferMmap(captureHandle, framesRead, framesToRead);
+                        }
+                        else
+                        {
+                            nFrames = ReadBuffer(
+                                captureHandle,
+                                this->rawCaptureBuffer.data() + this->captureFrameSize * framesRead,
+                                framesToRead);
+                        }
+                        if (nFrames < 0)
                         {
                             this->driverHost->OnUnderrun();
+                            if (flightRecorder)
+                            {
+                                flightRecorder->Mark(FlightPhase::Read);
+                                if (FlightRecord *record = flightRecorder->GetCurrentRecord())
+                                {
+                                    record->captureAvail = (int32_t)nFrames;
+                                }
+                                flightRecorder->OnXrun();
+                                flightRecorder->EndPeriod();
+                            }
                             recover_from_input_underrun(captureHandle, playbackHandle, nFrames, framesRead);
                             xrun = true;
                             break;
@@ -1834,28 +1676,55 @@ namespace pipedal
                         continue;
                     }
                     cpuUse.AddSample(ProfileCategory::Read);
+                    if (flightRecorder)
+                    {
+                        flightRecorder->Mark(FlightPhase::Read);
+                        if (FlightRecord *record = flightRecorder->GetCurrentRecord())
+                        {
+                            record->captureAvail = (int32_t)snd_pcm_avail_update(captureHandle);
+                        }
+                    }
                     if (framesRead == 0)
+                    {
+                        if (flightRecorder)
+                        {
+                            flightRecorder->EndPeriod();
+                        }
                         continue;
+                    }
                     if (framesRead != bufferSize)
                     {
                         throw PiPedalStateException("Invalid read.");
                     }
 
-                    (this->*copyInputFn)(framesRead);
+                    if (!captureMmap) // (mmap reads convert in place.)
+                    {
+                        (this->*copyInputFn)(framesRead);
+                    }
                     cpuUse.AddSample(ProfileCategory::Driver);
+                    if (flightRecorder)
+                    {
+                        flightRecorder->Mark(FlightPhase::Convert);
+                    }
 
                     this->driverHost->OnProcess(framesRead);
 
                     cpuUse.AddSample(ProfileCategory::Execute);
-
-                    // Perform any neccessary mixing of outputs.
-                    for (auto&mixOp: this->mixOps)
+                    if (flightRecorder)
                     {
-                        mixOp(framesRead);
+                        flightRecorder->Mark(FlightPhase::Process);
                     }
 
-                    // final format conversion.
-                    (this->*copyOutputFn)(framesRead);
+                    // Mix outputs, measure output levels, and interleave, in a single pass; then format conversion.
+                    if (playbackMmap) // (mmap writes convert in place.)
+                    {
+                        outputStage.Process(devicePlaybackBuffers.data(), nullptr, framesRead);
+                    }
+                    else
+                    {
+                        outputStage.Process(devicePlaybackBuffers.data(), interleavedPlaybackBuffer.data(), framesRead);
+                        playbackConverter.encode(interleavedPlaybackBuffer.data(), rawPlaybackBuffer.data(), framesRead * playbackChannels);
+                    }
 
                     if (this->driverHost)
                     {
@@ -1863,13 +1732,27 @@ namespace pipedal
                     }
 
                     cpuUse.AddSample(ProfileCategory::Driver);
+                    if (flightRecorder)
+                    {
+                        flightRecorder->Mark(FlightPhase::Mix);
+                        if (FlightRecord *record = flightRecorder->GetCurrentRecord())
+                        {
+                            record->playbackAvail = (int32_t)snd_pcm_avail_update(playbackHandle);
+                        }
+                    }
                     // process.
 
-                    ssize_t err = WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), framesRead);
+                    ssize_t err = playbackMmap
+                                      ? WriteBufferMmap(playbackHandle, framesRead)
+                                      : WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), framesRead);
 
                     if (err < 0)
                     {
                         this->driverHost->OnUnderrun();
+                        if (flightRecorder)
+                        {
+                            flightRecorder->OnXrun();
+                        }
 
                         recover_from_output_underrun(captureHandle, playbackHandle, err, framesRead);
                         framesRead = 0;
@@ -1879,6 +1762,11 @@ namespace pipedal
                         std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 30));
                     }
                     cpuUse.AddSample(ProfileCategory::Write);
+                    if (flightRecorder)
+                    {
+                        flightRecorder->Mark(FlightPhase::Write);
+                        flightRecorder->EndPeriod();
+                    }
                 }
             }
             catch (const std::exception &e)
@@ -1983,65 +1871,20 @@ namespace pipedal
             }
         }
 
-        using MixOp = std::function<void(size_t nFrames)>;
-        std::vector<MixOp> mixOps;
+        // Routing of main and aux outputs to device output channels.
+        AlsaOutputStage outputStage;
 
-        PIPEDAL_NON_INLINE 
-        void AddMixCopyOp(float*inputBuffer, float*outputBuffer)
-        {
-            mixOps.push_back([inputBuffer,outputBuffer](size_t nFrames) {
-                float*PIPEDAL_RESTRICT pIn = inputBuffer;
-                float*PIPEDAL_RESTRICT pOut = outputBuffer;
-                for (size_t i = 0; i < nFrames; ++i)
-                {
-                    pOut[i] = pIn[i];
-                }
-            });
-        }
-        PIPEDAL_NON_INLINE 
-        void AddMixAddOp(float*inputBuffer, float*outputBuffer)
-        {
-            mixOps.push_back([inputBuffer,outputBuffer](size_t nFrames) {
-                float*PIPEDAL_RESTRICT pIn = inputBuffer;
-                float*PIPEDAL_RESTRICT pOut = outputBuffer;
-                for (size_t i = 0; i < nFrames; ++i)
-                {
-                    pOut[i] += pIn[i];
-                }
-            });
-        }
-        PIPEDAL_NON_INLINE 
-        void AddMixCopyOp(float scale, float*inputBuffer, float*outputBuffer)
-        {
-            mixOps.push_back([scale,inputBuffer,outputBuffer](size_t nFrames) {
-                float*PIPEDAL_RESTRICT pIn = inputBuffer;
-                float*PIPEDAL_RESTRICT pOut = outputBuffer;
-                for (size_t i = 0; i < nFrames; ++i)
-                {
-                    pOut[i] = scale*pIn[i];
-                }
-            });
-        }
-        PIPEDAL_NON_INLINE 
-        void AddMixAddOp(float scale, float*inputBuffer, float*outputBuffer)
-        {
-            mixOps.push_back([scale,inputBuffer,outputBuffer](size_t nFrames) {
-                float*PIPEDAL_RESTRICT pIn = inputBuffer;
-                float*PIPEDAL_RESTRICT pOut = outputBuffer;
-                for (size_t i = 0; i < nFrames; ++i)
-                {
-                    pOut[i] += scale*pIn[i];
-                }
-            });
-        }
         PIPEDAL_NON_INLINE void AddMixOps() 
         {
-            std::set<size_t> usedOutputChannels;
+            outputStage.Reset(this->devicePlaybackBuffers.size());
 
             for (size_t i = 0; i < this->channelSelection.mainOutputChannels().size(); ++i) {
-                size_t outputChannel = this->channelSelection.mainOutputChannels()[i];
-                AddMixCopyOp(this->mainPlaybackBuffers[i],this->devicePlaybackBuffers[outputChannel]);
-                usedOutputChannels.insert(outputChannel);
+                int64_t outputChannel = this->channelSelection.mainOutputChannels()[i];
+                if (outputChannel < 0 || (size_t)outputChannel >= this->devicePlaybackBuffers.size())
+                {
+                    continue;
+                }
+                outputStage.AddInput(outputChannel, this->mainPlaybackBuffers[i]);
             }
             if (channelSelection.auxInputChannels().size() <= channelSelection.auxOutputChannels().size())
             {
@@ -2059,26 +1902,18 @@ namespace pipedal
                     {
                         continue;
                     }
-                    if (usedOutputChannels.contains(outputChannel))
-                    {
-                        AddMixAddOp(this->deviceCaptureBuffers[inputChannel],this->devicePlaybackBuffers[outputChannel]);
-                    } else {
-                        AddMixCopyOp(this->deviceCaptureBuffers[inputChannel],this->devicePlaybackBuffers[outputChannel]);
-                    }
-                    usedOutputChannels.insert(outputChannel);
+                    outputStage.AddInput(outputChannel, this->deviceCaptureBuffers[inputChannel]);
                 }
             } else if (channelSelection.auxInputChannels().size() >= 2 && channelSelection.auxOutputChannels().size() == 1) {
                 float scale = 1.0/channelSelection.auxInputChannels().size();
                 for (size_t i = 0; i < this->channelSelection.auxOutputChannels().size(); ++i)
                 {
                     size_t outputChannel = this->channelSelection.auxOutputChannels()[i];
-                    if (usedOutputChannels.contains(outputChannel))
+                    if (outputChannel >= this->devicePlaybackBuffers.size())
                     {
-                        AddMixAddOp(scale,this->auxCaptureBuffers[0],this->devicePlaybackBuffers[outputChannel]);
-                    } else {
-                        AddMixCopyOp(scale,this->auxCaptureBuffers[0],this->devicePlaybackBuffers[outputChannel]);
+                        continue;
                     }
-                    usedOutputChannels.insert(outputChannel);
+                    outputStage.AddInput(outputChannel, this->auxCaptureBuffers[0], scale);
                 }
             } 
         }
@@ -2200,6 +2035,15 @@ namespace pipedal
 
         virtual std::vector<float *> &DeviceInputBuffers() override { return this->deviceCaptureBuffers; }
         virtual std::vector<float *> &DeviceOutputBuffers() override { return this->devicePlaybackBuffers; }
+        virtual bool GetDeviceOutputLevel(size_t channel, VuLevel *level) const override
+        {
+            if (channel >= outputStage.GetChannelCount())
+            {
+                return false;
+            }
+            *level = outputStage.GetLevel(channel);
+            return true;
+        }
 
         virtual std::vector<float *> &MainInputBuffers() override { return this->mainCaptureBuffers; }
         virtual std::vector<float *> &MainOutputBuffers() override { return this->mainPlaybackBuffers; }
@@ -2546,6 +2390,100 @@ namespace pipedal
                 assert(std::abs(error) < 4e-5);
             }
         }
+
+        // SIMD conversions must be bit-identical to the scalar conversions, including for out-of-range values.
+        AlsaSampleFormat sampleFormat;
+        GetAlsaSampleFormat(captureFormat, &sampleFormat);
+        for (size_t i = 0; i < bufferSize; ++i)
+        {
+            for (size_t c = 0; c < playbackChannels; ++c)
+            {
+                this->devicePlaybackBuffers[c][i] = 2.5f * i / bufferSize - 1.25f + 1e-3f * c;
+            }
+        }
+        std::vector<uint8_t> expectedRaw;
+        std::vector<float> expectedCapture;
+        for (SimdLevel level : GetSupportedSimdLevels())
+        {
+            playbackConverter = GetAlsaFormatConverter(sampleFormat, level);
+            captureConverter = GetAlsaFormatConverter(sampleFormat, level);
+
+            (this->*copyOutputFn)(bufferSize);
+            memcpy(this->rawCaptureBuffer.data(), this->rawPlaybackBuffer.data(), captureFrameSize * bufferSize);
+            (this->*copyInputFn)(bufferSize);
+
+            std::vector<float> capture;
+            for (size_t c = 0; c < captureChannels; ++c)
+            {
+                capture.insert(capture.end(), deviceCaptureBuffers[c], deviceCaptureBuffers[c] + bufferSize);
+            }
+            if (level == SimdLevel::Scalar)
+            {
+                expectedRaw = rawPlaybackBuffer;
+                expectedCapture = capture;
+            }
+            else
+            {
+                AlsaAssert(rawPlaybackBuffer == expectedRaw);
+                AlsaAssert(memcmp(capture.data(), expectedCapture.data(), capture.size() * sizeof(float)) == 0);
+            }
+        }
+        playbackConverter = GetAlsaFormatConverter(sampleFormat, simdLevel);
+        captureConverter = GetAlsaFormatConverter(sampleFormat, simdLevel);
+
+        // mmap transfers must produce the same results as read/write transfers, for interleaved,
+        // non-interleaved, and strided buffer layouts, at a non-zero offset in the DMA buffer.
+        (this->*copyOutputFn)(bufferSize);
+        memcpy(this->rawCaptureBuffer.data(), this->rawPlaybackBuffer.data(), captureFrameSize * bufferSize);
+        (this->*copyInputFn)(bufferSize);
+        expectedCapture.clear();
+        for (size_t c = 0; c < captureChannels; ++c)
+        {
+            expectedCapture.insert(expectedCapture.end(), deviceCaptureBuffers[c], deviceCaptureBuffers[c] + bufferSize);
+        }
+
+        const snd_pcm_uframes_t offset = 3;
+        const size_t dmaFrames = bufferSize + offset;
+        for (int layout = 0; layout < 3; ++layout)
+        {
+            std::vector<uint8_t> dmaBuffer(dmaFrames * playbackFrameSize * 2);
+            std::vector<snd_pcm_channel_area_t> areas(playbackChannels);
+            for (size_t c = 0; c < playbackChannels; ++c)
+            {
+                switch (layout)
+                {
+                case 0: // interleaved
+                    areas[c].addr = dmaBuffer.data();
+                    areas[c].first = c * playbackSampleSize * 8;
+                    areas[c].step = playbackFrameSize * 8;
+                    break;
+                case 1: // non-interleaved
+                    areas[c].addr = dmaBuffer.data() + c * dmaFrames * playbackSampleSize;
+                    areas[c].first = 0;
+                    areas[c].step = playbackSampleSize * 8;
+                    break;
+                case 2: // strided
+                    areas[c].addr = dmaBuffer.data() + c * dmaFrames * playbackSampleSize * 2;
+                    areas[c].first = playbackSampleSize * 8;
+                    areas[c].step = playbackSampleSize * 2 * 8;
+                    break;
+                }
+            }
+            EncodeMmapAreas(areas.data(), offset, 0, bufferSize);
+            if (layout == 0)
+            {
+                AlsaAssert(memcmp(dmaBuffer.data() + offset * playbackFrameSize, rawPlaybackBuffer.data(), playbackFrameSize * bufferSize) == 0);
+            }
+            for (size_t c = 0; c < captureChannels; ++c)
+            {
+                std::fill(deviceCaptureBuffers[c], deviceCaptureBuffers[c] + bufferSize, 0.0f);
+            }
+            DecodeMmapAreas(areas.data(), offset, 0, bufferSize);
+            for (size_t c = 0; c < captureChannels; ++c)
+            {
+                AlsaAssert(memcmp(deviceCaptureBuffers[c], expectedCapture.data() + c * bufferSize, bufferSize * sizeof(float)) == 0);
+            }
+        }
     }
 
     void test::AlsaFormatEncodeDecodeTest(AudioDriverHost *testDriverHost)
@@ -2555,6 +2493,8 @@ namespace pipedal
             snd_pcm_format_t::SND_PCM_FORMAT_S16_BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S32_LE,
             snd_pcm_format_t::SND_PCM_FORMAT_S32_BE,
+            snd_pcm_format_t::SND_PCM_FORMAT_S24_LE,
+            snd_pcm_format_t::SND_PCM_FORMAT_S24_BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S24_3BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S24_3LE,
             snd_pcm_format_t::SND_PCM_FORMAT_FLOAT_BE,
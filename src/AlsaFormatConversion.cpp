@@ -0,0 +1,906 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "AlsaFormatConversion.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ALSA_CONVERSION_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define ALSA_CONVERSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace pipedal;
+
+// Scale factors are those of the original scalar converters. Note that S24Le/S24Be decode with a scale of 2^-24,
+// but encode with a scale of 0x00FFFFFF; and that S16 encodes in float precision, while S24 and S32 encode in
+// double precision. The SIMD kernels must match exactly.
+static constexpr float S16_DECODE_SCALE = 1.0f / 32768.0f;
+static constexpr float S24_DECODE_SCALE = 1.0f / 16777216.0f;
+static constexpr float S32_DECODE_SCALE = 1.0f / 2147483648.0f;
+static constexpr float S16_ENCODE_SCALE = 32767.0f;
+static constexpr double S24_ENCODE_SCALE = 16777215.0;
+static constexpr double S32_ENCODE_SCALE = 2147483647.0;
+
+namespace
+{
+    using Format = AlsaSampleFormat;
+
+    constexpr bool Is16Bit(Format format)
+    {
+        return format == Format::S16Le || format == Format::S16Be;
+    }
+    constexpr bool Is32BitInt(Format format)
+    {
+        return format == Format::S24Le || format == Format::S24Be || format == Format::S32Le || format == Format::S32Be;
+    }
+    constexpr bool IsPacked24(Format format)
+    {
+        return format == Format::S24_3Le || format == Format::S24_3Be;
+    }
+    constexpr bool IsFloat(Format format)
+    {
+        return format == Format::FloatLe || format == Format::FloatBe;
+    }
+    constexpr bool IsBigEndian(Format format)
+    {
+        return format == Format::S16Be || format == Format::S24Be || format == Format::S24_3Be || format == Format::S32Be || format == Format::FloatBe;
+    }
+    constexpr float DecodeScale(Format format)
+    {
+        return (format == Format::S24Le || format == Format::S24Be) ? S24_DECODE_SCALE : S32_DECODE_SCALE;
+    }
+    constexpr double EncodeScale(Format format)
+    {
+        return (format == Format::S24Le || format == Format::S24Be) ? S24_ENCODE_SCALE : S32_ENCODE_SCALE;
+    }
+
+    inline float Clamp(float v)
+    {
+        if (v > 1.0f)
+            v = 1.0f;
+        else if (v < -1.0f)
+            v = -1.0f;
+        return v;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Scalar reference kernels.
+
+    template <Format FORMAT>
+    inline float DecodeSample(const void *input, size_t i)
+    {
+        if constexpr (Is16Bit(FORMAT))
+        {
+            uint16_t v = ((const uint16_t *)input)[i];
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap16(v);
+            return S16_DECODE_SCALE * (int16_t)v;
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            uint32_t v = ((const uint32_t *)input)[i];
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap32(v);
+            return DecodeScale(FORMAT) * (int32_t)v;
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            const uint8_t *p = (const uint8_t *)input + 3 * i;
+            uint32_t v;
+            if constexpr (IsBigEndian(FORMAT))
+                v = ((uint32_t)p[2] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 24);
+            else
+                v = ((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24);
+            return S32_DECODE_SCALE * (int32_t)v;
+        }
+        else
+        {
+            uint32_t v = ((const uint32_t *)input)[i];
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap32(v);
+            float result;
+            memcpy(&result, &v, sizeof(result));
+            return result;
+        }
+    }
+
+    template <Format FORMAT>
+    inline void EncodeSample(float value, void *output, size_t i)
+    {
+        if constexpr (Is16Bit(FORMAT))
+        {
+            uint16_t v = (uint16_t)(int16_t)(S16_ENCODE_SCALE * Clamp(value));
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap16(v);
+            ((uint16_t *)output)[i] = v;
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            uint32_t v = (uint32_t)(int32_t)(EncodeScale(FORMAT) * (double)Clamp(value));
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap32(v);
+            ((uint32_t *)output)[i] = v;
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            int32_t v = (int32_t)(S32_ENCODE_SCALE * (double)Clamp(value));
+            uint8_t *p = (uint8_t *)output + 3 * i;
+            if constexpr (IsBigEndian(FORMAT))
+            {
+                p[0] = (uint8_t)(v >> 24);
+                p[1] = (uint8_t)(v >> 16);
+                p[2] = (uint8_t)(v >> 8);
+            }
+            else
+            {
+                p[0] = (uint8_t)(v >> 8);
+                p[1] = (uint8_t)(v >> 16);
+                p[2] = (uint8_t)(v >> 24);
+            }
+        }
+        else
+        {
+            // float formats are not clamped.
+            uint32_t v;
+            memcpy(&v, &value, sizeof(v));
+            if constexpr (IsBigEndian(FORMAT))
+                v = __builtin_bswap32(v);
+            ((uint32_t *)output)[i] = v;
+        }
+    }
+
+    template <Format FORMAT>
+    void DecodeScalar(const void *input, float *output, size_t samples)
+    {
+        for (size_t i = 0; i < samples; ++i)
+        {
+            output[i] = DecodeSample<FORMAT>(input, i);
+        }
+    }
+
+    template <Format FORMAT>
+    void EncodeScalar(const float *input, void *output, size_t samples)
+    {
+        for (size_t i = 0; i < samples; ++i)
+        {
+            EncodeSample<FORMAT>(input[i], output, i);
+        }
+    }
+
+    void DeinterleaveScalar(const float *input, float *const *outputs, size_t channels, size_t frames)
+    {
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            for (size_t channel = 0; channel < channels; ++channel)
+            {
+                outputs[channel][frame] = *input++;
+            }
+        }
+    }
+
+    void InterleaveScalar(const float *const *inputs, float *output, size_t channels, size_t frames)
+    {
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            for (size_t channel = 0; channel < channels; ++channel)
+            {
+                *output++ = inputs[channel][frame];
+            }
+        }
+    }
+
+#ifdef ALSA_CONVERSION_X86
+    ////////////////////////////////////////////////////////////////////////////////
+    // SSE2 kernels. SSE2 has no byte shuffle, so packed 24-bit formats use the scalar kernels.
+
+    inline __m128i ByteSwap16Sse2(__m128i v)
+    {
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+    inline __m128i ByteSwap32Sse2(__m128i v)
+    {
+        v = ByteSwap16Sse2(v);
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    inline __m128 ClampSse2(__m128 v)
+    {
+        return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    }
+    // (int32_t)(scale * (double)v) for 4 floats.
+    inline __m128i EncodeInt32Sse2(__m128 v, __m128d scale)
+    {
+        __m128d lo = _mm_mul_pd(_mm_cvtps_pd(v), scale);
+        __m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), scale);
+        return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+    }
+
+    template <Format FORMAT>
+    void DecodeSse2(const void *input, float *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            const __m128 scale = _mm_set1_ps(S16_DECODE_SCALE);
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)((const int16_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap16Sse2(x);
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            const __m128 scale = _mm_set1_ps(DecodeScale(FORMAT));
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)((const int32_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Sse2(x);
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+            }
+        }
+        else if constexpr (IsFloat(FORMAT))
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)((const int32_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Sse2(x);
+                _mm_storeu_si128((__m128i *)(output + i), x);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            output[i] = DecodeSample<FORMAT>(input, i);
+        }
+    }
+
+    template <Format FORMAT>
+    void EncodeSse2(const float *input, void *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            const __m128 scale = _mm_set1_ps(S16_ENCODE_SCALE);
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(ClampSse2(_mm_loadu_ps(input + i)), scale));
+                __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(ClampSse2(_mm_loadu_ps(input + i + 4)), scale));
+                __m128i x = _mm_packs_epi32(lo, hi);
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap16Sse2(x);
+                _mm_storeu_si128((__m128i *)((int16_t *)output + i), x);
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            const __m128d scale = _mm_set1_pd(EncodeScale(FORMAT));
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = EncodeInt32Sse2(ClampSse2(_mm_loadu_ps(input + i)), scale);
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Sse2(x);
+                _mm_storeu_si128((__m128i *)((int32_t *)output + i), x);
+            }
+        }
+        else if constexpr (IsFloat(FORMAT))
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)(input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Sse2(x);
+                _mm_storeu_si128((__m128i *)((int32_t *)output + i), x);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            EncodeSample<FORMAT>(input[i], output, i);
+        }
+    }
+
+    void DeinterleaveSse2(const float *input, float *const *outputs, size_t channels, size_t frames)
+    {
+        if (channels != 2)
+        {
+            DeinterleaveScalar(input, outputs, channels, frames);
+            return;
+        }
+        float *left = outputs[0];
+        float *right = outputs[1];
+        size_t frame = 0;
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            __m128 a = _mm_loadu_ps(input + 2 * frame);
+            __m128 b = _mm_loadu_ps(input + 2 * frame + 4);
+            _mm_storeu_ps(left + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        for (; frame < frames; ++frame)
+        {
+            left[frame] = input[2 * frame];
+            right[frame] = input[2 * frame + 1];
+        }
+    }
+
+    void InterleaveSse2(const float *const *inputs, float *output, size_t channels, size_t frames)
+    {
+        if (channels != 2)
+        {
+            InterleaveScalar(inputs, output, channels, frames);
+            return;
+        }
+        const float *left = inputs[0];
+        const float *right = inputs[1];
+        size_t frame = 0;
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            __m128 l = _mm_loadu_ps(left + frame);
+            __m128 r = _mm_loadu_ps(right + frame);
+            _mm_storeu_ps(output + 2 * frame, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(output + 2 * frame + 4, _mm_unpackhi_ps(l, r));
+        }
+        for (; frame < frames; ++frame)
+        {
+            output[2 * frame] = left[frame];
+            output[2 * frame + 1] = right[frame];
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // AVX2 kernels. Selected at runtime, so they are compiled with a target attribute rather than -mavx2.
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+    AVX2_TARGET inline __m256i ByteSwap32Avx2(__m256i v)
+    {
+        const __m256i mask = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        return _mm256_shuffle_epi8(v, mask);
+    }
+    AVX2_TARGET inline __m256i ByteSwap16Avx2(__m256i v)
+    {
+        const __m256i mask = _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        return _mm256_shuffle_epi8(v, mask);
+    }
+    AVX2_TARGET inline __m256 ClampAvx2(__m256 v)
+    {
+        return _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+    }
+    // (int32_t)(scale * (double)v) for 8 floats.
+    AVX2_TARGET inline __m256i EncodeInt32Avx2(__m256 v, __m256d scale)
+    {
+        __m256d lo = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), scale);
+        __m256d hi = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), scale);
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi), 1);
+    }
+
+    // Byte shuffles between 4 packed 24-bit samples and 4 int32 values (with the 24 bits in the high bytes).
+    template <Format FORMAT>
+    AVX2_TARGET inline __m128i UnpackS24_3Mask()
+    {
+        if constexpr (IsBigEndian(FORMAT))
+            return _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+        else
+            return _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    }
+    template <Format FORMAT>
+    AVX2_TARGET inline __m128i PackS24_3Mask()
+    {
+        if constexpr (IsBigEndian(FORMAT))
+            return _mm_setr_epi8(3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1);
+        else
+            return _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+    }
+
+    template <Format FORMAT>
+    AVX2_TARGET void DecodeAvx2(const void *input, float *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            const __m256 scale = _mm256_set1_ps(S16_DECODE_SCALE);
+            for (; i + 16 <= samples; i += 16)
+            {
+                __m256i x = _mm256_loadu_si256((const __m256i *)((const int16_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap16Avx2(x);
+                __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+                __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+                _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            const __m256 scale = _mm256_set1_ps(DecodeScale(FORMAT));
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = _mm256_loadu_si256((const __m256i *)((const int32_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Avx2(x);
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+            }
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            const __m128i mask = UnpackS24_3Mask<FORMAT>();
+            const __m256 scale = _mm256_set1_ps(S32_DECODE_SCALE);
+            const uint8_t *p = (const uint8_t *)input;
+            // Each 16-byte load covers 4 samples plus 4 bytes of the next, so stop while those are still in range.
+            for (; i + 10 <= samples; i += 8)
+            {
+                __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 3 * i)), mask);
+                __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 3 * i + 12)), mask);
+                __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+            }
+        }
+        else
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = _mm256_loadu_si256((const __m256i *)((const int32_t *)input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Avx2(x);
+                _mm256_storeu_si256((__m256i *)(output + i), x);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            output[i] = DecodeSample<FORMAT>(input, i);
+        }
+    }
+
+    template <Format FORMAT>
+    AVX2_TARGET void EncodeAvx2(const float *input, void *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            const __m256 scale = _mm256_set1_ps(S16_ENCODE_SCALE);
+            for (; i + 16 <= samples; i += 16)
+            {
+                __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(ClampAvx2(_mm256_loadu_ps(input + i)), scale));
+                __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(ClampAvx2(_mm256_loadu_ps(input + i + 8)), scale));
+                // packs works within 128-bit lanes; restore sample order.
+                __m256i x = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap16Avx2(x);
+                _mm256_storeu_si256((__m256i *)((int16_t *)output + i), x);
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            const __m256d scale = _mm256_set1_pd(EncodeScale(FORMAT));
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = EncodeInt32Avx2(ClampAvx2(_mm256_loadu_ps(input + i)), scale);
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Avx2(x);
+                _mm256_storeu_si256((__m256i *)((int32_t *)output + i), x);
+            }
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            const __m128i mask = PackS24_3Mask<FORMAT>();
+            const __m256d scale = _mm256_set1_pd(S32_ENCODE_SCALE);
+            uint8_t *p = (uint8_t *)output;
+            // 16-byte stores write 4 bytes past each group of 4 samples, which the next store overwrites.
+            for (; i + 10 <= samples; i += 8)
+            {
+                __m256i x = EncodeInt32Avx2(ClampAvx2(_mm256_loadu_ps(input + i)), scale);
+                _mm_storeu_si128((__m128i *)(p + 3 * i), _mm_shuffle_epi8(_mm256_castsi256_si128(x), mask));
+                _mm_storeu_si128((__m128i *)(p + 3 * i + 12), _mm_shuffle_epi8(_mm256_extracti128_si256(x, 1), mask));
+            }
+        }
+        else
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = _mm256_loadu_si256((const __m256i *)(input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = ByteSwap32Avx2(x);
+                _mm256_storeu_si256((__m256i *)((int32_t *)output + i), x);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            EncodeSample<FORMAT>(input[i], output, i);
+        }
+    }
+#undef AVX2_TARGET
+
+#endif
+
+#ifdef ALSA_CONVERSION_NEON
+    ////////////////////////////////////////////////////////////////////////////////
+    // NEON kernels.
+
+    inline float32x4_t ClampNeon(float32x4_t v)
+    {
+        return vminq_f32(vmaxq_f32(v, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+    }
+    // (int32_t)(scale * (double)v) for 4 floats.
+    inline int32x4_t EncodeInt32Neon(float32x4_t v, double scale)
+    {
+        float64x2_t lo = vmulq_n_f64(vcvt_f64_f32(vget_low_f32(v)), scale);
+        float64x2_t hi = vmulq_n_f64(vcvt_high_f64_f32(v), scale);
+        return vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)), vmovn_s64(vcvtq_s64_f64(hi)));
+    }
+
+    template <Format FORMAT>
+    void DecodeNeon(const void *input, float *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                uint8x16_t raw = vld1q_u8((const uint8_t *)input + 2 * i);
+                if constexpr (IsBigEndian(FORMAT))
+                    raw = vrev16q_u8(raw);
+                int16x8_t x = vreinterpretq_s16_u8(raw);
+                vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), S16_DECODE_SCALE));
+                vst1q_f32(output + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(x)), S16_DECODE_SCALE));
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t raw = vld1q_u8((const uint8_t *)input + 4 * i);
+                if constexpr (IsBigEndian(FORMAT))
+                    raw = vrev32q_u8(raw);
+                vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u8(raw)), DecodeScale(FORMAT)));
+            }
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            const uint8x16_t zero = vdupq_n_u8(0);
+            for (; i + 16 <= samples; i += 16)
+            {
+                uint8x16x3_t b = vld3q_u8((const uint8_t *)input + 3 * i);
+                uint8x16_t low = IsBigEndian(FORMAT) ? b.val[2] : b.val[0];
+                uint8x16_t mid = b.val[1];
+                uint8x16_t high = IsBigEndian(FORMAT) ? b.val[0] : b.val[2];
+                // (low << 8) and (mid | high << 8), as 16-bit values; then combined as 32-bit values.
+                uint16x8_t lo0 = vreinterpretq_u16_u8(vzip1q_u8(zero, low));
+                uint16x8_t lo1 = vreinterpretq_u16_u8(vzip2q_u8(zero, low));
+                uint16x8_t hi0 = vreinterpretq_u16_u8(vzip1q_u8(mid, high));
+                uint16x8_t hi1 = vreinterpretq_u16_u8(vzip2q_u8(mid, high));
+                float32x4_t s0 = vcvtq_f32_s32(vreinterpretq_s32_u16(vzip1q_u16(lo0, hi0)));
+                float32x4_t s1 = vcvtq_f32_s32(vreinterpretq_s32_u16(vzip2q_u16(lo0, hi0)));
+                float32x4_t s2 = vcvtq_f32_s32(vreinterpretq_s32_u16(vzip1q_u16(lo1, hi1)));
+                float32x4_t s3 = vcvtq_f32_s32(vreinterpretq_s32_u16(vzip2q_u16(lo1, hi1)));
+                vst1q_f32(output + i, vmulq_n_f32(s0, S32_DECODE_SCALE));
+                vst1q_f32(output + i + 4, vmulq_n_f32(s1, S32_DECODE_SCALE));
+                vst1q_f32(output + i + 8, vmulq_n_f32(s2, S32_DECODE_SCALE));
+                vst1q_f32(output + i + 12, vmulq_n_f32(s3, S32_DECODE_SCALE));
+            }
+        }
+        else
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t raw = vld1q_u8((const uint8_t *)input + 4 * i);
+                if constexpr (IsBigEndian(FORMAT))
+                    raw = vrev32q_u8(raw);
+                vst1q_u8((uint8_t *)(output + i), raw);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            output[i] = DecodeSample<FORMAT>(input, i);
+        }
+    }
+
+    template <Format FORMAT>
+    void EncodeNeon(const float *input, void *output, size_t samples)
+    {
+        size_t i = 0;
+        if constexpr (Is16Bit(FORMAT))
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                int32x4_t lo = vcvtq_s32_f32(vmulq_n_f32(ClampNeon(vld1q_f32(input + i)), S16_ENCODE_SCALE));
+                int32x4_t hi = vcvtq_s32_f32(vmulq_n_f32(ClampNeon(vld1q_f32(input + i + 4)), S16_ENCODE_SCALE));
+                uint8x16_t x = vreinterpretq_u8_s16(vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = vrev16q_u8(x);
+                vst1q_u8((uint8_t *)output + 2 * i, x);
+            }
+        }
+        else if constexpr (Is32BitInt(FORMAT))
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t x = vreinterpretq_u8_s32(EncodeInt32Neon(ClampNeon(vld1q_f32(input + i)), EncodeScale(FORMAT)));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = vrev32q_u8(x);
+                vst1q_u8((uint8_t *)output + 4 * i, x);
+            }
+        }
+        else if constexpr (IsPacked24(FORMAT))
+        {
+            for (; i + 16 <= samples; i += 16)
+            {
+                uint16x8_t s0 = vreinterpretq_u16_s32(EncodeInt32Neon(ClampNeon(vld1q_f32(input + i)), S32_ENCODE_SCALE));
+                uint16x8_t s1 = vreinterpretq_u16_s32(EncodeInt32Neon(ClampNeon(vld1q_f32(input + i + 4)), S32_ENCODE_SCALE));
+                uint16x8_t s2 = vreinterpretq_u16_s32(EncodeInt32Neon(ClampNeon(vld1q_f32(input + i + 8)), S32_ENCODE_SCALE));
+                uint16x8_t s3 = vreinterpretq_u16_s32(EncodeInt32Neon(ClampNeon(vld1q_f32(input + i + 12)), S32_ENCODE_SCALE));
+                // low and high 16-bit halves of each sample, then bytes 1, 2 and 3.
+                uint8x16_t l0 = vreinterpretq_u8_u16(vuzp1q_u16(s0, s1));
+                uint8x16_t h0 = vreinterpretq_u8_u16(vuzp2q_u16(s0, s1));
+                uint8x16_t l1 = vreinterpretq_u8_u16(vuzp1q_u16(s2, s3));
+                uint8x16_t h1 = vreinterpretq_u8_u16(vuzp2q_u16(s2, s3));
+                uint8x16_t byte1 = vuzp2q_u8(l0, l1);
+                uint8x16_t byte2 = vuzp1q_u8(h0, h1);
+                uint8x16_t byte3 = vuzp2q_u8(h0, h1);
+                uint8x16x3_t b;
+                if constexpr (IsBigEndian(FORMAT))
+                {
+                    b.val[0] = byte3;
+                    b.val[1] = byte2;
+                    b.val[2] = byte1;
+                }
+                else
+                {
+                    b.val[0] = byte1;
+                    b.val[1] = byte2;
+                    b.val[2] = byte3;
+                }
+                vst3q_u8((uint8_t *)output + 3 * i, b);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t x = vld1q_u8((const uint8_t *)(input + i));
+                if constexpr (IsBigEndian(FORMAT))
+                    x = vrev32q_u8(x);
+                vst1q_u8((uint8_t *)output + 4 * i, x);
+            }
+        }
+        for (; i < samples; ++i)
+        {
+            EncodeSample<FORMAT>(input[i], output, i);
+        }
+    }
+
+    void DeinterleaveNeon(const float *input, float *const *outputs, size_t channels, size_t frames)
+    {
+        if (channels != 2)
+        {
+            DeinterleaveScalar(input, outputs, channels, frames);
+            return;
+        }
+        float *left = outputs[0];
+        float *right = outputs[1];
+        size_t frame = 0;
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            float32x4x2_t x = vld2q_f32(input + 2 * frame);
+            vst1q_f32(left + frame, x.val[0]);
+            vst1q_f32(right + frame, x.val[1]);
+        }
+        for (; frame < frames; ++frame)
+        {
+            left[frame] = input[2 * frame];
+            right[frame] = input[2 * frame + 1];
+        }
+    }
+
+    void InterleaveNeon(const float *const *inputs, float *output, size_t channels, size_t frames)
+    {
+        if (channels != 2)
+        {
+            InterleaveScalar(inputs, output, channels, frames);
+            return;
+        }
+        const float *left = inputs[0];
+        const float *right = inputs[1];
+        size_t frame = 0;
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            float32x4x2_t x;
+            x.val[0] = vld1q_f32(left + frame);
+            x.val[1] = vld1q_f32(right + frame);
+            vst2q_f32(output + 2 * frame, x);
+        }
+        for (; frame < frames; ++frame)
+        {
+            output[2 * frame] = left[frame];
+            output[2 * frame + 1] = right[frame];
+        }
+    }
+#endif
+
+    template <Format FORMAT>
+    AlsaFormatConverter MakeConverter(SimdLevel level)
+    {
+        AlsaFormatConverter result;
+        result.decode = &DecodeScalar<FORMAT>;
+        result.encode = &EncodeScalar<FORMAT>;
+        result.deinterleave = &DeinterleaveScalar;
+        result.interleave = &InterleaveScalar;
+        switch (level)
+        {
+#ifdef ALSA_CONVERSION_X86
+        case SimdLevel::Avx2:
+            result.decode = &DecodeAvx2<FORMAT>;
+            result.encode = &EncodeAvx2<FORMAT>;
+            result.deinterleave = &DeinterleaveSse2;
+            result.interleave = &InterleaveSse2;
+            break;
+        case SimdLevel::Sse2:
+            result.decode = &DecodeSse2<FORMAT>;
+            result.encode = &EncodeSse2<FORMAT>;
+            result.deinterleave = &DeinterleaveSse2;
+            result.interleave = &InterleaveSse2;
+            break;
+#endif
+#ifdef ALSA_CONVERSION_NEON
+        case SimdLevel::Neon:
+            result.decode = &DecodeNeon<FORMAT>;
+            result.encode = &EncodeNeon<FORMAT>;
+            result.deinterleave = &DeinterleaveNeon;
+            result.interleave = &InterleaveNeon;
+            break;
+#endif
+        default:
+            break;
+        }
+        return result;
+    }
+}
+
+SimdLevel pipedal::GetBestSimdLevel()
+{
+#if defined(ALSA_CONVERSION_X86)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SimdLevel::Avx2;
+    }
+    return SimdLevel::Sse2;
+#elif defined(ALSA_CONVERSION_NEON)
+    return SimdLevel::Neon;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+std::vector<SimdLevel> pipedal::GetSupportedSimdLevels()
+{
+    std::vector<SimdLevel> result;
+    result.push_back(SimdLevel::Scalar);
+#if defined(ALSA_CONVERSION_X86)
+    result.push_back(SimdLevel::Sse2);
+    if (__builtin_cpu_supports("avx2"))
+    {
+        result.push_back(SimdLevel::Avx2);
+    }
+#elif defined(ALSA_CONVERSION_NEON)
+    result.push_back(SimdLevel::Neon);
+#endif
+    return result;
+}
+
+const char *pipedal::GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Avx2:
+        return "avx2";
+    case SimdLevel::Neon:
+        return "neon";
+    default:
+        return "?";
+    }
+}
+
+const char *pipedal::GetAlsaSampleFormatName(AlsaSampleFormat format)
+{
+    switch (format)
+    {
+    case Format::S16Le:
+        return "S16_LE";
+    case Format::S16Be:
+        return "S16_BE";
+    case Format::S24Le:
+        return "S24_LE";
+    case Format::S24Be:
+        return "S24_BE";
+    case Format::S24_3Le:
+        return "S24_3LE";
+    case Format::S24_3Be:
+        return "S24_3BE";
+    case Format::S32Le:
+        return "S32_LE";
+    case Format::S32Be:
+        return "S32_BE";
+    case Format::FloatLe:
+        return "FLOAT_LE";
+    case Format::FloatBe:
+        return "FLOAT_BE";
+    default:
+        return "?";
+    }
+}
+
+size_t pipedal::GetAlsaSampleSize(AlsaSampleFormat format)
+{
+    switch (format)
+    {
+    case Format::S16Le:
+    case Format::S16Be:
+        return 2;
+    case Format::S24_3Le:
+    case Format::S24_3Be:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+AlsaFormatConverter pipedal::GetAlsaFormatConverter(AlsaSampleFormat format, SimdLevel level)
+{
+    switch (format)
+    {
+    case Format::S16Le:
+        return MakeConverter<Format::S16Le>(level);
+    case Format::S16Be:
+        return MakeConverter<Format::S16Be>(level);
+    case Format::S24Le:
+        return MakeConverter<Format::S24Le>(level);
+    case Format::S24Be:
+        return MakeConverter<Format::S24Be>(level);
+    case Format::S24_3Le:
+        return MakeConverter<Format::S24_3Le>(level);
+    case Format::S24_3Be:
+        return MakeConverter<Format::S24_3Be>(level);
+    case Format::S32Le:
+        return MakeConverter<Format::S32Le>(level);
+    case Format::S32Be:
+        return MakeConverter<Format::S32Be>(level);
+    case Format::FloatLe:
+        return MakeConverter<Format::FloatLe>(level);
+    case Format::FloatBe:
+        return MakeConverter<Format::FloatBe>(level);
+    default:
+        return AlsaFormatConverter();
+    }
+}
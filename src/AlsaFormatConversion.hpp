@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pipedal
+{
+    // Interleaved sample formats supported by the ALSA driver.
+    enum class AlsaSampleFormat
+    {
+        S16Le,
+        S16Be,
+        S24Le, // 24 bits in the low bits of an int32_t.
+        S24Be,
+        S24_3Le, // packed 3-byte samples.
+        S24_3Be,
+        S32Le,
+        S32Be,
+        FloatLe,
+        FloatBe
+    };
+
+    // Instruction set used by sample format conversion kernels.
+    enum class SimdLevel
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    // The best instruction set supported by the current CPU.
+    SimdLevel GetBestSimdLevel();
+    // Every instruction set supported by the current CPU, starting with Scalar.
+    std::vector<SimdLevel> GetSupportedSimdLevels();
+    const char *GetSimdLevelName(SimdLevel level);
+
+    const char *GetAlsaSampleFormatName(AlsaSampleFormat format);
+    size_t GetAlsaSampleSize(AlsaSampleFormat format);
+
+    /**
+     * @brief Conversion kernels for one ALSA sample format.
+     *
+     * decode converts raw device samples to floats. encode converts floats to raw device samples,
+     * clamping integer formats to [-1,1]. Both treat interleaved frames as a flat array of samples.
+     * deinterleave and interleave move samples between an interleaved float buffer and per-channel buffers.
+     *
+     * Every SimdLevel produces results that are bit-identical to the Scalar kernels, for finite input.
+     */
+    struct AlsaFormatConverter
+    {
+        using DecodeFunction = void (*)(const void *input, float *output, size_t samples);
+        using EncodeFunction = void (*)(const float *input, void *output, size_t samples);
+        using DeinterleaveFunction = void (*)(const float *input, float *const *outputs, size_t channels, size_t frames);
+        using InterleaveFunction = void (*)(const float *const *inputs, float *output, size_t channels, size_t frames);
+
+        DecodeFunction decode = nullptr;
+        EncodeFunction encode = nullptr;
+        DeinterleaveFunction deinterleave = nullptr;
+        InterleaveFunction interleave = nullptr;
+    };
+
+    // Kernels for the requested instruction set. Falls back to Scalar kernels if level is not available on this architecture.
+    AlsaFormatConverter GetAlsaFormatConverter(AlsaSampleFormat format, SimdLevel level);
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "AlsaFormatConversion.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace pipedal;
+using namespace std;
+
+static const AlsaSampleFormat allFormats[] = {
+    AlsaSampleFormat::S16Le,
+    AlsaSampleFormat::S16Be,
+    AlsaSampleFormat::S24Le,
+    AlsaSampleFormat::S24Be,
+    AlsaSampleFormat::S24_3Le,
+    AlsaSampleFormat::S24_3Be,
+    AlsaSampleFormat::S32Le,
+    AlsaSampleFormat::S32Be,
+    AlsaSampleFormat::FloatLe,
+    AlsaSampleFormat::FloatBe,
+};
+
+static std::vector<float> MakeTestSignal(size_t samples, std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+    std::vector<float> result(samples);
+    for (size_t i = 0; i < samples; ++i)
+    {
+        result[i] = distribution(random);
+    }
+    // full scale, clipped, and signed zero values.
+    const float specialValues[] = {1.0f, -1.0f, 1.0001f, -1.0001f, 0.0f, -0.0f, 0.99999994f, -0.99999994f};
+    for (size_t i = 0; i < std::size(specialValues) && i < samples; ++i)
+    {
+        result[i] = specialValues[i];
+    }
+    return result;
+}
+
+TEST_CASE("ALSA format conversion matches scalar conversion", "[alsa_format_conversion][Build]")
+{
+    std::mt19937 random(1234);
+    // odd sizes exercise the scalar tails of the SIMD kernels.
+    const size_t sampleCounts[] = {0, 1, 7, 31, 64, 129, 1027};
+
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        for (AlsaSampleFormat format : allFormats)
+        {
+            INFO(GetSimdLevelName(level) << " " << GetAlsaSampleFormatName(format));
+            AlsaFormatConverter scalar = GetAlsaFormatConverter(format, SimdLevel::Scalar);
+            AlsaFormatConverter converter = GetAlsaFormatConverter(format, level);
+            size_t sampleSize = GetAlsaSampleSize(format);
+
+            for (size_t samples : sampleCounts)
+            {
+                // encode, with a guard byte after the output to catch overruns.
+                std::vector<float> signal = MakeTestSignal(samples, random);
+                std::vector<uint8_t> expectedRaw(samples * sampleSize + 1, 0xA5);
+                std::vector<uint8_t> actualRaw(samples * sampleSize + 1, 0xA5);
+                scalar.encode(signal.data(), expectedRaw.data(), samples);
+                converter.encode(signal.data(), actualRaw.data(), samples);
+                REQUIRE(memcmp(expectedRaw.data(), actualRaw.data(), actualRaw.size()) == 0);
+
+                // decode arbitrary bit patterns.
+                std::vector<uint8_t> raw(samples * sampleSize + 1);
+                for (auto &b : raw)
+                {
+                    b = (uint8_t)random();
+                }
+                std::vector<float> expected(samples + 1, 7.0f);
+                std::vector<float> actual(samples + 1, 7.0f);
+                scalar.decode(raw.data(), expected.data(), samples);
+                converter.decode(raw.data(), actual.data(), samples);
+                REQUIRE(memcmp(expected.data(), actual.data(), actual.size() * sizeof(float)) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("ALSA format conversion interleaving", "[alsa_format_conversion][Build]")
+{
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        AlsaFormatConverter converter = GetAlsaFormatConverter(AlsaSampleFormat::FloatLe, level);
+        for (size_t channels = 1; channels <= 4; ++channels)
+        {
+            const size_t frames = 67;
+            std::vector<float> interleaved(frames * channels);
+            for (size_t i = 0; i < interleaved.size(); ++i)
+            {
+                interleaved[i] = (float)i;
+            }
+            std::vector<std::vector<float>> channelData(channels, std::vector<float>(frames));
+            std::vector<float *> channelPointers;
+            for (auto &data : channelData)
+            {
+                channelPointers.push_back(data.data());
+            }
+            converter.deinterleave(interleaved.data(), channelPointers.data(), channels, frames);
+            for (size_t frame = 0; frame < frames; ++frame)
+            {
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    REQUIRE(channelData[c][frame] == interleaved[frame * channels + c]);
+                }
+            }
+            std::vector<float> result(frames * channels);
+            converter.interleave(channelPointers.data(), result.data(), channels, frames);
+            REQUIRE(result == interleaved);
+        }
+    }
+}
+
+// Not run by default. Reports the cost of converting one stereo frame, in each direction.
+TEST_CASE("ALSA format conversion benchmark", "[alsa_format_conversion_benchmark]")
+{
+    using clock_t = std::chrono::steady_clock;
+    constexpr size_t CHANNELS = 2;
+    constexpr size_t FRAMES = 64;
+    constexpr size_t ITERATIONS = 200000;
+
+    std::mt19937 random(1234);
+    std::vector<float> signal = MakeTestSignal(FRAMES * CHANNELS, random);
+    std::vector<float> interleaved(FRAMES * CHANNELS);
+    std::vector<uint8_t> raw(FRAMES * CHANNELS * 4);
+    std::vector<std::vector<float>> channelData(CHANNELS, std::vector<float>(FRAMES));
+    std::vector<float *> channelPointers;
+    for (size_t c = 0; c < CHANNELS; ++c)
+    {
+        memcpy(channelData[c].data(), signal.data() + c * FRAMES, FRAMES * sizeof(float));
+        channelPointers.push_back(channelData[c].data());
+    }
+
+    cout << "ALSA format conversion, ns/frame (" << CHANNELS << " channels, " << FRAMES << " frames)" << endl;
+    cout << setw(10) << "format" << setw(10) << "simd" << setw(10) << "capture" << setw(10) << "playback" << endl;
+    cout << fixed << setprecision(2);
+    for (AlsaSampleFormat format : allFormats)
+    {
+        for (SimdLevel level : GetSupportedSimdLevels())
+        {
+            AlsaFormatConverter converter = GetAlsaFormatConverter(format, level);
+
+            auto start = clock_t::now();
+            for (size_t i = 0; i < ITERATIONS; ++i)
+            {
+                converter.interleave(channelPointers.data(), interleaved.data(), CHANNELS, FRAMES);
+                converter.encode(interleaved.data(), raw.data(), FRAMES * CHANNELS);
+            }
+            double playbackNs = std::chrono::duration<double, std::nano>(clock_t::now() - start).count();
+
+            start = clock_t::now();
+            for (size_t i = 0; i < ITERATIONS; ++i)
+            {
+                converter.decode(raw.data(), interleaved.data(), FRAMES * CHANNELS);
+                converter.deinterleave(interleaved.data(), channelPointers.data(), CHANNELS, FRAMES);
+            }
+            double captureNs = std::chrono::duration<double, std::nano>(clock_t::now() - start).count();
+
+            cout << setw(10) << GetAlsaSampleFormatName(format)
+                 << setw(10) << GetSimdLevelName(level)
+                 << setw(10) << captureNs / (ITERATIONS * FRAMES)
+                 << setw(10) << playbackNs / (ITERATIONS * FRAMES)
+                 << endl;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "AlsaOutputStage.hpp"
+#include "PiPedalCommon.hpp"
+#include <cmath>
+
+using namespace pipedal;
+
+void AlsaOutputStage::Reset(size_t channels)
+{
+    this->channels.clear();
+    this->channels.resize(channels);
+}
+
+void AlsaOutputStage::AddInput(size_t channel, const float *input, float gain)
+{
+    channels[channel].inputs.push_back(MixInput{input, gain});
+}
+
+// Store mix(i) to the device buffer (and the interleaved buffer), and return the level of the result.
+template <bool INTERLEAVE, typename MIX>
+static inline VuLevel MixChannel(float *PIPEDAL_RESTRICT output, float *PIPEDAL_RESTRICT interleaved, size_t stride, size_t frames, MIX mix)
+{
+    float peak = 0;
+    float sumOfSquares = 0;
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float value = mix(i);
+        output[i] = value;
+        if constexpr (INTERLEAVE)
+        {
+            interleaved[i * stride] = value;
+        }
+        float magnitude = std::fabs(value);
+        if (magnitude > peak)
+        {
+            peak = magnitude;
+        }
+        sumOfSquares += value * value;
+    }
+    VuLevel result;
+    result.peak = peak;
+    result.sumOfSquares = sumOfSquares;
+    return result;
+}
+
+template <bool INTERLEAVE, typename INPUTS>
+static VuLevel MixChannel(const INPUTS &inputs, float *output, float *interleaved, size_t stride, size_t frames)
+{
+    // The common cases (a copy, a copy plus one aux input) get their own loops; the sum is accumulated
+    // in the order in which inputs were added, which matches the order of the original copy/add operations.
+    switch (inputs.size())
+    {
+    case 0:
+        return MixChannel<INTERLEAVE>(output, interleaved, stride, frames, [output](size_t i)
+                                      { return output[i]; });
+    case 1:
+    {
+        const float *in0 = inputs[0].buffer;
+        float gain0 = inputs[0].gain;
+        if (gain0 == 1.0f)
+        {
+            return MixChannel<INTERLEAVE>(output, interleaved, stride, frames, [in0](size_t i)
+                                          { return in0[i]; });
+        }
+        return MixChannel<INTERLEAVE>(output, interleaved, stride, frames, [in0, gain0](size_t i)
+                                      { return gain0 * in0[i]; });
+    }
+    case 2:
+    {
+        const float *in0 = inputs[0].buffer;
+        const float *in1 = inputs[1].buffer;
+        float gain0 = inputs[0].gain;
+        float gain1 = inputs[1].gain;
+        return MixChannel<INTERLEAVE>(output, interleaved, stride, frames, [=](size_t i)
+                                      { return gain0 * in0[i] + gain1 * in1[i]; });
+    }
+    default:
+        return MixChannel<INTERLEAVE>(output, interleaved, stride, frames, [&inputs](size_t i)
+                                      {
+            float value = inputs[0].gain * inputs[0].buffer[i];
+            for (size_t j = 1; j < inputs.size(); ++j)
+            {
+                value += inputs[j].gain * inputs[j].buffer[i];
+            }
+            return value; });
+    }
+}
+
+void AlsaOutputStage::Process(float *const *deviceBuffers, float *interleavedOutput, size_t frames)
+{
+    size_t nChannels = channels.size();
+    for (size_t c = 0; c < nChannels; ++c)
+    {
+        Channel &channel = channels[c];
+        if (interleavedOutput)
+        {
+            channel.level = MixChannel<true>(channel.inputs, deviceBuffers[c], interleavedOutput + c, nChannels, frames);
+        }
+        else
+        {
+            channel.level = MixChannel<false>(channel.inputs, deviceBuffers[c], nullptr, nChannels, frames);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "VuMeterKernels.hpp"
+
+namespace pipedal
+{
+    /**
+     * @brief The final mixing stage of ALSA output.
+     *
+     * A mix matrix that routes main and aux outputs to device output channels. In a single pass over
+     * each device channel, Process() mixes the channel's inputs into its device buffer, measures the
+     * channel's peak and RMS levels, and writes the channel into an interleaved buffer ready for format conversion.
+     *
+     * A device channel with no inputs passes the current contents of its device buffer through unchanged.
+     */
+    class AlsaOutputStage
+    {
+    public:
+        void Reset(size_t channels);
+
+        // Add gain*input to a device output channel. Inputs are summed in the order in which they were added.
+        void AddInput(size_t channel, const float *input, float gain = 1.0f);
+
+        size_t GetChannelCount() const { return channels.size(); }
+        size_t GetInputCount(size_t channel) const { return channels[channel].inputs.size(); }
+
+        // Mix one period. interleavedOutput may be null if interleaved output is not required.
+        void Process(float *const *deviceBuffers, float *interleavedOutput, size_t frames);
+
+        // Levels of a channel during the last call to Process().
+        const VuLevel &GetLevel(size_t channel) const { return channels[channel].level; }
+
+    private:
+        struct MixInput
+        {
+            const float *buffer;
+            float gain;
+        };
+        struct Channel
+        {
+            std::vector<MixInput> inputs;
+            VuLevel level;
+        };
+        std::vector<Channel> channels;
+    };
+}
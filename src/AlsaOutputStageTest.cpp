@@ -0,0 +1,153 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "AlsaOutputStage.hpp"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    struct TestBuffers
+    {
+        TestBuffers(size_t count, size_t frames, std::mt19937 &random)
+        {
+            std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+            data.resize(count, std::vector<float>(frames));
+            for (auto &buffer : data)
+            {
+                for (auto &v : buffer)
+                {
+                    v = distribution(random);
+                }
+                pointers.push_back(buffer.data());
+            }
+        }
+        std::vector<std::vector<float>> data;
+        std::vector<float *> pointers;
+    };
+
+    float Peak(const float *buffer, size_t frames)
+    {
+        float result = 0;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            result = std::max(result, std::fabs(buffer[i]));
+        }
+        return result;
+    }
+    double SumOfSquares(const float *buffer, size_t frames)
+    {
+        double result = 0;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            result += (double)buffer[i] * buffer[i];
+        }
+        return result;
+    }
+}
+
+TEST_CASE("ALSA output stage matches sequential mix operations", "[alsa_output_stage][Build]")
+{
+    std::mt19937 random(1234);
+    const size_t frames = 67;
+    const size_t deviceChannels = 4;
+    TestBuffers inputs(5, frames, random);
+
+    for (bool interleave : {false, true})
+    {
+        TestBuffers device(deviceChannels, frames, random);
+        TestBuffers expected = device;
+        for (size_t c = 0; c < deviceChannels; ++c)
+        {
+            expected.pointers[c] = expected.data[c].data();
+        }
+
+        // channel 0: copy. channel 1: copy + add. channel 2: scaled copy + scaled add + add. channel 3: no inputs.
+        AlsaOutputStage stage;
+        stage.Reset(deviceChannels);
+        stage.AddInput(0, inputs.pointers[0]);
+        stage.AddInput(1, inputs.pointers[1]);
+        stage.AddInput(1, inputs.pointers[2]);
+        stage.AddInput(2, inputs.pointers[3], 0.5f);
+        stage.AddInput(2, inputs.pointers[4], 0.25f);
+        stage.AddInput(2, inputs.pointers[0]);
+        REQUIRE(stage.GetChannelCount() == deviceChannels);
+        REQUIRE(stage.GetInputCount(2) == 3);
+        REQUIRE(stage.GetInputCount(3) == 0);
+
+        // the mix operations that the output stage replaces.
+        float **out = expected.pointers.data();
+        float **in = inputs.pointers.data();
+        for (size_t i = 0; i < frames; ++i)
+        {
+            out[0][i] = in[0][i];
+            out[1][i] = in[1][i];
+            out[1][i] += in[2][i];
+            out[2][i] = 0.5f * in[3][i];
+            out[2][i] += 0.25f * in[4][i];
+            out[2][i] += in[0][i];
+        }
+
+        // guard value after the interleaved output catches overruns.
+        std::vector<float> interleaved(frames * deviceChannels + 1, 7.0f);
+        stage.Process(device.pointers.data(), interleave ? interleaved.data() : nullptr, frames);
+
+        for (size_t c = 0; c < deviceChannels; ++c)
+        {
+            INFO("channel " << c);
+            REQUIRE(memcmp(device.data[c].data(), expected.data[c].data(), frames * sizeof(float)) == 0);
+            REQUIRE(stage.GetLevel(c).peak == Peak(expected.pointers[c], frames));
+            REQUIRE(stage.GetLevel(c).sumOfSquares == Approx(SumOfSquares(expected.pointers[c], frames)).epsilon(1E-5));
+            if (interleave)
+            {
+                for (size_t i = 0; i < frames; ++i)
+                {
+                    REQUIRE(interleaved[i * deviceChannels + c] == expected.data[c][i]);
+                }
+            }
+        }
+        REQUIRE(interleaved.back() == 7.0f);
+    }
+}
+
+TEST_CASE("ALSA output stage levels follow the last period", "[alsa_output_stage][Build]")
+{
+    const size_t frames = 16;
+    std::vector<float> input(frames, 0.0f);
+    std::vector<float> output(frames, 0.0f);
+    float *outputs[] = {output.data()};
+
+    AlsaOutputStage stage;
+    stage.Reset(1);
+    stage.AddInput(0, input.data());
+
+    input[3] = -0.75f;
+    stage.Process(outputs, nullptr, frames);
+    REQUIRE(stage.GetLevel(0).peak == 0.75f);
+
+    input[3] = 0.125f;
+    stage.Process(outputs, nullptr, frames);
+    REQUIRE(stage.GetLevel(0).peak == 0.125f);
+}
@@ -28,6 +28,7 @@
 #include "AlsaSequencer.hpp"
 #include "MidiEvent.hpp"
 #include "DeviceVus.hpp"
+#include "VuMeterKernels.hpp"
 
 
 
@@ -37,6 +38,7 @@ namespace pipedal {
     using ProcessCallback = std::function<void (size_t)>;
 
     class ChannelSelection;
+    class FlightRecorder;
 
     class AudioDriverHost {
     public:
@@ -44,6 +46,8 @@ namespace pipedal {
         virtual bool OnRealtimeUpdateDeviceVus(size_t nFrames) = 0;
 
         virtual void OnUnderrun() = 0;
+        // Per-period trace of the audio thread, or nullptr if there isn't one.
+        virtual FlightRecorder *GetFlightRecorder() { return nullptr; }
         virtual void OnAlsaDriverStopped() = 0;
         virtual void OnAudioTerminated() = 0;
     };
@@ -70,6 +74,9 @@ namespace pipedal {
         virtual std::vector<float*> &DeviceOutputBuffers() = 0;
         virtual size_t DeviceOutputBufferCount() const = 0;
         virtual float* GetDeviceOutputBuffer(size_t channel) const = 0;
+        // Level of a device output channel during the last period, if the driver measures output
+        // levels as it writes output. Returns false if the caller must measure the output buffer instead.
+        virtual bool GetDeviceOutputLevel(size_t channel, VuLevel *level) const { return false; }
 
         virtual std::vector<float*> &MainInputBuffers() = 0;
         virtual size_t MainInputBufferCount() const = 0;
@@ -36,6 +36,8 @@
 #include "PluginHost.hpp"
 #include "PatchPropertyWriter.hpp"
 #include "CpuTemperatureMonitor.hpp"
+#include "FlightRecorder.hpp"
+#include "IndexedSnapshot.hpp"
 #include "restrict.hpp"
 
 using namespace pipedal;
@@ -58,9 +60,14 @@ using namespace pipedal;
 #include "sched.h"
 #include <cmath>
 #include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <filesystem>
 #include <fstream>
 #include "Lv2EventBufferWriter.hpp"
 #include "InheritPriorityMutex.hpp"
+#include "RealtimeWorkerPool.hpp"
+#include "EqualPowerCrossfade.hpp"
 #include <atomic>
 
 #ifdef __linux__
@@ -74,7 +81,9 @@ using namespace pipedal;
 #include "AdminClient.hpp"
 
 const double VU_UPDATE_RATE_S = 1.0 / 30;
+const double EFFECT_CPU_UPDATE_RATE_S = 0.5;
 const double OVERRUN_GRACE_PERIOD_S = 15;
+const double FLIGHT_RECORDER_REPORT_INTERVAL_S = 10;
 using namespace pipedal;
 
 const int MIDI_LV2_BUFFER_SIZE = 16 * 1024;
@@ -118,182 +127,6 @@ static std::string GetGovernor()
     return pipedal::GetCpuGovernor();
 }
 
-namespace pipedal
-{
-
-    struct PathPatchProperty
-    {
-        LV2_URID propertyUrid = 0;
-        std::vector<uint8_t> atomBuffer;
-    };
-
-    class IndexedSnapshotValue
-    {
-    private:
-        struct InputControlEntry
-        {
-            bool isInputControl = false;
-            float value = 0;
-        };
-
-    public:
-        IndexedSnapshotValue(IEffect *effect, SnapshotValue *snapshotValue, PluginHost &pluginHost)
-            : pEffect(effect)
-        {
-            auto maxInputControl = effect->GetMaxInputControl();
-            inputControlValues.resize(maxInputControl);
-            this->enabled = true;
-            for (uint64_t i = 0; i < maxInputControl; ++i)
-            {
-                bool isInputControl = effect->IsInputControl(i);
-                if (isInputControl)
-                {
-                    inputControlValues[i] = InputControlEntry{isInputControl : true, value : effect->GetDefaultInputControlValue(i)};
-                }
-                else
-                {
-                    inputControlValues[i] = InputControlEntry{isInputControl : false, value : 0};
-                }
-            }
-            if (snapshotValue)
-            {
-                this->enabled = snapshotValue->isEnabled_;
-                for (auto &controlValue : snapshotValue->controlValues_)
-                {
-                    auto index = effect->GetControlIndex(controlValue.key());
-                    if (index >= 0 && index < inputControlValues.size())
-                    {
-                        inputControlValues[index].value = controlValue.value();
-                    }
-                }
-                this->lv2State = snapshotValue->lv2State_;
-
-                if (effect->IsLv2Effect())
-                {
-                    Lv2Effect *lv2Effect = (Lv2Effect *)effect;
-                    for (auto &pathProperty : snapshotValue->pathProperties_)
-                    {
-                        // only transmit changed path patch properties.
-                        if (lv2Effect->GetPathPatchProperty(pathProperty.first) != pathProperty.second)
-                        {
-                            lv2Effect->SetPathPatchProperty(pathProperty.first, pathProperty.second);
-
-                            PathPatchProperty pathPatchProperty;
-                            pathPatchProperty.propertyUrid = pluginHost.GetLv2Urid(pathProperty.first.c_str());
-                            // convert to json variant so we do a mappath operation.
-                            json_variant vProperty;
-                            std::istringstream ss(pathProperty.second);
-                            json_reader reader(ss);
-                            reader.read(&vProperty);
-                            if (!vProperty.is_null())
-                            {
-                                try
-                                {
-                                    vProperty = pluginHost.MapPath(vProperty);
-
-                                    // now to atom format (what we want on the rt thread0)
-                                    AtomConverter atomConverter(pluginHost.GetMapFeature());
-                                    LV2_Atom *atomValue = atomConverter.ToAtom(vProperty);
-
-                                    size_t atomBufferSize = (atomValue->size + sizeof(LV2_Atom) + 3) / 4 * 4;
-                                    pathPatchProperty.atomBuffer.resize(atomValue->size + sizeof(LV2_Atom));
-                                    memcpy(pathPatchProperty.atomBuffer.data(), atomValue, pathPatchProperty.atomBuffer.size());
-                                    this->pathPatchProperties.push_back(std::move(pathPatchProperty));
-                                }
-                                catch (const std::exception &e)
-                                {
-                                    Lv2Log::info(SS("IndexedSnapshotValue: Failed to map path property " << pathProperty.first << ". " << e.what()));
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        void ApplyValues(IEffect *effect)
-        {
-
-            effect->SetBypass(this->enabled);
-            if (effect != pEffect)
-            {
-                throw std::runtime_error("Wrong effect");
-            }
-            for (size_t i = 0; i < inputControlValues.size(); ++i)
-            {
-                InputControlEntry &e = inputControlValues[i];
-                if (e.isInputControl)
-                {
-                    effect->SetControl((int)i, e.value);
-                }
-            }
-
-            for (const auto &patchProperty : pathPatchProperties)
-            {
-                // yyy: only if the property changed!.
-                effect->SetPatchProperty(
-                    patchProperty.propertyUrid, patchProperty.atomBuffer.size(), (LV2_Atom *)patchProperty.atomBuffer.data());
-            }
-            // effect->SetLv2State(lv2State);
-        }
-
-    private:
-        IEffect *pEffect;
-        Lv2PluginState lv2State;
-        bool enabled;
-        std::vector<InputControlEntry> inputControlValues;
-        std::vector<PathPatchProperty> pathPatchProperties;
-    };
-    class IndexedSnapshot
-    {
-    public:
-        IndexedSnapshot(Snapshot *snapshot, std::shared_ptr<Lv2Pedalboard> currentPedalboard, PluginHost &pluginHost)
-        {
-            std::unordered_map<uint64_t, SnapshotValue *> index;
-            for (auto &value : snapshot->values_)
-            {
-                index[value.instanceId_] = &value;
-            }
-            std::vector<IEffect *> &effects = currentPedalboard->GetEffects();
-            snapshotValues.reserve(effects.size());
-
-            for (size_t i = 0; i < effects.size(); ++i)
-            {
-                auto &effect = effects[i];
-
-                SnapshotValue *snapshotValue = getSnapshotValue(index, effect->GetInstanceId());
-                snapshotValues.push_back(IndexedSnapshotValue(effect, snapshotValue, pluginHost));
-            }
-        }
-        static SnapshotValue *getSnapshotValue(std::unordered_map<uint64_t, SnapshotValue *> &index, uint64_t instanceId)
-        {
-            auto iter = index.find(instanceId);
-            if (iter == index.end())
-            {
-                return nullptr;
-            }
-            return iter->second;
-        }
-
-        void Apply(std::vector<IEffect *> &effects)
-        {
-            if (effects.size() != snapshotValues.size())
-            {
-                throw std::runtime_error("Effects and values don't match");
-            }
-            for (size_t i = 0; i < snapshotValues.size(); ++i)
-            {
-                snapshotValues[i].ApplyValues(effects[i]);
-            }
-        }
-        ~IndexedSnapshot()
-        {
-        }
-
-    private:
-        std::vector<IndexedSnapshotValue> snapshotValues;
-    };
-}
-
 class SystemMidiBinding
 {
 private:
@@ -392,6 +225,142 @@ bool SystemMidiBinding::IsMatch(const MidiEvent &event)
     }
 }
 
+/**
+ * @brief Keeps the outgoing pedalboard of a preset change running while it is crossfaded into the incoming pedalboard.
+ *
+ * The outgoing pedalboard is run on a dedicated realtime worker, if one was requested, so that
+ * a transition doesn't double the cost of a period on the audio thread. Messages written by its
+ * effects are buffered until the worker has been joined, as they are for pipeline stages.
+ */
+class PresetTransition
+{
+public:
+    static constexpr size_t DEFERRED_RING_BUFFER_SIZE = 16 * 1024;
+    static constexpr uint32_t MAX_TRANSITION_MS = 10000;
+
+    // non-realtime. transitionFrames == 0 disables transitions.
+    void Open(size_t transitionFrames, size_t maxBufferSize, bool useWorker)
+    {
+        this->transitionFrames = transitionFrames;
+        this->pedalboard = nullptr;
+        crossfade.Stop();
+        for (auto &buffer : outputBuffers)
+        {
+            buffer.resize(transitionFrames != 0 ? maxBufferSize : 0);
+        }
+        if (transitionFrames != 0 && useWorker)
+        {
+            worker = std::make_unique<RealtimeWorker>(0, "rtfade");
+            deferredRingBuffer = std::make_unique<RingBuffer<false, true>>(DEFERRED_RING_BUFFER_SIZE);
+            deferredWriter = std::make_unique<RealtimeRingBufferWriter>(deferredRingBuffer.get());
+            scratch.resize(DEFERRED_RING_BUFFER_SIZE);
+        }
+    }
+    // non-realtime, after the audio thread has stopped.
+    void Close()
+    {
+        worker = nullptr;
+        deferredWriter = nullptr;
+        deferredRingBuffer = nullptr;
+        pedalboard = nullptr;
+        crossfade.Stop();
+    }
+
+    Lv2Pedalboard *GetPedalboard() const { return pedalboard; }
+
+    // realtime. Abandon the transition in progress, if any. The caller takes ownership of the outgoing pedalboard.
+    void Cancel()
+    {
+        pedalboard = nullptr;
+        crossfade.Stop();
+    }
+
+    // realtime. Returns false if a transition isn't possible, in which case the caller should release outgoing immediately.
+    // Any transition already in progress is cancelled.
+    bool Start(Lv2Pedalboard *outgoing, Lv2Pedalboard *incoming)
+    {
+        Cancel();
+        if (transitionFrames == 0 || outgoing == nullptr || incoming == nullptr || outgoing->SharesEffectsWith(*incoming))
+        {
+            return false;
+        }
+        this->pedalboard = outgoing;
+        // Each pedalboard has its own RealtimeWorkerPool workers, so the outgoing pedalboard can always run concurrently.
+        this->runOnWorker = worker != nullptr;
+        crossfade.Start(transitionFrames);
+        return true;
+    }
+
+    // realtime. Start running the outgoing pedalboard for one period.
+    void BeginPeriod(float **inputBuffers, float **outputBuffers, uint32_t frames, RealtimeRingBufferWriter *writer)
+    {
+        this->frames = frames;
+        this->channels = 0;
+        for (size_t c = 0; c < 2 && outputBuffers[c] != nullptr; ++c)
+        {
+            this->transitionInputs[c] = inputBuffers[c];
+            this->transitionOutputs[c] = this->outputBuffers[c].data();
+            ++this->channels;
+        }
+        this->transitionInputs[2] = nullptr;
+        this->transitionOutputs[this->channels] = nullptr;
+        if (runOnWorker)
+        {
+            worker->Post(&RunJob, this, frames);
+        }
+        else
+        {
+            RunPedalboard(writer);
+        }
+    }
+
+    // realtime. Mix the outgoing pedalboard into outputBuffers. Returns the outgoing pedalboard, once the transition is complete.
+    Lv2Pedalboard *EndPeriod(float **outputBuffers, RealtimeRingBufferWriter *writer)
+    {
+        if (runOnWorker)
+        {
+            worker->Wait();
+            writer->Forward(deferredRingBuffer.get(), scratch);
+        }
+        crossfade.Mix(outputBuffers, transitionOutputs, channels, frames);
+        if (crossfade.IsActive())
+        {
+            return nullptr;
+        }
+        Lv2Pedalboard *result = pedalboard;
+        pedalboard = nullptr;
+        return result;
+    }
+
+private:
+    static void RunJob(void *data, uint32_t frames)
+    {
+        PresetTransition *this_ = (PresetTransition *)data;
+        this_->RunPedalboard(this_->deferredWriter.get());
+    }
+    void RunPedalboard(RealtimeRingBufferWriter *writer)
+    {
+        pedalboard->ResetAtomBuffers();
+        pedalboard->Run(transitionInputs, transitionOutputs, frames, writer);
+    }
+
+    size_t transitionFrames = 0;
+    Lv2Pedalboard *pedalboard = nullptr;
+    EqualPowerCrossfade crossfade;
+
+    std::vector<float> outputBuffers[2];
+    float *transitionInputs[3] = {nullptr, nullptr, nullptr};
+    float *transitionOutputs[3] = {nullptr, nullptr, nullptr};
+    size_t channels = 0;
+    uint32_t frames = 0;
+
+    bool runOnWorker = false;
+    std::unique_ptr<RealtimeWorker> worker;
+    std::unique_ptr<RingBuffer<false, true>> deferredRingBuffer;
+    std::unique_ptr<RealtimeRingBufferWriter> deferredWriter;
+    std::vector<uint8_t> scratch;
+};
+
 class AudioHostImpl : public AudioHost, private AudioDriverHost, private IPatchWriterCallback
 {
 private:
@@ -408,6 +377,15 @@ private:
     AtomConverter atomConverter;
 
     CpuTemperatureMonitor::ptr cpuTemperatureMonitor;
+
+    // Per-period trace of the audio thread, written to disk after an xrun.
+    std::unique_ptr<FlightRecorder> flightRecorder;
+    std::thread *flightRecorderThread = nullptr;
+    std::mutex flightRecorderMutex;
+    std::condition_variable flightRecorderCv;
+    bool stopFlightRecorder = false;
+    std::string lastXrunDiagnosis; // protected by flightRecorderMutex.
+
     static constexpr size_t DEFERRED_MIDI_BUFFER_SIZE = 1024;
 
     uint8_t deferredMidiMessages[DEFERRED_MIDI_BUFFER_SIZE];
@@ -534,6 +512,8 @@ private:
 
     std::vector<std::shared_ptr<Lv2Pedalboard>> activePedalboards; // pedalboards that have been sent to the audio queue.
     Lv2Pedalboard *realtimeActivePedalboard = nullptr;
+    SnapshotTable *realtimeSnapshotTable = nullptr;
+    PresetTransition presetTransition;
 
     uint32_t sampleRate = 0;
     uint64_t currentSample = 0;
@@ -570,6 +550,11 @@ private:
         this->lastUnderrunTime = std::chrono::system_clock ::now();
     }
 
+    virtual FlightRecorder *GetFlightRecorder() override
+    {
+        return flightRecorder.get();
+    }
+
     virtual void Close()
     {
         {
@@ -590,10 +575,14 @@ private:
         audioDriver->Close();
 
         StopReaderThread();
+        StopFlightRecorderThread();
+        StopSnapshotCompilerThread();
 
         // delete any leaked snapshots.
         CleanUpSnapshots();
 
+        presetTransition.Close();
+
         // release any pdealboards owned by the process thread.
         this->activePedalboards.resize(0);
         this->realtimeActivePedalboard = nullptr;
@@ -682,6 +671,45 @@ private:
         }
     }
 
+    // see JackHostStatus::silentPeriods_
+    std::atomic<uint64_t> processedPeriods = 0;
+    std::atomic<uint64_t> silentPeriods = 0;
+
+    std::atomic<bool> effectCpuUseSubscribed = false;
+    bool effectCpuUseWaitingForAcknowledge = false;
+    size_t effectCpuSamplesPerUpdate = 0;
+    int64_t realtimeEffectCpuSamplesRemaining = 0;
+
+    virtual void SetEffectCpuUseSubscription(bool enabled) override
+    {
+        this->effectCpuUseSubscribed = enabled;
+    }
+
+    void realtimeWriteEffectCpuUse(Lv2Pedalboard *pedalboard, size_t nframes)
+    {
+        realtimeEffectCpuSamplesRemaining -= nframes;
+        if (realtimeEffectCpuSamplesRemaining > 0)
+        {
+            return;
+        }
+        realtimeEffectCpuSamplesRemaining = effectCpuSamplesPerUpdate;
+
+        // The update is owned by the pedalboard. Don't overwrite it until the host thread acknowledges
+        // the last one. (The pedalboard won't be deleted before then, because EffectReplaced follows
+        // the update through the same ring buffer.)
+        if (effectCpuUseWaitingForAcknowledge)
+        {
+            return;
+        }
+        // Collect even if there are no subscribers, so that maximums are recent when a client subscribes.
+        const EffectCpuUpdate *update = pedalboard->CollectEffectCpuUse();
+        if (update && effectCpuUseSubscribed)
+        {
+            realtimeWriter.SendEffectCpuUpdate(update);
+            effectCpuUseWaitingForAcknowledge = true;
+        }
+    }
+
     void processMonitorPortSubscriptions(
         Lv2Pedalboard *pedalboard,
         uint32_t nframes)
@@ -754,13 +782,6 @@ private:
             }
             switch (command)
             {
-            case RingBufferCommand::SetValue:
-            {
-                SetControlValueBody body;
-                realtimeReader.readComplete(&body);
-                this->realtimeActivePedalboard->SetControlValue(body.effectIndex, body.controlIndex, body.value);
-                break;
-            }
             case RingBufferCommand::SetInputVolume:
             {
                 SetVolumeBody body;
@@ -796,6 +817,13 @@ private:
 
                 break;
             }
+            case RingBufferCommand::AckEffectCpuUpdate:
+            {
+                bool dummy;
+                realtimeReader.readComplete(&dummy);
+                this->effectCpuUseWaitingForAcknowledge = false;
+                break;
+            }
             case RingBufferCommand::AckMonitorPortUpdate:
             {
                 int64_t subscriptionHandle = 0;
@@ -848,6 +876,17 @@ private:
                 realtimeWriter.FreeSnapshot(snapshot);
                 break;
             }
+            case RingBufferCommand::SetSnapshotTable:
+            {
+                SnapshotTable *table;
+                realtimeReader.readComplete(&table);
+                if (this->realtimeSnapshotTable)
+                {
+                    realtimeWriter.FreeSnapshotTable(this->realtimeSnapshotTable);
+                }
+                this->realtimeSnapshotTable = table;
+                break;
+            }
             case RingBufferCommand::SetVuSubscriptions:
             {
                 RealtimeVuBuffers *configuration;
@@ -878,8 +917,22 @@ private:
                 {
                     auto oldValue = this->realtimeActivePedalboard;
                     this->realtimeActivePedalboard = body.effect;
+                    if (this->realtimeSnapshotTable && this->realtimeSnapshotTable->GetPedalboard() != body.effect)
+                    {
+                        realtimeWriter.FreeSnapshotTable(this->realtimeSnapshotTable);
+                        this->realtimeSnapshotTable = nullptr;
+                    }
 
-                    realtimeWriter.EffectReplaced(oldValue);
+                    if (Lv2Pedalboard *interrupted = presetTransition.GetPedalboard())
+                    {
+                        // a transition is already in progress. Drop the pedalboard that was fading out.
+                        presetTransition.Cancel();
+                        realtimeWriter.EffectReplaced(interrupted);
+                    }
+                    if (!presetTransition.Start(oldValue, body.effect))
+                    {
+                        realtimeWriter.EffectReplaced(oldValue);
+                    }
 
                     // invalidate the possibly no-good subscriptions. Model will update them shortly.
                     freeRealtimeVuConfiguration();
@@ -905,6 +958,11 @@ private:
                 throw PiPedalStateException("Unknown Ringbuffer command.");
             }
         }
+        // Control values are applied after structural commands, so that values set after a LoadSnapshot win.
+        if (this->realtimeActivePedalboard)
+        {
+            this->realtimeActivePedalboard->ApplyControlValues();
+        }
         reEntered = false;
         return true;
     }
@@ -970,9 +1028,19 @@ private:
 
     void OnSnapshotTriggered(int snapshotIndex)
     {
+        // Apply a precompiled snapshot now. The host still updates the model, and applies path properties.
+        bool applied = false;
+        if (this->realtimeSnapshotTable && this->realtimeSnapshotTable->GetPedalboard() == this->realtimeActivePedalboard)
+        {
+            if (IndexedSnapshot *snapshot = this->realtimeSnapshotTable->Get((size_t)snapshotIndex))
+            {
+                ApplySnapshot(snapshot);
+                applied = true;
+            }
+        }
         // midiProgramChangePending = true;
         this->midiSnapshotRequestPending = true;
-        this->realtimeWriter.OnRealtimeMidiSnapshotRequest(snapshotIndex, ++snapshotRequestId);
+        this->realtimeWriter.OnRealtimeMidiSnapshotRequest(snapshotIndex, ++snapshotRequestId, applied);
     }
 
     void ProcessMidiEvent(Lv2EventBufferWriter &eventBufferWriter, Lv2EventBufferWriter::LV2_EvBuf_Iterator &iterator, MidiEvent &event)
@@ -1225,9 +1293,35 @@ private:
         {
             pedalboard->ProcessParameterRequests(pParameterRequests, nframes);
 
-            pedalboard->Run(inputBuffers, outputBuffers, (uint32_t)nframes, &realtimeWriter);
+            bool inTransition = presetTransition.GetPedalboard() != nullptr;
+            if (inTransition)
+            {
+                presetTransition.BeginPeriod(inputBuffers, outputBuffers, (uint32_t)nframes, &realtimeWriter);
+            }
+            pedalboard->Run(inputBuffers, outputBuffers, (uint32_t)nframes, &realtimeWriter, this->realtimeVuBuffers);
+            if (flightRecorder)
+            {
+                if (FlightRecord *record = flightRecorder->GetCurrentRecord())
+                {
+                    record->pedalboardId = (uint64_t)(uintptr_t)pedalboard;
+                    record->effectCount = (uint16_t)pedalboard->GetEffectPeriodCosts(record->effectNs, FlightRecord::MAX_EFFECTS);
+                }
+            }
+            processedPeriods.fetch_add(1, std::memory_order_relaxed);
+            if (pedalboard->IsSilent())
+            {
+                silentPeriods.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (inTransition)
+            {
+                if (Lv2Pedalboard *finished = presetTransition.EndPeriod(outputBuffers, &realtimeWriter))
+                {
+                    realtimeWriter.EffectReplaced(finished);
+                }
+            }
             pedalboard->GatherPatchProperties(pParameterRequests);
             pedalboard->GatherPathPatchProperties(this);
+            realtimeWriteEffectCpuUse(pedalboard, nframes);
 
             if (this->realtimeMonitorPortSubscriptions != nullptr)
             {
@@ -1269,18 +1363,14 @@ private:
             masterOutputBuffers[outputIx++] = audioDriver->GetDeviceOutputBuffer(nChannel);
         }
     }
-    inline void AccumulateVu(float *result, size_t nFrames, float *buffer)
+    VuLevel MeasureOutputLevel(size_t nFrames, int64_t channel)
     {
-        float maxVal = *result;
-        for (size_t i = 0; i < nFrames; ++i)
+        VuLevel level;
+        if (this->audioDriver->GetDeviceOutputLevel(channel, &level)) // measured while writing output.
         {
-            float v = std::fabs(buffer[i]);
-            if (v > maxVal)
-            {
-                maxVal = v;
-            }
+            return level;
         }
-        *result = maxVal;
+        return MeasureVuLevel(this->audioDriver->DeviceOutputBuffers()[channel], nFrames);
     }
     void AccumulateVuInputs(size_t nFrames, VuUpdateX &vuUpdate, const std::vector<int64_t> &channels)
     {
@@ -1293,11 +1383,15 @@ private:
             return;
         }
 
-        AccumulateVu(&vuUpdate.inputMaxValueL_, nFrames, this->audioDriver->DeviceInputBuffers()[channels[0]]);
-
+        auto &buffers = this->audioDriver->DeviceInputBuffers();
+        VuLevel levelL = MeasureVuLevel(buffers[channels[0]], nFrames);
         if (channels.size() == 2)
         {
-            AccumulateVu(&vuUpdate.inputMaxValueR_, nFrames, this->audioDriver->DeviceInputBuffers()[channels[1]]);
+            vuUpdate.AccumulateInputs(levelL, MeasureVuLevel(buffers[channels[1]], nFrames), (uint32_t)nFrames);
+        }
+        else
+        {
+            vuUpdate.AccumulateInputs(levelL, (uint32_t)nFrames);
         }
     }
     void AccumulateVuOutputs(size_t nFrames, VuUpdateX &vuUpdate, const std::vector<int64_t> &channels)
@@ -1312,10 +1406,14 @@ private:
             return;
         }
 
-        AccumulateVu(&vuUpdate.outputMaxValueL_, nFrames, this->audioDriver->DeviceOutputBuffers()[channels[0]]);
+        VuLevel levelL = MeasureOutputLevel(nFrames, channels[0]);
         if (channels.size() >= 2)
         {
-            AccumulateVu(&vuUpdate.outputMaxValueR_, nFrames, this->audioDriver->DeviceOutputBuffers()[channels[1]]);
+            vuUpdate.AccumulateOutputs(levelL, MeasureOutputLevel(nFrames, channels[1]), (uint32_t)nFrames);
+        }
+        else
+        {
+            vuUpdate.AccumulateOutputs(levelL, (uint32_t)nFrames);
         }
     }
     void ComputeMasterVus(size_t nFrames)
@@ -1640,6 +1738,17 @@ public:
                                 }
                                 this->hostWriter.AckVuUpdate(); // please sir, can I have some more?
                             }
+                            else if (command == RingBufferCommand::SendEffectCpuUpdate)
+                            {
+                                const EffectCpuUpdate *update = nullptr;
+                                hostReader.read(&update);
+
+                                if (this->pNotifyCallbacks)
+                                {
+                                    this->pNotifyCallbacks->OnNotifyEffectCpuUse(*update);
+                                }
+                                this->hostWriter.AckEffectCpuUpdate();
+                            }
                             else if (command == RingBufferCommand::Lv2StateChanged)
                             {
                                 uint64_t instanceId;
@@ -1719,6 +1828,12 @@ public:
                                 hostReader.read(&snapshot);
                                 OnFreeSnapshot(snapshot);
                             }
+                            else if (command == RingBufferCommand::FreeSnapshotTable)
+                            {
+                                SnapshotTable *table;
+                                hostReader.read(&table);
+                                OnFreeSnapshotTable(table);
+                            }
                             else if (command == RingBufferCommand::SendPathPropertyBuffer)
                             {
                                 PatchPropertyWriter::Buffer *buffer = nullptr;
@@ -1770,7 +1885,8 @@ public:
                                 hostReader.read(&request);
                                 pNotifyCallbacks->OnNotifyMidiRealtimeSnapshotRequest(
                                     request.snapshotIndex,
-                                    request.snapshotRequestId);
+                                    request.snapshotRequestId,
+                                    request.appliedOnRealtimeThread);
                             }
                             else if (command == RingBufferCommand::Lv2ErrorMessage)
                             {
@@ -1828,6 +1944,155 @@ public:
         this->readerThread = new std::thread(f);
     }
 
+    void FlightRecorderThreadProc()
+    {
+        SetThreadName("flightrec");
+        using clock = std::chrono::steady_clock;
+
+        std::vector<FlightRecord> records;
+        clock::time_point nextSample = clock::now();
+        clock::time_point nextReport = clock::now();
+        try
+        {
+            std::unique_lock lock(flightRecorderMutex);
+            while (!stopFlightRecorder)
+            {
+                flightRecorderCv.wait_for(lock, std::chrono::milliseconds(250));
+                if (stopFlightRecorder)
+                {
+                    break;
+                }
+                lock.unlock();
+
+                // sysfs reads are too slow for the audio thread.
+                auto now = clock::now();
+                if (now >= nextSample)
+                {
+                    nextSample = now + std::chrono::seconds(1);
+                    uint64_t freqMin, freqMax;
+                    GetCpuFrequency(&freqMin, &freqMax);
+                    int32_t temperaturemC = cpuTemperatureMonitor
+                                                ? (int32_t)std::round(cpuTemperatureMonitor->GetTemperatureC() * 1000)
+                                                : -100000;
+                    flightRecorder->SetSystemState(temperaturemC, (uint32_t)freqMin, (uint32_t)freqMax);
+                }
+                if (flightRecorder->TakeFrozenRecords(&records) && !records.empty())
+                {
+                    const FlightRecord &last = records.back();
+                    // ignore xruns while audio is starting, and limit how often we write reports.
+                    if (last.period * last.frames > this->overrunGracePeriodSamples && now >= nextReport)
+                    {
+                        nextReport = now + std::chrono::duration_cast<clock::duration>(
+                                               std::chrono::duration<double>(FLIGHT_RECORDER_REPORT_INTERVAL_S));
+                        WriteFlightRecorderReport(records);
+                    }
+                }
+                lock.lock();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error("Flight recorder thread terminated abnormally. (%s)", e.what());
+        }
+    }
+
+    void WriteFlightRecorderReport(const std::vector<FlightRecord> &records)
+    {
+        std::shared_ptr<Lv2Pedalboard> pedalboard;
+        {
+            std::lock_guard guard(mutex);
+            pedalboard = this->currentPedalboard;
+        }
+        std::vector<FlightRecorder::EffectLabel> labels;
+        uint64_t pedalboardId = 0;
+        if (pedalboard)
+        {
+            pedalboardId = (uint64_t)(uintptr_t)pedalboard.get();
+            for (const auto &counter : pedalboard->GetEffectCostCounters())
+            {
+                labels.push_back(FlightRecorder::EffectLabel{counter.instanceId, counter.uri});
+            }
+        }
+        std::string diagnosis = FlightRecorder::Diagnose(records, this->sampleRate, labels, pedalboardId);
+        {
+            std::lock_guard guard(flightRecorderMutex);
+            this->lastXrunDiagnosis = diagnosis;
+        }
+
+        namespace fs = std::filesystem;
+        fs::path directory = pHost->GetFlightRecorderReportPath();
+        char name[64];
+        time_t t = time(nullptr);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        strftime(name, sizeof(name), "xrun-%Y%m%d-%H%M%S.csv", &tm);
+        fs::path path = directory / name;
+        try
+        {
+            fs::create_directories(directory);
+            {
+                std::ofstream f(path);
+                if (!f)
+                {
+                    throw std::runtime_error(SS("Can't write to " << path));
+                }
+                FlightRecorder::WriteReport(f, records, this->sampleRate, labels, pedalboardId);
+            }
+            // keep the most recent reports.
+            std::vector<fs::path> reports;
+            for (const auto &entry : fs::directory_iterator(directory))
+            {
+                std::string fileName = entry.path().filename().string();
+                if (fileName.starts_with("xrun-") && entry.path().extension() == ".csv")
+                {
+                    reports.push_back(entry.path());
+                }
+            }
+            std::sort(reports.begin(), reports.end());
+            size_t maxReports = pHost->GetFlightRecorderReports();
+            for (size_t i = 0; i + maxReports < reports.size(); ++i)
+            {
+                fs::remove(reports[i]);
+            }
+            Lv2Log::info(SS("Xrun: " << diagnosis << " (" << path.string() << ")"));
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Xrun: " << diagnosis << " Unable to write flight recorder report. " << e.what()));
+        }
+    }
+
+    void StartFlightRecorderThread()
+    {
+        if (!flightRecorder)
+        {
+            size_t periods = pHost->GetFlightRecorderPeriods();
+            if (periods == 0)
+            {
+                return;
+            }
+            flightRecorder = std::make_unique<FlightRecorder>(periods);
+        }
+        stopFlightRecorder = false;
+        this->flightRecorderThread = new std::thread([this]()
+                                                     { this->FlightRecorderThreadProc(); });
+    }
+
+    void StopFlightRecorderThread()
+    {
+        if (flightRecorderThread != nullptr)
+        {
+            {
+                std::lock_guard guard(flightRecorderMutex);
+                stopFlightRecorder = true;
+            }
+            flightRecorderCv.notify_all();
+            flightRecorderThread->join();
+            delete flightRecorderThread;
+            flightRecorderThread = nullptr;
+        }
+    }
+
     bool isOpen = false;
 
     virtual bool IsOpen() const
@@ -1882,6 +2147,17 @@ public:
 
             this->overrunGracePeriodSamples = (uint64_t)(((uint64_t)this->sampleRate) * OVERRUN_GRACE_PERIOD_S);
             this->vuSamplesPerUpdate = (size_t)(sampleRate * VU_UPDATE_RATE_S);
+            this->effectCpuSamplesPerUpdate = (size_t)(sampleRate * EFFECT_CPU_UPDATE_RATE_S);
+            this->effectCpuUseWaitingForAcknowledge = false;
+
+            uint32_t transitionMs = std::min(jackServerSettings.GetPresetTransitionMs(), PresetTransition::MAX_TRANSITION_MS);
+            presetTransition.Open(
+                (size_t)((uint64_t)sampleRate * transitionMs / 1000),
+                jackServerSettings.GetBufferSize(),
+                jackServerSettings.GetPresetTransitionParallel());
+
+            StartFlightRecorderThread();
+            StartSnapshotCompilerThread();
 
             active = true;
             audioStopped = false;
@@ -1935,6 +2211,10 @@ public:
     {
         std::lock_guard guard(mutex);
 
+        if (pedalboard)
+        {
+            pedalboard->BindRealtimeWorkers();
+        }
         this->currentPedalboard = pedalboard;
         if (active && pedalboard)
         {
@@ -1972,7 +2252,7 @@ public:
                     int controlIndex = this->currentPedalboard->GetControlIndex(instanceId, value.key());
                     if (controlIndex != -1 && effectIndex != -1)
                     {
-                        hostWriter.SetControlValue(effectIndex, controlIndex, value.value());
+                        currentPedalboard->GetControlValueTable().Set(effectIndex, controlIndex, value.value());
                     }
                 }
             }
@@ -1990,7 +2270,8 @@ public:
 
             if (controlIndex != -1 && effectIndex != -1)
             {
-                hostWriter.SetControlValue(effectIndex, controlIndex, value);
+                // last value wins. The audio thread picks up the latest value once per period.
+                currentPedalboard->GetControlValueTable().Set(effectIndex, controlIndex, value);
             }
         }
     }
@@ -2015,13 +2296,23 @@ public:
 
     std::vector<IndexedSnapshot *> pendingSnapshots;
 
-    virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost) override
+    virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost, SnapshotContents contents) override
     {
         std::lock_guard guard(mutex);
         if (active && this->currentPedalboard)
         {
-            IndexedSnapshot *indexedSnapshot = new IndexedSnapshot(&snapshot, this->currentPedalboard, pluginHost);
+            IndexedSnapshot *indexedSnapshot = new IndexedSnapshot(&snapshot, this->currentPedalboard.get(), pluginHost, contents);
+            if (indexedSnapshot->IsEmpty())
+            {
+                delete indexedSnapshot;
+                return;
+            }
             pendingSnapshots.push_back(indexedSnapshot);
+            if (contents != SnapshotContents::PathProperties)
+            {
+                // The snapshot sets every control. Values set before it, but not yet applied, must not override it.
+                this->currentPedalboard->GetControlValueTable().Clear();
+            }
             this->hostWriter.LoadSnapshot(indexedSnapshot);
         }
     }
@@ -2056,6 +2347,142 @@ public:
             delete snapshot;
         }
         pendingSnapshots.clear();
+
+        for (SnapshotTable *table : snapshotTables)
+        {
+            delete table;
+        }
+        snapshotTables.clear();
+        realtimeSnapshotTable = nullptr;
+    }
+
+    // Snapshot tables that have been sent to the audio thread, and not yet returned. Protected by mutex.
+    std::vector<SnapshotTable *> snapshotTables;
+
+    struct SnapshotCompileRequest
+    {
+        std::shared_ptr<Lv2Pedalboard> pedalboard;
+        std::vector<std::shared_ptr<Snapshot>> snapshots;
+        PluginHost *pluginHost = nullptr;
+    };
+    std::thread *snapshotCompilerThread = nullptr;
+    std::mutex snapshotCompilerMutex;
+    std::condition_variable snapshotCompilerCv;
+    std::unique_ptr<SnapshotCompileRequest> snapshotCompileRequest; // the latest request replaces any earlier one.
+    bool stopSnapshotCompiler = false;
+
+    virtual void SetSnapshots(const std::vector<std::shared_ptr<Snapshot>> &snapshots, PluginHost &pluginHost) override
+    {
+        auto request = std::make_unique<SnapshotCompileRequest>();
+        {
+            std::lock_guard guard(mutex);
+            if (!active || !this->currentPedalboard || snapshotCompilerThread == nullptr)
+            {
+                return;
+            }
+            request->pedalboard = this->currentPedalboard;
+        }
+        // copies, since the model modifies its snapshots.
+        for (const auto &snapshot : snapshots)
+        {
+            request->snapshots.push_back(snapshot ? std::make_shared<Snapshot>(*snapshot) : nullptr);
+        }
+        request->pluginHost = &pluginHost;
+        {
+            std::lock_guard guard(snapshotCompilerMutex);
+            this->snapshotCompileRequest = std::move(request);
+        }
+        snapshotCompilerCv.notify_all();
+    }
+
+    void SnapshotCompilerThreadProc()
+    {
+        SetThreadName("snapshotCompile");
+
+        // A copy of the last table sent to the audio thread, whose compiled snapshots can be reused.
+        std::unique_ptr<SnapshotTable> previous;
+        std::weak_ptr<Lv2Pedalboard> previousPedalboard;
+        try
+        {
+            std::unique_lock lock(snapshotCompilerMutex);
+            while (true)
+            {
+                snapshotCompilerCv.wait(lock, [this]()
+                                        { return stopSnapshotCompiler || snapshotCompileRequest; });
+                if (stopSnapshotCompiler)
+                {
+                    break;
+                }
+                std::unique_ptr<SnapshotCompileRequest> request = std::move(snapshotCompileRequest);
+                lock.unlock();
+
+                // (weak, so that a new pedalboard at the address of a deleted one doesn't match.)
+                if (previousPedalboard.lock() != request->pedalboard)
+                {
+                    previous = nullptr;
+                }
+                SnapshotTable *table = new SnapshotTable(
+                    request->snapshots, request->pedalboard.get(), *request->pluginHost, previous.get());
+                {
+                    std::lock_guard guard(mutex);
+                    if (active && this->currentPedalboard == request->pedalboard && !table->IsUnchanged())
+                    {
+                        previous = std::make_unique<SnapshotTable>(*table);
+                        previousPedalboard = request->pedalboard;
+                        snapshotTables.push_back(table);
+                        hostWriter.SetSnapshotTable(table);
+                        table = nullptr;
+                    }
+                }
+                delete table;
+                request = nullptr; // (may release the last reference to the pedalboard.)
+
+                lock.lock();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error("Snapshot compiler thread terminated abnormally. (%s)", e.what());
+        }
+    }
+
+    void StartSnapshotCompilerThread()
+    {
+        stopSnapshotCompiler = false;
+        snapshotCompileRequest = nullptr;
+        this->snapshotCompilerThread = new std::thread([this]()
+                                                       { this->SnapshotCompilerThreadProc(); });
+    }
+    void StopSnapshotCompilerThread()
+    {
+        if (snapshotCompilerThread != nullptr)
+        {
+            {
+                std::lock_guard guard(snapshotCompilerMutex);
+                stopSnapshotCompiler = true;
+                snapshotCompileRequest = nullptr;
+            }
+            snapshotCompilerCv.notify_all();
+            snapshotCompilerThread->join();
+            delete snapshotCompilerThread;
+            snapshotCompilerThread = nullptr;
+        }
+    }
+
+    void OnFreeSnapshotTable(SnapshotTable *table)
+    {
+        {
+            std::lock_guard guard(mutex);
+            for (auto i = snapshotTables.begin(); i != snapshotTables.end(); ++i)
+            {
+                if (*i == table)
+                {
+                    snapshotTables.erase(i);
+                    break;
+                }
+            }
+        }
+        delete table;
     }
 
     PIPEDAL_NON_INLINE RealtimePedalboardItemIndex GetRealtimeItemIndex(int64_t instanceId)
@@ -2342,6 +2769,12 @@ public:
         {
             result.cpuUsage_ = audioDriver->CpuUse();
         }
+        result.periods_ = this->processedPeriods.load(std::memory_order_relaxed);
+        result.silentPeriods_ = this->silentPeriods.load(std::memory_order_relaxed);
+        {
+            std::lock_guard flightRecorderGuard(flightRecorderMutex);
+            result.lastXrun_ = this->lastXrunDiagnosis;
+        }
         GetCpuFrequency(&result.cpuFreqMin_, &result.cpuFreqMax_);
         result.hasCpuGovernor_ = HasCpuGovernor();
         if (result.hasCpuGovernor_)
@@ -2547,6 +2980,9 @@ JSON_MAP_REFERENCE(JackHostStatus, errorMessage)
 JSON_MAP_REFERENCE(JackHostStatus, restarting)
 JSON_MAP_REFERENCE(JackHostStatus, underruns)
 JSON_MAP_REFERENCE(JackHostStatus, cpuUsage)
+JSON_MAP_REFERENCE(JackHostStatus, periods)
+JSON_MAP_REFERENCE(JackHostStatus, silentPeriods)
+JSON_MAP_REFERENCE(JackHostStatus, lastXrun)
 JSON_MAP_REFERENCE(JackHostStatus, msSinceLastUnderrun)
 JSON_MAP_REFERENCE(JackHostStatus, temperaturemC)
 JSON_MAP_REFERENCE(JackHostStatus, cpuFreqMin)
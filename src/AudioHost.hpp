@@ -33,6 +33,7 @@
 #include "json_variant.hpp"
 #include "RealtimeMidiEventType.hpp"
 #include "ChannelRouterSettings.hpp"
+#include "IndexedSnapshot.hpp"
 
 namespace pipedal
 {
@@ -160,6 +161,7 @@ namespace pipedal
         virtual void OnNotifyLv2StateChanged(uint64_t instanceId) = 0;
         virtual bool OnNotifyMaybeLv2StateChanged(uint64_t instanceId) = 0;
         virtual void OnNotifyVusSubscription(const std::vector<VuUpdateX> &updates) = 0;
+        virtual void OnNotifyEffectCpuUse(const EffectCpuUpdate &update) = 0;
         virtual void OnNotifyMonitorPort(const MonitorPortUpdate &update) = 0;
         virtual void OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value) = 0;
         virtual void OnNotifyMidiListen(uint8_t cc0, uint8_t cc1, uint8_t cc2) = 0;
@@ -180,7 +182,7 @@ namespace pipedal
         virtual void OnNotifyNextMidiSnapshot(const RealtimeNextMidiProgramRequest &request) = 0;
         virtual void OnNotifyLv2RealtimeError(int64_t instanceId, const std::string &error) = 0;
         virtual void OnNotifyMidiRealtimeEvent(RealtimeMidiEventType eventType) = 0;
-        virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex,int64_t snapshotRequestId) = 0;
+        virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex,int64_t snapshotRequestId, bool appliedOnRealtimeThread) = 0;
 
         virtual void OnAlsaDriverTerminatedAbnormally() = 0;
         virtual void OnAlsaSequencerDeviceAdded(int client, const std::string &clientName) = 0;
@@ -195,6 +197,11 @@ namespace pipedal
         bool restarting_;
         uint64_t underruns_;
         float cpuUsage_ = 0;
+        // Periods processed, and periods in which no plugin was run because of silence, since audio started.
+        uint64_t periods_ = 0;
+        uint64_t silentPeriods_ = 0;
+        // The flight recorder's explanation of the most recent xrun, if any.
+        std::string lastXrun_;
         uint64_t msSinceLastUnderrun_ = 0;
         int32_t temperaturemC_ = -100000;
         uint64_t cpuFreqMax_ = 0;
@@ -250,6 +257,8 @@ namespace pipedal
         virtual bool IsOpen() const = 0;
 
         virtual void SetVuSubscriptions(const std::vector<int64_t> &instanceIds) = 0;
+        // Enables periodic OnNotifyEffectCpuUse notifications.
+        virtual void SetEffectCpuUseSubscription(bool enabled) = 0;
         virtual void SetMonitorPortSubscriptions(const std::vector<MonitorPortSubscription> &subscriptions) = 0;
 
         virtual void SetSystemMidiBindings(const std::vector<MidiBinding> &bindings) = 0;
@@ -261,7 +270,10 @@ namespace pipedal
 
         virtual JackHostStatus getJackStatus() = 0;
 
-        virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost) = 0;
+        virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost, SnapshotContents contents = SnapshotContents::All) = 0;
+        // Precompile the current preset's snapshots in the background, so that MIDI snapshot
+        // requests can be applied on the audio thread immediately.
+        virtual void SetSnapshots(const std::vector<std::shared_ptr<Snapshot>> &snapshots, PluginHost &pluginHost) = 0;
 
         virtual void OnNotifyPathPatchPropertyReceived(
             int64_t instanceId,
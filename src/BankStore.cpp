@@ -0,0 +1,308 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "BankStore.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <fcntl.h>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static const char *TEMPORARY_EXTENSION = ".$$$";
+
+bool BankStoreIndex::HasName(const std::string &name) const
+{
+    for (const auto &preset : presets_)
+    {
+        if (preset.name() == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BankStoreIndex::HasItem(int64_t instanceId) const
+{
+    for (const auto &preset : presets_)
+    {
+        if (preset.instanceId() == instanceId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t BankStoreIndex::AddPreset(const std::string &name, int64_t afterItem)
+{
+    if (HasName(name))
+    {
+        throw PiPedalStateException("A preset by that name already exists.");
+    }
+    int64_t instanceId = ++nextInstanceId_;
+    PresetIndexEntry entry(instanceId, name);
+    for (auto it = presets_.begin(); it != presets_.end(); ++it)
+    {
+        if (afterItem != -1 && it->instanceId() == afterItem)
+        {
+            presets_.insert(it + 1, entry);
+            return instanceId;
+        }
+    }
+    presets_.push_back(entry);
+    return instanceId;
+}
+
+static void WriteJsonFile(const fs::path &path, const std::string &content)
+{
+    pipedal::WriteFileSynced(path, content.data(), content.size());
+}
+
+// Read the whole file, so that it can be parsed from a buffer instead of a stream.
+static std::string ReadJsonFile(const fs::path &path)
+{
+    std::ifstream s(path, std::ios::binary);
+    if (!s.is_open())
+    {
+        throw PiPedalException(SS("Can't open " << path));
+    }
+    std::string result;
+    result.resize(fs::file_size(path));
+    s.read(result.data(), (std::streamsize)result.size());
+    result.resize((size_t)s.gcount());
+    return result;
+}
+
+template <typename T>
+static std::string ToJson(const T &value, BlobStore *blobStore = nullptr)
+{
+    BlobStore::Scope blobScope{blobStore};
+    std::stringstream s;
+    json_writer writer(s, true);
+    writer.write(value);
+    return s.str();
+}
+
+BankStore::BankStore(const fs::path &directory, BlobStore *blobStore)
+    : directory(directory), blobStore(blobStore)
+{
+}
+
+bool BankStore::Exists() const
+{
+    return fs::exists(directory / INDEX_FILENAME);
+}
+
+fs::path BankStore::GetPresetPath(int64_t instanceId) const
+{
+    return directory / SS(instanceId << PRESET_EXTENSION);
+}
+
+void BankStore::LoadIndex(BankStoreIndex *pIndex) const
+{
+    std::string json = ReadJsonFile(directory / INDEX_FILENAME);
+    json_reader reader{std::string_view(json)};
+    reader.read(pIndex);
+}
+
+Pedalboard BankStore::LoadPreset(int64_t instanceId) const
+{
+    std::string json = ReadJsonFile(GetPresetPath(instanceId));
+    BlobStore::Scope blobScope{blobStore};
+    Pedalboard result;
+    json_reader reader{std::string_view(json)};
+    reader.read(&result);
+    return result;
+}
+
+void BankStore::Load(BankFile *pBank) const
+{
+    BankStoreIndex index;
+    LoadIndex(&index);
+
+    pBank->clear();
+    pBank->name(index.name_);
+    for (const auto &entry : index.presets_)
+    {
+        if (!fs::exists(GetPresetPath(entry.instanceId())))
+        {
+            // Can only happen if preset files were removed behind our back. Drop the preset rather than the whole bank.
+            Lv2Log::warning(SS("Bank " << directory << ": preset file for '" << entry.name() << "' is missing."));
+            continue;
+        }
+        auto bankFileEntry = std::make_unique<BankFileEntry>();
+        bankFileEntry->instanceId(entry.instanceId());
+        bankFileEntry->preset(LoadPreset(entry.instanceId()));
+        // the index is authoritative.
+        bankFileEntry->preset().name(entry.name());
+        pBank->presets().push_back(std::move(bankFileEntry));
+    }
+    pBank->nextInstanceId(index.nextInstanceId_);
+    pBank->updateNextIndex();
+    if (pBank->nextInstanceId() < index.nextInstanceId_)
+    {
+        pBank->nextInstanceId(index.nextInstanceId_);
+    }
+    if (pBank->presets().size() == 0)
+    {
+        pBank->addPreset(Pedalboard::MakeDefault());
+    }
+    if (pBank->hasItem(index.selectedPreset_))
+    {
+        pBank->selectedPreset(index.selectedPreset_);
+    }
+    else
+    {
+        pBank->selectedPreset(pBank->presets()[0]->instanceId());
+    }
+}
+
+BankStoreIndex BankStore::MakeIndex(const BankFile &bankFile)
+{
+    BankStoreIndex index;
+    index.name_ = bankFile.name();
+    index.nextInstanceId_ = bankFile.nextInstanceId();
+    index.selectedPreset_ = bankFile.selectedPreset();
+    index.presets_.reserve(bankFile.presets().size());
+    for (const auto &preset : bankFile.presets())
+    {
+        index.presets_.push_back(PresetIndexEntry(preset->instanceId(), preset->preset().name()));
+    }
+    return index;
+}
+
+void BankStore::SavePreset(int64_t instanceId, const Pedalboard &preset)
+{
+    fs::create_directories(directory);
+    WriteJsonFile(GetPresetPath(instanceId), ToJson(preset, blobStore));
+}
+
+void BankStore::SaveIndex(const BankFile &bankFile)
+{
+    for (const auto &preset : bankFile.presets())
+    {
+        if (!fs::exists(GetPresetPath(preset->instanceId())))
+        {
+            SavePreset(preset->instanceId(), preset->preset());
+        }
+    }
+    SaveIndex(MakeIndex(bankFile));
+}
+
+void BankStore::SaveIndex(const BankStoreIndex &index)
+{
+    fs::create_directories(directory);
+    WriteJsonFile(directory / INDEX_FILENAME, ToJson(index));
+    SyncDirectory();
+    RemoveUnreferencedPresets(index);
+}
+
+void BankStore::Save(const BankFile &bankFile)
+{
+    fs::create_directories(directory);
+    for (const auto &preset : bankFile.presets())
+    {
+        WriteJsonFile(GetPresetPath(preset->instanceId()), ToJson(preset->preset(), blobStore));
+    }
+    SaveIndex(bankFile);
+}
+
+void BankStore::RemoveUnreferencedPresets(const BankStoreIndex &index)
+{
+    std::set<std::string> referencedFiles;
+    for (const auto &preset : index.presets_)
+    {
+        referencedFiles.insert(GetPresetPath(preset.instanceId()).filename().string());
+    }
+    std::error_code ec;
+    for (const auto &dirEntry : fs::directory_iterator(directory, ec))
+    {
+        const fs::path &path = dirEntry.path();
+        if (path.filename() == INDEX_FILENAME || referencedFiles.contains(path.filename().string()))
+        {
+            continue;
+        }
+        // stray presets, and temporary files left behind by an interrupted write.
+        if (path.extension() == PRESET_EXTENSION || path.extension() == TEMPORARY_EXTENSION)
+        {
+            fs::remove(path, ec);
+        }
+    }
+}
+
+void BankStore::FindBlobReferences(std::set<std::string> *pResult) const
+{
+    for (const auto &dirEntry : fs::directory_iterator(directory))
+    {
+        if (dirEntry.path().extension() != PRESET_EXTENSION)
+        {
+            continue;
+        }
+        std::ifstream s(dirEntry.path());
+        if (!s.is_open())
+        {
+            // better to keep garbage than to discard blobs that are in use.
+            throw PiPedalException(SS("Can't open " << dirEntry.path()));
+        }
+        std::stringstream text;
+        text << s.rdbuf();
+        BlobStore::FindReferences(text.str(), pResult);
+    }
+}
+
+void BankStore::SyncDirectory()
+{
+    // make renames durable.
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1)
+    {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void BankStore::ConvertBankFile(const fs::path &bankFile, const fs::path &directory, BlobStore *blobStore)
+{
+    BankFile bank;
+    {
+        std::string json = ReadJsonFile(bankFile);
+        json_reader reader{std::string_view(json)};
+        reader.read(&bank);
+    }
+    // write to a temporary directory, so that an interrupted conversion is simply retried.
+    fs::path temporaryDirectory = directory.string() + TEMPORARY_EXTENSION;
+    fs::remove_all(temporaryDirectory);
+    BankStore(temporaryDirectory, blobStore).Save(bank);
+    fs::remove_all(directory);
+    fs::rename(temporaryDirectory, directory);
+}
+
+JSON_MAP_BEGIN(BankStoreIndex)
+    JSON_MAP_REFERENCE(BankStoreIndex, name)
+    JSON_MAP_REFERENCE(BankStoreIndex, nextInstanceId)
+    JSON_MAP_REFERENCE(BankStoreIndex, selectedPreset)
+    JSON_MAP_REFERENCE(BankStoreIndex, presets)
+JSON_MAP_END()
@@ -0,0 +1,102 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "Banks.hpp"
+#include "BlobStore.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    // The lightweight part of a bank: preset names and order, without preset bodies.
+    class BankStoreIndex
+    {
+    public:
+        std::string name_;
+        int64_t nextInstanceId_ = 0;
+        int64_t selectedPreset_ = -1;
+        std::vector<PresetIndexEntry> presets_;
+
+        bool HasName(const std::string &name) const;
+        bool HasItem(int64_t instanceId) const;
+
+        // Allocates an instance id for a new preset, and inserts it after afterItem (or at the end if afterItem is -1).
+        int64_t AddPreset(const std::string &name, int64_t afterItem = -1);
+
+        DECLARE_JSON_MAP(BankStoreIndex);
+    };
+
+    /**
+     * @brief On-disk storage for a single bank.
+     *
+     * A bank is a directory containing a small index file and one file per preset, so that saving
+     * a preset only rewrites (and fsyncs) that preset, and listing a bank's presets doesn't read
+     * any preset bodies. Every file is written to a temporary file and renamed into place, so a
+     * power failure leaves either the old or the new version of each file.
+     *
+     * Preset bodies are written before the index that refers to them. Preset files that the index
+     * doesn't refer to are removed whenever the index is saved.
+     *
+     * If a BlobStore is supplied, large LV2 state values in preset bodies are stored in it (see BlobStore).
+     */
+    class BankStore
+    {
+    public:
+        static constexpr const char *INDEX_FILENAME = "bank.index";
+        static constexpr const char *PRESET_EXTENSION = ".preset";
+
+        BankStore(const std::filesystem::path &directory, BlobStore *blobStore = nullptr);
+
+        const std::filesystem::path &GetDirectory() const { return directory; }
+        bool Exists() const;
+
+        void LoadIndex(BankStoreIndex *pIndex) const;
+        Pedalboard LoadPreset(int64_t instanceId) const;
+        // Loads the index and every preset body.
+        void Load(BankFile *pBank) const;
+
+        // Writes every preset and the index.
+        void Save(const BankFile &bankFile);
+        // Also writes presets that have no file yet (e.g. the default preset that Load() adds to an empty bank).
+        void SaveIndex(const BankFile &bankFile);
+        void SaveIndex(const BankStoreIndex &index);
+        void SavePreset(int64_t instanceId, const Pedalboard &preset);
+
+        // Adds the hashes of blobs referred to by this bank's presets to pResult.
+        void FindBlobReferences(std::set<std::string> *pResult) const;
+
+        static BankStoreIndex MakeIndex(const BankFile &bankFile);
+
+        // Converts a legacy single-file bank to a bank directory. The legacy file is left in place.
+        static void ConvertBankFile(const std::filesystem::path &bankFile, const std::filesystem::path &directory, BlobStore *blobStore = nullptr);
+
+    private:
+        std::filesystem::path GetPresetPath(int64_t instanceId) const;
+        void RemoveUnreferencedPresets(const BankStoreIndex &index);
+        void SyncDirectory();
+
+        std::filesystem::path directory;
+        BlobStore *blobStore;
+    };
+}
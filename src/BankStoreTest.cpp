@@ -0,0 +1,168 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "BankStore.hpp"
+#include "ss.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static BankFile MakeTestBank(size_t presets)
+{
+    BankFile bankFile;
+    bankFile.name("Test Bank");
+    for (size_t i = 0; i < presets; ++i)
+    {
+        Pedalboard pedalboard = Pedalboard::MakeDefault();
+        pedalboard.name(SS("Preset " << (i + 1)));
+        bankFile.addPreset(pedalboard);
+    }
+    bankFile.selectedPreset(bankFile.presets()[1]->instanceId());
+    return bankFile;
+}
+
+static void RequireSameBank(const BankFile &expected, const BankFile &actual)
+{
+    REQUIRE(actual.presets().size() == expected.presets().size());
+    REQUIRE(actual.selectedPreset() == expected.selectedPreset());
+    REQUIRE(actual.nextInstanceId() == expected.nextInstanceId());
+    for (size_t i = 0; i < expected.presets().size(); ++i)
+    {
+        REQUIRE(actual.presets()[i]->instanceId() == expected.presets()[i]->instanceId());
+        REQUIRE(actual.presets()[i]->preset().name() == expected.presets()[i]->preset().name());
+    }
+}
+
+static size_t CountPresetFiles(const fs::path &directory)
+{
+    size_t result = 0;
+    for (const auto &dirEntry : fs::directory_iterator(directory))
+    {
+        if (dirEntry.path().extension() == BankStore::PRESET_EXTENSION)
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+TEST_CASE("BankStore round trip", "[bank_store][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "BankStoreTest" / "roundTrip";
+    fs::remove_all(root);
+
+    BankFile bankFile = MakeTestBank(4);
+    BankStore bankStore(root / "Test+Bank.bankdir");
+    REQUIRE(!bankStore.Exists());
+    bankStore.Save(bankFile);
+    REQUIRE(bankStore.Exists());
+    REQUIRE(CountPresetFiles(bankStore.GetDirectory()) == 4);
+
+    BankFile loaded;
+    bankStore.Load(&loaded);
+    RequireSameBank(bankFile, loaded);
+
+    // the index lists presets without reading preset bodies.
+    BankStoreIndex index;
+    bankStore.LoadIndex(&index);
+    REQUIRE(index.presets_.size() == 4);
+    REQUIRE(index.presets_[2].name() == "Preset 3");
+
+    // saving one preset doesn't touch the others.
+    int64_t changedId = bankFile.presets()[2]->instanceId();
+    int64_t otherId = bankFile.presets()[0]->instanceId();
+    auto otherTime = fs::last_write_time(bankStore.GetDirectory() / SS(otherId << BankStore::PRESET_EXTENSION));
+    Pedalboard changed = bankFile.presets()[2]->preset();
+    changed.input_volume_db(-6.0f);
+    bankStore.SavePreset(changedId, changed);
+    REQUIRE(bankStore.LoadPreset(changedId).input_volume_db() == -6.0f);
+    REQUIRE(fs::last_write_time(bankStore.GetDirectory() / SS(otherId << BankStore::PRESET_EXTENSION)) == otherTime);
+
+    // deleting a preset only rewrites the index, and removes the preset's file.
+    bankFile.deletePreset(otherId);
+    bankStore.SaveIndex(bankFile);
+    REQUIRE(CountPresetFiles(bankStore.GetDirectory()) == 3);
+    bankStore.Load(&loaded);
+    RequireSameBank(bankFile, loaded);
+
+    // adding a preset to a bank that isn't loaded.
+    int64_t newId = index.AddPreset("New Preset", index.presets_[0].instanceId());
+    REQUIRE(newId == 5);
+    REQUIRE_THROWS(index.AddPreset("New Preset"));
+    REQUIRE(index.presets_[1].instanceId() == newId);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("BankStore saves the default preset of an empty bank", "[bank_store][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "BankStoreTest" / "emptyBank";
+    fs::remove_all(root);
+
+    BankStore bankStore(root / "Empty.bankdir");
+    bankStore.SaveIndex(BankStoreIndex());
+
+    // Load() makes up a default preset, which has no file until the index is saved.
+    BankFile loaded;
+    bankStore.Load(&loaded);
+    REQUIRE(loaded.presets().size() == 1);
+    int64_t defaultId = loaded.selectedPreset();
+    bankStore.SaveIndex(loaded);
+    REQUIRE(CountPresetFiles(bankStore.GetDirectory()) == 1);
+
+    BankFile reloaded;
+    bankStore.Load(&reloaded);
+    REQUIRE(reloaded.presets().size() == 1);
+    REQUIRE(reloaded.presets()[0]->instanceId() == defaultId);
+    REQUIRE(reloaded.selectedPreset() == defaultId);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("BankStore converts legacy bank files", "[bank_store][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "BankStoreTest" / "convert";
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    BankFile bankFile = MakeTestBank(3);
+    fs::path legacyFile = root / "Test+Bank.bank";
+    {
+        std::ofstream s(legacyFile);
+        json_writer writer(s, true);
+        writer.write(bankFile);
+    }
+    fs::path directory = root / "Test+Bank.bankdir";
+    BankStore::ConvertBankFile(legacyFile, directory);
+
+    BankStore bankStore(directory);
+    REQUIRE(bankStore.Exists());
+    BankFile loaded;
+    bankStore.Load(&loaded);
+    RequireSameBank(bankFile, loaded);
+    REQUIRE(loaded.name() == "Test Bank");
+    REQUIRE(!fs::exists(directory.string() + ".$$$"));
+
+    fs::remove_all(root);
+}
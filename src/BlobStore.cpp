@@ -0,0 +1,266 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "BlobStore.hpp"
+#include "PiPedalException.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static const char *TEMPORARY_EXTENSION = ".$$$";
+
+void pipedal::WriteFileSynced(const fs::path &path, const void *data, size_t size)
+{
+    fs::path temporaryPath = path.string() + TEMPORARY_EXTENSION;
+    int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        throw PiPedalException(SS("Can't write to " << temporaryPath << ". " << strerror(errno)));
+    }
+    const char *p = (const char *)data;
+    size_t remaining = size;
+    while (remaining != 0)
+    {
+        ssize_t written = ::write(fd, p, remaining);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            int error = errno;
+            ::close(fd);
+            fs::remove(temporaryPath);
+            throw PiPedalException(SS("Can't write to " << temporaryPath << ". " << strerror(error)));
+        }
+        p += written;
+        remaining -= (size_t)written;
+    }
+    if (::fsync(fd) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        fs::remove(temporaryPath);
+        throw PiPedalException(SS("Can't write to " << temporaryPath << ". " << strerror(error)));
+    }
+    ::close(fd);
+    fs::rename(temporaryPath, path);
+}
+
+Blob::Blob(const std::string &hash, void *mappedData, size_t mappedSize)
+    : hash_(hash), mappedData(mappedData), mappedSize(mappedSize)
+{
+}
+
+Blob::~Blob()
+{
+    munmap(mappedData, mappedSize);
+}
+
+static thread_local BlobStore *currentBlobStore = nullptr;
+
+BlobStore::Scope::Scope(BlobStore *blobStore)
+    : previous(currentBlobStore)
+{
+    currentBlobStore = blobStore;
+}
+
+BlobStore::Scope::~Scope()
+{
+    currentBlobStore = previous;
+}
+
+BlobStore *BlobStore::GetCurrent()
+{
+    return currentBlobStore;
+}
+
+BlobStore::BlobStore(const fs::path &directory)
+    : directory(directory)
+{
+}
+
+fs::path BlobStore::GetBlobPath(const std::string &hash) const
+{
+    return directory / hash;
+}
+
+std::string BlobStore::Hash(const uint8_t *data, size_t size)
+{
+    std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+    unsigned int digestLength = 0;
+    // EVP_Digest rather than EVP_Q_digest, which requires OpenSSL 3.0.
+    if (EVP_Digest(data, size, digest.data(), &digestLength, EVP_sha256(), nullptr) != 1)
+    {
+        throw std::runtime_error("EVP_Digest(SHA256) failed.");
+    }
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    std::string result(digestLength * 2, '\0');
+    for (size_t i = 0; i < digestLength; ++i)
+    {
+        unsigned char value = digest[i];
+        result[2 * i] = hexDigits[(value >> 4) & 0x0F];
+        result[2 * i + 1] = hexDigits[value & 0x0F];
+    }
+    return result;
+}
+
+bool BlobStore::IsValidHash(const std::string &hash)
+{
+    if (hash.length() != HASH_LENGTH)
+    {
+        return false;
+    }
+    for (char c : hash)
+    {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BlobStore::Put(const uint8_t *data, size_t size)
+{
+    std::string hash = Hash(data, size);
+    fs::path path = GetBlobPath(hash);
+    if (!fs::exists(path))
+    {
+        fs::create_directories(directory);
+        WriteFileSynced(path, data, size);
+    }
+    return hash;
+}
+
+bool BlobStore::Contains(const std::string &hash) const
+{
+    return IsValidHash(hash) && fs::exists(GetBlobPath(hash));
+}
+
+std::shared_ptr<const Blob> BlobStore::Get(const std::string &hash)
+{
+    if (!IsValidHash(hash))
+    {
+        throw PiPedalException(SS("Invalid blob reference: " << hash));
+    }
+    std::lock_guard lock{mapMutex};
+    auto f = mappedBlobs.find(hash);
+    if (f != mappedBlobs.end())
+    {
+        auto result = f->second.lock();
+        if (result)
+        {
+            return result;
+        }
+    }
+
+    fs::path path = GetBlobPath(hash);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw PiPedalException(SS("Missing blob " << path << ". " << strerror(errno)));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        throw PiPedalException(SS("Invalid blob " << path << "."));
+    }
+    size_t size = (size_t)st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        throw PiPedalException(SS("Can't map blob " << path << ". " << strerror(errno)));
+    }
+    std::shared_ptr<const Blob> result{new Blob(hash, p, size)};
+
+    // prune expired entries while we're here.
+    for (auto i = mappedBlobs.begin(); i != mappedBlobs.end();)
+    {
+        if (i->second.expired())
+        {
+            i = mappedBlobs.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    mappedBlobs[hash] = result;
+    return result;
+}
+
+size_t BlobStore::CollectGarbage(const std::set<std::string> &referencedHashes)
+{
+    size_t removed = 0;
+    std::error_code ec;
+    for (const auto &dirEntry : fs::directory_iterator(directory, ec))
+    {
+        std::string name = dirEntry.path().filename().string();
+        if (IsValidHash(name) && referencedHashes.contains(name))
+        {
+            continue;
+        }
+        // unreferenced blobs, and temporary files left behind by an interrupted write.
+        if (IsValidHash(name) || dirEntry.path().extension() == TEMPORARY_EXTENSION)
+        {
+            // Existing mappings of the file remain valid after it has been removed.
+            if (fs::remove(dirEntry.path(), ec))
+            {
+                ++removed;
+            }
+        }
+    }
+    return removed;
+}
+
+void BlobStore::FindReferences(const std::string &jsonText, std::set<std::string> *pResult)
+{
+    static const std::string KEY = "\"blob\"";
+    size_t pos = 0;
+    while ((pos = jsonText.find(KEY, pos)) != std::string::npos)
+    {
+        pos += KEY.length();
+        size_t i = pos;
+        while (i < jsonText.length() && (jsonText[i] == ' ' || jsonText[i] == ':' || jsonText[i] == '\n' || jsonText[i] == '\t'))
+        {
+            ++i;
+        }
+        if (i < jsonText.length() && jsonText[i] == '"')
+        {
+            std::string hash = jsonText.substr(i + 1, HASH_LENGTH);
+            if (IsValidHash(hash))
+            {
+                pResult->insert(std::move(hash));
+            }
+        }
+    }
+}
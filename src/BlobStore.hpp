@@ -0,0 +1,114 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace pipedal
+{
+    // Write a file to a temporary file, fsync it, and rename it into place.
+    void WriteFileSynced(const std::filesystem::path &path, const void *data, size_t size);
+
+    // A read-only memory mapping of a blob.
+    class Blob
+    {
+    public:
+        Blob(const Blob &) = delete;
+        Blob &operator=(const Blob &) = delete;
+        ~Blob();
+
+        const uint8_t *data() const { return (const uint8_t *)mappedData; }
+        size_t size() const { return mappedSize; }
+        const std::string &hash() const { return hash_; }
+
+    private:
+        friend class BlobStore;
+        Blob(const std::string &hash, void *mappedData, size_t mappedSize);
+
+        std::string hash_;
+        void *mappedData;
+        size_t mappedSize;
+    };
+
+    /**
+     * @brief Content-addressed storage for large LV2 state values.
+     *
+     * Each blob is stored once, in a file named by the SHA-256 hash of its contents. Presets
+     * that share a value (copies of a preset, presets that load the same model) share the blob.
+     *
+     * While a BlobStore::Scope is active on the current thread, Lv2PluginState values of at least
+     * MIN_BLOB_SIZE bytes are written as a reference to a blob instead of as inline base64, and
+     * blob references are read as read-only mappings of the blob file, which are handed to the
+     * plugin's restore() without being copied. Without a Scope, values are always written inline,
+     * so pedalboards sent to clients, or exported as bank files, are self-contained.
+     */
+    class BlobStore
+    {
+    public:
+        static constexpr size_t MIN_BLOB_SIZE = 4096;
+        static constexpr size_t HASH_LENGTH = 64; // hex digits.
+
+        BlobStore(const std::filesystem::path &directory);
+
+        const std::filesystem::path &GetDirectory() const { return directory; }
+
+        // Stores a value (if it's not already stored), and returns its hash.
+        std::string Put(const uint8_t *data, size_t size);
+        bool Contains(const std::string &hash) const;
+        // Throws if the blob doesn't exist.
+        std::shared_ptr<const Blob> Get(const std::string &hash);
+
+        // Removes every blob whose hash is not in referencedHashes. Returns the number of blobs removed.
+        size_t CollectGarbage(const std::set<std::string> &referencedHashes);
+
+        static std::string Hash(const uint8_t *data, size_t size);
+        static bool IsValidHash(const std::string &hash);
+        // Adds the hashes of blob references in serialized json text to pResult.
+        static void FindReferences(const std::string &jsonText, std::set<std::string> *pResult);
+
+        class Scope
+        {
+        public:
+            Scope(BlobStore *blobStore);
+            ~Scope();
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            BlobStore *previous;
+        };
+        // The BlobStore of the innermost active Scope on this thread, or nullptr.
+        static BlobStore *GetCurrent();
+
+    private:
+        std::filesystem::path GetBlobPath(const std::string &hash) const;
+
+        std::filesystem::path directory;
+        std::mutex mapMutex;
+        std::map<std::string, std::weak_ptr<const Blob>> mappedBlobs;
+    };
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "BlobStore.hpp"
+#include "StateInterface.hpp"
+#include "json.hpp"
+#include <filesystem>
+#include <sstream>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> MakeTestValue(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        result[i] = (uint8_t)(i * 31 + seed);
+    }
+    return result;
+}
+
+static size_t CountBlobs(const fs::path &directory)
+{
+    size_t result = 0;
+    for (const auto &dirEntry : fs::directory_iterator(directory))
+    {
+        if (BlobStore::IsValidHash(dirEntry.path().filename().string()))
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+TEST_CASE("BlobStore stores each value once", "[blob_store][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "BlobStoreTest" / "store";
+    fs::remove_all(root);
+    BlobStore blobStore(root);
+
+    std::vector<uint8_t> value = MakeTestValue(10000, 1);
+    std::string hash = blobStore.Put(value.data(), value.size());
+    REQUIRE(BlobStore::IsValidHash(hash));
+    REQUIRE(blobStore.Put(value.data(), value.size()) == hash);
+    REQUIRE(CountBlobs(root) == 1);
+
+    auto blob = blobStore.Get(hash);
+    REQUIRE(blob->size() == value.size());
+    REQUIRE(memcmp(blob->data(), value.data(), value.size()) == 0);
+    // the same mapping is shared while it's in use.
+    REQUIRE(blobStore.Get(hash).get() == blob.get());
+
+    std::vector<uint8_t> otherValue = MakeTestValue(10000, 2);
+    std::string otherHash = blobStore.Put(otherValue.data(), otherValue.size());
+    REQUIRE(otherHash != hash);
+    REQUIRE(CountBlobs(root) == 2);
+
+    REQUIRE(blobStore.CollectGarbage({hash}) == 1);
+    REQUIRE(blobStore.Contains(hash));
+    REQUIRE(!blobStore.Contains(otherHash));
+    REQUIRE_THROWS(blobStore.Get(otherHash));
+    // mappings remain valid after collection.
+    REQUIRE(blobStore.CollectGarbage({}) == 1);
+    REQUIRE(memcmp(blob->data(), value.data(), value.size()) == 0);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("BlobStore LV2 state serialization", "[blob_store][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "BlobStoreTest" / "state";
+    fs::remove_all(root);
+    BlobStore blobStore(root);
+
+    Lv2PluginState state;
+    state.isValid_ = true;
+    Lv2PluginStateEntry &small = state.values_["urn:test:small"];
+    small.atomType_ = LV2_ATOM__Chunk;
+    small.value_ = MakeTestValue(100, 3);
+    Lv2PluginStateEntry &large = state.values_["urn:test:large"];
+    large.atomType_ = LV2_ATOM__Chunk;
+    large.value_ = MakeTestValue(100000, 4);
+
+    std::string json;
+    {
+        BlobStore::Scope scope{&blobStore};
+        std::stringstream s;
+        json_writer writer(s);
+        writer.write(state);
+        json = s.str();
+    }
+    // the large value is stored by reference, the small value inline.
+    std::set<std::string> references;
+    BlobStore::FindReferences(json, &references);
+    REQUIRE(references.size() == 1);
+    REQUIRE(json.length() < 2000);
+
+    Lv2PluginState restored;
+    {
+        BlobStore::Scope scope{&blobStore};
+        std::stringstream s(json);
+        json_reader reader(s);
+        reader.read(&restored);
+    }
+    REQUIRE(restored.values_["urn:test:large"].blob_);
+    REQUIRE(restored.values_["urn:test:large"].value_.size() == 0);
+    REQUIRE(!restored.values_["urn:test:small"].blob_);
+    REQUIRE(restored == state);
+
+    // without a blob store, values are written inline.
+    std::stringstream inlineJson;
+    json_writer writer(inlineJson);
+    writer.write(restored);
+    references.clear();
+    BlobStore::FindReferences(inlineJson.str(), &references);
+    REQUIRE(references.size() == 0);
+    Lv2PluginState inlineState;
+    {
+        std::stringstream s(inlineJson.str());
+        json_reader reader(s);
+        reader.read(&inlineState);
+    }
+    REQUIRE(inlineState == state);
+
+    // a blob reference can't be read without a blob store.
+    {
+        std::stringstream s(json);
+        json_reader reader(s);
+        Lv2PluginState t;
+        REQUIRE_THROWS(reader.read(&t));
+    }
+
+    fs::remove_all(root);
+}
@@ -22,15 +22,28 @@
 
 
 #include <type_traits>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
 // maintains ownership of allocated buffers.
 
 namespace pipedal {
 
 
 class BufferPool {
+    struct Arena {
+        char *memory;
+        size_t size;
+        bool locked;
+    };
     std::vector<void*> allocatedBuffers;
+    std::vector<Arena> arenas;
 
 public: 
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
     ~BufferPool() {
         Clear();
     }
@@ -46,12 +59,63 @@ public:
         return result;
     }
 
+    // Allocate nBuffers zeroed buffers from a single contiguous block of memory. Each buffer
+    // starts on a cache-line boundary. The block is locked into memory if the process is
+    // permitted to do so.
+    template <typename TYPE>
+    std::vector<TYPE*> AllocateArena(size_t nBuffers, size_t size)
+    {
+        static_assert(std::is_trivial_v<TYPE>);
+        std::vector<TYPE*> result;
+        if (nBuffers == 0)
+        {
+            return result;
+        }
+        size_t stride = (size*sizeof(TYPE) + CACHE_LINE_SIZE-1) & ~(CACHE_LINE_SIZE-1);
+        size_t bytes = stride*nBuffers;
+        char *memory = (char*)std::aligned_alloc(CACHE_LINE_SIZE,bytes);
+        if (memory == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        std::memset(memory,0,bytes);
+        bool locked = false;
+#ifndef NO_MLOCK
+        // failure is not fatal: mlockall() normally covers this memory anyway.
+        locked = mlock(memory,bytes) == 0;
+#endif
+        arenas.push_back(Arena{memory,bytes,locked});
+        for (size_t i = 0; i < nBuffers; ++i)
+        {
+            result.push_back((TYPE*)(memory + i*stride));
+        }
+        return result;
+    }
+
+    size_t GetArenaSize() const {
+        size_t result = 0;
+        for (const auto &arena: arenas)
+        {
+            result += arena.size;
+        }
+        return result;
+    }
+
     void Clear() {
         for (int i = 0; i < allocatedBuffers.size(); ++i)
         {
             delete[] (char*)(allocatedBuffers[i]);
         }
         allocatedBuffers.resize(0);
+        for (auto &arena: arenas)
+        {
+            if (arena.locked)
+            {
+                munlock(arena.memory,arena.size);
+            }
+            std::free(arena.memory);
+        }
+        arenas.resize(0);
     }
 
 
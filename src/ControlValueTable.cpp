@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "ControlValueTable.hpp"
+
+using namespace pipedal;
+
+void ControlValueTable::Prepare(const std::vector<size_t> &controlCounts)
+{
+    effectOffsets.clear();
+    effectControlCounts = controlCounts;
+    slotEffects.clear();
+    slotControls.clear();
+    for (size_t effect = 0; effect < controlCounts.size(); ++effect)
+    {
+        effectOffsets.push_back(slotEffects.size());
+        for (size_t control = 0; control < controlCounts[effect]; ++control)
+        {
+            slotEffects.push_back((int)effect);
+            slotControls.push_back((int)control);
+        }
+    }
+    size_t slots = slotEffects.size();
+    values = std::make_unique<std::atomic<float>[]>(slots);
+    dirtyWordCount = (slots + 63) / 64;
+    dirty = std::make_unique<std::atomic<uint64_t>[]>(dirtyWordCount);
+    for (size_t i = 0; i < slots; ++i)
+    {
+        values[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < dirtyWordCount; ++i)
+    {
+        dirty[i].store(0, std::memory_order_relaxed);
+    }
+    pending = false;
+}
+
+bool ControlValueTable::Set(int effectIndex, int controlIndex, float value)
+{
+    if (effectIndex < 0 || (size_t)effectIndex >= effectOffsets.size() || controlIndex < 0 || (size_t)controlIndex >= effectControlCounts[effectIndex])
+    {
+        return false;
+    }
+    size_t slot = effectOffsets[effectIndex] + (size_t)controlIndex;
+    values[slot].store(value, std::memory_order_relaxed);
+    // (release: the audio thread sees the value once it sees the dirty bit.)
+    dirty[slot / 64].fetch_or((uint64_t)1 << (slot % 64), std::memory_order_release);
+    pending.store(true, std::memory_order_release);
+    return true;
+}
+
+void ControlValueTable::Clear()
+{
+    for (size_t i = 0; i < dirtyWordCount; ++i)
+    {
+        dirty[i].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Latest requested value of every input control of a pedalboard.
+     *
+     * Host threads write control values with Set(); the audio thread picks up the values that have
+     * changed, once per period, with Apply(). Only the most recent value of each control is applied,
+     * so a fast sweep of a knob or a MIDI controller costs one SetControl per period, no matter how many
+     * values were written.
+     *
+     * Prepare allocates, and must be called while preparing the pedalboard. Set and Clear are lock-free, and may
+     * be called from any thread. Apply is realtime-safe, and must only be called from the audio thread.
+     */
+    class ControlValueTable
+    {
+    public:
+        // controlCounts: number of controls of each effect, in effect-index order.
+        void Prepare(const std::vector<size_t> &controlCounts);
+
+        bool Set(int effectIndex, int controlIndex, float value);
+        // Discard values that haven't been applied yet.
+        void Clear();
+
+        // Call apply(effectIndex, controlIndex, value) for each control set since the last call.
+        template <typename FN>
+        void Apply(FN &&apply)
+        {
+            if (!pending.exchange(false, std::memory_order_acquire))
+            {
+                return;
+            }
+            for (size_t word = 0; word < dirtyWordCount; ++word)
+            {
+                uint64_t bits = dirty[word].exchange(0, std::memory_order_acquire);
+                while (bits != 0)
+                {
+                    size_t bit = (size_t)__builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    size_t slot = word * 64 + bit;
+                    apply(slotEffects[slot], slotControls[slot], values[slot].load(std::memory_order_relaxed));
+                }
+            }
+        }
+
+        size_t GetSlotCount() const { return slotEffects.size(); }
+
+    private:
+        std::vector<size_t> effectOffsets; // first slot of each effect.
+        std::vector<size_t> effectControlCounts;
+        std::vector<int> slotEffects;
+        std::vector<int> slotControls;
+        std::unique_ptr<std::atomic<float>[]> values;
+        std::unique_ptr<std::atomic<uint64_t>[]> dirty;
+        size_t dirtyWordCount = 0;
+        std::atomic<bool> pending = false;
+    };
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ControlValueTable.hpp"
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+using AppliedValues = std::map<std::pair<int, int>, std::vector<float>>;
+
+static AppliedValues Apply(ControlValueTable &table)
+{
+    AppliedValues result;
+    table.Apply([&result](int effectIndex, int controlIndex, float value)
+                { result[{effectIndex, controlIndex}].push_back(value); });
+    return result;
+}
+
+TEST_CASE("Control value table", "[control_value_table][Build]")
+{
+    ControlValueTable table;
+    // enough controls that slots span several dirty words.
+    table.Prepare({3, 0, 100, 70});
+    REQUIRE(table.GetSlotCount() == 173);
+
+    REQUIRE(Apply(table).empty());
+
+    // last value wins.
+    REQUIRE(table.Set(0, 1, 1.0f));
+    REQUIRE(table.Set(0, 1, 2.0f));
+    REQUIRE(table.Set(0, 1, 3.0f));
+    REQUIRE(table.Set(2, 99, 4.0f));
+    REQUIRE(table.Set(3, 69, 5.0f));
+    AppliedValues applied = Apply(table);
+    REQUIRE(applied.size() == 3);
+    REQUIRE(applied[{0, 1}] == std::vector<float>{3.0f});
+    REQUIRE(applied[{2, 99}] == std::vector<float>{4.0f});
+    REQUIRE(applied[{3, 69}] == std::vector<float>{5.0f});
+
+    // applied values are not applied again.
+    REQUIRE(Apply(table).empty());
+
+    // out of range.
+    REQUIRE(!table.Set(1, 0, 1.0f));
+    REQUIRE(!table.Set(0, 3, 1.0f));
+    REQUIRE(!table.Set(4, 0, 1.0f));
+    REQUIRE(!table.Set(-1, 0, 1.0f));
+    REQUIRE(Apply(table).empty());
+
+    table.Set(2, 5, 1.0f);
+    table.Clear();
+    REQUIRE(Apply(table).empty());
+}
+
+TEST_CASE("Control value table concurrent writers", "[control_value_table][Build]")
+{
+    ControlValueTable table;
+    table.Prepare({64, 64});
+
+    // each writer sweeps its own control upward; the reader must see every control's values increase,
+    // and must see the final value of every control.
+    const int WRITERS = 8;
+    const int STEPS = 20000;
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w)
+    {
+        threads.emplace_back([&table, w]()
+                             {
+            for (int i = 1; i <= STEPS; ++i)
+            {
+                table.Set(w % 2, w * 7, (float)i);
+            } });
+    }
+    std::map<std::pair<int, int>, float> lastValues;
+    bool increasing = true;
+    auto collect = [&]()
+    {
+        table.Apply([&](int effectIndex, int controlIndex, float value)
+                    {
+            float &last = lastValues[{effectIndex, controlIndex}];
+            increasing = increasing && value > last;
+            last = value; });
+    };
+    bool done = false;
+    while (!done)
+    {
+        collect();
+        done = lastValues.size() == WRITERS;
+        for (auto &entry : lastValues)
+        {
+            done = done && entry.second == (float)STEPS;
+        }
+        std::this_thread::yield();
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    collect();
+    REQUIRE(increasing);
+    REQUIRE(lastValues.size() == WRITERS);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "EffectCpuUse.hpp"
+#include "IEffect.hpp"
+
+using namespace pipedal;
+
+void EffectCpuUseCollector::AddEffect(int64_t instanceId, StepCost *cost, const IEffect *pEffect)
+{
+    sources.push_back(Source{cost, pEffect, cost->totalNs.load(std::memory_order_relaxed), pEffect ? pEffect->GetSilentPeriods() : 0});
+    EffectCpuUse effect;
+    effect.instanceId_ = instanceId;
+    update.effects_.push_back(effect);
+}
+
+const EffectCpuUpdate &EffectCpuUseCollector::Collect(uint64_t periods, uint64_t frames, double sampleRate)
+{
+    uint64_t nPeriods = periods - lastPeriods;
+    uint64_t nFrames = frames - lastFrames;
+    lastPeriods = periods;
+    lastFrames = frames;
+
+    update.periods_ = nPeriods;
+    update.periodUs_ = (nPeriods == 0 || sampleRate == 0) ? 0 : (float)(nFrames * 1E6 / (nPeriods * sampleRate));
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        Source &source = sources[i];
+        EffectCpuUse &effect = update.effects_[i];
+
+        uint64_t totalNs = source.cost->totalNs.load(std::memory_order_relaxed);
+        effect.averageUs_ = nPeriods == 0 ? 0 : (float)((totalNs - source.lastTotalNs) * 1E-3 / nPeriods);
+        source.lastTotalNs = totalNs;
+
+        effect.maxUs_ = (float)(source.cost->maxNs.load(std::memory_order_relaxed) * 1E-3);
+        source.cost->maxNs.store(0, std::memory_order_relaxed);
+
+        effect.suspended_ = source.effect != nullptr && source.effect->IsSuspended();
+        uint64_t silentPeriods = source.effect ? source.effect->GetSilentPeriods() : 0;
+        effect.silentPeriods_ = silentPeriods - source.lastSilentPeriods;
+        source.lastSilentPeriods = silentPeriods;
+    }
+    return update;
+}
+
+JSON_MAP_BEGIN(EffectCpuUse)
+    JSON_MAP_REFERENCE(EffectCpuUse, instanceId)
+    JSON_MAP_REFERENCE(EffectCpuUse, averageUs)
+    JSON_MAP_REFERENCE(EffectCpuUse, maxUs)
+    JSON_MAP_REFERENCE(EffectCpuUse, suspended)
+    JSON_MAP_REFERENCE(EffectCpuUse, silentPeriods)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(EffectCpuUpdate)
+    JSON_MAP_REFERENCE(EffectCpuUpdate, periodUs)
+    JSON_MAP_REFERENCE(EffectCpuUpdate, periods)
+    JSON_MAP_REFERENCE(EffectCpuUpdate, effects)
+JSON_MAP_END()
@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include "ExecutionPlan.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace pipedal
+{
+    class IEffect;
+
+    class EffectCpuUse
+    {
+    public:
+        int64_t instanceId_ = -1;
+        // Mean execution time per period, since the last update.
+        float averageUs_ = 0;
+        // Longest execution time of a single period, since the last update.
+        float maxUs_ = 0;
+        // True if the effect is bypassed, and is no longer being run (see Lv2Effect hard bypass).
+        bool suspended_ = false;
+        // Periods skipped because the effect's input and output were silent, since the last update.
+        uint64_t silentPeriods_ = 0;
+
+        DECLARE_JSON_MAP(EffectCpuUse);
+    };
+
+    class EffectCpuUpdate
+    {
+    public:
+        // Duration of an audio period, for reporting execution times as a fraction of the available time.
+        float periodUs_ = 0;
+        uint64_t periods_ = 0;
+        std::vector<EffectCpuUse> effects_;
+
+        DECLARE_JSON_MAP(EffectCpuUpdate);
+    };
+
+    /**
+     * @brief Turns the StepCost counters of a pedalboard's effects into periodic EffectCpuUpdates.
+     *
+     * AddEffect allocates, and must be called while preparing the pedalboard. Collect is realtime-safe,
+     * and must be called on the audio thread while no effects are running. Collect resets the maximum
+     * execution times, and overwrites the result of the previous call.
+     */
+    class EffectCpuUseCollector
+    {
+    public:
+        void AddEffect(int64_t instanceId, StepCost *cost, const IEffect *pEffect = nullptr);
+        size_t GetEffectCount() const { return sources.size(); }
+
+        const EffectCpuUpdate &Collect(uint64_t periods, uint64_t frames, double sampleRate);
+
+    private:
+        struct Source
+        {
+            StepCost *cost;
+            const IEffect *effect;
+            uint64_t lastTotalNs;
+            uint64_t lastSilentPeriods;
+        };
+        std::vector<Source> sources;
+        uint64_t lastPeriods = 0;
+        uint64_t lastFrames = 0;
+        EffectCpuUpdate update;
+    };
+}
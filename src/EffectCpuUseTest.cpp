@@ -0,0 +1,87 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "EffectCpuUse.hpp"
+#include <sstream>
+
+using namespace pipedal;
+using namespace std;
+
+TEST_CASE("Effect CPU use", "[effect_cpu_use][Build]")
+{
+    StepCost costs[2];
+    costs[0].Add(1000); // before the collector was created; not reported.
+
+    EffectCpuUseCollector collector;
+    collector.AddEffect(10, &costs[0]);
+    collector.AddEffect(11, &costs[1]);
+    REQUIRE(collector.GetEffectCount() == 2);
+
+    // 4 periods of 64 frames at 48kHz.
+    costs[0].Add(10000);
+    costs[0].Add(30000);
+    costs[0].Add(10000);
+    costs[0].Add(10000);
+    costs[1].Add(2000);
+    costs[1].Add(2000);
+    costs[1].Add(2000);
+    costs[1].Add(2000);
+
+    const EffectCpuUpdate &update = collector.Collect(4, 4 * 64, 48000);
+    REQUIRE(update.periods_ == 4);
+    REQUIRE(update.periodUs_ == Approx(1333.333));
+    REQUIRE(update.effects_.size() == 2);
+    REQUIRE(update.effects_[0].instanceId_ == 10);
+    REQUIRE(update.effects_[0].averageUs_ == Approx(15));
+    REQUIRE(update.effects_[0].maxUs_ == Approx(30));
+    REQUIRE(update.effects_[1].instanceId_ == 11);
+    REQUIRE(update.effects_[1].averageUs_ == Approx(2));
+    REQUIRE(update.effects_[1].maxUs_ == Approx(2));
+    REQUIRE(!update.effects_[0].suspended_); // no effect to ask.
+    REQUIRE(update.effects_[0].silentPeriods_ == 0);
+
+    // maximums are reset by each collection.
+    REQUIRE(costs[0].maxNs.load() == 0);
+    costs[0].Add(5000);
+    costs[0].Add(7000);
+    const EffectCpuUpdate &update2 = collector.Collect(6, 6 * 64, 48000);
+    REQUIRE(update2.periods_ == 2);
+    REQUIRE(update2.effects_[0].averageUs_ == Approx(6));
+    REQUIRE(update2.effects_[0].maxUs_ == Approx(7));
+    REQUIRE(update2.effects_[1].averageUs_ == 0);
+    REQUIRE(update2.effects_[1].maxUs_ == 0);
+
+    // no periods since the last collection.
+    const EffectCpuUpdate &update3 = collector.Collect(6, 6 * 64, 48000);
+    REQUIRE(update3.periods_ == 0);
+    REQUIRE(update3.periodUs_ == 0);
+    REQUIRE(update3.effects_[0].averageUs_ == 0);
+
+    std::stringstream s;
+    json_writer writer(s);
+    writer.write(update);
+    json_reader reader(s);
+    EffectCpuUpdate copy;
+    reader.read(&copy);
+    REQUIRE(copy.effects_.size() == 2);
+    REQUIRE(copy.effects_[1].instanceId_ == 11);
+}
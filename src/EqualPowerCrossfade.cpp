@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "EqualPowerCrossfade.hpp"
+#include "PiPedalCommon.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using namespace pipedal;
+
+void EqualPowerCrossfade::Start(size_t frames)
+{
+    length = frames;
+    position = 0;
+}
+
+void EqualPowerCrossfade::Mix(float *const *outputs, const float *const *fadingOutputs, size_t channels, size_t frames)
+{
+    if (!IsActive())
+    {
+        return;
+    }
+    size_t fadeFrames = std::min(frames, length - position);
+
+    // Gains for consecutive frames are generated by rotating (cos,sin) by a fixed angle, starting
+    // from an exact value at the start of each period, so that rounding errors can't accumulate.
+    constexpr double QUARTER_CYCLE = std::numbers::pi / 2;
+    double step = QUARTER_CYCLE / length;
+    double angle = QUARTER_CYCLE * position / length;
+    float startOut = (float)std::cos(angle);
+    float startIn = (float)std::sin(angle);
+    float rotateCos = (float)std::cos(step);
+    float rotateSin = (float)std::sin(step);
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        float *PIPEDAL_RESTRICT output = outputs[c];
+        const float *PIPEDAL_RESTRICT fadingOutput = fadingOutputs[c];
+        float fadeOut = startOut;
+        float fadeIn = startIn;
+        for (size_t i = 0; i < fadeFrames; ++i)
+        {
+            output[i] = fadeIn * output[i] + fadeOut * fadingOutput[i];
+            float t = fadeOut * rotateCos - fadeIn * rotateSin;
+            fadeIn = fadeIn * rotateCos + fadeOut * rotateSin;
+            fadeOut = t;
+        }
+        // frames after the end of the fade have a gain of 1 on the incoming signal, so are left alone.
+    }
+    position += fadeFrames;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace pipedal
+{
+    /**
+     * @brief An equal-power crossfade from an outgoing signal to an incoming signal.
+     *
+     * Gains follow a quarter cycle of cos/sin, so the summed power of two uncorrelated signals stays
+     * constant through the transition. The fade advances by the number of frames passed to each
+     * call to Mix(), and completes after the number of frames passed to Start().
+     */
+    class EqualPowerCrossfade
+    {
+    public:
+        void Start(size_t frames);
+        void Stop() { position = length = 0; }
+
+        bool IsActive() const { return position < length; }
+        size_t GetPosition() const { return position; }
+        size_t GetLength() const { return length; }
+
+        // outputs[c] = fadeIn*outputs[c] + fadeOut*fadingOutputs[c], and advance the fade.
+        void Mix(float *const *outputs, const float *const *fadingOutputs, size_t channels, size_t frames);
+
+    private:
+        size_t length = 0;
+        size_t position = 0;
+    };
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "EqualPowerCrossfade.hpp"
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+// Run a crossfade from a constant 1.0 signal to a constant 2.0 signal, and recover the gains applied at each frame.
+static void RunCrossfade(size_t length, size_t periodSize, size_t totalFrames, std::vector<float> &fadeIn, std::vector<float> &fadeOut)
+{
+    EqualPowerCrossfade crossfade;
+    crossfade.Start(length);
+
+    // channel 0 fades from 0 to 1, and channel 1 from 1 to 1, so that the two gains can be separated.
+    fadeIn.clear();
+    fadeOut.clear();
+    for (size_t frame = 0; frame < totalFrames; frame += periodSize)
+    {
+        size_t frames = std::min(periodSize, totalFrames - frame);
+        std::vector<float> a(frames, 1.0f), b(frames, 1.0f);
+        std::vector<float> oldA(frames, 0.0f), oldB(frames, 1.0f);
+        float *outputs[2] = {a.data(), b.data()};
+        const float *fadingOutputs[2] = {oldA.data(), oldB.data()};
+        crossfade.Mix(outputs, fadingOutputs, 2, frames);
+        for (size_t i = 0; i < frames; ++i)
+        {
+            fadeIn.push_back(a[i]);
+            fadeOut.push_back(b[i] - a[i]);
+        }
+    }
+    REQUIRE(!crossfade.IsActive());
+}
+
+TEST_CASE("Equal power crossfade gains", "[equal_power_crossfade][Build]")
+{
+    const size_t length = 1000;
+    for (size_t periodSize : {1, 16, 64, 333, 4096})
+    {
+        INFO("period size " << periodSize);
+        std::vector<float> fadeIn, fadeOut;
+        RunCrossfade(length, periodSize, length + 100, fadeIn, fadeOut);
+
+        REQUIRE(fadeIn[0] == Approx(0.0f).margin(1E-6));
+        REQUIRE(fadeOut[0] == Approx(1.0f));
+        for (size_t i = 0; i < length; ++i)
+        {
+            // constant power, monotonic.
+            REQUIRE(fadeIn[i] * fadeIn[i] + fadeOut[i] * fadeOut[i] == Approx(1.0f).margin(1E-4));
+            if (i != 0)
+            {
+                REQUIRE(fadeIn[i] > fadeIn[i - 1]);
+                REQUIRE(fadeOut[i] < fadeOut[i - 1]);
+            }
+        }
+        REQUIRE(fadeIn[length / 2] == Approx(std::sqrt(0.5f)).margin(2E-3));
+        REQUIRE(fadeOut[length - 1] == Approx(0.0f).margin(2E-3));
+
+        // after the fade, the incoming signal is untouched.
+        for (size_t i = length; i < fadeIn.size(); ++i)
+        {
+            REQUIRE(fadeIn[i] == 1.0f);
+            REQUIRE(fadeOut[i] == 0.0f);
+        }
+    }
+}
+
+TEST_CASE("Equal power crossfade restart", "[equal_power_crossfade][Build]")
+{
+    EqualPowerCrossfade crossfade;
+    REQUIRE(!crossfade.IsActive());
+
+    crossfade.Start(100);
+    std::vector<float> output(64, 1.0f), fading(64, 1.0f);
+    float *outputs[1] = {output.data()};
+    const float *fadingOutputs[1] = {fading.data()};
+    crossfade.Mix(outputs, fadingOutputs, 1, 64);
+    REQUIRE(crossfade.IsActive());
+    REQUIRE(crossfade.GetPosition() == 64);
+
+    crossfade.Start(100);
+    REQUIRE(crossfade.GetPosition() == 0);
+
+    crossfade.Stop();
+    REQUIRE(!crossfade.IsActive());
+    std::fill(output.begin(), output.end(), 0.5f);
+    crossfade.Mix(outputs, fadingOutputs, 1, 64);
+    REQUIRE(output[0] == 0.5f);
+}
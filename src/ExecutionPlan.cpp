@@ -0,0 +1,295 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "ExecutionPlan.hpp"
+#include "ss.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+void ExecutionGraph::Clear()
+{
+    nodes.clear();
+    bufferProducers.clear();
+}
+
+int32_t ExecutionGraph::AddNode(NodeType type, int64_t instanceId, const std::string &name)
+{
+    nodes.push_back(Node{type, instanceId, name, {}, {}, {}});
+    return (int32_t)(nodes.size() - 1);
+}
+
+void ExecutionGraph::AddBufferEdge(int32_t node, const float *buffer, EdgeType type)
+{
+    auto &reads = nodes[node].reads;
+    if (std::find(reads.begin(), reads.end(), buffer) == reads.end())
+    {
+        reads.push_back(buffer);
+    }
+
+    int32_t from = GetBufferProducer(buffer);
+    if (from == -1 || from == node)
+    {
+        return;
+    }
+    auto &inputs = nodes[node].inputs;
+    for (const auto &edge : inputs)
+    {
+        if (edge.from == from && edge.type == type)
+        {
+            return;
+        }
+    }
+    inputs.push_back(Edge{from, type});
+}
+
+void ExecutionGraph::SetBufferProducer(const float *buffer, int32_t node)
+{
+    bufferProducers[buffer] = node;
+    nodes[node].writes.push_back(buffer);
+}
+
+std::map<const float *, ExecutionGraph::BufferLifetime> ExecutionGraph::GetBufferLifetimes() const
+{
+    std::map<const float *, BufferLifetime> result;
+    auto touch = [&result](const float *buffer, int32_t node)
+    {
+        BufferLifetime &lifetime = result[buffer];
+        if (lifetime.first == -1 || node < lifetime.first)
+        {
+            lifetime.first = node;
+        }
+        if (node > lifetime.last)
+        {
+            lifetime.last = node;
+        }
+    };
+    for (int32_t i = 0; i < (int32_t)nodes.size(); ++i)
+    {
+        for (const float *buffer : nodes[i].writes)
+        {
+            touch(buffer, i);
+        }
+        for (const float *buffer : nodes[i].reads)
+        {
+            touch(buffer, i);
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> pipedal::AssignBufferSlots(const std::vector<BufferSlotRequest> &requests, size_t *pSlotCount)
+{
+    std::vector<size_t> order(requests.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&requests](size_t a, size_t b)
+                     { return requests[a].first < requests[b].first; });
+
+    struct Slot
+    {
+        int32_t group;
+        int32_t last;
+    };
+    std::vector<Slot> slots;
+    std::vector<size_t> result(requests.size());
+    for (size_t index : order)
+    {
+        const auto &request = requests[index];
+        size_t slot = slots.size();
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            if (slots[i].group == request.group && slots[i].last < request.first)
+            {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == slots.size())
+        {
+            slots.push_back(Slot{request.group, request.last});
+        }
+        else
+        {
+            slots[slot].last = request.last;
+        }
+        result[index] = slot;
+    }
+    *pSlotCount = slots.size();
+    return result;
+}
+
+int32_t ExecutionGraph::GetBufferProducer(const float *buffer) const
+{
+    auto f = bufferProducers.find(buffer);
+    if (f == bufferProducers.end())
+    {
+        return -1;
+    }
+    return f->second;
+}
+
+bool ExecutionGraph::FindEdge(
+    int32_t fromBegin, int32_t fromEnd,
+    int32_t toBegin, int32_t toEnd,
+    int32_t *pFrom, int32_t *pTo) const
+{
+    int32_t bestFrom = -1;
+    int32_t bestTo = -1;
+    for (int32_t to = toBegin; to < toEnd; ++to)
+    {
+        for (const auto &edge : nodes[to].inputs)
+        {
+            if (edge.from >= fromBegin && edge.from < fromEnd && (bestFrom == -1 || edge.from < bestFrom))
+            {
+                bestFrom = edge.from;
+                bestTo = to;
+            }
+        }
+    }
+    if (bestFrom == -1)
+    {
+        return false;
+    }
+    *pFrom = bestFrom;
+    *pTo = bestTo;
+    return true;
+}
+
+std::vector<size_t> ExecutionGraph::MergePipelineStages(const std::vector<PipelineStageNodes> &stages, std::vector<std::string> *mergeReasons) const
+{
+    size_t nStages = stages.size();
+    std::vector<size_t> groups(nStages);
+    for (size_t k = 0; k < nStages; ++k)
+    {
+        groups[k] = k;
+    }
+    mergeReasons->assign(nStages, "");
+
+    for (size_t k = 1; k < nStages; ++k)
+    {
+        int32_t fromNode = -1, toNode = -1;
+        if (!FindEdge(0, stages[k].beginNode, stages[k].beginNode + 1, stages[k].endNode, &fromNode, &toNode))
+        {
+            continue;
+        }
+        // nodes before stage 0 (the pedalboard input) are written by stage 0's thread.
+        size_t sourceStage = 0;
+        while (sourceStage + 1 < k && stages[sourceStage + 1].beginNode <= fromNode)
+        {
+            ++sourceStage;
+        }
+        size_t target = groups[sourceStage];
+        size_t last = k;
+        std::string reason = SS(
+            "node " << GetNodeDescription(toNode)
+                    << " depends on node " << GetNodeDescription(fromNode) << ".");
+        if (target != groups[k - 1])
+        {
+            target = 0;
+            last = nStages - 1;
+            reason = "pipelining disabled, " + reason;
+        }
+        for (size_t j = target + 1; j <= last; ++j)
+        {
+            if (groups[j] != target)
+            {
+                groups[j] = target;
+                if ((*mergeReasons)[j].empty())
+                {
+                    (*mergeReasons)[j] = reason;
+                }
+            }
+        }
+    }
+    return groups;
+}
+
+static const char *NodeTypeName(ExecutionGraph::NodeType type)
+{
+    switch (type)
+    {
+    case ExecutionGraph::NodeType::PedalboardInput:
+        return "input";
+    case ExecutionGraph::NodeType::Effect:
+        return "effect";
+    case ExecutionGraph::NodeType::SplitStart:
+        return "split-start";
+    case ExecutionGraph::NodeType::SplitEnd:
+        return "split-end";
+    case ExecutionGraph::NodeType::PipelineHandoff:
+        return "pipeline-handoff";
+    default:
+        return "?";
+    }
+}
+
+std::string ExecutionGraph::GetNodeDescription(int32_t node) const
+{
+    if (node < 0 || node >= (int32_t)nodes.size())
+    {
+        return "#?";
+    }
+    const Node &n = nodes[node];
+    if (n.type == NodeType::PedalboardInput)
+    {
+        return SS("#" << node << " input");
+    }
+    return SS("#" << node << " " << NodeTypeName(n.type) << " " << n.instanceId << " (" << n.name << ")");
+}
+
+void ExecutionGraph::Dump(std::ostream &s) const
+{
+    s << "Nodes:" << std::endl;
+    for (int32_t i = 0; i < (int32_t)nodes.size(); ++i)
+    {
+        s << "    " << GetNodeDescription(i);
+        const auto &inputs = nodes[i].inputs;
+        if (!inputs.empty())
+        {
+            s << " <-";
+            for (const auto &edge : inputs)
+            {
+                s << " #" << edge.from;
+                if (edge.type == EdgeType::Sidechain)
+                {
+                    s << "(sidechain)";
+                }
+            }
+        }
+        s << std::endl;
+    }
+}
+
+void ExecutionGraph::DumpSteps(std::ostream &s, const ExecutionSteps &steps, const std::string &indent)
+{
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        const auto &step = steps[i];
+        s << indent << i << ": " << step.name << " #" << step.node;
+        if (step.controlIndex != -1)
+        {
+            s << " control " << step.controlIndex << "=" << step.value;
+        }
+        s << std::endl;
+    }
+}
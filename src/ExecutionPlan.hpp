@@ -0,0 +1,206 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <atomic>
+#include <algorithm>
+
+namespace pipedal
+{
+    class RealtimeRingBufferWriter;
+
+    /**
+     * @brief Accumulated execution time of an execution graph node.
+     *
+     * Each node is run by exactly one thread, so there is a single writer; the fields are atomic
+     * only so that other threads can read them.
+     */
+    struct StepCost
+    {
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0}; // longest single run since maxNs was last reset.
+        std::atomic<uint32_t> lastNs{0}; // the most recent run.
+
+        void Add(uint64_t ns)
+        {
+            lastNs.store((uint32_t)std::min<uint64_t>(ns, UINT32_MAX), std::memory_order_relaxed);
+            totalNs.store(totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > maxNs.load(std::memory_order_relaxed))
+            {
+                maxNs.store(ns, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief One step of a compiled pedalboard execution plan.
+     *
+     * Steps are plain data, stored contiguously, and dispatched through a plain function pointer.
+     * The meaning of target, controlIndex and value depends on the step function.
+     */
+    struct ExecutionStep
+    {
+        using Function = void (*)(const ExecutionStep &step, uint32_t frames);
+
+        Function fn = nullptr;
+        void *target = nullptr;
+        RealtimeRingBufferWriter **ppWriter = nullptr;
+        int32_t controlIndex = -1;
+        float value = 0;
+        int32_t node = -1;       // ExecutionGraph node that generated the step.
+        StepCost *pCost = nullptr; // accumulated execution time, for steps that measure it.
+        const char *name = "";   // for debug dumps.
+    };
+
+    using ExecutionSteps = std::vector<ExecutionStep>;
+
+    /**
+     * @brief Dependency graph of a pedalboard.
+     *
+     * Nodes are effects (splits contribute a start and an end node; pipeline stage boundaries
+     * contribute a handoff node). Edges are derived from
+     * the audio buffers that each node reads: an edge runs from the node that writes a buffer
+     * to each node that reads it, including sidechain inputs.
+     *
+     * Nodes are numbered in the order in which they were prepared, so the nodes of a chain
+     * occupy a contiguous range of node indices.
+     */
+    class ExecutionGraph
+    {
+    public:
+        enum class NodeType
+        {
+            PedalboardInput,
+            Effect,
+            SplitStart,
+            SplitEnd,
+            PipelineHandoff
+        };
+        enum class EdgeType
+        {
+            Audio,
+            Sidechain
+        };
+        struct Edge
+        {
+            int32_t from = -1;
+            EdgeType type = EdgeType::Audio;
+        };
+        struct Node
+        {
+            NodeType type = NodeType::Effect;
+            int64_t instanceId = -1;
+            std::string name;
+            std::vector<Edge> inputs;
+            std::vector<const float *> reads;
+            std::vector<const float *> writes;
+        };
+        // The first and last node that touch a buffer.
+        struct BufferLifetime
+        {
+            int32_t first = -1;
+            int32_t last = -1;
+        };
+
+        void Clear();
+
+        int32_t AddNode(NodeType type, int64_t instanceId, const std::string &name);
+
+        // Record that node reads buffer, and add an edge from the node that writes buffer, if there is one.
+        void AddBufferEdge(int32_t node, const float *buffer, EdgeType type = EdgeType::Audio);
+        void SetBufferProducer(const float *buffer, int32_t node);
+        int32_t GetBufferProducer(const float *buffer) const;
+
+        int32_t GetNodeCount() const { return (int32_t)nodes.size(); }
+        const Node &GetNode(int32_t index) const { return nodes[index]; }
+
+        /**
+         * @brief Find an edge into the nodes [toBegin,toEnd) from the nodes [fromBegin,fromEnd).
+         *
+         * If there are several, the edge from the earliest node is returned.
+         *
+         * @returns true if there is such an edge, in which case *pFrom and *pTo are set.
+         */
+        bool FindEdge(
+            int32_t fromBegin, int32_t fromEnd,
+            int32_t toBegin, int32_t toEnd,
+            int32_t *pFrom, int32_t *pTo) const;
+
+        // The nodes [beginNode,endNode) of a pipeline stage. The first node of every stage but stage 0 is its handoff node.
+        struct PipelineStageNodes
+        {
+            int32_t beginNode = -1;
+            int32_t endNode = -1;
+        };
+
+        /**
+         * @brief Decide which pipeline stages can't run on their own thread.
+         *
+         * A stage that reads a buffer written by an earlier stage (other than through its handoff
+         * node), or by the pedalboard input, would read it while another thread writes it, and a period
+         * late. Such a stage is merged, together with every stage in between, into the stage that
+         * writes the buffer. If that isn't the group directly before the stage, pipelining is abandoned,
+         * and every stage is merged into stage 0.
+         *
+         * @returns the stage whose thread runs each stage. Groups of merged stages are contiguous.
+         */
+        std::vector<size_t> MergePipelineStages(const std::vector<PipelineStageNodes> &stages, std::vector<std::string> *mergeReasons) const;
+
+        std::map<const float *, BufferLifetime> GetBufferLifetimes() const;
+
+        std::string GetNodeDescription(int32_t node) const;
+
+        void Dump(std::ostream &s) const;
+
+        static void DumpSteps(std::ostream &s, const ExecutionSteps &steps, const std::string &indent);
+
+    private:
+        std::vector<Node> nodes;
+        std::map<const float *, int32_t> bufferProducers;
+    };
+
+    /**
+     * @brief A request for storage for one audio buffer.
+     *
+     * Buffers in the same group execute sequentially, in node order. Buffers in different groups may be
+     * in use concurrently, and never share storage.
+     */
+    struct BufferSlotRequest
+    {
+        int32_t first;
+        int32_t last;
+        int32_t group;
+    };
+
+    /**
+     * @brief Assign buffers to storage slots.
+     *
+     * Buffers share a slot only if they are in the same group and their lifetimes [first,last] do not overlap.
+     * Greedy assignment in order of first use, which is optimal for interval graphs.
+     *
+     * @returns the slot assigned to each request. *pSlotCount receives the number of slots required.
+     */
+    std::vector<size_t> AssignBufferSlots(const std::vector<BufferSlotRequest> &requests, size_t *pSlotCount);
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ExecutionPlan.hpp"
+#include "BufferPool.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("Buffer lifetimes", "[execution_plan][Build]")
+{
+    // input -> a -> b -> c, with c also taking a sidechain from a.
+    float input[1], aOut[1], bOut[1], cOut[1];
+    ExecutionGraph graph;
+    int32_t inputNode = graph.AddNode(ExecutionGraph::NodeType::PedalboardInput, -1, "");
+    graph.SetBufferProducer(input, inputNode);
+
+    int32_t a = graph.AddNode(ExecutionGraph::NodeType::Effect, 1, "a");
+    graph.AddBufferEdge(a, input);
+    graph.SetBufferProducer(aOut, a);
+
+    int32_t b = graph.AddNode(ExecutionGraph::NodeType::Effect, 2, "b");
+    graph.AddBufferEdge(b, aOut);
+    graph.SetBufferProducer(bOut, b);
+
+    int32_t c = graph.AddNode(ExecutionGraph::NodeType::Effect, 3, "c");
+    graph.AddBufferEdge(c, bOut);
+    graph.AddBufferEdge(c, aOut, ExecutionGraph::EdgeType::Sidechain);
+    graph.SetBufferProducer(cOut, c);
+
+    auto lifetimes = graph.GetBufferLifetimes();
+    REQUIRE(lifetimes[input].first == inputNode);
+    REQUIRE(lifetimes[input].last == a);
+    REQUIRE(lifetimes[aOut].first == a);
+    REQUIRE(lifetimes[aOut].last == c);
+    REQUIRE(lifetimes[bOut].first == b);
+    REQUIRE(lifetimes[bOut].last == c);
+    REQUIRE(lifetimes[cOut].first == c);
+    REQUIRE(lifetimes[cOut].last == c);
+
+    int32_t from, to;
+    REQUIRE(graph.FindEdge(a, a + 1, c, c + 1, &from, &to));
+    REQUIRE(from == a);
+    REQUIRE(to == c);
+    REQUIRE(!graph.FindEdge(c, c + 1, a, c, &from, &to));
+}
+
+namespace
+{
+    // input -> s0 -> handoff1 -> s1 -> handoff2 -> s2, a pedalboard split into three pipeline stages.
+    class ThreeStageGraph
+    {
+    public:
+        ThreeStageGraph()
+        {
+            inputNode = graph.AddNode(ExecutionGraph::NodeType::PedalboardInput, -1, "");
+            graph.SetBufferProducer(input, inputNode);
+            s0 = AddEffect(1, "s0", input, s0Out);
+            handoff1 = AddHandoff(s0Out, handoff1Out);
+            s1 = AddEffect(2, "s1", handoff1Out, s1Out);
+            handoff2 = AddHandoff(s1Out, handoff2Out);
+            s2 = AddEffect(3, "s2", handoff2Out, s2Out);
+        }
+        std::vector<ExecutionGraph::PipelineStageNodes> Stages() const
+        {
+            return {{s0, handoff1}, {handoff1, handoff2}, {handoff2, s2 + 1}};
+        }
+
+        ExecutionGraph graph;
+        float input[1], s0Out[1], handoff1Out[1], s1Out[1], handoff2Out[1], s2Out[1];
+        int32_t inputNode, s0, handoff1, s1, handoff2, s2;
+
+    private:
+        int32_t AddEffect(int64_t instanceId, const std::string &name, const float *in, const float *out)
+        {
+            int32_t node = graph.AddNode(ExecutionGraph::NodeType::Effect, instanceId, name);
+            graph.AddBufferEdge(node, in);
+            graph.SetBufferProducer(out, node);
+            return node;
+        }
+        int32_t AddHandoff(const float *in, const float *out)
+        {
+            int32_t node = graph.AddNode(ExecutionGraph::NodeType::PipelineHandoff, -1, "");
+            graph.AddBufferEdge(node, in);
+            graph.SetBufferProducer(out, node);
+            return node;
+        }
+    };
+}
+
+TEST_CASE("Pipeline stage merging", "[execution_plan][Build]")
+{
+    std::vector<std::string> reasons;
+    SECTION("independent stages")
+    {
+        ThreeStageGraph g;
+        auto groups = g.graph.MergePipelineStages(g.Stages(), &reasons);
+        REQUIRE(groups == std::vector<size_t>{0, 1, 2});
+        REQUIRE(reasons[1].empty());
+        REQUIRE(reasons[2].empty());
+    }
+    SECTION("sidechain from the previous stage")
+    {
+        ThreeStageGraph g;
+        g.graph.AddBufferEdge(g.s2, g.s1Out, ExecutionGraph::EdgeType::Sidechain);
+        auto groups = g.graph.MergePipelineStages(g.Stages(), &reasons);
+        REQUIRE(groups == std::vector<size_t>{0, 1, 1});
+        REQUIRE(reasons[1].empty());
+        REQUIRE(!reasons[2].empty());
+    }
+    SECTION("sidechain from two stages back")
+    {
+        // stage 2 reads s0's output, which stage 0's thread writes while stage 1 is running.
+        ThreeStageGraph g;
+        g.graph.AddBufferEdge(g.s2, g.s0Out, ExecutionGraph::EdgeType::Sidechain);
+        auto groups = g.graph.MergePipelineStages(g.Stages(), &reasons);
+        REQUIRE(groups == std::vector<size_t>{0, 0, 0});
+        REQUIRE(reasons[1].find("pipelining disabled") != std::string::npos);
+        REQUIRE(reasons[2].find("pipelining disabled") != std::string::npos);
+    }
+    SECTION("sidechain from the pedalboard input")
+    {
+        ThreeStageGraph g;
+        g.graph.AddBufferEdge(g.s1, g.input, ExecutionGraph::EdgeType::Sidechain);
+        auto groups = g.graph.MergePipelineStages(g.Stages(), &reasons);
+        REQUIRE(groups == std::vector<size_t>{0, 0, 2});
+    }
+    SECTION("earlier stages already merged")
+    {
+        // stage 1 merges into stage 0, so stage 2's sidechain from stage 0 comes from the previous group.
+        ThreeStageGraph g;
+        g.graph.AddBufferEdge(g.s1, g.input, ExecutionGraph::EdgeType::Sidechain);
+        g.graph.AddBufferEdge(g.s2, g.s0Out, ExecutionGraph::EdgeType::Sidechain);
+        auto groups = g.graph.MergePipelineStages(g.Stages(), &reasons);
+        REQUIRE(groups == std::vector<size_t>{0, 0, 0});
+        REQUIRE(reasons[2].find("pipelining disabled") == std::string::npos);
+    }
+}
+
+TEST_CASE("Buffer slot assignment", "[execution_plan][Build]")
+{
+    SECTION("Chain")
+    {
+        // a straight chain only ever needs two buffers.
+        std::vector<BufferSlotRequest> requests;
+        for (int32_t i = 0; i < 10; ++i)
+        {
+            requests.push_back(BufferSlotRequest{i, i + 1, 0});
+        }
+        size_t slotCount = 0;
+        auto slots = AssignBufferSlots(requests, &slotCount);
+        REQUIRE(slotCount == 2);
+        for (size_t i = 1; i < slots.size(); ++i)
+        {
+            REQUIRE(slots[i] != slots[i - 1]);
+        }
+    }
+    SECTION("Overlapping lifetimes never share")
+    {
+        std::vector<BufferSlotRequest> requests{
+            {0, 5, 0},
+            {1, 2, 0},
+            {3, 4, 0},
+            {4, 6, 0},
+            {6, 7, 0},
+        };
+        size_t slotCount = 0;
+        auto slots = AssignBufferSlots(requests, &slotCount);
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            for (size_t j = i + 1; j < requests.size(); ++j)
+            {
+                bool overlap = requests[i].first <= requests[j].last && requests[j].first <= requests[i].last;
+                if (overlap)
+                {
+                    REQUIRE(slots[i] != slots[j]);
+                }
+            }
+        }
+        REQUIRE(slotCount == 3);
+    }
+    SECTION("Groups never share")
+    {
+        std::vector<BufferSlotRequest> requests{
+            {0, 1, 0},
+            {2, 3, 1},
+            {4, 5, 0},
+        };
+        size_t slotCount = 0;
+        auto slots = AssignBufferSlots(requests, &slotCount);
+        REQUIRE(slotCount == 2);
+        REQUIRE(slots[0] == slots[2]);
+        REQUIRE(slots[0] != slots[1]);
+    }
+}
+
+TEST_CASE("BufferPool arena", "[execution_plan][Build]")
+{
+    BufferPool pool;
+    auto buffers = pool.AllocateArena<float>(5, 33);
+    REQUIRE(buffers.size() == 5);
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        REQUIRE(((uintptr_t)buffers[i]) % BufferPool::CACHE_LINE_SIZE == 0);
+        for (size_t j = 0; j < 33; ++j)
+        {
+            REQUIRE(buffers[i][j] == 0);
+        }
+        if (i != 0)
+        {
+            REQUIRE(buffers[i] - buffers[i - 1] == 48); // 33 floats, rounded up to a cache line.
+        }
+    }
+    REQUIRE(pool.GetArenaSize() == 5 * 48 * sizeof(float));
+}
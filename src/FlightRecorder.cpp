@@ -0,0 +1,371 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "FlightRecorder.hpp"
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <sys/mman.h>
+
+using namespace pipedal;
+
+uint64_t FlightRecord::GetTotalNs() const
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < (size_t)FlightPhase::Count; ++i)
+    {
+        result += phaseNs[i];
+    }
+    return result;
+}
+
+FlightRecorder::FlightRecorder(size_t capacity)
+{
+    size_t n = 1;
+    while (n < capacity)
+    {
+        n *= 2;
+    }
+    this->capacity = n;
+    this->mappedBytes = n * sizeof(FlightRecord);
+
+    // An anonymous mapping, pre-faulted, and locked if possible, so the audio thread never takes a page fault.
+    void *p = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (p != MAP_FAILED)
+    {
+        mlock(p, mappedBytes); // best effort; mlockall() may already have locked it.
+        this->records = (FlightRecord *)p;
+        this->mapped = true;
+    }
+    else
+    {
+        this->records = new FlightRecord[n];
+        memset((void *)records, 0, mappedBytes);
+    }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    if (mapped)
+    {
+        munmap(records, mappedBytes);
+    }
+    else
+    {
+        delete[] records;
+    }
+}
+
+void FlightRecorder::Reset()
+{
+    periodCount = 0;
+    current = nullptr;
+}
+
+void FlightRecorder::BeginPeriod(uint32_t frames)
+{
+    if (frozen.load(std::memory_order_acquire))
+    {
+        current = nullptr;
+        droppedPeriods.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t index = writeIndex.load(std::memory_order_relaxed);
+    FlightRecord *record = &records[index & (capacity - 1)];
+    record->period = periodCount++;
+    record->startNs = lastMarkNs = Now();
+    record->pedalboardId = 0;
+    for (size_t i = 0; i < (size_t)FlightPhase::Count; ++i)
+    {
+        record->phaseNs[i] = 0;
+    }
+    record->frames = frames;
+    record->captureAvail = 0;
+    record->playbackAvail = 0;
+    record->temperaturemC = temperaturemC.load(std::memory_order_relaxed);
+    record->cpuFreqMinKHz = cpuFreqMinKHz.load(std::memory_order_relaxed);
+    record->cpuFreqMaxKHz = cpuFreqMaxKHz.load(std::memory_order_relaxed);
+    record->flags = 0;
+    record->effectCount = 0;
+    current = record;
+}
+
+void FlightRecorder::OnXrun()
+{
+    if (!current)
+    {
+        return;
+    }
+    current->flags |= FlightRecord::XRUN;
+    if (!triggered)
+    {
+        triggered = true;
+        postTriggerRemaining = POST_TRIGGER_PERIODS;
+    }
+}
+
+void FlightRecorder::EndPeriod()
+{
+    if (!current)
+    {
+        return;
+    }
+    current = nullptr;
+    writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    if (triggered)
+    {
+        if (--postTriggerRemaining == 0)
+        {
+            triggered = false;
+            frozen.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void FlightRecorder::SetSystemState(int32_t temperaturemC, uint32_t cpuFreqMinKHz, uint32_t cpuFreqMaxKHz)
+{
+    this->temperaturemC.store(temperaturemC, std::memory_order_relaxed);
+    this->cpuFreqMinKHz.store(cpuFreqMinKHz, std::memory_order_relaxed);
+    this->cpuFreqMaxKHz.store(cpuFreqMaxKHz, std::memory_order_relaxed);
+}
+
+bool FlightRecorder::TakeFrozenRecords(std::vector<FlightRecord> *result)
+{
+    if (!frozen.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    // The audio thread doesn't touch the ring while it is frozen.
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t start = end > capacity ? end - capacity : 0;
+    if (start < resumeIndex)
+    {
+        start = resumeIndex;
+    }
+    result->clear();
+    result->reserve(end - start);
+    for (uint64_t i = start; i < end; ++i)
+    {
+        result->push_back(records[i & (capacity - 1)]);
+    }
+    resumeIndex = end;
+    frozen.store(false, std::memory_order_release);
+    return true;
+}
+
+static std::string GetEffectLabel(
+    size_t index,
+    const FlightRecord &record,
+    const std::vector<FlightRecorder::EffectLabel> &labels,
+    uint64_t labelledPedalboardId)
+{
+    if (record.pedalboardId == labelledPedalboardId && index < labels.size())
+    {
+        std::stringstream s;
+        s << labels[index].uri << " (#" << labels[index].instanceId << ")";
+        return s.str();
+    }
+    std::stringstream s;
+    s << "effect " << index;
+    return s.str();
+}
+
+std::string FlightRecorder::Diagnose(
+    const std::vector<FlightRecord> &records,
+    uint32_t sampleRate,
+    const std::vector<EffectLabel> &labels,
+    uint64_t labelledPedalboardId)
+{
+    constexpr size_t WINDOW = 8;
+
+    size_t xrunIndex = records.size();
+    for (size_t i = records.size(); i != 0; --i)
+    {
+        if (records[i - 1].flags & FlightRecord::XRUN)
+        {
+            xrunIndex = i - 1;
+            break;
+        }
+    }
+    if (xrunIndex == records.size() || sampleRate == 0)
+    {
+        return "No xrun recorded.";
+    }
+    const FlightRecord &xrun = records[xrunIndex];
+    size_t windowStart = xrunIndex >= WINDOW ? xrunIndex - WINDOW : 0;
+    double budgetNs = xrun.frames * 1E9 / sampleRate;
+
+    std::stringstream s;
+    s << std::fixed << std::setprecision(2);
+    s << "Xrun in period " << xrun.period << ". ";
+
+    // The slowest period leading up to the xrun.
+    const FlightRecord *worst = nullptr;
+    uint64_t worstWorkNs = 0;
+    const FlightRecord *stalled = nullptr;
+    FlightPhase stalledPhase = FlightPhase::Read;
+    uint64_t stalledNs = 0;
+    for (size_t i = windowStart; i <= xrunIndex; ++i)
+    {
+        const FlightRecord &record = records[i];
+        uint64_t workNs =
+            (uint64_t)record.phaseNs[(size_t)FlightPhase::Convert] +
+            record.phaseNs[(size_t)FlightPhase::Process] +
+            record.phaseNs[(size_t)FlightPhase::Mix];
+        if (workNs > worstWorkNs)
+        {
+            worstWorkNs = workNs;
+            worst = &record;
+        }
+        // Reads normally wait for most of a period; writes normally don't wait at all.
+        uint64_t readNs = record.phaseNs[(size_t)FlightPhase::Read];
+        uint64_t writeNs = record.phaseNs[(size_t)FlightPhase::Write];
+        if (readNs > 2 * budgetNs && readNs > stalledNs)
+        {
+            stalled = &record;
+            stalledPhase = FlightPhase::Read;
+            stalledNs = readNs;
+        }
+        if (writeNs > budgetNs / 2 && writeNs > stalledNs)
+        {
+            stalled = &record;
+            stalledPhase = FlightPhase::Write;
+            stalledNs = writeNs;
+        }
+    }
+
+    if (worst && worstWorkNs > budgetNs)
+    {
+        size_t worstEffect = 0;
+        uint32_t worstEffectNs = 0;
+        for (size_t i = 0; i < worst->effectCount; ++i)
+        {
+            if (worst->effectNs[i] > worstEffectNs)
+            {
+                worstEffectNs = worst->effectNs[i];
+                worstEffect = i;
+            }
+        }
+        if (worstEffectNs > worstWorkNs / 2)
+        {
+            s << GetEffectLabel(worstEffect, *worst, labels, labelledPedalboardId)
+              << " took " << worstEffectNs * 1E-6 << "ms";
+        }
+        else
+        {
+            s << "Processing took " << worstWorkNs * 1E-6 << "ms";
+        }
+        s << " in period " << worst->period << " (period length " << budgetNs * 1E-6 << "ms).";
+    }
+    else if (stalled)
+    {
+        s << "Audio thread stalled for " << stalledNs * 1E-6 << "ms in "
+          << (stalledPhase == FlightPhase::Read ? "read" : "write")
+          << " in period " << stalled->period << " (kernel, driver, or scheduling stall).";
+    }
+    else
+    {
+        s << "No slow period was recorded before the xrun.";
+    }
+
+    if (xrun.temperaturemC >= 80000)
+    {
+        s << " CPU temperature " << xrun.temperaturemC * 1E-3 << "C.";
+    }
+    uint32_t peakFreqKHz = 0;
+    for (const auto &record : records)
+    {
+        peakFreqKHz = std::max(peakFreqKHz, record.cpuFreqMaxKHz);
+    }
+    if (xrun.cpuFreqMaxKHz != 0 && xrun.cpuFreqMaxKHz < peakFreqKHz * 0.9)
+    {
+        s << " CPU frequency dropped to " << xrun.cpuFreqMaxKHz / 1000 << "MHz (from " << peakFreqKHz / 1000 << "MHz).";
+    }
+    return s.str();
+}
+
+void FlightRecorder::WriteReport(
+    std::ostream &s,
+    const std::vector<FlightRecord> &records,
+    uint32_t sampleRate,
+    const std::vector<EffectLabel> &labels,
+    uint64_t labelledPedalboardId)
+{
+    size_t effectColumns = 0;
+    const FlightRecord *labelledRecord = nullptr;
+    for (const auto &record : records)
+    {
+        effectColumns = std::max(effectColumns, (size_t)record.effectCount);
+        if (record.pedalboardId == labelledPedalboardId)
+        {
+            labelledRecord = &record;
+        }
+    }
+
+    s << "# " << Diagnose(records, sampleRate, labels, labelledPedalboardId) << "\n";
+    s << "# Times in microseconds. Sample rate " << sampleRate << ".\n";
+    s << "period,startMs,frames,xrun,read,convert,process,mix,write,total,captureAvail,playbackAvail,temperatureC,cpuFreqMinMHz,cpuFreqMaxMHz";
+    for (size_t i = 0; i < effectColumns; ++i)
+    {
+        s << ",\"";
+        if (labelledRecord)
+        {
+            s << GetEffectLabel(i, *labelledRecord, labels, labelledPedalboardId);
+        }
+        else
+        {
+            s << "effect " << i;
+        }
+        s << "\"";
+    }
+    s << "\n";
+
+    uint64_t startNs = records.empty() ? 0 : records[0].startNs;
+    s << std::fixed;
+    for (const auto &record : records)
+    {
+        s << record.period
+          << "," << std::setprecision(3) << (record.startNs - startNs) * 1E-6
+          << "," << record.frames
+          << "," << ((record.flags & FlightRecord::XRUN) ? 1 : 0);
+        s << std::setprecision(1);
+        for (size_t i = 0; i < (size_t)FlightPhase::Count; ++i)
+        {
+            s << "," << record.phaseNs[i] * 1E-3;
+        }
+        s << "," << record.GetTotalNs() * 1E-3
+          << "," << record.captureAvail
+          << "," << record.playbackAvail
+          << "," << record.temperaturemC * 1E-3
+          << "," << record.cpuFreqMinKHz / 1000
+          << "," << record.cpuFreqMaxKHz / 1000;
+        // effect columns of another pedalboard are still written, but may not match the header.
+        for (size_t i = 0; i < effectColumns; ++i)
+        {
+            s << ",";
+            if (i < record.effectCount)
+            {
+                s << record.effectNs[i] * 1E-3;
+            }
+        }
+        s << "\n";
+    }
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    // Phases of one audio period, in the order in which the audio thread runs them.
+    enum class FlightPhase
+    {
+        Read,    // waiting for, and reading, capture data.
+        Convert, // capture format conversion.
+        Process, // running the pedalboard.
+        Mix,     // output mixing, format conversion, and device VUs.
+        Write,   // writing playback data.
+
+        Count
+    };
+
+    /**
+     * @brief What happened during one audio period.
+     *
+     * Plain data, so that a frozen ring can be copied and written to disk without locks.
+     */
+    struct FlightRecord
+    {
+        static constexpr size_t MAX_EFFECTS = 32;
+
+        // Flags
+        static constexpr uint16_t XRUN = 0x01;
+
+        uint64_t period;       // periods since the audio thread started.
+        uint64_t startNs;      // steady_clock time at which the period started.
+        uint64_t pedalboardId; // identifies the pedalboard that produced effectNs.
+        uint32_t phaseNs[(size_t)FlightPhase::Count];
+        uint32_t frames;
+        int32_t captureAvail;  // frames waiting in the capture buffer after the read (or a negative ALSA error).
+        int32_t playbackAvail; // free frames in the playback buffer before the write (or a negative ALSA error).
+        int32_t temperaturemC;
+        uint32_t cpuFreqMinKHz;
+        uint32_t cpuFreqMaxKHz;
+        uint16_t flags;
+        uint16_t effectCount;
+        uint32_t effectNs[MAX_EFFECTS]; // per-effect execution time, in pedalboard node order.
+
+        uint64_t GetTotalNs() const;
+    };
+
+    /**
+     * @brief An always-on trace of the last few thousand audio periods.
+     *
+     * The audio thread is the only writer. Records are written to a fixed, pre-faulted ring in an
+     * anonymous memory mapping, so recording never allocates, locks, or takes a page fault.
+     *
+     * When an xrun is reported, the recorder keeps recording for POST_TRIGGER_PERIODS more periods,
+     * and then freezes, leaving the periods before and after the xrun in the ring. While frozen,
+     * periods are not recorded. A non-realtime thread collects the frozen ring with TakeFrozenRecords(),
+     * which resumes recording.
+     */
+    class FlightRecorder
+    {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 4096;
+        static constexpr uint32_t POST_TRIGGER_PERIODS = 32;
+
+        // capacity is rounded up to a power of two.
+        FlightRecorder(size_t capacity = DEFAULT_CAPACITY);
+        ~FlightRecorder();
+
+        FlightRecorder(const FlightRecorder &) = delete;
+        FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+        size_t GetCapacity() const { return capacity; }
+
+        // Realtime. Restart period numbering. Call when the audio thread starts.
+        void Reset();
+        // Realtime. Start recording a period.
+        void BeginPeriod(uint32_t frames);
+        // Realtime. Record the end of a phase. The phase's duration is the time since the previous mark.
+        void Mark(FlightPhase phase)
+        {
+            if (current)
+            {
+                uint64_t now = Now();
+                current->phaseNs[(size_t)phase] = (uint32_t)std::min<uint64_t>(now - lastMarkNs, UINT32_MAX);
+                lastMarkNs = now;
+            }
+        }
+        // Realtime. The record for the current period, or nullptr if the recorder is frozen.
+        FlightRecord *GetCurrentRecord() { return current; }
+        // Realtime. Flag the current period as an xrun, and freeze the recorder shortly afterward.
+        void OnXrun();
+        // Realtime. Commit the current period.
+        void EndPeriod();
+
+        // Any thread. Sampled off the audio thread, and copied into each record.
+        void SetSystemState(int32_t temperaturemC, uint32_t cpuFreqMinKHz, uint32_t cpuFreqMaxKHz);
+
+        bool IsFrozen() const { return frozen.load(std::memory_order_acquire); }
+        // Periods that were not recorded because the recorder was frozen.
+        uint64_t GetDroppedPeriods() const { return droppedPeriods.load(std::memory_order_relaxed); }
+
+        // Non-realtime. If the recorder is frozen, copy the recorded periods (oldest first) and resume recording.
+        bool TakeFrozenRecords(std::vector<FlightRecord> *records);
+
+        // Labels for the effect columns of a report, in pedalboard node order.
+        struct EffectLabel
+        {
+            int64_t instanceId;
+            std::string uri;
+        };
+
+        // A one-line guess at the cause of the (last) xrun in records.
+        static std::string Diagnose(
+            const std::vector<FlightRecord> &records,
+            uint32_t sampleRate,
+            const std::vector<EffectLabel> &labels,
+            uint64_t labelledPedalboardId);
+
+        // Write records as CSV.
+        static void WriteReport(
+            std::ostream &s,
+            const std::vector<FlightRecord> &records,
+            uint32_t sampleRate,
+            const std::vector<EffectLabel> &labels,
+            uint64_t labelledPedalboardId);
+
+    private:
+        static uint64_t Now()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        FlightRecord *records = nullptr;
+        size_t capacity = 0;
+        size_t mappedBytes = 0;
+        bool mapped = false;
+
+        // audio thread only.
+        FlightRecord *current = nullptr;
+        uint64_t lastMarkNs = 0;
+        uint64_t periodCount = 0;
+        uint32_t postTriggerRemaining = 0;
+        bool triggered = false;
+
+        // reader only. Records before this were written before the last resume.
+        uint64_t resumeIndex = 0;
+
+        std::atomic<uint64_t> writeIndex{0};
+        std::atomic<bool> frozen{false};
+        std::atomic<uint64_t> droppedPeriods{0};
+
+        std::atomic<int32_t> temperaturemC{-100000};
+        std::atomic<uint32_t> cpuFreqMinKHz{0};
+        std::atomic<uint32_t> cpuFreqMaxKHz{0};
+    };
+}
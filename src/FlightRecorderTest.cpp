@@ -0,0 +1,154 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "FlightRecorder.hpp"
+#include <sstream>
+
+using namespace pipedal;
+using namespace std;
+
+static void RecordPeriod(FlightRecorder &recorder, bool xrun = false)
+{
+    recorder.BeginPeriod(64);
+    recorder.Mark(FlightPhase::Read);
+    recorder.Mark(FlightPhase::Convert);
+    recorder.Mark(FlightPhase::Process);
+    recorder.Mark(FlightPhase::Mix);
+    if (xrun)
+    {
+        recorder.OnXrun();
+    }
+    recorder.Mark(FlightPhase::Write);
+    recorder.EndPeriod();
+}
+
+TEST_CASE("FlightRecorder freezes after an xrun", "[flight_recorder][Build]")
+{
+    FlightRecorder recorder(100);
+    REQUIRE(recorder.GetCapacity() == 128);
+
+    std::vector<FlightRecord> records;
+    for (size_t i = 0; i < 200; ++i)
+    {
+        RecordPeriod(recorder);
+    }
+    REQUIRE(!recorder.TakeFrozenRecords(&records));
+
+    RecordPeriod(recorder, true);
+    for (uint32_t i = 0; i < FlightRecorder::POST_TRIGGER_PERIODS - 1; ++i)
+    {
+        REQUIRE(!recorder.IsFrozen());
+        RecordPeriod(recorder);
+    }
+    REQUIRE(recorder.IsFrozen());
+
+    // frozen periods are dropped, not recorded.
+    RecordPeriod(recorder);
+    REQUIRE(recorder.GetDroppedPeriods() == 1);
+
+    REQUIRE(recorder.TakeFrozenRecords(&records));
+    REQUIRE(!recorder.IsFrozen());
+    REQUIRE(records.size() == 128);
+    for (size_t i = 1; i < records.size(); ++i)
+    {
+        REQUIRE(records[i].period == records[i - 1].period + 1);
+    }
+    REQUIRE(records.back().period == 200 + FlightRecorder::POST_TRIGGER_PERIODS - 1);
+    size_t xrunIndex = records.size() - FlightRecorder::POST_TRIGGER_PERIODS;
+    REQUIRE((records[xrunIndex].flags & FlightRecord::XRUN) != 0);
+    REQUIRE(records[xrunIndex].period == 200);
+
+    // the next snapshot only contains periods recorded after the last one.
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        RecordPeriod(recorder);
+    }
+    RecordPeriod(recorder, true);
+    for (uint32_t i = 0; i < FlightRecorder::POST_TRIGGER_PERIODS - 1; ++i)
+    {
+        RecordPeriod(recorder);
+    }
+    REQUIRE(recorder.TakeFrozenRecords(&records));
+    REQUIRE(records.size() == 4 + FlightRecorder::POST_TRIGGER_PERIODS);
+}
+
+TEST_CASE("FlightRecorder diagnosis", "[flight_recorder][Build]")
+{
+    constexpr uint32_t SAMPLE_RATE = 48000;
+    constexpr uint32_t FRAMES = 64; // 1.33ms
+    auto makeRecords = []()
+    {
+        std::vector<FlightRecord> records(10);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            FlightRecord &record = records[i];
+            record = FlightRecord{};
+            record.period = i;
+            record.frames = FRAMES;
+            record.pedalboardId = 7;
+            record.phaseNs[(size_t)FlightPhase::Read] = 1000000;
+            record.phaseNs[(size_t)FlightPhase::Process] = 300000;
+            record.effectCount = 2;
+            record.effectNs[0] = 100000;
+            record.effectNs[1] = 200000;
+            record.cpuFreqMaxKHz = 1800000;
+        }
+        records[8].flags = FlightRecord::XRUN;
+        return records;
+    };
+    std::vector<FlightRecorder::EffectLabel> labels{{1, "urn:a"}, {2, "urn:b"}};
+
+    {
+        auto records = makeRecords();
+        records[7].phaseNs[(size_t)FlightPhase::Process] = 3000000;
+        records[7].effectNs[1] = 2800000;
+        std::string diagnosis = FlightRecorder::Diagnose(records, SAMPLE_RATE, labels, 7);
+        INFO(diagnosis);
+        REQUIRE(diagnosis.find("urn:b (#2) took 2.80ms in period 7") != std::string::npos);
+        // unlabelled, if the pedalboard has changed since.
+        diagnosis = FlightRecorder::Diagnose(records, SAMPLE_RATE, labels, 8);
+        REQUIRE(diagnosis.find("effect 1 took") != std::string::npos);
+    }
+    {
+        auto records = makeRecords();
+        records[8].phaseNs[(size_t)FlightPhase::Write] = 5000000;
+        records[8].cpuFreqMaxKHz = 600000;
+        std::string diagnosis = FlightRecorder::Diagnose(records, SAMPLE_RATE, labels, 7);
+        INFO(diagnosis);
+        REQUIRE(diagnosis.find("stalled for 5.00ms in write") != std::string::npos);
+        REQUIRE(diagnosis.find("dropped to 600MHz") != std::string::npos);
+    }
+    {
+        auto records = makeRecords();
+        std::stringstream s;
+        FlightRecorder::WriteReport(s, records, SAMPLE_RATE, labels, 7);
+        std::string report = s.str();
+        REQUIRE(report.find("No slow period") != std::string::npos);
+        REQUIRE(report.find("\"urn:a (#1)\",\"urn:b (#2)\"") != std::string::npos);
+        size_t lines = 0;
+        for (char c : report)
+        {
+            if (c == '\n')
+                ++lines;
+        }
+        REQUIRE(lines == 3 + records.size());
+    }
+}
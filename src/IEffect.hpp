@@ -47,6 +47,12 @@ namespace pipedal {
 
         virtual float GetControlValue(int index) const = 0;
         virtual void SetBypass(bool enable)  = 0;
+        // True if the effect is bypassed, and is no longer being run. (audio thread only)
+        virtual bool IsSuspended() const { return false; }
+        // True if the last period was skipped because the effect's input and output were silent. (audio thread only)
+        virtual bool IsSkippingSilence() const { return false; }
+        // Number of periods skipped because of silence, since the effect was created. (audio thread only)
+        virtual uint64_t GetSilentPeriods() const { return 0; }
         virtual float GetOutputControlValue(int controlIndex) const = 0;
 
         virtual int GetNumberOfInputAudioPorts() const = 0; // as declared
@@ -19,19 +19,26 @@
 #pragma once
 
 #include <lilv/lilv.h>
+#include <mutex>
 
 namespace pipedal {
     class MapFeature;
     class PedalboardItem;
     class Lv2PluginInfo;
     class IEffect;
-    class HostWorkerThread;
+    class HostWorkerPool;
     class ChannelSelection;
+    class RealtimeWorkerPool;
 
     class IHost
     {
     public:
         virtual LilvWorld *getWorld() = 0;
+        // A world in which the plugin's bundle, and bundles that declare presets for it, have been loaded.
+        // Other bundles may not have been loaded. Hold LockWorld() while using the world.
+        virtual LilvWorld *GetWorldForPlugin(const std::string &pluginUri) = 0;
+        // Bundles are loaded into the world on demand, on other threads.
+        virtual std::unique_lock<std::recursive_mutex> LockWorld() = 0;
         virtual LV2_URID_Map *GetLv2UridMap() = 0;
         virtual MapFeature&GetMapFeature() = 0;
         virtual LV2_URID GetLv2Urid(const char *uri) = 0;
@@ -51,5 +58,34 @@ namespace pipedal {
         virtual std::string GetPluginStoragePath() const = 0;
         virtual const ChannelSelection&GetChannelSelection() const = 0;
 
+        // nullptr if neither parallel split chains nor pipelining are enabled.
+        virtual RealtimeWorkerPool *GetRealtimeWorkerPool() = 0;
+        // Runs LV2 worker requests for all plugin instances.
+        virtual std::shared_ptr<HostWorkerPool> GetHostWorkerPool() = 0;
+        virtual bool GetParallelSplitChains() const = 0;
+        virtual size_t GetPipelineStages() const = 0;
+
+        // Stop running bypassed effects once their output has stayed below GetHardBypassThreshold()
+        // for GetHardBypassSilenceSeconds().
+        virtual bool GetHardBypass() const = 0;
+        virtual double GetHardBypassSilenceSeconds() const = 0;
+        virtual float GetHardBypassThreshold() const = 0; // linear amplitude.
+
+        // Skip effects whose input has been below GetSilenceThreshold(), and whose output has stayed
+        // below it for GetSilenceTailSeconds().
+        virtual bool GetSkipSilentEffects() const = 0;
+        virtual double GetSilenceTailSeconds() const = 0;
+        virtual float GetSilenceThreshold() const = 0; // linear amplitude.
+
+        // Number of audio periods kept by the xrun flight recorder; 0 if it is disabled.
+        virtual size_t GetFlightRecorderPeriods() const = 0;
+        // Where xrun reports are written, and how many of them are kept.
+        virtual std::string GetFlightRecorderReportPath() const = 0;
+        virtual size_t GetFlightRecorderReports() const = 0;
+
+        // Measured average execution time of a plugin, in microseconds per period; -1 if unknown.
+        virtual double GetEffectCost(const std::string &uri) = 0;
+        virtual void UpdateEffectCost(const std::string &uri, double averageUs) = 0;
+
     };
 }
\ No newline at end of file
@@ -0,0 +1,237 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "IndexedSnapshot.hpp"
+#include "Lv2Pedalboard.hpp"
+#include "Lv2Effect.hpp"
+#include "PluginHost.hpp"
+#include "AtomConverter.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <sstream>
+#include <unordered_map>
+
+using namespace pipedal;
+
+IndexedSnapshotValue::IndexedSnapshotValue(IEffect *effect, SnapshotValue *snapshotValue, PluginHost &pluginHost, SnapshotContents contents)
+    : pEffect(effect), applyControlValues(contents != SnapshotContents::PathProperties)
+{
+    auto maxInputControl = effect->GetMaxInputControl();
+    inputControlValues.resize(maxInputControl);
+    this->enabled = true;
+    for (uint64_t i = 0; i < maxInputControl; ++i)
+    {
+        bool isInputControl = effect->IsInputControl(i);
+        if (isInputControl)
+        {
+            inputControlValues[i] = InputControlEntry{isInputControl : true, value : effect->GetDefaultInputControlValue(i)};
+        }
+        else
+        {
+            inputControlValues[i] = InputControlEntry{isInputControl : false, value : 0};
+        }
+    }
+    if (snapshotValue)
+    {
+        this->enabled = snapshotValue->isEnabled_;
+        for (auto &controlValue : snapshotValue->controlValues_)
+        {
+            auto index = effect->GetControlIndex(controlValue.key());
+            if (index >= 0 && index < inputControlValues.size())
+            {
+                inputControlValues[index].value = controlValue.value();
+            }
+        }
+        this->lv2State = snapshotValue->lv2State_;
+
+        if (contents != SnapshotContents::ControlValues && effect->IsLv2Effect())
+        {
+            Lv2Effect *lv2Effect = (Lv2Effect *)effect;
+            for (auto &pathProperty : snapshotValue->pathProperties_)
+            {
+                // only transmit changed path patch properties.
+                if (lv2Effect->GetPathPatchProperty(pathProperty.first) != pathProperty.second)
+                {
+                    lv2Effect->SetPathPatchProperty(pathProperty.first, pathProperty.second);
+
+                    PathPatchProperty pathPatchProperty;
+                    pathPatchProperty.propertyUrid = pluginHost.GetLv2Urid(pathProperty.first.c_str());
+                    // convert to json variant so we do a mappath operation.
+                    json_variant vProperty;
+                    std::istringstream ss(pathProperty.second);
+                    json_reader reader(ss);
+                    reader.read(&vProperty);
+                    if (!vProperty.is_null())
+                    {
+                        try
+                        {
+                            vProperty = pluginHost.MapPath(vProperty);
+
+                            // now to atom format (what we want on the rt thread0)
+                            AtomConverter atomConverter(pluginHost.GetMapFeature());
+                            LV2_Atom *atomValue = atomConverter.ToAtom(vProperty);
+
+                            size_t atomBufferSize = (atomValue->size + sizeof(LV2_Atom) + 3) / 4 * 4;
+                            pathPatchProperty.atomBuffer.resize(atomValue->size + sizeof(LV2_Atom));
+                            memcpy(pathPatchProperty.atomBuffer.data(), atomValue, pathPatchProperty.atomBuffer.size());
+                            this->pathPatchProperties.push_back(std::move(pathPatchProperty));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            Lv2Log::info(SS("IndexedSnapshotValue: Failed to map path property " << pathProperty.first << ". " << e.what()));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void IndexedSnapshotValue::ApplyValues(IEffect *effect)
+{
+    if (effect != pEffect)
+    {
+        throw std::runtime_error("Wrong effect");
+    }
+    if (applyControlValues)
+    {
+        effect->SetBypass(this->enabled);
+        for (size_t i = 0; i < inputControlValues.size(); ++i)
+        {
+            InputControlEntry &e = inputControlValues[i];
+            if (e.isInputControl)
+            {
+                effect->SetControl((int)i, e.value);
+            }
+        }
+    }
+
+    for (const auto &patchProperty : pathPatchProperties)
+    {
+        // yyy: only if the property changed!.
+        effect->SetPatchProperty(
+            patchProperty.propertyUrid, patchProperty.atomBuffer.size(), (LV2_Atom *)patchProperty.atomBuffer.data());
+    }
+    // effect->SetLv2State(lv2State);
+}
+
+static SnapshotValue *getSnapshotValue(std::unordered_map<uint64_t, SnapshotValue *> &index, uint64_t instanceId)
+{
+    auto iter = index.find(instanceId);
+    if (iter == index.end())
+    {
+        return nullptr;
+    }
+    return iter->second;
+}
+
+IndexedSnapshot::IndexedSnapshot(Snapshot *snapshot, Lv2Pedalboard *pedalboard, PluginHost &pluginHost, SnapshotContents contents)
+    : IndexedSnapshot(snapshot, pedalboard->GetEffects(), pluginHost, contents)
+{
+}
+
+IndexedSnapshot::IndexedSnapshot(Snapshot *snapshot, std::vector<IEffect *> &effects, PluginHost &pluginHost, SnapshotContents contents)
+{
+    std::unordered_map<uint64_t, SnapshotValue *> index;
+    for (auto &value : snapshot->values_)
+    {
+        index[value.instanceId_] = &value;
+    }
+    snapshotValues.reserve(effects.size());
+
+    for (size_t i = 0; i < effects.size(); ++i)
+    {
+        auto &effect = effects[i];
+
+        SnapshotValue *snapshotValue = getSnapshotValue(index, effect->GetInstanceId());
+        snapshotValues.push_back(IndexedSnapshotValue(effect, snapshotValue, pluginHost, contents));
+    }
+}
+
+bool IndexedSnapshot::IsEmpty() const
+{
+    for (const auto &snapshotValue : snapshotValues)
+    {
+        if (!snapshotValue.IsEmpty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IndexedSnapshot::Apply(std::vector<IEffect *> &effects)
+{
+    if (effects.size() != snapshotValues.size())
+    {
+        throw std::runtime_error("Effects and values don't match");
+    }
+    for (size_t i = 0; i < snapshotValues.size(); ++i)
+    {
+        snapshotValues[i].ApplyValues(effects[i]);
+    }
+}
+
+std::string SnapshotTable::GetSnapshotKey(const Snapshot &snapshot)
+{
+    std::stringstream s;
+    json_writer writer(s, true);
+    writer.write(snapshot.values_);
+    return s.str();
+}
+
+SnapshotTable::SnapshotTable(
+    const std::vector<std::shared_ptr<Snapshot>> &snapshots,
+    Lv2Pedalboard *pedalboard,
+    PluginHost &pluginHost,
+    const SnapshotTable *previous)
+    : pedalboard(pedalboard)
+{
+    if (previous && previous->pedalboard != pedalboard)
+    {
+        previous = nullptr;
+    }
+    unchanged = previous != nullptr && previous->entries.size() == snapshots.size();
+
+    entries.resize(snapshots.size());
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+        if (!snapshots[i])
+        {
+            if (previous && i < previous->entries.size() && previous->entries[i].snapshot)
+            {
+                unchanged = false;
+            }
+            continue;
+        }
+        Entry &entry = entries[i];
+        entry.key = GetSnapshotKey(*snapshots[i]);
+        if (previous && i < previous->entries.size() && previous->entries[i].snapshot && previous->entries[i].key == entry.key)
+        {
+            entry.snapshot = previous->entries[i].snapshot;
+        }
+        else
+        {
+            entry.snapshot = std::make_shared<IndexedSnapshot>(snapshots[i].get(), pedalboard, pluginHost, SnapshotContents::ControlValues);
+            ++compiledCount;
+            unchanged = false;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Pedalboard.hpp"
+#include <lv2/urid/urid.h>
+
+namespace pipedal
+{
+    class IEffect;
+    class Lv2Pedalboard;
+    class PluginHost;
+
+    // The parts of a snapshot that an IndexedSnapshot applies.
+    enum class SnapshotContents
+    {
+        All,
+        // Control values and enable states only (snapshots that are precompiled for the realtime thread).
+        ControlValues,
+        // Path properties only, for a snapshot whose control values the realtime thread has already applied.
+        PathProperties
+    };
+
+    struct PathPatchProperty
+    {
+        LV2_URID propertyUrid = 0;
+        std::vector<uint8_t> atomBuffer;
+    };
+
+    // The values of one effect in a snapshot, in a form that can be applied on the realtime thread.
+    class IndexedSnapshotValue
+    {
+    private:
+        struct InputControlEntry
+        {
+            bool isInputControl = false;
+            float value = 0;
+        };
+
+    public:
+        // Path properties that differ from the effect's current value are included (unless contents
+        // is ControlValues), and recorded as the effect's current value.
+        IndexedSnapshotValue(IEffect *effect, SnapshotValue *snapshotValue, PluginHost &pluginHost, SnapshotContents contents = SnapshotContents::All);
+
+        void ApplyValues(IEffect *effect);
+        bool IsEmpty() const { return !applyControlValues && pathPatchProperties.empty(); }
+
+    private:
+        IEffect *pEffect;
+        bool applyControlValues = true;
+        Lv2PluginState lv2State;
+        bool enabled;
+        std::vector<InputControlEntry> inputControlValues;
+        std::vector<PathPatchProperty> pathPatchProperties;
+    };
+
+    // A snapshot, indexed by the effects of a particular Lv2Pedalboard.
+    class IndexedSnapshot
+    {
+    public:
+        IndexedSnapshot(Snapshot *snapshot, Lv2Pedalboard *pedalboard, PluginHost &pluginHost, SnapshotContents contents = SnapshotContents::All);
+        IndexedSnapshot(Snapshot *snapshot, std::vector<IEffect *> &effects, PluginHost &pluginHost, SnapshotContents contents = SnapshotContents::All);
+
+        // Realtime.
+        void Apply(std::vector<IEffect *> &effects);
+        // True if applying the snapshot would do nothing.
+        bool IsEmpty() const;
+
+    private:
+        std::vector<IndexedSnapshotValue> snapshotValues;
+    };
+
+    /**
+     * @brief The snapshots of a preset, precompiled for one Lv2Pedalboard.
+     *
+     * Lets the realtime thread switch snapshots in response to MIDI without a round trip to the host.
+     * Only control values and enable states are precompiled; path properties (which load files on a worker
+     * thread anyway) are applied by the host when it updates the model.
+     *
+     * Immutable once compiled. Entries are shared with the table that a table was compiled from, so
+     * that editing one snapshot only recompiles that snapshot.
+     */
+    class SnapshotTable
+    {
+    public:
+        // previous (which may be null) supplies compiled entries for snapshots that have not changed.
+        SnapshotTable(
+            const std::vector<std::shared_ptr<Snapshot>> &snapshots,
+            Lv2Pedalboard *pedalboard,
+            PluginHost &pluginHost,
+            const SnapshotTable *previous);
+
+        const Lv2Pedalboard *GetPedalboard() const { return pedalboard; }
+        size_t GetSize() const { return entries.size(); }
+        // Number of snapshots that were compiled (rather than reused from the previous table).
+        size_t GetCompiledCount() const { return compiledCount; }
+        // True if the table is identical to the table it was compiled from.
+        bool IsUnchanged() const { return unchanged; }
+
+        // Realtime. nullptr if there is no snapshot at index.
+        IndexedSnapshot *Get(size_t index) const
+        {
+            return index < entries.size() ? entries[index].snapshot.get() : nullptr;
+        }
+
+    private:
+        static std::string GetSnapshotKey(const Snapshot &snapshot);
+
+        struct Entry
+        {
+            std::string key; // the snapshot's values, as JSON.
+            std::shared_ptr<IndexedSnapshot> snapshot;
+        };
+        Lv2Pedalboard *pedalboard;
+        std::vector<Entry> entries;
+        size_t compiledCount = 0;
+        bool unchanged = false;
+    };
+}
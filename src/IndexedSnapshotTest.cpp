@@ -0,0 +1,136 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "IndexedSnapshot.hpp"
+#include "ControlValueTable.hpp"
+#include "IEffect.hpp"
+#include "PluginHost.hpp"
+
+using namespace pipedal;
+
+namespace
+{
+    class TestEffect : public IEffect
+    {
+    public:
+        TestEffect(uint64_t instanceId, std::vector<std::string> symbols)
+            : instanceId(instanceId), symbols(std::move(symbols))
+        {
+            controls.resize(this->symbols.size());
+        }
+
+        std::vector<float> controls;
+        bool enabled = true;
+
+        virtual uint64_t GetInstanceId() const override { return instanceId; }
+        virtual bool IsLv2Effect() const override { return false; }
+        virtual uint64_t GetMaxInputControl() const override { return symbols.size(); }
+        virtual bool IsInputControl(uint64_t index) const override { return index < symbols.size(); }
+        virtual float GetDefaultInputControlValue(uint64_t index) const override { return 0; }
+        virtual int GetControlIndex(const std::string &symbol) const override
+        {
+            for (size_t i = 0; i < symbols.size(); ++i)
+            {
+                if (symbols[i] == symbol)
+                {
+                    return (int)i;
+                }
+            }
+            return -1;
+        }
+        virtual void SetControl(int index, float value) override { controls[index] = value; }
+        virtual void SetPatchProperty(LV2_URID uridUri, size_t size, LV2_Atom *value) override {}
+        virtual void RequestPatchProperty(LV2_URID uridUri) override {}
+        virtual void RequestAllPathPatchProperties() override {}
+        virtual float GetControlValue(int index) const override { return controls[index]; }
+        virtual void SetBypass(bool enable) override { enabled = enable; }
+        virtual float GetOutputControlValue(int controlIndex) const override { return 0; }
+        virtual int GetNumberOfInputAudioPorts() const override { return 0; }
+        virtual int GetNumberOfOutputAudioPorts() const override { return 0; }
+        virtual int GetNumberOfInputAudioBuffers() const override { return 0; }
+        virtual int GetNumberOfOutputAudioBuffers() const override { return 0; }
+        virtual float *GetAudioInputBuffer(int index) const override { return nullptr; }
+        virtual float *GetAudioOutputBuffer(int index) const override { return nullptr; }
+        virtual void ResetAtomBuffers() override {}
+        virtual bool GetRequestStateChangedNotification() const override { return false; }
+        virtual void SetRequestStateChangedNotification(bool value) override {}
+        virtual void PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize) override {}
+        virtual void SetAudioInputBuffer(int index, float *buffer) override {}
+        virtual void SetAudioOutputBuffer(int index, float *buffer) override {}
+        virtual void Activate() override {}
+        virtual void Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter) override {}
+        virtual void Deactivate() override {}
+        virtual bool IsVst3() const override { return false; }
+        virtual bool GetLv2State(Lv2PluginState *state) override { return false; }
+        virtual void SetLv2State(Lv2PluginState &state) override {}
+        virtual bool HasErrorMessage() const override { return false; }
+        virtual const char *TakeErrorMessage() override { return nullptr; }
+
+    private:
+        uint64_t instanceId;
+        std::vector<std::string> symbols;
+    };
+}
+
+TEST_CASE("A control change made after a MIDI snapshot survives", "[indexed_snapshot][Build]")
+{
+    PluginHost pluginHost;
+    TestEffect effect(1, {"gain", "tone"});
+    std::vector<IEffect *> effects{&effect};
+
+    Snapshot snapshot;
+    SnapshotValue snapshotValue;
+    snapshotValue.instanceId_ = 1;
+    snapshotValue.isEnabled_ = true;
+    snapshotValue.controlValues_ = {ControlValue("gain", 0.25f), ControlValue("tone", 0.75f)};
+    snapshot.values_.push_back(snapshotValue);
+
+    ControlValueTable controlValueTable;
+    controlValueTable.Prepare({2});
+    auto applyControlValues = [&effects, &controlValueTable]()
+    {
+        controlValueTable.Apply([&effects](int effectIndex, int controlIndex, float value)
+                                { effects[effectIndex]->SetControl(controlIndex, value); });
+    };
+
+    // the audio thread applies the precompiled snapshot when MIDI triggers it.
+    IndexedSnapshot precompiled(&snapshot, effects, pluginHost, SnapshotContents::ControlValues);
+    precompiled.Apply(effects);
+    REQUIRE(effect.controls == std::vector<float>{0.25f, 0.75f});
+
+    // a control change lands before the host has handled the snapshot request.
+    controlValueTable.Set(0, 1, 0.5f);
+
+    // the host only applies what the audio thread couldn't.
+    IndexedSnapshot pathProperties(&snapshot, effects, pluginHost, SnapshotContents::PathProperties);
+    REQUIRE(pathProperties.IsEmpty());
+    pathProperties.Apply(effects);
+
+    applyControlValues();
+    REQUIRE(effect.controls == std::vector<float>{0.25f, 0.5f});
+
+    // a full snapshot would have overwritten the change.
+    IndexedSnapshot full(&snapshot, effects, pluginHost);
+    REQUIRE(!full.IsEmpty());
+    full.Apply(effects);
+    REQUIRE(effect.controls == std::vector<float>{0.25f, 0.75f});
+}
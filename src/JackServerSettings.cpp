@@ -170,4 +170,9 @@ JSON_MAP_REFERENCE(JackServerSettings, alsaOutputDeviceName)
 JSON_MAP_REFERENCE(JackServerSettings, sampleRate)
 JSON_MAP_REFERENCE(JackServerSettings, bufferSize)
 JSON_MAP_REFERENCE(JackServerSettings, numberOfBuffers)
+JSON_MAP_REFERENCE(JackServerSettings, parallelSplitChains)
+JSON_MAP_REFERENCE(JackServerSettings, pipelineStages)
+JSON_MAP_REFERENCE(JackServerSettings, alsaMmapAccess)
+JSON_MAP_REFERENCE(JackServerSettings, presetTransitionMs)
+JSON_MAP_REFERENCE(JackServerSettings, presetTransitionParallel)
 JSON_MAP_END()
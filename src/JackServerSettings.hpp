@@ -40,6 +40,11 @@ namespace pipedal
         uint64_t sampleRate_ = 0;
         uint32_t bufferSize_ = 64;
         uint32_t numberOfBuffers_ = 3;
+        bool parallelSplitChains_ = false;
+        uint32_t pipelineStages_ = 1;
+        bool alsaMmapAccess_ = false;
+        uint32_t presetTransitionMs_ = 0;
+        bool presetTransitionParallel_ = false;
 
     public:
         JackServerSettings();
@@ -71,6 +76,27 @@ namespace pipedal
         const std::string &GetAlsaOutputDeviceName() const { return alsaOutputDeviceName_; }
         const std::string &GetLegacyAlsaDevice() const { return alsaDevice_; } //legacy
 
+        // Run the top and bottom chains of split effects concurrently on realtime worker threads.
+        bool GetParallelSplitChains() const { return parallelSplitChains_; }
+        void SetParallelSplitChains(bool value) { parallelSplitChains_ = value; }
+
+        // Number of pipeline stages the pedalboard is divided into (1 = not pipelined). Each
+        // additional stage adds one period of latency.
+        uint32_t GetPipelineStages() const { return pipelineStages_; }
+        void SetPipelineStages(uint32_t value) { pipelineStages_ = value; }
+
+        // Convert audio directly to and from the ALSA DMA buffers, if the device supports mmap access.
+        bool GetAlsaMmapAccess() const { return alsaMmapAccess_; }
+        void SetAlsaMmapAccess(bool value) { alsaMmapAccess_ = value; }
+
+        // Length of the crossfade between the outgoing and incoming pedalboards when a preset changes (0 = switch immediately).
+        uint32_t GetPresetTransitionMs() const { return presetTransitionMs_; }
+        void SetPresetTransitionMs(uint32_t value) { presetTransitionMs_ = value; }
+
+        // Run the outgoing pedalboard on a separate realtime thread during a preset transition.
+        bool GetPresetTransitionParallel() const { return presetTransitionParallel_; }
+        void SetPresetTransitionParallel(bool value) { presetTransitionParallel_ = value; }
+
         void SetAlsaInputDevice(const std::string &id, const std::string&name){ alsaInputDevice_ = id; alsaInputDeviceName_ = name; }
         void SetAlsaOutputDevice(const std::string &id, const std::string&name){ alsaOutputDevice_ = id; alsaOutputDeviceName_ = name; }
         void SetLegacyAlsaDevice(const std::string &d) { alsaDevice_ = d; }
@@ -109,7 +135,12 @@ namespace pipedal
                    this->alsaDevice_       == other.alsaDevice_ &&
                    this->sampleRate_       == other.sampleRate_ &&
                    this->bufferSize_       == other.bufferSize_ &&
-                   this->numberOfBuffers_  == other.numberOfBuffers_;
+                   this->numberOfBuffers_  == other.numberOfBuffers_ &&
+                   this->parallelSplitChains_ == other.parallelSplitChains_ &&
+                   this->pipelineStages_ == other.pipelineStages_ &&
+                   this->alsaMmapAccess_ == other.alsaMmapAccess_ &&
+                   this->presetTransitionMs_ == other.presetTransitionMs_ &&
+                   this->presetTransitionParallel_ == other.presetTransitionParallel_;
         }
         void FixUpDeviceNames();
 
@@ -43,6 +43,7 @@
 #include <exception>
 #include "RingBufferReader.hpp"
 #include "Worker.hpp"
+#include "VuMeterKernels.hpp"
 
 using namespace pipedal;
 namespace fs = std::filesystem;
@@ -86,7 +87,8 @@ Lv2Effect::Lv2Effect(
     PedalboardItem &pedalboardItem)
     : pHost(pHost_), pInstance(nullptr), info(info_), urids(pHost), instanceId(pedalboardItem.instanceId())
 {
-    auto pWorld = pHost_->getWorld();
+    auto worldLock = pHost_->LockWorld();
+    auto pWorld = pHost_->GetWorldForPlugin(info_->uri());
 
     size_t stagedBufferSize = GetStagedBufferSize();
 
@@ -98,11 +100,17 @@ Lv2Effect::Lv2Effect(
 
     this->bypass = pedalboardItem.isEnabled();
 
-    this->workerThread = std::make_unique<HostWorkerThread>();
-    if (info_->WantsWorkerThread())
+    this->hardBypassEnabled = pHost->GetHardBypass();
+    if (this->hardBypassEnabled)
     {
-        workerThread->StartThread();
+        this->hardBypassThreshold = pHost->GetHardBypassThreshold();
+        this->hardBypassSilenceSamples = (uint64_t)(pHost->GetSampleRate() * pHost->GetHardBypassSilenceSeconds());
+        this->hardBypassZeroBuffer.resize(pHost->GetMaxAudioBufferSize());
     }
+    this->skipSilenceEnabled = pHost->GetSkipSilentEffects();
+    this->silenceThreshold = pHost->GetSilenceThreshold();
+    this->silenceGate.SetTailSamples((uint64_t)(pHost->GetSampleRate() * pHost->GetSilenceTailSeconds()));
+
     // stash a list of known file properties that we want to keep synced.
     if (info->piPedalUI())
     {
@@ -223,7 +231,7 @@ Lv2Effect::Lv2Effect(
     const LV2_Worker_Interface *worker_interface =
         (const LV2_Worker_Interface *)lilv_instance_get_extension_data(pInstance,
                                                                        LV2_WORKER__interface);
-    this->worker = std::make_unique<Worker>(workerThread, pInstance, worker_interface);
+    this->worker = std::make_unique<Worker>(pHost->GetHostWorkerPool(), pInstance, worker_interface, info_->name(), instanceId);
 
     const LV2_State_Interface *state_interface =
         (const LV2_State_Interface *)lilv_instance_get_extension_data(pInstance,
@@ -660,6 +668,11 @@ void Lv2Effect::Activate()
     }
     this->activated = true;
     this->AssignUnconnectedPorts();
+    if (this->hardBypassState != HardBypassState::Running)
+    {
+        ConnectHardBypassInputs(false);
+        this->hardBypassState = HardBypassState::Running;
+    }
     lilv_instance_activate(pInstance);
     if (this->bypassControlIndex == -1)
     {
@@ -677,6 +690,8 @@ void Lv2Effect::UpdateAudioPorts()
     // called on realtime thread to switch borrowed effects to the new buffer pointers.
     if (borrowedEffect)
     {
+        // inputs get reconnected to the new input buffers.
+        this->hardBypassState = HardBypassState::Running;
         if (stagingBufferSize != 0)
         {
             for (size_t i = 0; i < this->inputAudioPortIndices.size(); ++i)
@@ -1095,24 +1110,7 @@ inline void Lv2Effect::MixOutput(uint32_t samples, RealtimeRingBufferWriter *rea
     {
         if (this->currentBypass == 0)
         {
-            // replace the contents of the output buffer(s) with the input buffer(s).
-            if (this->outputAudioBuffers.size() == 1)
-            {
-                CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-            }
-            else
-            {
-                if (this->inputAudioBuffers.size() == 1)
-                {
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(1), samples);
-                }
-                else
-                {
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-                    CopyBuffer(this->inputAudioBuffers.at(1), this->outputAudioBuffers.at(1), samples);
-                }
-            }
+            CopyInputToOutput(samples);
         } // else leave the output alone.
     }
     else
@@ -1180,6 +1178,133 @@ inline void Lv2Effect::MixOutput(uint32_t samples, RealtimeRingBufferWriter *rea
     RelayPatchSetMessages(this->instanceId, realtimeRingBufferWriter);
 }
 
+void Lv2Effect::CopyInputToOutput(uint32_t samples)
+{
+    // replace the contents of the output buffer(s) with the input buffer(s).
+    if (this->outputAudioBuffers.size() == 1)
+    {
+        CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
+    }
+    else
+    {
+        if (this->inputAudioBuffers.size() == 1)
+        {
+            CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
+            CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(1), samples);
+        }
+        else
+        {
+            CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
+            CopyBuffer(this->inputAudioBuffers.at(1), this->outputAudioBuffers.at(1), samples);
+        }
+    }
+}
+
+bool Lv2Effect::CanDrain() const
+{
+    // Effects with their own bypass control, and staged effects always run.
+    return this->bypassControlIndex == -1 && this->stagingBufferSize == 0 && this->targetBypass == 0 && this->currentBypass == 0 && this->bypassSamplesRemaining == 0;
+}
+
+bool Lv2Effect::HasPendingInputEvents() const
+{
+    for (char *buffer : this->inputAtomBuffers)
+    {
+        const LV2_Atom_Sequence *sequence = (const LV2_Atom_Sequence *)buffer;
+        if (sequence->atom.size > sizeof(LV2_Atom_Sequence_Body))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Lv2Effect::ConnectHardBypassInputs(bool silence)
+{
+    // connect_port is realtime-safe.
+    for (size_t i = 0; i < this->inputAudioPortIndices.size(); ++i)
+    {
+        float *buffer = silence ? this->hardBypassZeroBuffer.data() : this->inputAudioBuffers.at(i);
+        lilv_instance_connect_port(pInstance, this->inputAudioPortIndices[i], buffer);
+    }
+}
+
+float Lv2Effect::GetPluginOutputPeak(uint32_t samples) const
+{
+    float peak = 0;
+    if (this->outputMixBuffers.size() != 0)
+    {
+        for (auto &buffer : this->outputMixBuffers)
+        {
+            peak = MaxAbs(buffer.data(), samples, peak);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < this->outputAudioPortIndices.size(); ++i)
+        {
+            peak = MaxAbs(this->outputAudioBuffers.at(i), samples, peak);
+        }
+    }
+    return peak;
+}
+
+bool Lv2Effect::IsInputSilent(uint32_t samples) const
+{
+    for (size_t i = 0; i < this->inputAudioPortIndices.size(); ++i)
+    {
+        if (MaxAbs(this->inputAudioBuffers.at(i), samples) > this->silenceThreshold)
+        {
+            return false;
+        }
+    }
+    for (float *buffer : this->inputSidechainBuffers)
+    {
+        if (buffer && MaxAbs(buffer, samples) > this->silenceThreshold)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Lv2Effect::ZeroOutputs(uint32_t samples)
+{
+    for (float *buffer : this->outputAudioBuffers)
+    {
+        std::fill(buffer, buffer + samples, 0.0f);
+    }
+}
+
+void Lv2Effect::UpdateHardBypass(uint32_t samples)
+{
+    // called after running the plugin, before mixing its output.
+    if (this->hardBypassState == HardBypassState::Running)
+    {
+        if (CanDrain())
+        {
+            // The effect is no longer audible. Feed it silence so that delay lines and reverb tails decay.
+            ConnectHardBypassInputs(true);
+            this->hardBypassState = HardBypassState::Draining;
+            this->hardBypassSilentSamples = 0;
+        }
+        return;
+    }
+
+    if (GetPluginOutputPeak(samples) > this->hardBypassThreshold)
+    {
+        this->hardBypassSilentSamples = 0;
+    }
+    else
+    {
+        this->hardBypassSilentSamples += samples;
+        if (this->hardBypassSilentSamples >= this->hardBypassSilenceSamples)
+        {
+            this->hardBypassState = HardBypassState::Suspended;
+        }
+    }
+}
+
 void Lv2Effect::Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter)
 {
     // close off the atom input frame.
@@ -1187,6 +1312,46 @@ void Lv2Effect::Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBuff
     {
         lv2_atom_forge_pop(&this->inputForgeRt, &input_frame);
     }
+    if (this->hardBypassState != HardBypassState::Running)
+    {
+        if (this->targetBypass != 0)
+        {
+            // re-enabled. The bypass dezipper fades the effect back in.
+            ConnectHardBypassInputs(false);
+            this->hardBypassState = HardBypassState::Running;
+        }
+        else if (this->hardBypassState == HardBypassState::Suspended)
+        {
+            if (!HasPendingInputEvents())
+            {
+                if (worker)
+                {
+                    worker->EmitResponses();
+                }
+                CopyInputToOutput(samples);
+                ClearOutputAtomBuffers();
+                return;
+            }
+            // deliver the events, and then wait for the output to decay again.
+            this->hardBypassState = HardBypassState::Draining;
+            this->hardBypassSilentSamples = 0;
+        }
+    }
+
+    // Effects with no audio inputs are generators, so never silent.
+    bool inputSilent = this->skipSilenceEnabled && this->inputAudioPortIndices.size() != 0 && this->bypassSamplesRemaining == 0 && this->hardBypassState == HardBypassState::Running && IsInputSilent(samples);
+    if (this->skipSilenceEnabled && this->silenceGate.Skip(inputSilent && !HasPendingInputEvents()))
+    {
+        // silence in, silence out.
+        if (worker)
+        {
+            worker->EmitResponses();
+        }
+        ZeroOutputs(samples);
+        ClearOutputAtomBuffers();
+        return;
+    }
+
     lilv_instance_run(pInstance, samples);
 
     if (worker)
@@ -1195,6 +1360,15 @@ void Lv2Effect::Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBuff
         worker->EmitResponses();
     }
 
+    if (this->skipSilenceEnabled)
+    {
+        // wait for reverb and delay tails to decay before skipping.
+        this->silenceGate.Update(inputSilent, inputSilent && GetPluginOutputPeak(samples) <= this->silenceThreshold, samples);
+    }
+    if (this->hardBypassEnabled)
+    {
+        UpdateHardBypass(samples);
+    }
     MixOutput(samples, realtimeRingBufferWriter);
 }
 
@@ -1225,6 +1399,15 @@ void Lv2Effect::ResetOutputAtomBuffer(char *data)
     header->size = pHost->GetAtomBufferSize() - 8;
     header->type = urids.atom__Chunk;
 }
+void Lv2Effect::ClearOutputAtomBuffers()
+{
+    for (char *buffer : this->outputAtomBuffers)
+    {
+        // an empty sequence.
+        ResetInputAtomBuffer(buffer);
+    }
+}
+
 void Lv2Effect::BypassDezipperSet(float targetValue)
 {
     this->targetBypass = targetValue;
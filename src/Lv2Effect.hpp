@@ -40,13 +40,13 @@
 #include "AtomBuffer.hpp"
 #include "StateInterface.hpp"
 #include "LogFeature.hpp"
+#include "SilenceGate.hpp"
 
 namespace pipedal
 {
 
     class RealtimeRingBufferWriter;    
     class IPatchWriterCallback;
-    class HostWorkerThread;
 
     class Lv2Effect : public IEffect, private LogFeature::LogMessageListener
     {
@@ -59,7 +59,6 @@ namespace pipedal
     private:
         size_t GetStagedBufferSize() const;
 
-        std::shared_ptr<HostWorkerThread> workerThread;
         std::unique_ptr<Worker> worker;
 
         std::unordered_map<std::string,int> controlIndex;
@@ -195,6 +194,8 @@ namespace pipedal
 
         void ResetInputAtomBuffer(char*data);
         void ResetOutputAtomBuffer(char*data);
+        // For periods in which the plugin doesn't run, so that nothing stale is read from its output atom buffers.
+        void ClearOutputAtomBuffers();
 
         uint32_t bypassStartingSamples = 0;
 
@@ -204,6 +205,35 @@ namespace pipedal
         double currentBypassDx = 0;
         uint32_t bypassSamplesRemaining = 0;
 
+        // Hard bypass: once a bypassed effect has faded out, its inputs are switched to silence.
+        // Once its output has decayed to silence, it is no longer run at all.
+        enum class HardBypassState
+        {
+            Running,
+            Draining,
+            Suspended
+        };
+        bool hardBypassEnabled = false;
+        HardBypassState hardBypassState = HardBypassState::Running;
+        float hardBypassThreshold = 0;
+        uint64_t hardBypassSilenceSamples = 0;
+        uint64_t hardBypassSilentSamples = 0;
+        std::vector<float> hardBypassZeroBuffer;
+        bool CanDrain() const;
+        bool HasPendingInputEvents() const;
+        void ConnectHardBypassInputs(bool silence);
+        void UpdateHardBypass(uint32_t samples);
+        void CopyInputToOutput(uint32_t samples);
+        float GetPluginOutputPeak(uint32_t samples) const;
+
+        // Silence skipping: while the input is silent, and the output has been silent for
+        // the silence tail time, the plugin is not run, and its outputs are zeroed.
+        bool skipSilenceEnabled = false;
+        float silenceThreshold = 0;
+        SilenceGate silenceGate;
+        bool IsInputSilent(uint32_t samples) const;
+        void ZeroOutputs(uint32_t samples);
+
         bool requestStateChangedNotification = false;
 
         float zeroInputMix = 0.5f;
@@ -344,6 +374,11 @@ namespace pipedal
             {
                 SetBypass(value != 0);
             } else {
+                if (controlValues[index] != value)
+                {
+                    // the plugin may respond to the change without any audio input (e.g. a looper or a drum machine).
+                    silenceGate.Wake();
+                }
                 controlValues[index] = value;
             }
         }
@@ -370,6 +405,10 @@ namespace pipedal
             return 0;
         }
 
+        virtual bool IsSuspended() const override { return hardBypassState == HardBypassState::Suspended; }
+        virtual bool IsSkippingSilence() const override { return silenceGate.IsSkipping(); }
+        virtual uint64_t GetSilentPeriods() const override { return silenceGate.GetSkippedPeriods(); }
+
         virtual void SetBypass(bool bypass)
         {
             if (bypass != this->bypass)
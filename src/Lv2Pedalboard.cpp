@@ -30,24 +30,990 @@
 #include "CrashGuard.hpp"
 #include "restrict.hpp"
 #include "AudioDriver.hpp"
+#include "RealtimeWorkerPool.hpp"
+#include "RingBuffer.hpp"
+#include "ExecutionPlan.hpp"
+#include <chrono>
+#include <sstream>
+#include <set>
 
 using namespace pipedal;
 
+namespace pipedal
+{
+    /**
+     * @brief The top and bottom chains of a split.
+     *
+     * If the chains can run concurrently, the split is executed by a single step that runs the top
+     * chain on the calling thread and the bottom chain on a dedicated realtime worker. Otherwise,
+     * the steps of both chains are spliced into the enclosing plan between the split's start and end steps.
+     */
+    class Lv2Pedalboard::SplitSection
+    {
+    public:
+        // Messages written by effects in the bottom chain are buffered here until the chains are joined.
+        static constexpr size_t DEFERRED_RING_BUFFER_SIZE = 16 * 1024;
+
+        SplitSection(SplitEffect *pSplit, RealtimeRingBufferWriter **ppOuterWriter)
+            : pSplit(pSplit),
+              ppOuterWriter(ppOuterWriter)
+        {
+        }
+
+        SplitEffect *pSplit;
+        RealtimeRingBufferWriter **ppOuterWriter;
+        // The writer used by steps of the bottom chain.
+        RealtimeRingBufferWriter *bottomWriter = nullptr;
+
+        int32_t startNode = -1;
+        int32_t endNode = -1;
+        int32_t topBeginNode = -1;
+        int32_t topEndNode = -1;
+        int32_t bottomBeginNode = -1;
+        int32_t bottomEndNode = -1;
+
+        ExecutionSteps topSteps;
+        ExecutionSteps bottomSteps;
+
+        bool parallel = false;
+        int workerIndex = -1;
+        RealtimeWorker *worker = nullptr; // bound by Lv2Pedalboard::BindRealtimeWorkers().
+        std::string serialReason;
+
+        std::unique_ptr<RingBuffer<false, true>> deferredRingBuffer;
+        std::unique_ptr<RealtimeRingBufferWriter> deferredWriter;
+        std::vector<uint8_t> scratch;
+
+        std::atomic<uint64_t> periods{0};
+        std::atomic<uint64_t> topTotalNs{0};
+        std::atomic<uint64_t> topMaxNs{0};
+        std::atomic<uint64_t> bottomTotalNs{0};
+        std::atomic<uint64_t> bottomMaxNs{0};
+        std::atomic<uint64_t> waitTotalNs{0};
+        std::atomic<uint64_t> waitMaxNs{0};
+
+        bool IsParallel() const { return parallel; }
+
+        void MakeParallel(int workerIndex)
+        {
+            this->parallel = true;
+            this->workerIndex = workerIndex;
+            deferredRingBuffer = std::make_unique<RingBuffer<false, true>>(DEFERRED_RING_BUFFER_SIZE);
+            deferredWriter = std::make_unique<RealtimeRingBufferWriter>(deferredRingBuffer.get());
+            scratch.resize(DEFERRED_RING_BUFFER_SIZE);
+            bottomWriter = deferredWriter.get();
+        }
+
+        static void SerialStartStep(const ExecutionStep &step, uint32_t frames)
+        {
+            SplitSection *this_ = (SplitSection *)step.target;
+            this_->bottomWriter = *(this_->ppOuterWriter);
+            this_->pSplit->PreMix(frames);
+        }
+        static void SerialEndStep(const ExecutionStep &step, uint32_t frames)
+        {
+            SplitSection *this_ = (SplitSection *)step.target;
+            this_->pSplit->PostMix(frames);
+        }
+
+        static void ParallelStep(const ExecutionStep &step, uint32_t frames)
+        {
+            ((SplitSection *)step.target)->RunParallel(frames);
+        }
+
+        SplitBranchTiming GetTiming() const
+        {
+            SplitBranchTiming result;
+            result.instanceId = pSplit->GetInstanceId();
+            result.periods = periods.load(std::memory_order_relaxed);
+            if (result.periods != 0)
+            {
+                double scale = 1E-3 / result.periods;
+                result.topAverageUs = topTotalNs.load(std::memory_order_relaxed) * scale;
+                result.bottomAverageUs = bottomTotalNs.load(std::memory_order_relaxed) * scale;
+                result.waitAverageUs = waitTotalNs.load(std::memory_order_relaxed) * scale;
+            }
+            result.topMaxUs = topMaxNs.load(std::memory_order_relaxed) * 1E-3;
+            result.bottomMaxUs = bottomMaxNs.load(std::memory_order_relaxed) * 1E-3;
+            result.waitMaxUs = waitMaxNs.load(std::memory_order_relaxed) * 1E-3;
+            return result;
+        }
+
+    private:
+        static void RunSteps(const ExecutionSteps &steps, uint32_t frames)
+        {
+            const ExecutionStep *p = steps.data();
+            const ExecutionStep *end = p + steps.size();
+            for (; p != end; ++p)
+            {
+                p->fn(*p, frames);
+            }
+        }
+
+        void RunParallel(uint32_t frames)
+        {
+            pSplit->PreMix(frames);
+
+            auto startTime = std::chrono::steady_clock::now();
+            worker->Post(&RunBottomChain, this, frames);
+
+            RunSteps(topSteps, frames);
+            auto topTime = std::chrono::steady_clock::now();
+
+            worker->Wait();
+            auto joinTime = std::chrono::steady_clock::now();
+
+            (*ppOuterWriter)->Forward(deferredRingBuffer.get(), scratch);
+
+            pSplit->PostMix(frames);
+
+            periods.fetch_add(1, std::memory_order_relaxed);
+            AddTiming(topTotalNs, topMaxNs, ToNs(topTime - startTime));
+            AddTiming(waitTotalNs, waitMaxNs, ToNs(joinTime - topTime));
+        }
+
+        static uint64_t ToNs(std::chrono::steady_clock::duration duration)
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+        static void AddTiming(std::atomic<uint64_t> &total, std::atomic<uint64_t> &max, uint64_t value)
+        {
+            // single writer; atomics only so that the host thread can read the stats.
+            total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            if (value > max.load(std::memory_order_relaxed))
+            {
+                max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        static void RunBottomChain(void *data, uint32_t frames)
+        {
+            SplitSection *this_ = (SplitSection *)data;
+            auto startTime = std::chrono::steady_clock::now();
+            RunSteps(this_->bottomSteps, frames);
+            AddTiming(this_->bottomTotalNs, this_->bottomMaxNs, ToNs(std::chrono::steady_clock::now() - startTime));
+        }
+    };
+}
+
+namespace pipedal
+{
+    /**
+     * @brief Audio passed from one pipeline stage to the next.
+     *
+     * The handoff buffers are double-buffered: in each period, the upstream stage writes
+     * handoff[parity] while the downstream stage reads handoff[parity^1], which was written
+     * in the previous period.
+     */
+    class Lv2Pedalboard::PipelineBoundary
+    {
+    public:
+        PipelineBoundary(const std::vector<float *> &source, const uint32_t *pParity)
+            : source(source), pParity(pParity)
+        {
+        }
+        std::vector<float *> source;
+        std::vector<float *> target;
+        std::vector<float *> handoff[2];
+        const uint32_t *pParity;
+
+        static void SendStep(const ExecutionStep &step, uint32_t frames)
+        {
+            PipelineBoundary *this_ = (PipelineBoundary *)step.target;
+            CopyBuffers(this_->source, this_->handoff[*this_->pParity], frames);
+        }
+        static void ReceiveStep(const ExecutionStep &step, uint32_t frames)
+        {
+            PipelineBoundary *this_ = (PipelineBoundary *)step.target;
+            CopyBuffers(this_->handoff[*this_->pParity ^ 1], this_->target, frames);
+        }
+        // Used when the downstream stage has been merged into the upstream stage.
+        static void DirectCopyStep(const ExecutionStep &step, uint32_t frames)
+        {
+            PipelineBoundary *this_ = (PipelineBoundary *)step.target;
+            CopyBuffers(this_->source, this_->target, frames);
+        }
+
+    private:
+        static void CopyBuffers(const std::vector<float *> &from, const std::vector<float *> &to, uint32_t frames)
+        {
+            for (size_t c = 0; c < to.size(); ++c)
+            {
+                const float *restrict pFrom = from[c];
+                float *restrict pTo = to[c];
+                for (uint32_t i = 0; i < frames; ++i)
+                {
+                    pTo[i] = pFrom[i];
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief A stage of a pipelined pedalboard.
+     *
+     * Stages other than stage 0 run on a dedicated realtime worker, concurrently with stage 0,
+     * each processing audio that is one period older than the audio processed by the stage before it.
+     */
+    class Lv2Pedalboard::PipelineStage
+    {
+    public:
+        static constexpr size_t DEFERRED_RING_BUFFER_SIZE = 16 * 1024;
+
+        PipelineStage()
+        {
+            deferredRingBuffer = std::make_unique<RingBuffer<false, true>>(DEFERRED_RING_BUFFER_SIZE);
+            deferredWriter = std::make_unique<RealtimeRingBufferWriter>(deferredRingBuffer.get());
+            scratch.resize(DEFERRED_RING_BUFFER_SIZE);
+            writer = deferredWriter.get();
+        }
+
+        ExecutionSteps steps;
+        int32_t beginNode = -1;
+        int32_t endNode = -1;
+        double plannedCost = 0;
+
+        // Stages that can't be run concurrently are merged into an earlier stage.
+        bool merged = false;
+        size_t mergedInto = 0;
+        std::string mergeReason;
+
+        int workerIndex = -1; // -1 if the stage doesn't run on a worker (stage 0, and merged stages).
+        RealtimeWorker *worker = nullptr; // bound by Lv2Pedalboard::BindRealtimeWorkers().
+
+        // Messages written by the stage's effects are buffered here until the stage has been joined.
+        RealtimeRingBufferWriter *writer = nullptr;
+        std::unique_ptr<RingBuffer<false, true>> deferredRingBuffer;
+        std::unique_ptr<RealtimeRingBufferWriter> deferredWriter;
+        std::vector<uint8_t> scratch;
+
+        std::atomic<uint64_t> periods{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+
+        static void RunStage(void *data, uint32_t frames)
+        {
+            PipelineStage *this_ = (PipelineStage *)data;
+            auto startTime = std::chrono::steady_clock::now();
+            const ExecutionStep *p = this_->steps.data();
+            const ExecutionStep *end = p + this_->steps.size();
+            for (; p != end; ++p)
+            {
+                p->fn(*p, frames);
+            }
+            uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+            // single writer; atomics only so that the host thread can read the stats.
+            this_->periods.store(this_->periods.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            this_->totalNs.store(this_->totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > this_->maxNs.load(std::memory_order_relaxed))
+            {
+                this_->maxNs.store(ns, std::memory_order_relaxed);
+            }
+        }
+    };
+}
+
+static void RunEffectStep(const ExecutionStep &step, uint32_t frames)
+{
+    ((IEffect *)step.target)->Run(frames, *step.ppWriter);
+}
+
+static void RunStagedEffectStep(const ExecutionStep &step, uint32_t frames)
+{
+    ((Lv2Effect *)step.target)->RunWithBufferStaging(frames, *step.ppWriter);
+}
+
+static void AddCost(StepCost *pCost, std::chrono::steady_clock::time_point startTime)
+{
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    pCost->Add(ns);
+}
+
+static void RunEffectStepTimed(const ExecutionStep &step, uint32_t frames)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    ((IEffect *)step.target)->Run(frames, *step.ppWriter);
+    AddCost(step.pCost, startTime);
+}
+
+static void RunStagedEffectStepTimed(const ExecutionStep &step, uint32_t frames)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    ((Lv2Effect *)step.target)->RunWithBufferStaging(frames, *step.ppWriter);
+    AddCost(step.pCost, startTime);
+}
+
+static void ResetTriggerStep(const ExecutionStep &step, uint32_t frames)
+{
+    ((IEffect *)step.target)->SetControl(step.controlIndex, step.value);
+}
+
+Lv2Pedalboard::Lv2Pedalboard()
+{
+}
+
+Lv2Pedalboard::~Lv2Pedalboard()
+{
+    ReportEffectCosts();
+    for (size_t i = 1; i < pipelineStages.size(); ++i)
+    {
+        const auto &stage = pipelineStages[i];
+        uint64_t periods = stage->periods.load(std::memory_order_relaxed);
+        if (stage->workerIndex >= 0 && periods != 0)
+        {
+            Lv2Log::debug(SS("Pipeline stage " << i << ": "
+                                               << periods << " periods, "
+                                               << (stage->totalNs.load(std::memory_order_relaxed) * 1E-3 / periods) << "us "
+                                               << "(max " << (stage->maxNs.load(std::memory_order_relaxed) * 1E-3) << "us)"));
+        }
+    }
+    for (const auto &section : splitSections)
+    {
+        if (!section->IsParallel())
+        {
+            continue;
+        }
+        SplitBranchTiming timing = section->GetTiming();
+        if (timing.periods != 0)
+        {
+            Lv2Log::debug(SS("Parallel split " << timing.instanceId << ": "
+                                               << timing.periods << " periods, "
+                                               << "top " << timing.topAverageUs << "us (max " << timing.topMaxUs << "us), "
+                                               << "bottom " << timing.bottomAverageUs << "us (max " << timing.bottomMaxUs << "us), "
+                                               << "wait " << timing.waitAverageUs << "us (max " << timing.waitMaxUs << "us)"));
+        }
+    }
+}
+
+std::vector<SplitBranchTiming> Lv2Pedalboard::GetSplitBranchTimings() const
+{
+    std::vector<SplitBranchTiming> result;
+    for (const auto &section : splitSections)
+    {
+        if (section->IsParallel())
+        {
+            result.push_back(section->GetTiming());
+        }
+    }
+    return result;
+}
+
+void Lv2Pedalboard::AddStep(ExecutionStep::Function fn, const char *name, void *target, int32_t node)
+{
+    ExecutionStep step;
+    step.fn = fn;
+    step.name = name;
+    step.target = target;
+    step.node = node;
+    step.ppWriter = this->preparingWriter;
+    this->preparingSteps->push_back(step);
+}
+
+void Lv2Pedalboard::CompileSplitSection(SplitSection *section)
+{
+    int32_t fromNode = -1, toNode = -1;
+    if (this->realtimeWorkerPool == nullptr || !this->parallelSplitChains)
+    {
+        section->serialReason = "parallel split chains are disabled.";
+    }
+    else if (section->topSteps.empty() || section->bottomSteps.empty())
+    {
+        section->serialReason = "empty chain.";
+    }
+    else if (executionGraph.FindEdge(
+                 section->topBeginNode, section->topEndNode,
+                 section->bottomBeginNode, section->bottomEndNode,
+                 &fromNode, &toNode))
+    {
+        // e.g. a sidechain input taken from an effect in the top chain.
+        section->serialReason = SS(
+            "bottom chain node " << executionGraph.GetNodeDescription(toNode)
+                                 << " depends on top chain node " << executionGraph.GetNodeDescription(fromNode) << ".");
+    }
+    else if (this->nextWorkerIndex >= this->realtimeWorkerPool->GetWorkerCount())
+    {
+        // each parallel split gets a dedicated worker, so that nested splits can never wait on themselves.
+        section->serialReason = "no free realtime worker.";
+    }
+    else
+    {
+        int workerIndex = (int)(this->nextWorkerIndex++);
+        ++this->parallelSplitCount;
+        section->MakeParallel(workerIndex);
+    }
+
+    if (section->IsParallel())
+    {
+        AddStep(&SplitSection::ParallelStep, "parallel-split", section, section->startNode);
+    }
+    else
+    {
+        AddStep(&SplitSection::SerialStartStep, "split-start", section, section->startNode);
+        this->preparingSteps->insert(this->preparingSteps->end(), section->topSteps.begin(), section->topSteps.end());
+        this->preparingSteps->insert(this->preparingSteps->end(), section->bottomSteps.begin(), section->bottomSteps.end());
+        AddStep(&SplitSection::SerialEndStep, "split-end", section, section->endNode);
+        section->topSteps.clear();
+        section->bottomSteps.clear();
+    }
+}
+
+std::string Lv2Pedalboard::GetExecutionPlanDump() const
+{
+    std::stringstream s;
+    s << "Execution plan: " << executionGraph.GetNodeCount() << " nodes, "
+      << executionPlan.size() << " steps, "
+      << parallelSplitCount << " parallel split(s)." << std::endl;
+    s << "Audio buffers: " << audioBufferAllocation.requested << " requested, "
+      << audioBufferAllocation.allocated << " allocated ("
+      << (audioBufferAllocation.requested - audioBufferAllocation.allocated) << " saved), "
+      << audioBufferAllocation.arenaBytes << " byte arena." << std::endl;
+    executionGraph.Dump(s);
+    s << "Splits:" << std::endl;
+    for (const auto &section : splitSections)
+    {
+        s << "    " << executionGraph.GetNodeDescription(section->startNode) << ": ";
+        if (section->IsParallel())
+        {
+            s << "parallel, bottom chain on worker " << section->workerIndex << "." << std::endl;
+        }
+        else
+        {
+            s << "serial, " << section->serialReason << std::endl;
+        }
+    }
+    if (!pipelineStages.empty())
+    {
+        s << "Pipeline: " << pipelineStages.size() << " stage(s), " << GetPipelineLatencyPeriods() << " period(s) of added latency." << std::endl;
+        for (size_t i = 0; i < pipelineStages.size(); ++i)
+        {
+            const auto &stage = pipelineStages[i];
+            s << "    stage " << i << ": nodes #" << stage->beginNode << "-#" << (stage->endNode - 1)
+              << ", estimated cost " << stage->plannedCost << ", ";
+            if (stage->merged)
+            {
+                s << "merged into stage " << stage->mergedInto << ", " << stage->mergeReason << std::endl;
+            }
+            else if (stage->workerIndex >= 0)
+            {
+                s << "worker " << stage->workerIndex << "." << std::endl;
+            }
+            else
+            {
+                s << "audio thread." << std::endl;
+            }
+        }
+    }
+    s << "Steps:" << std::endl;
+    ExecutionGraph::DumpSteps(s, executionPlan, "    ");
+    for (size_t i = 1; i < pipelineStages.size(); ++i)
+    {
+        if (pipelineStages[i]->workerIndex >= 0)
+        {
+            s << "Steps (pipeline stage " << i << ", worker " << pipelineStages[i]->workerIndex << "):" << std::endl;
+            ExecutionGraph::DumpSteps(s, pipelineStages[i]->steps, "    ");
+        }
+    }
+    for (const auto &section : splitSections)
+    {
+        if (section->IsParallel())
+        {
+            s << "Steps (split " << section->pSplit->GetInstanceId() << " top chain):" << std::endl;
+            ExecutionGraph::DumpSteps(s, section->topSteps, "    ");
+            s << "Steps (split " << section->pSplit->GetInstanceId() << " bottom chain, worker " << section->workerIndex << "):" << std::endl;
+            ExecutionGraph::DumpSteps(s, section->bottomSteps, "    ");
+        }
+    }
+    return s.str();
+}
+
+size_t Lv2Pedalboard::GetPipelineLatencyPeriods() const
+{
+    size_t result = 0;
+    for (size_t i = 1; i < pipelineStages.size(); ++i)
+    {
+        if (pipelineStages[i]->workerIndex >= 0)
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+double Lv2Pedalboard::EstimateCost(const PedalboardItem &item, double defaultCost)
+{
+    if (item.isEmpty())
+    {
+        return 0;
+    }
+    if (item.isSplit())
+    {
+        double result = 0;
+        for (const auto &child : item.topChain())
+        {
+            result += EstimateCost(child, defaultCost);
+        }
+        for (const auto &child : item.bottomChain())
+        {
+            result += EstimateCost(child, defaultCost);
+        }
+        return result;
+    }
+    double cost = pHost->GetEffectCost(item.uri());
+    return cost < 0 ? defaultCost : cost;
+}
+
+static void GetKnownEffectCosts(IHost *pHost, const std::vector<PedalboardItem> &items, double *pTotal, size_t *pCount)
+{
+    for (const auto &item : items)
+    {
+        if (item.isSplit())
+        {
+            GetKnownEffectCosts(pHost, item.topChain(), pTotal, pCount);
+            GetKnownEffectCosts(pHost, item.bottomChain(), pTotal, pCount);
+        }
+        else if (!item.isEmpty())
+        {
+            double cost = pHost->GetEffectCost(item.uri());
+            if (cost >= 0)
+            {
+                *pTotal += cost;
+                ++*pCount;
+            }
+        }
+    }
+}
+
+std::vector<size_t> Lv2Pedalboard::PlanPipelineStages(const std::vector<PedalboardItem> &items, size_t nStages)
+{
+    // Effects whose cost hasn't been measured yet are assumed to cost the average of those that have.
+    double knownTotal = 0;
+    size_t knownCount = 0;
+    GetKnownEffectCosts(pHost, items, &knownTotal, &knownCount);
+    double defaultCost = knownCount == 0 ? 1.0 : knownTotal / knownCount;
+
+    // Stages start at non-empty items.
+    std::vector<size_t> positions;
+    std::vector<double> costs;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (!items[i].isEmpty())
+        {
+            positions.push_back(i);
+            costs.push_back(EstimateCost(items[i], defaultCost));
+        }
+    }
+    size_t n = positions.size();
+    std::vector<double> prefix(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        prefix[i + 1] = prefix[i] + costs[i];
+    }
+
+    // Linear partition: best[k][i] is the smallest achievable maximum stage cost when
+    // the first i items are divided into k stages.
+    constexpr double INF = std::numeric_limits<double>::max();
+    std::vector<std::vector<double>> best(nStages + 1, std::vector<double>(n + 1, INF));
+    std::vector<std::vector<size_t>> split(nStages + 1, std::vector<size_t>(n + 1, 0));
+    best[0][0] = 0;
+    for (size_t k = 1; k <= nStages; ++k)
+    {
+        for (size_t i = k; i <= n; ++i)
+        {
+            for (size_t j = k - 1; j < i; ++j)
+            {
+                if (best[k - 1][j] == INF)
+                {
+                    continue;
+                }
+                double cost = std::max(best[k - 1][j], prefix[i] - prefix[j]);
+                if (cost < best[k][i])
+                {
+                    best[k][i] = cost;
+                    split[k][i] = j;
+                }
+            }
+        }
+    }
+    std::vector<size_t> result(nStages);
+    size_t i = n;
+    for (size_t k = nStages; k > 0; --k)
+    {
+        size_t j = split[k][i];
+        result[k - 1] = (k == 1) ? 0 : positions[j];
+        i = j;
+    }
+    return result;
+}
+
+std::vector<float *> Lv2Pedalboard::PreparePipeline(
+    std::vector<PedalboardItem> &items,
+    size_t nStages,
+    Lv2PedalboardErrorList &errorList,
+    ExistingEffectMap *existingEffects)
+{
+    std::vector<size_t> stageStarts = PlanPipelineStages(items, nStages);
+
+    // Stage workers are reserved ahead of any parallel splits.
+    this->nextWorkerIndex = nStages - 1;
+
+    std::vector<float *> buffers = this->pedalboardInputBuffers;
+    for (size_t k = 0; k < nStages; ++k)
+    {
+        size_t begin = stageStarts[k];
+        size_t end = k + 1 < nStages ? stageStarts[k + 1] : items.size();
+
+        auto stage = std::make_unique<PipelineStage>();
+        for (size_t i = begin; i < end; ++i)
+        {
+            stage->plannedCost += EstimateCost(items[i], 1.0);
+        }
+        if (k != 0)
+        {
+            auto boundary = std::make_unique<PipelineBoundary>(buffers, &this->pipelineParity);
+            boundary->target = AllocateAudioBuffers(buffers.size());
+            boundary->handoff[0] = AllocatePersistentAudioBuffers(buffers.size());
+            boundary->handoff[1] = AllocatePersistentAudioBuffers(buffers.size());
+
+            // the send step goes at the end of the previous stage.
+            AddStep(&PipelineBoundary::SendStep, "pipeline-send", boundary.get(), -1);
+
+            this->preparingSteps = &stage->steps;
+            this->preparingWriter = &stage->writer;
+            stage->beginNode = executionGraph.AddNode(ExecutionGraph::NodeType::PipelineHandoff, -1, "pipeline");
+            for (float *buffer : buffers)
+            {
+                executionGraph.AddBufferEdge(stage->beginNode, buffer);
+            }
+            for (float *buffer : boundary->target)
+            {
+                executionGraph.SetBufferProducer(buffer, stage->beginNode);
+            }
+            AddStep(&PipelineBoundary::ReceiveStep, "pipeline-receive", boundary.get(), stage->beginNode);
+            buffers = boundary->target;
+            this->pipelineBoundaries.push_back(std::move(boundary));
+        }
+        else
+        {
+            this->preparingSteps = &stage->steps;
+            this->preparingWriter = &this->ringBufferWriter;
+            stage->beginNode = executionGraph.GetNodeCount();
+        }
+        buffers = PrepareItems(items, begin, end, buffers, errorList, existingEffects);
+        stage->endNode = executionGraph.GetNodeCount();
+        this->pipelineStages.push_back(std::move(stage));
+    }
+
+    // A stage that takes a sidechain input from an earlier stage (or from the pedalboard input)
+    // would see it one period late, so it is merged into the stage that produces the input.
+    std::vector<ExecutionGraph::PipelineStageNodes> stageNodes;
+    for (const auto &stage : pipelineStages)
+    {
+        stageNodes.push_back({stage->beginNode, stage->endNode});
+    }
+    std::vector<std::string> mergeReasons;
+    std::vector<size_t> groups = executionGraph.MergePipelineStages(stageNodes, &mergeReasons);
+
+    int workerIndex = 0;
+    for (size_t k = 1; k < nStages; ++k)
+    {
+        PipelineStage *stage = pipelineStages[k].get();
+        size_t group = groups[k];
+        if (group != k)
+        {
+            // groups are contiguous, so the group's steps end with the send step for this stage.
+            stage->merged = true;
+            stage->mergedInto = group;
+            stage->mergeReason = mergeReasons[k];
+            ExecutionSteps &groupSteps = pipelineStages[group]->steps;
+            groupSteps.back().fn = &PipelineBoundary::DirectCopyStep;
+            groupSteps.back().name = "pipeline-copy";
+            groupSteps.insert(groupSteps.end(), stage->steps.begin() + 1, stage->steps.end());
+            stage->steps.clear();
+        }
+        else
+        {
+            stage->workerIndex = workerIndex++;
+        }
+    }
+    this->preparingSteps = &this->executionPlan;
+    this->preparingWriter = &this->ringBufferWriter;
+    this->executionPlan = std::move(pipelineStages[0]->steps);
+    pipelineStages[0]->steps.clear();
+    return buffers;
+}
+
+void Lv2Pedalboard::AssignCostCounters(ExecutionSteps &steps)
+{
+    for (auto &step : steps)
+    {
+        if (step.fn == &RunEffectStep)
+        {
+            step.fn = &RunEffectStepTimed;
+            step.pCost = &this->nodeCosts[step.node];
+        }
+        else if (step.fn == &RunStagedEffectStep)
+        {
+            step.fn = &RunStagedEffectStepTimed;
+            step.pCost = &this->nodeCosts[step.node];
+        }
+    }
+}
+
+void Lv2Pedalboard::EnableEffectCostMeasurement()
+{
+    if (this->measureEffectCosts)
+    {
+        return;
+    }
+    this->measureEffectCosts = true;
+    this->nodeCosts = std::make_unique<StepCost[]>(executionGraph.GetNodeCount());
+    AssignCostCounters(this->executionPlan);
+    for (auto &stage : this->pipelineStages)
+    {
+        AssignCostCounters(stage->steps);
+    }
+    for (auto &section : this->splitSections)
+    {
+        AssignCostCounters(section->topSteps);
+        AssignCostCounters(section->bottomSteps);
+    }
+    for (int32_t i = 0; i < executionGraph.GetNodeCount(); ++i)
+    {
+        if (executionGraph.GetNode(i).type == ExecutionGraph::NodeType::Effect)
+        {
+            int64_t instanceId = executionGraph.GetNode(i).instanceId;
+            effectCpuUseCollector.AddEffect(instanceId, &nodeCosts[i], GetEffect(instanceId));
+            effectNodeCosts.push_back(&nodeCosts[i]);
+        }
+    }
+}
+
+size_t Lv2Pedalboard::GetEffectPeriodCosts(uint32_t *ns, size_t maxEffects) const
+{
+    size_t n = std::min(effectNodeCosts.size(), maxEffects);
+    for (size_t i = 0; i < n; ++i)
+    {
+        ns[i] = effectNodeCosts[i]->lastNs.load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+const EffectCpuUpdate *Lv2Pedalboard::CollectEffectCpuUse()
+{
+    if (!measureEffectCosts)
+    {
+        return nullptr;
+    }
+    return &effectCpuUseCollector.Collect(
+        measuredPeriods.load(std::memory_order_relaxed),
+        measuredFrames,
+        pHost->GetSampleRate());
+}
+
+std::vector<Lv2Pedalboard::EffectCostCounter> Lv2Pedalboard::GetEffectCostCounters() const
+{
+    std::vector<EffectCostCounter> result;
+    if (!measureEffectCosts || !nodeCosts)
+    {
+        return result;
+    }
+    for (int32_t i = 0; i < executionGraph.GetNodeCount(); ++i)
+    {
+        const auto &node = executionGraph.GetNode(i);
+        if (node.type == ExecutionGraph::NodeType::Effect)
+        {
+            result.push_back(EffectCostCounter{node.instanceId, node.name, &nodeCosts[i].totalNs});
+        }
+    }
+    return result;
+}
+
+void Lv2Pedalboard::ReportEffectCosts()
+{
+    if (!measureEffectCosts || !nodeCosts)
+    {
+        return;
+    }
+    uint64_t periods = measuredPeriods.load(std::memory_order_relaxed);
+    if (periods == 0)
+    {
+        return;
+    }
+    for (int32_t i = 0; i < executionGraph.GetNodeCount(); ++i)
+    {
+        const auto &node = executionGraph.GetNode(i);
+        if (node.type == ExecutionGraph::NodeType::Effect)
+        {
+            pHost->UpdateEffectCost(node.name, nodeCosts[i].totalNs.load(std::memory_order_relaxed) * 1E-3 / periods);
+        }
+    }
+}
+
 float *Lv2Pedalboard::CreateNewAudioBuffer()
 {
-    return bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize());
+    float *result = chainBufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize());
+    chainBuffers.push_back(result);
+    return result;
+}
+
+std::vector<float *> Lv2Pedalboard::AllocateAudioBuffers(int nChannels)
+{
+    std::vector<float *> result;
+    for (int i = 0; i < nChannels; ++i)
+    {
+        result.push_back(CreateNewAudioBuffer());
+    }
+    return result;
 }
 
-std::vector<float *> Lv2Pedalboard::AllocateAudioBuffers(int nChannels)
+std::vector<float *> Lv2Pedalboard::AllocatePersistentAudioBuffers(size_t nChannels)
 {
     std::vector<float *> result;
-    for (int i = 0; i < nChannels; ++i)
+    for (size_t i = 0; i < nChannels; ++i)
     {
         result.push_back(bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize()));
     }
     return result;
 }
 
+void Lv2Pedalboard::AllocateBufferArena()
+{
+    auto lifetimes = executionGraph.GetBufferLifetimes();
+    int32_t nodeCount = executionGraph.GetNodeCount();
+
+    // Pipeline stages run concurrently, so each stage gets its own group of buffers.
+    std::vector<int32_t> nodeGroups(nodeCount, 0);
+    int32_t group = 0;
+    for (size_t k = 1; k < pipelineStages.size(); ++k)
+    {
+        const auto &stage = pipelineStages[k];
+        if (!stage->merged)
+        {
+            group = (int32_t)k;
+        }
+        for (int32_t node = stage->beginNode; node < stage->endNode; ++node)
+        {
+            nodeGroups[node] = group;
+        }
+    }
+
+    std::vector<BufferSlotRequest> requests;
+    requests.reserve(chainBuffers.size());
+    for (float *buffer : chainBuffers)
+    {
+        // buffers the graph doesn't know about are live for the whole period.
+        BufferSlotRequest request{0, nodeCount, 0};
+        auto f = lifetimes.find(buffer);
+        if (f != lifetimes.end())
+        {
+            request.first = f->second.first;
+            request.last = f->second.last;
+            request.group = nodeGroups[request.first];
+        }
+        for (float *output : pedalboardOutputBuffers)
+        {
+            if (output == buffer)
+            {
+                request.last = nodeCount; // read after the plan completes.
+            }
+        }
+        requests.push_back(request);
+    }
+    // The chains of a parallel split run concurrently, so buffers used anywhere in the split are
+    // live for the whole split. Sections are in pre-order; inner sections are extended first.
+    for (auto i = splitSections.rbegin(); i != splitSections.rend(); ++i)
+    {
+        const SplitSection *section = i->get();
+        if (!section->IsParallel())
+        {
+            continue;
+        }
+        for (auto &request : requests)
+        {
+            if (request.first <= section->endNode && request.last >= section->startNode)
+            {
+                request.first = std::min(request.first, section->startNode);
+                request.last = std::max(request.last, section->endNode);
+            }
+        }
+    }
+
+    size_t slotCount = 0;
+    std::vector<size_t> slots = AssignBufferSlots(requests, &slotCount);
+    std::vector<float *> arena = bufferPool.AllocateArena<float>(slotCount, pHost->GetMaxAudioBufferSize());
+
+    std::map<float *, float *> bufferMap;
+    for (size_t i = 0; i < chainBuffers.size(); ++i)
+    {
+        bufferMap[chainBuffers[i]] = arena[slots[i]];
+    }
+    auto remap = [&bufferMap](float *buffer) -> float *
+    {
+        auto f = bufferMap.find(buffer);
+        return f == bufferMap.end() ? buffer : f->second;
+    };
+
+    std::set<IEffect *> splitEffects;
+    for (auto &section : splitSections)
+    {
+        section->pSplit->RemapAudioBuffers(remap);
+        splitEffects.insert(section->pSplit);
+    }
+    for (auto &effect : effects)
+    {
+        if (splitEffects.contains(effect.get()))
+        {
+            continue;
+        }
+        for (int i = 0; i < effect->GetNumberOfInputAudioBuffers(); ++i)
+        {
+            float *buffer = effect->GetAudioInputBuffer(i);
+            if (remap(buffer) != buffer)
+            {
+                effect->SetAudioInputBuffer(i, remap(buffer));
+            }
+        }
+        for (int i = 0; i < effect->GetNumberOfSidechainAudioBuffers(); ++i)
+        {
+            float *buffer = effect->GetAudioSidechainBuffer(i);
+            if (remap(buffer) != buffer)
+            {
+                effect->SetAudioSidechainBuffer(i, remap(buffer));
+            }
+        }
+        for (int i = 0; i < effect->GetNumberOfOutputAudioBuffers(); ++i)
+        {
+            float *buffer = effect->GetAudioOutputBuffer(i);
+            if (remap(buffer) != buffer)
+            {
+                effect->SetAudioOutputBuffer(i, remap(buffer));
+            }
+        }
+    }
+    for (auto &boundary : pipelineBoundaries)
+    {
+        for (auto &buffer : boundary->source)
+        {
+            buffer = remap(buffer);
+        }
+        for (auto &buffer : boundary->target)
+        {
+            buffer = remap(buffer);
+        }
+    }
+    for (auto &buffer : pedalboardOutputBuffers)
+    {
+        buffer = remap(buffer);
+    }
+
+    audioBufferAllocation.requested = chainBuffers.size();
+    audioBufferAllocation.allocated = slotCount;
+    audioBufferAllocation.arenaBytes = bufferPool.GetArenaSize();
+
+    chainBuffers.clear();
+    chainBufferPool.Clear();
+}
+
 int Lv2Pedalboard::GetControlIndex(uint64_t instanceId, const std::string &symbol)
 {
     for (int i = 0; i < realtimeEffects.size(); ++i)
@@ -67,12 +1033,23 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
     Lv2PedalboardErrorList &errorList,
     ExistingEffectMap *existingEffects)
 {
-    for (int i = 0; i < items.size(); ++i)
+    return PrepareItems(items, 0, items.size(), inputBuffers, errorList, existingEffects);
+}
+
+std::vector<float *> Lv2Pedalboard::PrepareItems(
+    std::vector<PedalboardItem> &items,
+    size_t begin, size_t end,
+    std::vector<float *> inputBuffers,
+    Lv2PedalboardErrorList &errorList,
+    ExistingEffectMap *existingEffects)
+{
+    for (size_t i = begin; i < end; ++i)
     {
         auto &item = items[i];
         if (!item.isEmpty())
         {
             std::shared_ptr<IEffect> pEffect = nullptr;
+            int32_t effectNode = -1;
 
             if (item.isSplit())
             {
@@ -85,17 +1062,58 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                 std::vector<float *> topInputs = AllocateAudioBuffers(topInputChannels);
                 std::vector<float *> bottomInputs = AllocateAudioBuffers(bottomInputChannels);
 
-                auto preMixAction = [pSplit](uint32_t frames)
-                { pSplit->PreMix(frames); };
+                auto section = std::make_unique<SplitSection>(pSplit, this->preparingWriter);
+                SplitSection *pSection = section.get();
+                this->splitSections.push_back(std::move(section));
+
+                effectNode = pSection->startNode = executionGraph.AddNode(ExecutionGraph::NodeType::SplitStart, item.instanceId(), "split");
+                for (float *buffer : inputBuffers)
+                {
+                    executionGraph.AddBufferEdge(pSection->startNode, buffer);
+                }
+                for (float *buffer : topInputs)
+                {
+                    executionGraph.SetBufferProducer(buffer, pSection->startNode);
+                }
+                for (float *buffer : bottomInputs)
+                {
+                    executionGraph.SetBufferProducer(buffer, pSection->startNode);
+                }
 
-                this->processActions.push_back(preMixAction);
+                auto *outerSteps = this->preparingSteps;
+                auto **outerWriter = this->preparingWriter;
 
+                this->preparingSteps = &pSection->topSteps;
+                pSection->topBeginNode = executionGraph.GetNodeCount();
                 std::vector<float *> topResult = PrepareItems(item.topChain(), topInputs, errorList, existingEffects);
+                pSection->topEndNode = executionGraph.GetNodeCount();
+
+                this->preparingSteps = &pSection->bottomSteps;
+                this->preparingWriter = &pSection->bottomWriter;
+                pSection->bottomBeginNode = executionGraph.GetNodeCount();
                 std::vector<float *> bottomResult = PrepareItems(item.bottomChain(), bottomInputs, errorList, existingEffects);
+                pSection->bottomEndNode = executionGraph.GetNodeCount();
+
+                this->preparingSteps = outerSteps;
+                this->preparingWriter = outerWriter;
+
+                effectNode = pSection->endNode = executionGraph.AddNode(ExecutionGraph::NodeType::SplitEnd, item.instanceId(), "split");
+                for (float *buffer : topResult)
+                {
+                    executionGraph.AddBufferEdge(pSection->endNode, buffer);
+                }
+                for (float *buffer : bottomResult)
+                {
+                    executionGraph.AddBufferEdge(pSection->endNode, buffer);
+                }
+                for (float *buffer : inputBuffers)
+                {
+                    // read by the split's VU step.
+                    executionGraph.AddBufferEdge(pSection->endNode, buffer);
+                }
+
+                CompileSplitSection(pSection);
 
-                this->processActions.push_back(
-                    [pSplit](uint32_t frames)
-                    { pSplit->PostMix(frames); });
                 auto controlValue = item.GetControlValue("splitType");
                 // if split is L/R, always output stereo.
 
@@ -148,6 +1166,12 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                     uint64_t instanceId = pEffect->GetInstanceId();
                     pLv2Effect->PrepareNoInputEffect(inputBuffers.size(), pHost->GetMaxAudioBufferSize());
 
+                    effectNode = executionGraph.AddNode(ExecutionGraph::NodeType::Effect, item.instanceId(), item.uri());
+                    for (float *buffer : inputBuffers)
+                    {
+                        executionGraph.AddBufferEdge(effectNode, buffer);
+                    }
+
                     if (inputBuffers.size() == 1)
                     {
                         if (pLv2Effect->GetNumberOfInputAudioBuffers() == 1)
@@ -194,6 +1218,7 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                     // just use the first output buffer for all sidechain inputs.
                                     pLv2Effect->SetAudioSidechainBuffer(i, this->pedalboardInputBuffers[0]);
                                 }
+                                executionGraph.AddBufferEdge(effectNode, pLv2Effect->GetAudioSidechainBuffer(i), ExecutionGraph::EdgeType::Sidechain);
                             }
                         }
                         else if (item.sideChainInputId() != -1)
@@ -213,6 +1238,7 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                         // just use the first output buffer for all sidechain inputs.
                                         pLv2Effect->SetAudioSidechainBuffer(i, pSideChainInput->GetAudioOutputBuffer(0));
                                     }
+                                    executionGraph.AddBufferEdge(effectNode, pLv2Effect->GetAudioSidechainBuffer(i), ExecutionGraph::EdgeType::Sidechain);
                                 }
                             }
                             else
@@ -229,7 +1255,7 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                 // just use one buffer for all plugins
                                 if (!this->pedalboardSidechainBuffer)
                                 {
-                                    this->pedalboardSidechainBuffer = CreateNewAudioBuffer();
+                                    this->pedalboardSidechainBuffer = AllocatePersistentAudioBuffers(1)[0];
                                 }
                                 pLv2Effect->SetAudioSidechainBuffer(i, this->pedalboardSidechainBuffer);
                             }
@@ -245,21 +1271,13 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                         if (lv2Effect->RequiresBufferStaging())
                         {
                             requiresBufferStaging = true;
-                            this->processActions.push_back(
-                                [lv2Effect, this](uint32_t frames)
-                                {
-                                    lv2Effect->RunWithBufferStaging(frames, this->ringBufferWriter);
-                                });
+                            AddStep(&RunStagedEffectStep, "run-staged", lv2Effect, effectNode);
                         }
                     }
 
                     if (!requiresBufferStaging)
                     {
-                        this->processActions.push_back(
-                            [pLv2Effect, this](uint32_t frames)
-                            {
-                                pLv2Effect->Run(frames, this->ringBufferWriter);
-                            });
+                        AddStep(&RunEffectStep, "run", pLv2Effect.get(), effectNode);
                     }
 
                     // reset any trigger controls to default state after processing
@@ -277,12 +1295,9 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                     int controlIndex = lv2Effect->GetControlIndex(control->symbol());
                                     if (controlIndex >= 0)
                                     {
-                                        float defaultValue = control->default_value();
-                                        this->processActions.push_back(
-                                            [pLv2Effect, controlIndex, defaultValue](int32_t frames)
-                                            {
-                                                pLv2Effect->SetControl(controlIndex, defaultValue);
-                                            });
+                                        AddStep(&ResetTriggerStep, "reset-trigger", pLv2Effect.get(), effectNode);
+                                        this->preparingSteps->back().controlIndex = controlIndex;
+                                        this->preparingSteps->back().value = control->default_value();
                                     }
                                 }
                             }
@@ -296,6 +1311,10 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
 
                 this->realtimeEffects.push_back(pEffect.get()); // because std::shared_ptr is not threadsafe.
 
+                AddStep(&Lv2Pedalboard::VuStep, "vu", this, effectNode);
+                this->preparingSteps->back().controlIndex = (int32_t)(this->realtimeEffects.size() - 1);
+                SetVuInputSource(pEffect.get());
+
                 std::vector<float *> effectOutput;
 
                 if (pEffect->GetNumberOfOutputAudioBuffers() == 1)
@@ -310,6 +1329,7 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                 for (size_t i = 0; i < effectOutput.size(); ++i)
                 {
                     pEffect->SetAudioOutputBuffer(i, effectOutput[i]);
+                    executionGraph.SetBufferProducer(effectOutput[i], effectNode);
                 }
                 inputBuffers = effectOutput;
             }
@@ -321,6 +1341,8 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
 void Lv2Pedalboard::Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects)
 {
     this->pHost = pHost;
+    this->realtimeWorkerPool = pHost->GetRealtimeWorkerPool();
+    this->parallelSplitChains = pHost->GetParallelSplitChains();
 
     inputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
     outputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
@@ -332,12 +1354,41 @@ void Lv2Pedalboard::Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardE
 
     size_t nInputs = std::max(GetNumberOfAudioInputChannels(),(size_t)1);
 
+    int32_t inputNode = executionGraph.AddNode(ExecutionGraph::NodeType::PedalboardInput, -1, "");
     for (size_t i = 0; i < nInputs; ++i)
     {
         this->pedalboardInputBuffers.push_back(bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize()));
+        executionGraph.SetBufferProducer(this->pedalboardInputBuffers.back(), inputNode);
     }
 
-    auto outputs = PrepareItems(pedalboard.items(), this->pedalboardInputBuffers, errorList, existingEffects);
+    size_t nStages = 1;
+    if (this->realtimeWorkerPool != nullptr && pHost->GetPipelineStages() > 1)
+    {
+        size_t nItems = 0;
+        for (const auto &item : pedalboard.items())
+        {
+            if (!item.isEmpty())
+            {
+                ++nItems;
+            }
+        }
+        nStages = std::min(pHost->GetPipelineStages(), this->realtimeWorkerPool->GetWorkerCount() + 1);
+        nStages = std::min(nStages, nItems);
+    }
+
+    std::vector<float *> outputs;
+    if (nStages > 1)
+    {
+        outputs = PreparePipeline(pedalboard.items(), nStages, errorList, existingEffects);
+    }
+    else
+    {
+        outputs = PrepareItems(pedalboard.items(), this->pedalboardInputBuffers, errorList, existingEffects);
+    }
+
+    // Cheap enough to leave on: two clock reads per effect per period.
+    EnableEffectCostMeasurement();
+
     size_t nOutputs = GetNumberOfAudioOutputChannels();
     if (nOutputs == 1)
     {
@@ -357,6 +1408,35 @@ void Lv2Pedalboard::Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardE
         }
     }
     PrepareMidiMap(pedalboard);
+
+    std::vector<size_t> controlCounts;
+    controlCounts.reserve(this->realtimeEffects.size());
+    for (IEffect *effect : this->realtimeEffects)
+    {
+        controlCounts.push_back(effect->GetMaxInputControl());
+    }
+    controlValueTable.Prepare(controlCounts);
+
+    // (before buffers are moved into the arena, where unrelated buffers may share storage.)
+    this->vuStartSource = FindVuLevelSource(this->pedalboardInputBuffers, false);
+    this->vuEndSource = FindVuLevelSource(this->pedalboardOutputBuffers, true);
+
+    AllocateBufferArena();
+    this->effectVuUpdates.resize(this->realtimeEffects.size());
+    this->effectVuLevels.resize(this->realtimeEffects.size());
+    this->vuInputSources.resize(this->realtimeEffects.size());
+
+    Lv2Log::debug(SS("Pedalboard audio buffers: " << audioBufferAllocation.allocated << " of " << audioBufferAllocation.requested
+                                                    << " (" << (audioBufferAllocation.requested - audioBufferAllocation.allocated) << " saved by reuse)."));
+    if (GetPipelineLatencyPeriods() != 0)
+    {
+        Lv2Log::info(SS("Pedalboard pipelined over " << (GetPipelineLatencyPeriods() + 1) << " threads. Added latency: "
+                                                     << GetPipelineLatencyPeriods() << " period(s)."));
+    }
+    if (Lv2Log::log_level() >= LogLevel::Debug)
+    {
+        Lv2Log::debug(GetExecutionPlanDump());
+    }
 }
 
 void Lv2Pedalboard::PrepareMidiMap(const PedalboardItem &pedalboardItem)
@@ -486,6 +1566,29 @@ void Lv2Pedalboard::UpdateAudioPorts()
     }
 }
 
+void Lv2Pedalboard::BindRealtimeWorkers()
+{
+    if (this->realtimeWorkers || this->realtimeWorkerPool == nullptr)
+    {
+        return;
+    }
+    this->realtimeWorkers = this->realtimeWorkerPool->AcquireWorkerSet();
+    for (auto &section : splitSections)
+    {
+        if (section->IsParallel())
+        {
+            section->worker = this->realtimeWorkers->GetWorker(section->workerIndex);
+        }
+    }
+    for (auto &stage : pipelineStages)
+    {
+        if (stage->workerIndex >= 0)
+        {
+            stage->worker = this->realtimeWorkers->GetWorker(stage->workerIndex);
+        }
+    }
+}
+
 void Lv2Pedalboard::Activate()
 {
     CrashGuardLock crashGuardLock;
@@ -510,9 +1613,37 @@ static void Copy(float *restrict input, float *restrict output, uint32_t samples
         output[i] = input[i];
     }
 }
-bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *ringBufferWriter)
+bool Lv2Pedalboard::SharesEffectsWith(const Lv2Pedalboard &other) const
+{
+    for (IEffect *effect : this->realtimeEffects)
+    {
+        for (IEffect *otherEffect : other.realtimeEffects)
+        {
+            if (effect == otherEffect)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *ringBufferWriter, RealtimeVuBuffers *realtimeVuBuffers)
 {
     this->ringBufferWriter = ringBufferWriter;
+
+    std::fill(this->effectVuUpdates.begin(), this->effectVuUpdates.end(), nullptr);
+    if (realtimeVuBuffers != nullptr)
+    {
+        for (size_t i = 0; i < realtimeVuBuffers->enabledIndexes.size(); ++i)
+        {
+            int index = realtimeVuBuffers->enabledIndexes[i].index;
+            if (index >= 0 && index < (int)this->effectVuUpdates.size())
+            {
+                this->effectVuUpdates[index] = &realtimeVuBuffers->vuUpdateWorkingData[i];
+            }
+        }
+    }
     for (size_t i = 0; i < this->pedalboardInputBuffers.size(); ++i)
     {
         if (inputBuffers[i] == nullptr)
@@ -529,10 +1660,46 @@ bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t sa
             this->pedalboardInputBuffers[c][i] = inputBuffers[c][i] * volume;
         }
     }
-    for (int i = 0; i < this->processActions.size(); ++i)
+    for (size_t i = 1; i < this->pipelineStages.size(); ++i)
+    {
+        PipelineStage *stage = this->pipelineStages[i].get();
+        if (stage->worker)
+        {
+            stage->worker->Post(&PipelineStage::RunStage, stage, samples);
+        }
+    }
+    {
+        const ExecutionStep *step = this->executionPlan.data();
+        const ExecutionStep *end = step + this->executionPlan.size();
+        for (; step != end; ++step)
+        {
+            step->fn(*step, samples);
+        }
+    }
+    if (!this->pipelineStages.empty())
+    {
+        for (size_t i = 1; i < this->pipelineStages.size(); ++i)
+        {
+            PipelineStage *stage = this->pipelineStages[i].get();
+            if (stage->worker)
+            {
+                stage->worker->Wait();
+            }
+        }
+        for (size_t i = 1; i < this->pipelineStages.size(); ++i)
+        {
+            PipelineStage *stage = this->pipelineStages[i].get();
+            ringBufferWriter->Forward(stage->deferredRingBuffer.get(), stage->scratch);
+        }
+        this->pipelineParity ^= 1;
+    }
+    if (this->measureEffectCosts)
     {
-        processActions[i](samples);
+        this->measuredPeriods.fetch_add(1, std::memory_order_relaxed);
+        this->measuredFrames += samples;
     }
+    size_t plugins = 0;
+    size_t idlePlugins = 0;
     for (size_t i = 0; i < this->effects.size(); ++i)
     {
         IEffect *effect = effects[i].get();
@@ -540,7 +1707,16 @@ bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t sa
         {
             ringBufferWriter->WriteLv2ErrorMessage(effect->GetInstanceId(), effect->TakeErrorMessage());
         }
+        if (effect->IsLv2Effect() || effect->IsVst3())
+        {
+            ++plugins;
+            if (effect->IsSkippingSilence() || effect->IsSuspended())
+            {
+                ++idlePlugins;
+            }
+        }
     }
+    this->silent = plugins != 0 && idlePlugins == plugins;
     for (size_t i = 0; i < samples; ++i)
     {
         float volume = outputVolume.Tick();
@@ -568,6 +1744,15 @@ void Lv2Pedalboard::SetControlValue(int effectIndex, int index, float value)
     auto effect = realtimeEffects[effectIndex];
     effect->SetControl(index, value);
 }
+void Lv2Pedalboard::ApplyControlValues()
+{
+    controlValueTable.Apply(
+        [this](int effectIndex, int controlIndex, float value)
+        {
+            realtimeEffects[effectIndex]->SetControl(controlIndex, value);
+        });
+}
+
 void Lv2Pedalboard::SetBypass(int effectIndex, bool enabled)
 {
     auto effect = realtimeEffects[effectIndex];
@@ -575,6 +1760,107 @@ void Lv2Pedalboard::SetBypass(int effectIndex, bool enabled)
 }
 
 
+bool Lv2Pedalboard::MatchVuBuffers(const std::vector<float *> &buffers, IEffect *effect, bool effectOutputs, VuLevelSource *source)
+{
+    int nChannels = effectOutputs ? effect->GetNumberOfOutputAudioBuffers() : effect->GetNumberOfInputAudioBuffers();
+    nChannels = std::min(nChannels, 2);
+    if (buffers.empty() || buffers.size() > 2)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        bool found = false;
+        for (int c = 0; c < nChannels; ++c)
+        {
+            float *buffer = effectOutputs ? effect->GetAudioOutputBuffer(c) : effect->GetAudioInputBuffer(c);
+            if (buffer != nullptr && buffer == buffers[i])
+            {
+                source->channel[i] = (uint8_t)c;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Lv2Pedalboard::SetVuInputSource(IEffect *effect)
+{
+    int32_t effectIndex = (int32_t)(this->realtimeEffects.size() - 1);
+    this->vuInputSources.resize(this->realtimeEffects.size());
+
+    // Only a buffer's producer writes to it. So if this effect reads the outputs of the effect measured by the
+    // preceding VU step in the same step list, they have not changed since that VU step measured them.
+    const ExecutionSteps &steps = *this->preparingSteps;
+    for (size_t i = steps.size() - 1; i-- > 0;)
+    {
+        if (steps[i].fn == &Lv2Pedalboard::VuStep)
+        {
+            int32_t sourceIndex = steps[i].controlIndex;
+            std::vector<float *> inputs;
+            for (int c = 0; c < std::min(effect->GetNumberOfInputAudioBuffers(), 2); ++c)
+            {
+                inputs.push_back(effect->GetAudioInputBuffer(c));
+            }
+            VuLevelSource source;
+            if (MatchVuBuffers(inputs, this->realtimeEffects[sourceIndex], true, &source))
+            {
+                source.effectIndex = sourceIndex;
+                this->vuInputSources[effectIndex] = source;
+            }
+            break;
+        }
+    }
+}
+
+Lv2Pedalboard::VuLevelSource Lv2Pedalboard::FindVuLevelSource(const std::vector<float *> &buffers, bool effectOutputs) const
+{
+    // Every step list runs in every period, and the pedalboard VUs are computed after all of them have completed.
+    VuLevelSource source;
+    for (size_t i = 0; i < this->realtimeEffects.size(); ++i)
+    {
+        if (MatchVuBuffers(buffers, this->realtimeEffects[i], effectOutputs, &source))
+        {
+            source.effectIndex = (int32_t)i;
+            return source;
+        }
+    }
+    return VuLevelSource();
+}
+
+bool Lv2Pedalboard::GetMeasuredVuLevels(const VuLevelSource &source, bool effectOutputs, size_t nChannels, VuLevel *levels) const
+{
+    if (source.effectIndex == -1 || this->effectVuUpdates[source.effectIndex] == nullptr) // not measured this period.
+    {
+        return false;
+    }
+    const EffectVuLevels &sourceLevels = this->effectVuLevels[source.effectIndex];
+    const VuLevel *measured = effectOutputs ? sourceLevels.output : sourceLevels.input;
+    for (size_t c = 0; c < nChannels; ++c)
+    {
+        levels[c] = measured[source.channel[c]];
+    }
+    return true;
+}
+
+// Measure up to two buffers, measuring a buffer that is used for both channels only once.
+static void MeasureVuLevels(VuLevel *levels, float *buffer0, float *buffer1, size_t nChannels, uint32_t samples)
+{
+    if (nChannels >= 1)
+    {
+        levels[0] = buffer0 ? MeasureVuLevel(buffer0, samples) : VuLevel();
+    }
+    if (nChannels >= 2)
+    {
+        levels[1] = buffer1 == buffer0 ? levels[0] : (buffer1 ? MeasureVuLevel(buffer1, samples) : VuLevel());
+    }
+}
+
 void Lv2Pedalboard::ComputeVus(RealtimeVuBuffers *realtimeVuBuffers, uint32_t samples)
 {
     if (realtimeVuBuffers == nullptr) 
@@ -592,56 +1878,98 @@ void Lv2Pedalboard::ComputeVus(RealtimeVuBuffers *realtimeVuBuffers, uint32_t sa
             continue;
         }
         VuUpdateX *pUpdate = &realtimeVuBuffers->vuUpdateWorkingData[i];
+        VuLevel levels[2];
         if (index == Pedalboard::START_CONTROL_ID)
         {
-            if (this->pedalboardInputBuffers.size() == 2)
+            size_t nChannels = this->pedalboardInputBuffers.size();
+            if (nChannels == 0 || nChannels > 2)
             {
-                // input is handled by master VU updates.
-                pUpdate->AccumulateOutputs(&(this->pedalboardInputBuffers[0][0]), &(this->pedalboardInputBuffers[1][0]), samples); // after outputVolume applied.
+                continue;
             }
-            else if (this->pedalboardInputBuffers.size() == 1)
+            // The pedalboard inputs are usually the inputs of the first effect, which may have measured them already.
+            if (!GetMeasuredVuLevels(this->vuStartSource, false, nChannels, levels))
             {
-                pUpdate->AccumulateOutputs(&(this->pedalboardInputBuffers[0][0]), samples); // before input volume applied.
-                // output is handled by master VU updates.
+                MeasureVuLevels(levels, this->pedalboardInputBuffers[0], this->pedalboardInputBuffers[nChannels - 1], nChannels, samples);
             }
-        }
-        else if (index == Pedalboard::END_CONTROL_ID)
-        {
-            if (this->pedalboardOutputBuffers.size() == 2)
+            if (nChannels == 2)
             {
-                pUpdate->AccumulateInputs(&(this->pedalboardOutputBuffers[0][0]), &(this->pedalboardOutputBuffers[1][0]), samples);
+                // input is handled by master VU updates.
+                pUpdate->AccumulateOutputs(levels[0], levels[1], samples); // after outputVolume applied.
             }
-            else if (this->pedalboardOutputBuffers.size() == 1)
+            else
             {
-                pUpdate->AccumulateInputs(&(this->pedalboardOutputBuffers[0][0]), samples);
+                pUpdate->AccumulateOutputs(levels[0], samples); // before input volume applied.
+                // output is handled by master VU updates.
             }
         }
-        else
+        else if (index == Pedalboard::END_CONTROL_ID)
         {
-            auto effect = this->realtimeEffects[index];
-
-            if (effect->GetNumberOfInputAudioBuffers() == 1)
+            size_t nChannels = this->pedalboardOutputBuffers.size();
+            if (nChannels == 0 || nChannels > 2)
             {
-                pUpdate->AccumulateInputs(effect->GetAudioInputBuffer(0), samples);
+                continue;
             }
-            else if (effect->GetNumberOfInputAudioBuffers() >= 2)
+            if (!GetMeasuredVuLevels(this->vuEndSource, true, nChannels, levels))
             {
-                pUpdate->AccumulateInputs(
-                    effect->GetAudioInputBuffer(0),
-                    effect->GetAudioInputBuffer(1), samples);
+                MeasureVuLevels(levels, this->pedalboardOutputBuffers[0], this->pedalboardOutputBuffers[nChannels - 1], nChannels, samples);
             }
-            if (effect->GetNumberOfOutputAudioBuffers() == 1)
+            if (nChannels == 2)
             {
-                pUpdate->AccumulateOutputs(effect->GetAudioOutputBuffer(0), samples);
+                pUpdate->AccumulateInputs(levels[0], levels[1], samples);
             }
-            else if (effect->GetNumberOfOutputAudioBuffers() >= 2)
+            else
             {
-                pUpdate->AccumulateOutputs(
-                    effect->GetAudioOutputBuffer(0),
-                    effect->GetAudioOutputBuffer(1),
-                    samples);
+                pUpdate->AccumulateInputs(levels[0], samples);
             }
         }
+        // effect VUs are accumulated by VU steps as the effects run.
+    }
+}
+
+void Lv2Pedalboard::VuStep(const ExecutionStep &step, uint32_t samples)
+{
+    Lv2Pedalboard *this_ = (Lv2Pedalboard *)step.target;
+    VuUpdateX *pUpdate = this_->effectVuUpdates[step.controlIndex];
+    if (pUpdate == nullptr)
+    {
+        return;
+    }
+    IEffect *effect = this_->realtimeEffects[step.controlIndex];
+    EffectVuLevels &levels = this_->effectVuLevels[step.controlIndex];
+
+    size_t nInputs = (size_t)std::min(effect->GetNumberOfInputAudioBuffers(), 2);
+    size_t nOutputs = (size_t)std::min(effect->GetNumberOfOutputAudioBuffers(), 2);
+
+    // The inputs are usually the outputs of the preceding effect, which have been measured already.
+    if (!this_->GetMeasuredVuLevels(this_->vuInputSources[step.controlIndex], true, nInputs, levels.input))
+    {
+        MeasureVuLevels(
+            levels.input,
+            nInputs >= 1 ? effect->GetAudioInputBuffer(0) : nullptr,
+            nInputs >= 2 ? effect->GetAudioInputBuffer(1) : nullptr,
+            nInputs, samples);
+    }
+    MeasureVuLevels(
+        levels.output,
+        nOutputs >= 1 ? effect->GetAudioOutputBuffer(0) : nullptr,
+        nOutputs >= 2 ? effect->GetAudioOutputBuffer(1) : nullptr,
+        nOutputs, samples);
+
+    if (nInputs == 1)
+    {
+        pUpdate->AccumulateInputs(levels.input[0], samples);
+    }
+    else if (nInputs == 2)
+    {
+        pUpdate->AccumulateInputs(levels.input[0], levels.input[1], samples);
+    }
+    if (nOutputs == 1)
+    {
+        pUpdate->AccumulateOutputs(levels.output[0], samples);
+    }
+    else if (nOutputs == 2)
+    {
+        pUpdate->AccumulateOutputs(levels.output[0], levels.output[1], samples);
     }
 }
 
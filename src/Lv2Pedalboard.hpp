@@ -23,10 +23,15 @@
 #include "PluginHost.hpp"
 #include "Lv2Effect.hpp"
 #include "BufferPool.hpp"
+#include "ExecutionPlan.hpp"
+#include "EffectCpuUse.hpp"
 #include <functional>
 #include <lv2/urid/urid.h>
 #include <functional>
 #include "DbDezipper.hpp"
+#include "VuMeterKernels.hpp"
+#include "ControlValueTable.hpp"
+#include "RealtimeWorkerPool.hpp"
 
 namespace pipedal
 {
@@ -36,6 +41,7 @@ namespace pipedal
     class RealtimeVuBuffers;
     class RealtimePatchPropertyRequest;
     class RealtimeRingBufferWriter;
+    class VuUpdateX;
 
     using ExistingEffectMap = std::map<uint64_t, std::shared_ptr<IEffect>>;
 
@@ -49,6 +55,28 @@ namespace pipedal
     {
     };
 
+    // Audio buffers required by a pedalboard, before and after buffers with disjoint lifetimes were merged.
+    struct AudioBufferAllocation
+    {
+        size_t requested = 0;
+        size_t allocated = 0;
+        size_t arenaBytes = 0;
+    };
+
+    // Per-period execution times of a split whose chains run in parallel.
+    struct SplitBranchTiming
+    {
+        int64_t instanceId = -1;
+        uint64_t periods = 0;
+        double topAverageUs = 0;
+        double topMaxUs = 0;
+        double bottomAverageUs = 0;
+        double bottomMaxUs = 0;
+        // time the calling thread spent waiting for the bottom chain to complete.
+        double waitAverageUs = 0;
+        double waitMaxUs = 0;
+    };
+
     class Lv2Pedalboard
     {
     private:
@@ -58,6 +86,13 @@ namespace pipedal
         DbDezipper outputVolume;
 
         BufferPool bufferPool;
+        // Buffers passed between effects. These are placeholders until AllocateBufferArena() moves them
+        // into a shared arena in bufferPool.
+        BufferPool chainBufferPool;
+        std::vector<float *> chainBuffers;
+        AudioBufferAllocation audioBufferAllocation;
+        void AllocateBufferArena();
+
         std::vector<float *> pedalboardInputBuffers;
         std::vector<float *> pedalboardOutputBuffers;
         float *pedalboardSidechainBuffer = nullptr;
@@ -65,19 +100,95 @@ namespace pipedal
         std::vector<std::shared_ptr<IEffect>> effects;
         std::vector<IEffect *> realtimeEffects;
 
+        ControlValueTable controlValueTable;
+
         using Action = std::function<void()>;
-        using ProcessAction = std::function<void(uint32_t frames)>;
 
         std::vector<Action> activateActions;
 
-        std::vector<ProcessAction> processActions;
+        // The compiled execution plan, and the dependency graph it was compiled from.
+        ExecutionSteps executionPlan;
+        ExecutionGraph executionGraph;
 
         std::vector<Action> deactivateActions;
 
         float *CreateNewAudioBuffer();
+        // buffers whose contents must survive from one period to the next.
+        std::vector<float *> AllocatePersistentAudioBuffers(size_t nChannels);
+
+        // Effect VUs are accumulated as each effect runs, since effect buffers are reused later in the period.
+        std::vector<VuUpdateX *> effectVuUpdates;
+        static void VuStep(const ExecutionStep &step, uint32_t frames);
+
+        // Levels measured by each effect's VU step during the current period. Each buffer is measured at most
+        // once per period: where a buffer has already been measured as another effect's output (or input),
+        // the VU step reuses that measurement.
+        struct EffectVuLevels
+        {
+            VuLevel input[2];
+            VuLevel output[2];
+        };
+        struct VuLevelSource
+        {
+            int32_t effectIndex = -1;
+            uint8_t channel[2] = {0, 0};
+        };
+        std::vector<EffectVuLevels> effectVuLevels;
+        std::vector<VuLevelSource> vuInputSources;   // for each effect, the preceding effect whose outputs are its inputs.
+        VuLevelSource vuStartSource;                  // the effect whose inputs are the pedalboard inputs.
+        VuLevelSource vuEndSource;                    // the effect whose outputs are the pedalboard outputs.
+        void SetVuInputSource(IEffect *effect);
+        VuLevelSource FindVuLevelSource(const std::vector<float *> &buffers, bool effectOutputs) const;
+        static bool MatchVuBuffers(const std::vector<float *> &buffers, IEffect *effect, bool effectOutputs, VuLevelSource *source);
+        bool GetMeasuredVuLevels(const VuLevelSource &source, bool effectOutputs, size_t nChannels, VuLevel *levels) const;
 
         RealtimeRingBufferWriter *ringBufferWriter;
 
+        // Splits. If the worker pool is available, and the chains are independent, the
+        // top and bottom chains of a split run concurrently on realtime worker threads.
+        class SplitSection;
+        RealtimeWorkerPool *realtimeWorkerPool = nullptr;
+        std::unique_ptr<RealtimeWorkerPool::WorkerSet> realtimeWorkers; // reserved by BindRealtimeWorkers().
+        std::vector<std::unique_ptr<SplitSection>> splitSections;
+        size_t parallelSplitCount = 0;
+        bool parallelSplitChains = false;
+        size_t nextWorkerIndex = 0;
+
+        // Pipelined execution. The top-level chain is divided into stages, each of which runs on its
+        // own thread, one period behind the stage before it. Stage 0 runs on the calling thread, and
+        // its steps are in executionPlan.
+        class PipelineStage;
+        class PipelineBoundary;
+        std::vector<std::unique_ptr<PipelineStage>> pipelineStages;
+        std::vector<std::unique_ptr<PipelineBoundary>> pipelineBoundaries;
+        uint32_t pipelineParity = 0;
+
+        // Per-node execution times. Used to choose pipeline stage boundaries, and reported to clients.
+        bool measureEffectCosts = false;
+        std::atomic<uint64_t> measuredPeriods{0};
+        uint64_t measuredFrames = 0;
+        bool silent = false;
+        std::unique_ptr<StepCost[]> nodeCosts;
+        std::vector<const StepCost *> effectNodeCosts; // effect nodes only, in node order.
+        EffectCpuUseCollector effectCpuUseCollector;
+        void AssignCostCounters(ExecutionSteps &steps);
+        void ReportEffectCosts();
+
+        std::vector<float *> PreparePipeline(
+            std::vector<PedalboardItem> &items,
+            size_t nStages,
+            Lv2PedalboardErrorList &errorList,
+            ExistingEffectMap *existingEffects);
+        std::vector<size_t> PlanPipelineStages(const std::vector<PedalboardItem> &items, size_t nStages);
+        double EstimateCost(const PedalboardItem &item, double defaultCost);
+
+        // Where PrepareItems puts the steps it generates, and the ring buffer writer that those steps use.
+        ExecutionSteps *preparingSteps = &executionPlan;
+        RealtimeRingBufferWriter **preparingWriter = &ringBufferWriter;
+
+        void AddStep(ExecutionStep::Function fn, const char *name, void *target, int32_t node);
+        void CompileSplitSection(SplitSection *section);
+
         enum class MidiControlType
         {
             None,
@@ -112,6 +223,12 @@ namespace pipedal
             std::vector<float *> inputBuffers,
             Lv2PedalboardErrorList &errorList,
             ExistingEffectMap *existingEffects);
+        std::vector<float *> PrepareItems(
+            std::vector<PedalboardItem> &items,
+            size_t begin, size_t end,
+            std::vector<float *> inputBuffers,
+            Lv2PedalboardErrorList &errorList,
+            ExistingEffectMap *existingEffects);
 
         void PrepareMidiMap(const Pedalboard &pedalboard);
         void PrepareMidiMap(const PedalboardItem &pedalboardItem);
@@ -121,8 +238,8 @@ namespace pipedal
         void AppendParameterRequest(uint8_t *atomBuffer, LV2_URID uridParameter);
 
     public:
-        Lv2Pedalboard() {}
-        ~Lv2Pedalboard() {}
+        Lv2Pedalboard();
+        ~Lv2Pedalboard();
 
         void Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects = nullptr);
 
@@ -152,11 +269,17 @@ namespace pipedal
             }
             return nullptr;
         }
+        // True if any effect instance also belongs to other (see PluginHost::UpdateLv2PedalboardStructure).
+        bool SharesEffectsWith(const Lv2Pedalboard &other) const;
+
+        // Reserve realtime workers for parallel splits and pipeline stages. Must be called before the
+        // pedalboard runs. Preloaded pedalboards don't hold workers until they become the current pedalboard.
+        void BindRealtimeWorkers();
         void Activate();
         void Deactivate();
         void UpdateAudioPorts();
 
-        bool Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *realtimeWriter);
+        bool Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *realtimeWriter, RealtimeVuBuffers *realtimeVuBuffers = nullptr);
 
         void ResetAtomBuffers();
 
@@ -169,12 +292,47 @@ namespace pipedal
 
         int GetControlIndex(uint64_t instanceId, const std::string &symbol);
         void SetControlValue(int effectIndex, int portIndex, float value);
+        // Control values written by host threads, applied by ApplyControlValues() on the audio thread.
+        ControlValueTable &GetControlValueTable() { return controlValueTable; }
+        void ApplyControlValues();
         void SetInputVolume(float value) { this->inputVolume.SetTarget(value); }
         void SetOutputVolume(float value) { this->outputVolume.SetTarget(value); }
         void SetBypass(int effectIndex, bool enabled);
 
         void ComputeVus(RealtimeVuBuffers *vuConfiguration, uint32_t samples);
 
+        std::vector<SplitBranchTiming> GetSplitBranchTimings() const;
+
+        const AudioBufferAllocation &GetAudioBufferAllocation() const { return audioBufferAllocation; }
+
+        // A description of the dependency graph and execution plan, for debugging.
+        std::string GetExecutionPlanDump() const;
+
+        // Additional latency introduced by pipelined execution, in periods.
+        size_t GetPipelineLatencyPeriods() const;
+
+        // Realtime. True if no plugin was run during the last period, because of silence or hard bypass.
+        bool IsSilent() const { return silent; }
+
+        // Measure the execution time of each effect. Prepare() enables measurement; call before Activate() otherwise.
+        void EnableEffectCostMeasurement();
+
+        // Realtime. Per-effect execution times since the last call, or nullptr if they are not being measured.
+        // The result is owned by the pedalboard, and is overwritten by the next call.
+        const EffectCpuUpdate *CollectEffectCpuUse();
+
+        struct EffectCostCounter
+        {
+            int64_t instanceId;
+            std::string uri;
+            const std::atomic<uint64_t> *pTotalNs; // total execution time since the pedalboard was prepared.
+        };
+        std::vector<EffectCostCounter> GetEffectCostCounters() const;
+
+        // Realtime. Execution time of each effect during the last period, in the same order as
+        // GetEffectCostCounters(). Returns the number of effects written.
+        size_t GetEffectPeriodCosts(uint32_t *ns, size_t maxEffects) const;
+
         float GetControlOutputValue(int effectIndex, int portIndex);
 
         typedef void(MidiCallbackFn)(void *data, uint64_t intanceId, int controlIndex, float value);
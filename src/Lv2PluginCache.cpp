@@ -0,0 +1,598 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "Lv2PluginCache.hpp"
+#include "PluginHost.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static constexpr char CACHE_MAGIC[8] = {'P', 'P', 'L', 'V', '2', 'C', 'A', 'C'};
+
+// Bump this when the archive layout changes.
+static constexpr uint32_t CACHE_FORMAT_VERSION = 2;
+
+namespace
+{
+    class Fnv1aHash
+    {
+    public:
+        void Add(const void *data, size_t size)
+        {
+            const uint8_t *p = (const uint8_t *)data;
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ p[i]) * 0x100000001B3ull;
+            }
+        }
+        void Add(const std::string &value)
+        {
+            Add(value.data(), value.size() + 1); // include the terminating null, so that "ab"+"c" != "a"+"bc".
+        }
+        template <typename T>
+            requires std::is_arithmetic_v<T>
+        void Add(T value)
+        {
+            Add(&value, sizeof(value));
+        }
+        uint64_t Get() const { return hash; }
+
+    private:
+        uint64_t hash = 0xCBF29CE484222325ull;
+    };
+}
+
+static void AddFileStamp(Fnv1aHash &hash, const fs::path &path)
+{
+    std::error_code ec;
+    auto lastWriteTime = fs::last_write_time(path, ec);
+    hash.Add((int64_t)(ec ? 0 : lastWriteTime.time_since_epoch().count()));
+    uintmax_t size = 0;
+    if (fs::is_regular_file(path, ec))
+    {
+        size = fs::file_size(path, ec);
+        if (ec)
+        {
+            size = 0;
+        }
+    }
+    hash.Add((uint64_t)size);
+}
+
+// Plugin infos are built by code in this executable, so a cache written by any other build of pipedald is discarded.
+static uint64_t GetExecutableStamp()
+{
+    Fnv1aHash hash;
+    std::error_code ec;
+    fs::path exePath = fs::read_symlink("/proc/self/exe", ec);
+    if (!ec)
+    {
+        hash.Add(exePath.string());
+        AddFileStamp(hash, exePath);
+    }
+    return hash.Get();
+}
+
+std::string Lv2PluginCache::NormalizeBundlePath(const std::string &bundlePath)
+{
+    std::string result = fs::path(bundlePath).lexically_normal().string();
+    while (result.length() > 1 && result.back() == '/')
+    {
+        result.pop_back();
+    }
+    return result;
+}
+
+uint64_t Lv2PluginCache::GetBundleStamp(const fs::path &bundlePath)
+{
+    // Only the top level of the bundle is examined. That covers the manifest and the .ttl files that lilv reads, and
+    // the plugin binaries; resource subdirectories aren't part of the plugin catalogue.
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (auto iter = fs::directory_iterator(bundlePath, ec); !ec && iter != fs::directory_iterator(); iter.increment(ec))
+    {
+        names.push_back(iter->path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+
+    Fnv1aHash hash;
+    AddFileStamp(hash, bundlePath);
+    for (const auto &name : names)
+    {
+        hash.Add(name);
+        AddFileStamp(hash, bundlePath / name);
+    }
+    return hash.Get();
+}
+
+Lv2BundleStamps Lv2PluginCache::GetBundleStamps(const std::string &lv2Path)
+{
+    Lv2BundleStamps result;
+    size_t start = 0;
+    while (start <= lv2Path.length())
+    {
+        size_t end = lv2Path.find(':', start);
+        if (end == std::string::npos)
+        {
+            end = lv2Path.length();
+        }
+        fs::path directory = lv2Path.substr(start, end - start);
+        start = end + 1;
+
+        std::error_code ec;
+        if (directory.empty() || !fs::is_directory(directory, ec))
+        {
+            continue;
+        }
+        for (auto iter = fs::directory_iterator(directory, ec); !ec && iter != fs::directory_iterator(); iter.increment(ec))
+        {
+            std::error_code ecEntry;
+            if (iter->is_directory(ecEntry))
+            {
+                result[NormalizeBundlePath(iter->path().string())] = GetBundleStamp(iter->path());
+            }
+        }
+    }
+    return result;
+}
+
+class Lv2PluginCache::Archive
+{
+public:
+    // An archive that writes.
+    Archive()
+        : reading(false)
+    {
+    }
+    // An archive that reads from data.
+    Archive(const std::vector<uint8_t> &data)
+        : reading(true), readPosition(data.data()), readEnd(data.data() + data.size())
+    {
+    }
+
+    const std::vector<uint8_t> &GetData() const { return data; }
+    bool AtEnd() const { return readPosition == readEnd; }
+
+    void Transfer(bool &value)
+    {
+        uint8_t t = value ? 1 : 0;
+        Transfer(t);
+        value = t != 0;
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    void Transfer(T &value)
+    {
+        if (reading)
+        {
+            CheckAvailable(sizeof(T));
+            memcpy(&value, readPosition, sizeof(T));
+            readPosition += sizeof(T);
+        }
+        else
+        {
+            const uint8_t *p = (const uint8_t *)&value;
+            data.insert(data.end(), p, p + sizeof(T));
+        }
+    }
+    void Transfer(std::string &value)
+    {
+        uint32_t size = (uint32_t)value.size();
+        Transfer(size);
+        if (reading)
+        {
+            CheckAvailable(size);
+            value.assign((const char *)readPosition, size);
+            readPosition += size;
+        }
+        else
+        {
+            data.insert(data.end(), value.begin(), value.end());
+        }
+    }
+    template <typename T>
+    void Transfer(std::vector<T> &values)
+    {
+        uint32_t size = (uint32_t)values.size();
+        Transfer(size);
+        if (reading)
+        {
+            CheckAvailable(size); // every element occupies at least one byte; guards against allocating garbage sizes.
+            values.clear();
+            values.resize(size);
+        }
+        for (auto &value : values)
+        {
+            Transfer(value);
+        }
+    }
+    template <typename K, typename V>
+    void Transfer(std::map<K, V> &values)
+    {
+        uint32_t size = (uint32_t)values.size();
+        Transfer(size);
+        if (reading)
+        {
+            values.clear();
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                K key;
+                V value;
+                Transfer(key);
+                Transfer(value);
+                values[std::move(key)] = std::move(value);
+            }
+        }
+        else
+        {
+            for (auto &value : values)
+            {
+                K key = value.first;
+                Transfer(key);
+                Transfer(value.second);
+            }
+        }
+    }
+    template <typename T>
+    void Transfer(std::shared_ptr<T> &value)
+    {
+        bool present = (bool)value;
+        Transfer(present);
+        if (reading)
+        {
+            value = present ? std::make_shared<T>() : nullptr;
+        }
+        if (present)
+        {
+            Transfer(*value);
+        }
+    }
+
+    void Transfer(PluginClass &value)
+    {
+        Transfer(value.uri);
+        Transfer(value.displayName);
+        Transfer(value.parentUri);
+    }
+    void Transfer(Lv2PluginClasses &value)
+    {
+        std::vector<std::string> classes = value.classes();
+        Transfer(classes);
+        if (reading)
+        {
+            value = Lv2PluginClasses(std::move(classes));
+        }
+    }
+    void Transfer(Lv2ScalePoint &value)
+    {
+        Transfer(value.value_);
+        Transfer(value.label_);
+    }
+    void Transfer(Lv2PortGroup &value)
+    {
+        Transfer(value.isA());
+        Transfer(value.uri());
+        Transfer(value.symbol());
+        Transfer(value.name());
+        Transfer(value.sideChainOf());
+    }
+    void Transfer(Lv2PatchPropertyInfo &value)
+    {
+        Transfer(value.uri_);
+        Transfer(value.writable_);
+        Transfer(value.readable_);
+        Transfer(value.label_);
+        Transfer(value.index_);
+        Transfer(value.type_);
+        Transfer(value.comment_);
+        Transfer(value.shortName_);
+        Transfer(value.fileTypes_);
+        Transfer(value.supportedExtensions_);
+    }
+    void Transfer(UiFileType &value)
+    {
+        Transfer(value.label_);
+        Transfer(value.mimeType_);
+        Transfer(value.fileExtension_);
+    }
+    void Transfer(UiFileProperty &value)
+    {
+        Transfer(value.label_);
+        Transfer(value.index_);
+        Transfer(value.directory_);
+        Transfer(value.fileTypes_);
+        Transfer(value.patchProperty_);
+        Transfer(value.portGroup_);
+        Transfer(value.resourceDirectory_);
+        Transfer(value.modDirectories_);
+        Transfer(value.useLegacyModDirectory_);
+        if (reading)
+        {
+            value.PrecalculateFileExtensions();
+        }
+    }
+    void Transfer(UiFrequencyPlot &value)
+    {
+        Transfer(value.patchProperty_);
+        Transfer(value.index_);
+        Transfer(value.portGroup_);
+        Transfer(value.xLeft_);
+        Transfer(value.xRight_);
+        Transfer(value.yTop_);
+        Transfer(value.yBottom_);
+        Transfer(value.xLog_);
+        Transfer(value.yDb_);
+        Transfer(value.width_);
+    }
+    void Transfer(UiPortNotification &value)
+    {
+        Transfer(value.portIndex_);
+        Transfer(value.symbol_);
+        Transfer(value.plugin_);
+        Transfer(value.protocol_);
+    }
+    // PiPedalUI has no default constructor.
+    void Transfer(PiPedalUI::ptr &value)
+    {
+        bool present = (bool)value;
+        Transfer(present);
+        if (!present)
+        {
+            if (reading)
+            {
+                value = nullptr;
+            }
+            return;
+        }
+        std::vector<UiFileProperty::ptr> fileProperties;
+        std::vector<UiFrequencyPlot::ptr> frequencyPlots;
+        if (!reading)
+        {
+            fileProperties = value->fileProperties_;
+            frequencyPlots = value->frequencyPlots_;
+        }
+        Transfer(fileProperties);
+        Transfer(frequencyPlots);
+        if (reading)
+        {
+            value = std::make_shared<PiPedalUI>(std::move(fileProperties), std::move(frequencyPlots));
+        }
+        Transfer(value->unsupportedPatchProperty_);
+        Transfer(value->portNotifications_);
+    }
+    void Transfer(ModGuiPort &value)
+    {
+        Transfer(value.index_);
+        Transfer(value.symbol_);
+        Transfer(value.name_);
+    }
+    void Transfer(ModGui &value)
+    {
+        Transfer(value.pluginUri_);
+        Transfer(value.resourceDirectory_);
+        Transfer(value.iconTemplate_);
+        Transfer(value.settingsTemplate_);
+        Transfer(value.javascript_);
+        Transfer(value.stylesheet_);
+        Transfer(value.screenshot_);
+        Transfer(value.thumbnail_);
+        Transfer(value.discussionUrl_);
+        Transfer(value.documentationUrl_);
+        Transfer(value.brand_);
+        Transfer(value.label_);
+        Transfer(value.model_);
+        Transfer(value.panel_);
+        Transfer(value.color_);
+        Transfer(value.knob_);
+        Transfer(value.ports_);
+        Transfer(value.monitoredOutputs_);
+    }
+    void Transfer(Lv2PortInfo &value)
+    {
+        Transfer(value.index_);
+        Transfer(value.symbol_);
+        Transfer(value.name_);
+        Transfer(value.min_value_);
+        Transfer(value.max_value_);
+        Transfer(value.default_value_);
+        Transfer(value.classes_);
+        Transfer(value.scale_points_);
+        Transfer(value.is_input_);
+        Transfer(value.is_output_);
+        Transfer(value.is_control_port_);
+        Transfer(value.is_audio_port_);
+        Transfer(value.is_sidechain_);
+        Transfer(value.is_atom_port_);
+        Transfer(value.is_cv_port_);
+        Transfer(value.connection_optional_);
+        Transfer(value.is_valid_);
+        Transfer(value.supports_midi_);
+        Transfer(value.supports_time_position_);
+        Transfer(value.is_logarithmic_);
+        Transfer(value.display_priority_);
+        Transfer(value.range_steps_);
+        Transfer(value.trigger_property_);
+        Transfer(value.integer_property_);
+        Transfer(value.enumeration_property_);
+        Transfer(value.toggled_property_);
+        Transfer(value.mod_momentaryOffByDefault_);
+        Transfer(value.mod_momentaryOnByDefault_);
+        Transfer(value.is_expensive_);
+        Transfer(value.pipedal_graphicEq_);
+        Transfer(value.not_on_gui_);
+        Transfer(value.buffer_type_);
+        Transfer(value.port_group_);
+        Transfer(value.designation_);
+        Transfer(value.is_bypass_);
+        Transfer(value.units_);
+        Transfer(value.custom_units_);
+        Transfer(value.comment_);
+        Transfer(value.piPedalUI_);
+        Transfer(value.pipedal_ledColor_);
+    }
+    void Transfer(Lv2PluginInfo &value)
+    {
+        Transfer(value.bundle_path_);
+        Transfer(value.uri_);
+        Transfer(value.minorVersion_);
+        Transfer(value.microVersion_);
+        Transfer(value.name_);
+        Transfer(value.plugin_class_);
+        Transfer(value.brand_);
+        Transfer(value.label_);
+        Transfer(value.supported_features_);
+        Transfer(value.required_features_);
+        Transfer(value.optional_features_);
+        Transfer(value.extensions_);
+        Transfer(value.has_factory_presets_);
+        Transfer(value.author_name_);
+        Transfer(value.author_homepage_);
+        Transfer(value.comment_);
+        Transfer(value.ports_);
+        Transfer(value.port_groups_);
+        Transfer(value.patchProperties_);
+        Transfer(value.audio_sidechain_title_);
+        Transfer(value.hasDefaultState_);
+        Transfer(value.is_valid_);
+        Transfer(value.piPedalUI_);
+        Transfer(value.modGui_);
+        Transfer(value.hasUnsupportedPatchProperties_);
+        Transfer(value.powerOf2BlockLength_);
+        Transfer(value.minBlockLength_);
+        Transfer(value.maxBlockLength_);
+    }
+
+private:
+    void CheckAvailable(size_t size)
+    {
+        if ((size_t)(readEnd - readPosition) < size)
+        {
+            throw std::runtime_error("Unexpected end of file.");
+        }
+    }
+    bool reading;
+    std::vector<uint8_t> data;
+    const uint8_t *readPosition = nullptr;
+    const uint8_t *readEnd = nullptr;
+};
+
+bool Lv2PluginCache::Load(const fs::path &path)
+{
+    std::vector<uint8_t> data;
+    {
+        std::ifstream f(path, std::ios_base::binary);
+        if (!f.is_open())
+        {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        if (f.bad())
+        {
+            return false;
+        }
+    }
+    if (data.size() < sizeof(CACHE_MAGIC) || memcmp(data.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0)
+    {
+        return false;
+    }
+    try
+    {
+        std::vector<uint8_t> body(data.begin() + sizeof(CACHE_MAGIC), data.end());
+        data.clear();
+
+        Archive archive(body);
+        uint32_t formatVersion = 0;
+        archive.Transfer(formatVersion);
+        if (formatVersion != CACHE_FORMAT_VERSION)
+        {
+            return false;
+        }
+        uint64_t executableStamp = 0;
+        archive.Transfer(executableStamp);
+        if (executableStamp != GetExecutableStamp())
+        {
+            return false;
+        }
+        archive.Transfer(this->lv2Path);
+        archive.Transfer(this->bundleStamps);
+        archive.Transfer(this->pluginClasses);
+        archive.Transfer(this->plugins);
+        archive.Transfer(this->presetBundles);
+        if (!archive.AtEnd())
+        {
+            throw std::runtime_error("Unexpected data at end of file.");
+        }
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Discarding damaged LV2 plugin cache " << path << ". " << e.what()));
+        this->lv2Path.clear();
+        this->bundleStamps.clear();
+        this->pluginClasses.clear();
+        this->plugins.clear();
+        this->presetBundles.clear();
+        return false;
+    }
+}
+
+void Lv2PluginCache::Save(const fs::path &path) const
+{
+    Archive archive;
+    uint32_t formatVersion = CACHE_FORMAT_VERSION;
+    archive.Transfer(formatVersion);
+    uint64_t executableStamp = GetExecutableStamp();
+    archive.Transfer(executableStamp);
+    // Archive::Transfer is bidirectional, so it takes non-const references. Nothing is modified when writing.
+    Lv2PluginCache &self = const_cast<Lv2PluginCache &>(*this);
+    archive.Transfer(self.lv2Path);
+    archive.Transfer(self.bundleStamps);
+    archive.Transfer(self.pluginClasses);
+    archive.Transfer(self.plugins);
+    archive.Transfer(self.presetBundles);
+
+    fs::path tempPath = path;
+    tempPath += ".$$$";
+    {
+        std::ofstream f(tempPath, std::ios_base::binary | std::ios_base::trunc);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't write to " << tempPath << "."));
+        }
+        f.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        f.write((const char *)archive.GetData().data(), archive.GetData().size());
+        f.close();
+        if (f.fail())
+        {
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            throw std::runtime_error(SS("Can't write to " << tempPath << "."));
+        }
+    }
+    fs::rename(tempPath, path);
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    class Lv2PluginInfo;
+
+    // Stamps of LV2 bundle directories, indexed by normalized bundle path.
+    using Lv2BundleStamps = std::map<std::string, uint64_t>;
+
+    /**
+     * @brief On-disk cache of the LV2 plugin catalogue.
+     *
+     * Holds fully-built Lv2PluginInfo objects, so that a warm start doesn't have to load the lilv world,
+     * or query RDF data. Entries are validated against a stamp of each bundle directory on the LV2_PATH;
+     * plugins from bundles whose stamps have changed have to be rescanned.
+     *
+     * The file format is a private binary format that is only ever read by the build that wrote it.
+     * Load() rejects files written by other builds, or by other versions of the format.
+     */
+    class Lv2PluginCache
+    {
+    public:
+        struct PluginClass
+        {
+            std::string uri;
+            std::string displayName;
+            std::string parentUri;
+        };
+
+        // Plugins in lilv enumeration order, including plugins that PluginHost rejects.
+        std::vector<std::shared_ptr<Lv2PluginInfo>> plugins;
+        std::vector<PluginClass> pluginClasses;
+        std::string lv2Path;
+        Lv2BundleStamps bundleStamps;
+        // Bundles other than the plugin's own that declare presets for a plugin, indexed by plugin uri.
+        // Plugins with factory presets that have no entry have presets in bundles that couldn't be identified.
+        std::map<std::string, std::vector<std::string>> presetBundles;
+
+        // false if the file doesn't exist, is damaged, or was written by a different build.
+        bool Load(const std::filesystem::path &path);
+        // Throws on error. Replaces the file atomically.
+        void Save(const std::filesystem::path &path) const;
+
+        // Stamps of all the bundles in a ':'-separated LV2_PATH.
+        static Lv2BundleStamps GetBundleStamps(const std::string &lv2Path);
+        // A hash of the names, sizes, and modification times of the files in the bundle directory.
+        static uint64_t GetBundleStamp(const std::filesystem::path &bundlePath);
+        static std::string NormalizeBundlePath(const std::string &bundlePath);
+
+    private:
+        class Archive;
+    };
+}
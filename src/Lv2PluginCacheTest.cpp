@@ -0,0 +1,195 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Lv2PluginCache.hpp"
+#include "PluginHost.hpp"
+#include <fstream>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static void WriteFile(const fs::path &path, const std::string &text)
+{
+    std::ofstream f(path, std::ios_base::app);
+    f << text;
+}
+
+TEST_CASE("LV2 plugin cache bundle stamps", "[lv2_plugin_cache][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "Lv2PluginCacheTest" / "stamps";
+    fs::remove_all(root);
+    fs::create_directories(root / "lib1" / "a.lv2");
+    fs::create_directories(root / "lib1" / "b.lv2");
+    fs::create_directories(root / "lib2" / "c.lv2");
+    WriteFile(root / "lib1" / "a.lv2" / "manifest.ttl", "a");
+    WriteFile(root / "lib1" / "b.lv2" / "manifest.ttl", "b");
+    WriteFile(root / "lib2" / "c.lv2" / "manifest.ttl", "c");
+
+    std::string lv2Path = (root / "lib1").string() + ":" + (root / "lib2").string() + "/:" + (root / "missing").string();
+
+    Lv2BundleStamps stamps = Lv2PluginCache::GetBundleStamps(lv2Path);
+    REQUIRE(stamps.size() == 3);
+    std::string a = Lv2PluginCache::NormalizeBundlePath((root / "lib1" / "a.lv2").string() + "/");
+    std::string b = Lv2PluginCache::NormalizeBundlePath((root / "lib1" / "b.lv2").string());
+    std::string c = Lv2PluginCache::NormalizeBundlePath((root / "lib2" / "c.lv2").string());
+    REQUIRE(stamps.contains(a));
+    REQUIRE(stamps.contains(b));
+    REQUIRE(stamps.contains(c));
+    REQUIRE(Lv2PluginCache::GetBundleStamps(lv2Path) == stamps);
+
+    // modified files, and added bundles.
+    WriteFile(root / "lib1" / "b.lv2" / "manifest.ttl", "more");
+    fs::create_directories(root / "lib2" / "d.lv2");
+    Lv2BundleStamps newStamps = Lv2PluginCache::GetBundleStamps(lv2Path);
+    REQUIRE(newStamps.size() == 4);
+    REQUIRE(newStamps[a] == stamps[a]);
+    REQUIRE(newStamps[b] != stamps[b]);
+    REQUIRE(newStamps[c] == stamps[c]);
+
+    // added files.
+    WriteFile(root / "lib2" / "c.lv2" / "c.ttl", "c");
+    REQUIRE(Lv2PluginCache::GetBundleStamp(root / "lib2" / "c.lv2") != stamps[c]);
+
+    fs::remove_all(root);
+}
+
+static std::shared_ptr<Lv2PluginInfo> MakeTestPluginInfo()
+{
+    auto result = std::make_shared<Lv2PluginInfo>();
+    result->bundle_path("/usr/lib/lv2/test.lv2/");
+    result->uri("http://example.com/plugins/test");
+    result->name("Test Plugin");
+    result->minorVersion(3);
+    result->plugin_class("http://lv2plug.in/ns/lv2core#DelayPlugin");
+    result->required_features({"http://lv2plug.in/ns/ext/urid#map"});
+    result->is_valid(true);
+    result->minBlockLength(16);
+
+    auto port = std::make_shared<Lv2PortInfo>();
+    port->index(2);
+    port->symbol("gain");
+    port->name("Gain");
+    port->min_value(-60);
+    port->max_value(12);
+    port->default_value(0);
+    port->is_input(true);
+    port->is_control_port(true);
+    port->units(Units::db);
+    port->scale_points().push_back(Lv2ScalePoint(0, "Unity"));
+    result->ports().push_back(port);
+
+    auto portGroup = std::make_shared<Lv2PortGroup>();
+    portGroup->uri("http://example.com/plugins/test#group");
+    portGroup->name("Group");
+    result->port_groups().push_back(portGroup);
+
+    std::vector<UiFileProperty::ptr> fileProperties;
+    auto fileProperty = std::make_shared<UiFileProperty>("Model", "http://example.com/plugins/test#model", "models");
+    fileProperty->fileTypes().push_back(UiFileType("Model file", ".nam"));
+    fileProperties.push_back(fileProperty);
+    result->piPedalUI(std::make_shared<PiPedalUI>(std::move(fileProperties)));
+
+    auto modGui = std::make_shared<ModGui>();
+    modGui->brand("Example");
+    modGui->ports().push_back(ModGuiPort());
+    modGui->ports()[0].symbol("gain");
+    result->modGui(modGui);
+    return result;
+}
+
+TEST_CASE("LV2 plugin cache round trip", "[lv2_plugin_cache][Build]")
+{
+    fs::path root = fs::temp_directory_path() / "Lv2PluginCacheTest" / "roundTrip";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    fs::path cachePath = root / "lv2cache.bin";
+
+    Lv2PluginCache cache;
+    cache.lv2Path = "/usr/lib/lv2";
+    cache.bundleStamps["/usr/lib/lv2/test.lv2"] = 1234;
+    cache.pluginClasses.push_back(Lv2PluginCache::PluginClass{"http://lv2plug.in/ns/lv2core#DelayPlugin", "Delay", "http://lv2plug.in/ns/lv2core#Plugin"});
+    cache.plugins.push_back(MakeTestPluginInfo());
+    cache.plugins.push_back(std::make_shared<Lv2PluginInfo>());
+    cache.presetBundles["http://example.com/plugins/test"] = {"/usr/lib/lv2/test-presets.lv2"};
+    cache.Save(cachePath);
+
+    Lv2PluginCache loaded;
+    REQUIRE(loaded.Load(cachePath));
+    REQUIRE(loaded.lv2Path == cache.lv2Path);
+    REQUIRE(loaded.bundleStamps == cache.bundleStamps);
+    REQUIRE(loaded.pluginClasses.size() == 1);
+    REQUIRE(loaded.pluginClasses[0].displayName == "Delay");
+    REQUIRE(loaded.pluginClasses[0].parentUri == "http://lv2plug.in/ns/lv2core#Plugin");
+    REQUIRE(loaded.plugins.size() == 2);
+    REQUIRE(loaded.presetBundles == cache.presetBundles);
+
+    const Lv2PluginInfo &plugin = *loaded.plugins[0];
+    REQUIRE(plugin.uri() == "http://example.com/plugins/test");
+    REQUIRE(plugin.name() == "Test Plugin");
+    REQUIRE(plugin.minorVersion() == 3);
+    REQUIRE(plugin.required_features().size() == 1);
+    REQUIRE(plugin.is_valid());
+    REQUIRE(plugin.minBlockLength() == 16);
+    REQUIRE(plugin.ports().size() == 1);
+    const Lv2PortInfo &port = *plugin.ports()[0];
+    REQUIRE(port.index() == 2);
+    REQUIRE(port.symbol() == "gain");
+    REQUIRE(port.min_value() == -60);
+    REQUIRE(port.max_value() == 12);
+    REQUIRE(port.is_control_port());
+    REQUIRE(!port.is_output());
+    REQUIRE(port.units() == Units::db);
+    REQUIRE(port.scale_points().size() == 1);
+    REQUIRE(port.scale_points()[0].label() == "Unity");
+    REQUIRE(plugin.port_groups().size() == 1);
+    REQUIRE(plugin.port_groups()[0]->name() == "Group");
+    REQUIRE(plugin.piPedalUI());
+    REQUIRE(plugin.piPedalUI()->fileProperties().size() == 1);
+    REQUIRE(plugin.piPedalUI()->fileProperties()[0]->directory() == "models");
+    REQUIRE(plugin.piPedalUI()->fileProperties()[0]->fileTypes().size() == 1);
+    REQUIRE(plugin.piPedalUI()->fileProperties()[0]->fileTypes()[0].fileExtension() == ".nam");
+    REQUIRE(plugin.modGui());
+    REQUIRE(plugin.modGui()->brand() == "Example");
+    REQUIRE(plugin.modGui()->ports().size() == 1);
+    REQUIRE(plugin.modGui()->ports()[0].symbol() == "gain");
+
+    REQUIRE(!loaded.plugins[1]->piPedalUI());
+    REQUIRE(!loaded.plugins[1]->modGui());
+
+    // damaged files are rejected.
+    {
+        std::vector<char> data;
+        {
+            std::ifstream f(cachePath, std::ios_base::binary);
+            data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+        std::ofstream f(cachePath, std::ios_base::binary | std::ios_base::trunc);
+        f.write(data.data(), data.size() / 2);
+    }
+    Lv2PluginCache damaged;
+    REQUIRE(!damaged.Load(cachePath));
+    REQUIRE(damaged.plugins.empty());
+
+    REQUIRE(!damaged.Load(root / "missing.bin"));
+
+    fs::remove_all(root);
+}
@@ -64,8 +64,10 @@ namespace pipedal
     };
 
     class PluginHost;
+    class Lv2PluginCache;
 
     class ModGuiPort {
+        friend class Lv2PluginCache;
     public:
         ModGuiPort() = default;
         ModGuiPort(PluginHost *lv2Host, const LilvNode *portNode);
@@ -86,6 +88,7 @@ namespace pipedal
 
     class ModGui
     {
+        friend class Lv2PluginCache;
     private:
         ModGui(PluginHost *lv2Host, const LilvPlugin *lilvPlugin, const std::string &resourceDirectory, const LilvNode *modGuiNode);
 
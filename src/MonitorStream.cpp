@@ -0,0 +1,173 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "MonitorStream.hpp"
+#include "VuUpdate.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using namespace pipedal;
+
+static_assert(std::endian::native == std::endian::little, "Monitor stream frames are written in native byte order.");
+
+template <typename T>
+static void Append(std::vector<uint8_t> &buffer, T value)
+{
+    size_t position = buffer.size();
+    buffer.resize(position + sizeof(T));
+    std::memcpy(buffer.data() + position, &value, sizeof(T));
+}
+
+MonitorStreamFrameWriter::MonitorStreamFrameWriter()
+{
+    Clear(0);
+}
+
+void MonitorStreamFrameWriter::Clear(uint32_t sequence)
+{
+    buffer.clear();
+    recordCount = 0;
+    Append<uint16_t>(buffer, MONITOR_STREAM_VERSION);
+    Append<uint16_t>(buffer, 0);
+    Append<uint32_t>(buffer, sequence);
+}
+
+void MonitorStreamFrameWriter::AddRecord(int64_t subscriptionHandle, MonitorStreamRecordType recordType, uint8_t flags, const float *values, size_t count)
+{
+    Append<uint32_t>(buffer, (uint32_t)subscriptionHandle);
+    Append<uint8_t>(buffer, (uint8_t)recordType);
+    Append<uint8_t>(buffer, flags);
+    Append<uint16_t>(buffer, (uint16_t)count);
+    size_t position = buffer.size();
+    buffer.resize(position + count * sizeof(float));
+    std::memcpy(buffer.data() + position, values, count * sizeof(float));
+
+    ++recordCount;
+    std::memcpy(buffer.data() + 2, &recordCount, sizeof(recordCount));
+}
+
+void MonitorStream::Enable(uint32_t credits)
+{
+    std::lock_guard lock{mutex};
+    this->enabled = true;
+    this->credits = std::min(credits, MAX_CREDITS);
+}
+
+void MonitorStream::Disable()
+{
+    std::lock_guard lock{mutex};
+    enabled = false;
+    credits = 0;
+    pendingValues.clear();
+}
+
+bool MonitorStream::IsEnabled() const
+{
+    std::lock_guard lock{mutex};
+    return enabled;
+}
+
+void MonitorStream::AddCredits(uint32_t credits)
+{
+    std::lock_guard lock{mutex};
+    this->credits = std::min(this->credits + std::min(credits, MAX_CREDITS), MAX_CREDITS);
+}
+
+uint32_t MonitorStream::GetCredits() const
+{
+    std::lock_guard lock{mutex};
+    return credits;
+}
+
+MonitorStream::PendingValue &MonitorStream::GetPendingValue(int64_t subscriptionHandle, MonitorStreamRecordType recordType)
+{
+    // a handful of subscriptions per client, so a linear search is fine.
+    for (auto &pendingValue : pendingValues)
+    {
+        if (pendingValue.subscriptionHandle == subscriptionHandle && pendingValue.recordType == recordType)
+        {
+            return pendingValue;
+        }
+    }
+    PendingValue &result = pendingValues.emplace_back();
+    result.subscriptionHandle = subscriptionHandle;
+    result.recordType = recordType;
+    return result;
+}
+
+void MonitorStream::PostVuUpdate(int64_t subscriptionHandle, const VuUpdateX &vuUpdate)
+{
+    std::lock_guard lock{mutex};
+    if (!enabled)
+        return;
+    PendingValue &pendingValue = GetPendingValue(subscriptionHandle, MonitorStreamRecordType::VuUpdate);
+    pendingValue.flags = (vuUpdate.isStereoInput_ ? 1 : 0) | (vuUpdate.isStereoOutput_ ? 2 : 0);
+    pendingValue.valueCount = 8;
+    pendingValue.values[0] = vuUpdate.inputMaxValueL_;
+    pendingValue.values[1] = vuUpdate.inputMaxValueR_;
+    pendingValue.values[2] = vuUpdate.outputMaxValueL_;
+    pendingValue.values[3] = vuUpdate.outputMaxValueR_;
+    pendingValue.values[4] = vuUpdate.inputRmsValueL_;
+    pendingValue.values[5] = vuUpdate.inputRmsValueR_;
+    pendingValue.values[6] = vuUpdate.outputRmsValueL_;
+    pendingValue.values[7] = vuUpdate.outputRmsValueR_;
+}
+
+void MonitorStream::PostPortValue(int64_t subscriptionHandle, float value)
+{
+    std::lock_guard lock{mutex};
+    if (!enabled)
+        return;
+    PendingValue &pendingValue = GetPendingValue(subscriptionHandle, MonitorStreamRecordType::PortValue);
+    pendingValue.flags = 0;
+    pendingValue.valueCount = 1;
+    pendingValue.values[0] = value;
+}
+
+void MonitorStream::RemoveSubscription(int64_t subscriptionHandle)
+{
+    std::lock_guard lock{mutex};
+    std::erase_if(pendingValues, [subscriptionHandle](const PendingValue &pendingValue)
+                  { return pendingValue.subscriptionHandle == subscriptionHandle; });
+}
+
+bool MonitorStream::Flush(const SendFunction &send)
+{
+    std::lock_guard lock{mutex};
+    if (!enabled || credits == 0 || pendingValues.empty())
+    {
+        return false;
+    }
+    --credits;
+    frameWriter.Clear(++sequence);
+    for (const auto &pendingValue : pendingValues)
+    {
+        frameWriter.AddRecord(
+            pendingValue.subscriptionHandle,
+            pendingValue.recordType,
+            pendingValue.flags,
+            pendingValue.values,
+            pendingValue.valueCount);
+    }
+    pendingValues.clear();
+    send(frameWriter.GetData(), frameWriter.GetSize());
+    return true;
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace pipedal
+{
+    class VuUpdateX;
+
+    /*
+        Binary monitor stream frames (websocket binary messages), little-endian.
+
+        Frame header (8 bytes):
+            uint16 version (MONITOR_STREAM_VERSION)
+            uint16 recordCount
+            uint32 sequence
+        followed by recordCount records:
+            uint32 subscriptionHandle
+            uint8  recordType (MonitorStreamRecordType)
+            uint8  flags (VuUpdate: bit 0 = stereo input, bit 1 = stereo output)
+            uint16 valueCount
+            float  values[valueCount]
+
+        VuUpdate values: inputMaxL, inputMaxR, outputMaxL, outputMaxR, inputRmsL, inputRmsR, outputRmsL, outputRmsR.
+        PortValue values: the current value of the monitored port.
+    */
+    constexpr uint16_t MONITOR_STREAM_VERSION = 1;
+
+    enum class MonitorStreamRecordType : uint8_t
+    {
+        VuUpdate = 1,
+        PortValue = 2
+    };
+
+    class MonitorStreamFrameWriter
+    {
+    public:
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t RECORD_HEADER_SIZE = 8;
+
+        MonitorStreamFrameWriter();
+
+        void Clear(uint32_t sequence);
+        void AddRecord(int64_t subscriptionHandle, MonitorStreamRecordType recordType, uint8_t flags, const float *values, size_t count);
+
+        size_t GetRecordCount() const { return recordCount; }
+        const uint8_t *GetData() const { return buffer.data(); }
+        size_t GetSize() const { return buffer.size(); }
+
+    private:
+        std::vector<uint8_t> buffer;
+        uint16_t recordCount = 0;
+    };
+
+    /**
+     * @brief Coalescing, credit-based flow control for one client's monitor stream.
+     *
+     * Values are posted as they arrive; only the latest value for each subscription is kept.
+     * Flush() sends everything that is pending as a single frame, consuming one credit. With no
+     * credits left, values keep coalescing until the client grants more (typically one credit per
+     * animation frame), so a slow client receives fewer, fresher frames instead of a backlog.
+     */
+    class MonitorStream
+    {
+    public:
+        // Upper bound on outstanding credits, so that a misbehaving client can't queue unbounded frames.
+        static constexpr uint32_t MAX_CREDITS = 8;
+
+        using SendFunction = std::function<void(const uint8_t *data, size_t size)>;
+
+        void Enable(uint32_t credits);
+        void Disable();
+        bool IsEnabled() const;
+
+        void AddCredits(uint32_t credits);
+        uint32_t GetCredits() const;
+
+        void PostVuUpdate(int64_t subscriptionHandle, const VuUpdateX &vuUpdate);
+        void PostPortValue(int64_t subscriptionHandle, float value);
+        void RemoveSubscription(int64_t subscriptionHandle);
+
+        // Send pending values if there are any, and a credit is available. send is called with the stream locked.
+        // Returns true if a frame was sent.
+        bool Flush(const SendFunction &send);
+
+    private:
+        static constexpr size_t MAX_VALUES = 8;
+        struct PendingValue
+        {
+            int64_t subscriptionHandle;
+            MonitorStreamRecordType recordType;
+            uint8_t flags;
+            uint16_t valueCount;
+            float values[MAX_VALUES];
+        };
+        PendingValue &GetPendingValue(int64_t subscriptionHandle, MonitorStreamRecordType recordType);
+
+        mutable std::mutex mutex;
+        bool enabled = false;
+        uint32_t credits = 0;
+        uint32_t sequence = 0;
+        std::vector<PendingValue> pendingValues;
+        MonitorStreamFrameWriter frameWriter;
+    };
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "MonitorStream.hpp"
+#include "VuUpdate.hpp"
+#include <cstring>
+
+using namespace pipedal;
+using namespace std;
+
+template <typename T>
+static T ReadAt(const std::vector<uint8_t> &frame, size_t offset)
+{
+    REQUIRE(offset + sizeof(T) <= frame.size());
+    T result;
+    memcpy(&result, frame.data() + offset, sizeof(T));
+    return result;
+}
+
+TEST_CASE("Monitor stream frame layout", "[monitor_stream][Build]")
+{
+    MonitorStream stream;
+    stream.Enable(1);
+
+    VuUpdateX vuUpdate;
+    vuUpdate.isStereoOutput_ = true;
+    vuUpdate.inputMaxValueL_ = 0.5f;
+    vuUpdate.outputRmsValueR_ = 0.25f;
+    stream.PostVuUpdate(3, vuUpdate);
+    stream.PostPortValue(7, 1.5f);
+
+    std::vector<uint8_t> frame;
+    REQUIRE(stream.Flush([&frame](const uint8_t *data, size_t size)
+                         { frame.assign(data, data + size); }));
+
+    REQUIRE(frame.size() == 8 + (8 + 8 * 4) + (8 + 4));
+    REQUIRE(ReadAt<uint16_t>(frame, 0) == MONITOR_STREAM_VERSION);
+    REQUIRE(ReadAt<uint16_t>(frame, 2) == 2);
+    REQUIRE(ReadAt<uint32_t>(frame, 4) == 1);
+
+    size_t offset = 8;
+    REQUIRE(ReadAt<uint32_t>(frame, offset) == 3);
+    REQUIRE(ReadAt<uint8_t>(frame, offset + 4) == (uint8_t)MonitorStreamRecordType::VuUpdate);
+    REQUIRE(ReadAt<uint8_t>(frame, offset + 5) == 2);
+    REQUIRE(ReadAt<uint16_t>(frame, offset + 6) == 8);
+    REQUIRE(ReadAt<float>(frame, offset + 8) == 0.5f);
+    REQUIRE(ReadAt<float>(frame, offset + 8 + 7 * 4) == 0.25f);
+
+    offset += 8 + 8 * 4;
+    REQUIRE(ReadAt<uint32_t>(frame, offset) == 7);
+    REQUIRE(ReadAt<uint8_t>(frame, offset + 4) == (uint8_t)MonitorStreamRecordType::PortValue);
+    REQUIRE(ReadAt<uint16_t>(frame, offset + 6) == 1);
+    REQUIRE(ReadAt<float>(frame, offset + 8) == 1.5f);
+}
+
+TEST_CASE("Monitor stream credits and coalescing", "[monitor_stream][Build]")
+{
+    MonitorStream stream;
+    size_t framesSent = 0;
+    std::vector<uint8_t> frame;
+    auto send = [&](const uint8_t *data, size_t size)
+    {
+        ++framesSent;
+        frame.assign(data, data + size);
+    };
+
+    // not enabled: values are discarded.
+    stream.PostPortValue(1, 1.0f);
+    REQUIRE(!stream.Flush(send));
+
+    stream.Enable(1);
+    stream.PostPortValue(1, 1.0f);
+    REQUIRE(stream.Flush(send));
+    REQUIRE(stream.GetCredits() == 0);
+
+    // out of credit: only the latest value of each subscription is kept.
+    stream.PostPortValue(1, 2.0f);
+    stream.PostPortValue(1, 3.0f);
+    stream.PostPortValue(2, 4.0f);
+    REQUIRE(!stream.Flush(send));
+    REQUIRE(framesSent == 1);
+
+    stream.AddCredits(1);
+    REQUIRE(stream.Flush(send));
+    REQUIRE(framesSent == 2);
+    REQUIRE(ReadAt<uint16_t>(frame, 2) == 2);
+    REQUIRE(ReadAt<uint32_t>(frame, 4) == 2);
+    REQUIRE(ReadAt<float>(frame, 8 + 8) == 3.0f);
+    REQUIRE(ReadAt<float>(frame, 8 + 12 + 8) == 4.0f);
+
+    // nothing pending: the credit is not consumed.
+    stream.AddCredits(1);
+    REQUIRE(!stream.Flush(send));
+    REQUIRE(stream.GetCredits() == 1);
+
+    // removed subscriptions are not sent.
+    stream.PostPortValue(1, 5.0f);
+    stream.RemoveSubscription(1);
+    REQUIRE(!stream.Flush(send));
+
+    stream.AddCredits(1000);
+    REQUIRE(stream.GetCredits() == MonitorStream::MAX_CREDITS);
+
+    stream.Disable();
+    stream.PostPortValue(1, 6.0f);
+    REQUIRE(!stream.Flush(send));
+}
@@ -0,0 +1,214 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "PedalboardBenchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace pipedal;
+
+static double NearestRank(const std::vector<uint64_t> &sorted, double percentile)
+{
+    size_t rank = (size_t)std::ceil(percentile / 100.0 * sorted.size());
+    rank = std::clamp(rank, (size_t)1, sorted.size());
+    return sorted[rank - 1] * 1E-3;
+}
+
+BenchmarkTiming PeriodTimeRecorder::Summarize() const
+{
+    BenchmarkTiming result;
+    if (samplesNs.empty())
+    {
+        return result;
+    }
+    std::vector<uint64_t> sorted = samplesNs;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0;
+    for (uint64_t ns : sorted)
+    {
+        total += ns;
+    }
+    result.mean_ = total * 1E-3 / sorted.size();
+    result.p50_ = NearestRank(sorted, 50);
+    result.p99_ = NearestRank(sorted, 99);
+    result.max_ = sorted.back() * 1E-3;
+    return result;
+}
+
+void BenchmarkResult::SetTiming(const BenchmarkTiming &timing)
+{
+    this->timing_ = timing;
+    double periodUs = bufferSize_ * 1E6 / sampleRate_;
+    this->loadP50_ = timing.p50_ * 100 / periodUs;
+    this->loadP99_ = timing.p99_ * 100 / periodUs;
+}
+
+static std::string CsvEscape(const std::string &value)
+{
+    if (value.find_first_of(",\"\n") == std::string::npos)
+    {
+        return value;
+    }
+    std::string result = "\"";
+    for (char c : value)
+    {
+        if (c == '"')
+        {
+            result += '"';
+        }
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+static void WriteCsvTiming(std::ostream &s, const BenchmarkTiming &timing)
+{
+    s << timing.mean_ << "," << timing.p50_ << "," << timing.p99_ << "," << timing.max_;
+}
+
+void pipedal::WriteBenchmarkCsv(std::ostream &s, const BenchmarkReport &report)
+{
+    s << "preset,sampleRate,bufferSize,instanceId,uri,periods,meanUs,p50Us,p99Us,maxUs,loadP50,loadP99,error,snapshots,snapshotCompileP50Us,snapshotSwitchP50Us,snapshotSwitchP99Us,snapshotSwitchMaxUs" << std::endl;
+    s << std::fixed << std::setprecision(3);
+    for (const auto &result : report.results_)
+    {
+        std::string prefix = CsvEscape(result.preset_) + "," + std::to_string((int64_t)result.sampleRate_) + "," + std::to_string(result.bufferSize_) + ",";
+        s << prefix << "-1,," << result.periods_ << ",";
+        WriteCsvTiming(s, result.timing_);
+        s << "," << result.loadP50_ << "," << result.loadP99_ << "," << CsvEscape(result.error_)
+          << "," << result.snapshots_
+          << "," << result.snapshotCompile_.p50_
+          << "," << result.snapshotSwitch_.p50_
+          << "," << result.snapshotSwitch_.p99_
+          << "," << result.snapshotSwitch_.max_ << std::endl;
+
+        for (const auto &effect : result.effects_)
+        {
+            s << prefix << effect.instanceId_ << "," << CsvEscape(effect.uri_) << "," << result.periods_ << ",";
+            WriteCsvTiming(s, effect.timing_);
+            s << ",,,,,,,," << std::endl;
+        }
+    }
+}
+
+static void CompareTiming(
+    std::vector<BenchmarkRegression> &regressions,
+    const BenchmarkResult &result,
+    int64_t instanceId,
+    const std::string &uri,
+    const BenchmarkTiming &baseline,
+    const BenchmarkTiming &current,
+    double tolerancePercent,
+    double noiseFloorUs)
+{
+    auto compare = [&](const char *metric, double baselineUs, double currentUs)
+    {
+        if (currentUs > baselineUs * (1 + tolerancePercent / 100) && currentUs - baselineUs > noiseFloorUs)
+        {
+            BenchmarkRegression regression;
+            regression.preset = result.preset_;
+            regression.sampleRate = result.sampleRate_;
+            regression.bufferSize = result.bufferSize_;
+            regression.instanceId = instanceId;
+            regression.uri = uri;
+            regression.metric = metric;
+            regression.baseline = baselineUs;
+            regression.current = currentUs;
+            regressions.push_back(regression);
+        }
+    };
+    compare("p50", baseline.p50_, current.p50_);
+    compare("p99", baseline.p99_, current.p99_);
+}
+
+std::vector<BenchmarkRegression> pipedal::CompareBenchmarkReports(
+    const BenchmarkReport &baseline,
+    const BenchmarkReport &current,
+    double tolerancePercent,
+    double noiseFloorUs)
+{
+    std::vector<BenchmarkRegression> regressions;
+    for (const auto &result : current.results_)
+    {
+        if (!result.error_.empty())
+        {
+            continue;
+        }
+        auto baselineResult = std::find_if(
+            baseline.results_.begin(), baseline.results_.end(),
+            [&result](const BenchmarkResult &r)
+            {
+                return r.preset_ == result.preset_ && r.sampleRate_ == result.sampleRate_ && r.bufferSize_ == result.bufferSize_ && r.error_.empty();
+            });
+        if (baselineResult == baseline.results_.end())
+        {
+            continue;
+        }
+        CompareTiming(regressions, result, -1, "", baselineResult->timing_, result.timing_, tolerancePercent, noiseFloorUs);
+        for (const auto &effect : result.effects_)
+        {
+            for (const auto &baselineEffect : baselineResult->effects_)
+            {
+                if (baselineEffect.instanceId_ == effect.instanceId_ && baselineEffect.uri_ == effect.uri_)
+                {
+                    CompareTiming(regressions, result, effect.instanceId_, effect.uri_, baselineEffect.timing_, effect.timing_, tolerancePercent, noiseFloorUs);
+                    break;
+                }
+            }
+        }
+    }
+    return regressions;
+}
+
+JSON_MAP_BEGIN(BenchmarkTiming)
+    JSON_MAP_REFERENCE(BenchmarkTiming, mean)
+    JSON_MAP_REFERENCE(BenchmarkTiming, p50)
+    JSON_MAP_REFERENCE(BenchmarkTiming, p99)
+    JSON_MAP_REFERENCE(BenchmarkTiming, max)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BenchmarkEffectResult)
+    JSON_MAP_REFERENCE(BenchmarkEffectResult, instanceId)
+    JSON_MAP_REFERENCE(BenchmarkEffectResult, uri)
+    JSON_MAP_REFERENCE(BenchmarkEffectResult, timing)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BenchmarkResult)
+    JSON_MAP_REFERENCE(BenchmarkResult, preset)
+    JSON_MAP_REFERENCE(BenchmarkResult, sampleRate)
+    JSON_MAP_REFERENCE(BenchmarkResult, bufferSize)
+    JSON_MAP_REFERENCE(BenchmarkResult, periods)
+    JSON_MAP_REFERENCE(BenchmarkResult, timing)
+    JSON_MAP_REFERENCE(BenchmarkResult, loadP50)
+    JSON_MAP_REFERENCE(BenchmarkResult, loadP99)
+    JSON_MAP_REFERENCE(BenchmarkResult, effects)
+    JSON_MAP_REFERENCE(BenchmarkResult, snapshots)
+    JSON_MAP_REFERENCE(BenchmarkResult, snapshotCompile)
+    JSON_MAP_REFERENCE(BenchmarkResult, snapshotSwitch)
+    JSON_MAP_REFERENCE(BenchmarkResult, error)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BenchmarkReport)
+    JSON_MAP_REFERENCE(BenchmarkReport, host)
+    JSON_MAP_REFERENCE(BenchmarkReport, results)
+JSON_MAP_END()
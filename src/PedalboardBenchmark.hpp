@@ -0,0 +1,130 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "json.hpp"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    // Execution time statistics, in microseconds per period.
+    class BenchmarkTiming
+    {
+    public:
+        double mean_ = 0;
+        double p50_ = 0;
+        double p99_ = 0;
+        double max_ = 0;
+
+        DECLARE_JSON_MAP(BenchmarkTiming);
+    };
+
+    // Collects per-period execution times.
+    class PeriodTimeRecorder
+    {
+    public:
+        void Reserve(size_t periods) { samplesNs.reserve(periods); }
+        void Add(uint64_t ns) { samplesNs.push_back(ns); }
+        size_t GetCount() const { return samplesNs.size(); }
+
+        // Percentiles use the nearest-rank method.
+        BenchmarkTiming Summarize() const;
+
+    private:
+        std::vector<uint64_t> samplesNs;
+    };
+
+    class BenchmarkEffectResult
+    {
+    public:
+        int64_t instanceId_ = -1;
+        std::string uri_;
+        BenchmarkTiming timing_;
+
+        DECLARE_JSON_MAP(BenchmarkEffectResult);
+    };
+
+    // Results for one preset, at one sample rate and buffer size.
+    class BenchmarkResult
+    {
+    public:
+        std::string preset_;
+        double sampleRate_ = 0;
+        uint32_t bufferSize_ = 0;
+        uint64_t periods_ = 0;
+        BenchmarkTiming timing_;
+        // p50 and p99 execution time as a percentage of the period's duration.
+        double loadP50_ = 0;
+        double loadP99_ = 0;
+        std::vector<BenchmarkEffectResult> effects_;
+        // Time to precompile one snapshot, and to apply a precompiled snapshot on the audio thread.
+        uint32_t snapshots_ = 0;
+        BenchmarkTiming snapshotCompile_;
+        BenchmarkTiming snapshotSwitch_;
+        // Non-empty if the preset could not be run (e.g. a plugin is not installed).
+        std::string error_;
+
+        void SetTiming(const BenchmarkTiming &timing);
+
+        DECLARE_JSON_MAP(BenchmarkResult);
+    };
+
+    class BenchmarkReport
+    {
+    public:
+        std::string host_;
+        std::vector<BenchmarkResult> results_;
+
+        DECLARE_JSON_MAP(BenchmarkReport);
+    };
+
+    // One row per result, followed by one row per effect of the result.
+    void WriteBenchmarkCsv(std::ostream &s, const BenchmarkReport &report);
+
+    struct BenchmarkRegression
+    {
+        std::string preset;
+        double sampleRate = 0;
+        uint32_t bufferSize = 0;
+        int64_t instanceId = -1; // -1 for the whole pedalboard.
+        std::string uri;
+        std::string metric;
+        double baseline = 0;
+        double current = 0;
+
+        double GetChangePercent() const { return baseline == 0 ? 0 : (current - baseline) * 100 / baseline; }
+    };
+
+    /**
+     * @brief Compare a report against a saved baseline.
+     *
+     * Compares the p50 and p99 times of each pedalboard and each effect that appear in both reports.
+     * A time is a regression if it exceeds the baseline by more than tolerancePercent, and by more than
+     * noiseFloorUs microseconds (so that very cheap effects don't report noise as regressions).
+     */
+    std::vector<BenchmarkRegression> CompareBenchmarkReports(
+        const BenchmarkReport &baseline,
+        const BenchmarkReport &current,
+        double tolerancePercent,
+        double noiseFloorUs);
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PedalboardBenchmark.hpp"
+#include <sstream>
+
+using namespace pipedal;
+using namespace std;
+
+static BenchmarkResult MakeResult(const std::string &preset, double p50, double p99, double effectP50, double effectP99)
+{
+    BenchmarkResult result;
+    result.preset_ = preset;
+    result.sampleRate_ = 48000;
+    result.bufferSize_ = 64;
+    result.periods_ = 1000;
+    BenchmarkTiming timing;
+    timing.p50_ = p50;
+    timing.p99_ = p99;
+    result.SetTiming(timing);
+
+    BenchmarkEffectResult effect;
+    effect.instanceId_ = 3;
+    effect.uri_ = "http://example.com/plugins/test";
+    effect.timing_.p50_ = effectP50;
+    effect.timing_.p99_ = effectP99;
+    result.effects_.push_back(effect);
+    return result;
+}
+
+TEST_CASE("Pedalboard benchmark percentiles", "[pedalboard_benchmark][Build]")
+{
+    PeriodTimeRecorder recorder;
+    REQUIRE(recorder.Summarize().max_ == 0);
+
+    // 1..100 us, in reverse order.
+    for (uint64_t i = 100; i >= 1; --i)
+    {
+        recorder.Add(i * 1000);
+    }
+    REQUIRE(recorder.GetCount() == 100);
+    BenchmarkTiming timing = recorder.Summarize();
+    REQUIRE(timing.mean_ == Approx(50.5));
+    REQUIRE(timing.p50_ == 50);
+    REQUIRE(timing.p99_ == 99);
+    REQUIRE(timing.max_ == 100);
+
+    PeriodTimeRecorder single;
+    single.Add(2500);
+    timing = single.Summarize();
+    REQUIRE(timing.p50_ == 2.5);
+    REQUIRE(timing.p99_ == 2.5);
+
+    // 64 frames at 48kHz is 1333.3us.
+    BenchmarkResult result = MakeResult("x", 666.6667, 1333.3333, 0, 0);
+    REQUIRE(result.loadP50_ == Approx(50));
+    REQUIRE(result.loadP99_ == Approx(100));
+}
+
+TEST_CASE("Pedalboard benchmark regressions", "[pedalboard_benchmark][Build]")
+{
+    BenchmarkReport baseline;
+    baseline.results_.push_back(MakeResult("clean", 100, 200, 50, 60));
+    baseline.results_.push_back(MakeResult("high-gain", 100, 200, 50, 60));
+
+    BenchmarkReport current;
+    current.results_.push_back(MakeResult("clean", 104, 200, 50, 80));     // p50 within tolerance; effect p99 regressed.
+    current.results_.push_back(MakeResult("high-gain", 100, 300, 51, 60)); // pedalboard p99 regressed; effect p50 below the noise floor.
+    current.results_.push_back(MakeResult("new-preset", 1000, 2000, 50, 60));
+
+    auto regressions = CompareBenchmarkReports(baseline, current, 5, 2);
+    REQUIRE(regressions.size() == 2);
+
+    REQUIRE(regressions[0].preset == "clean");
+    REQUIRE(regressions[0].instanceId == 3);
+    REQUIRE(regressions[0].metric == "p99");
+    REQUIRE(regressions[0].GetChangePercent() == Approx(33.3333));
+
+    REQUIRE(regressions[1].preset == "high-gain");
+    REQUIRE(regressions[1].instanceId == -1);
+    REQUIRE(regressions[1].metric == "p99");
+    REQUIRE(regressions[1].GetChangePercent() == Approx(50));
+
+    // failed runs are not compared.
+    current.results_[1].error_ = "Plugin not found.";
+    REQUIRE(CompareBenchmarkReports(baseline, current, 5, 2).size() == 1);
+}
+
+TEST_CASE("Pedalboard benchmark report files", "[pedalboard_benchmark][Build]")
+{
+    BenchmarkReport report;
+    report.host_ = "pi5";
+    report.results_.push_back(MakeResult("clean, \"quoted\"", 100, 200, 50, 60));
+    report.results_[0].snapshots_ = 6;
+    report.results_[0].snapshotSwitch_.p99_ = 12.5;
+    BenchmarkResult failed;
+    failed.preset_ = "missing";
+    failed.sampleRate_ = 96000;
+    failed.bufferSize_ = 32;
+    failed.error_ = "Plugin not found.";
+    report.results_.push_back(failed);
+
+    std::stringstream csv;
+    WriteBenchmarkCsv(csv, report);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(csv, line))
+    {
+        lines.push_back(line);
+    }
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0].rfind("preset,sampleRate,bufferSize,", 0) == 0);
+    REQUIRE(lines[1].rfind("\"clean, \"\"quoted\"\"\",48000,64,-1,,1000,", 0) == 0);
+    REQUIRE(lines[1].find(",6,0.000,0.000,12.500,0.000") != std::string::npos);
+    REQUIRE(lines[2].rfind("\"clean, \"\"quoted\"\"\",48000,64,3,http://example.com/plugins/test,1000,", 0) == 0);
+    REQUIRE(lines[3].rfind("missing,96000,32,-1,,0,", 0) == 0);
+    REQUIRE(lines[3].find("Plugin not found.") != std::string::npos);
+
+    std::stringstream s;
+    json_writer writer(s);
+    writer.write(report);
+
+    json_reader reader(s);
+    BenchmarkReport copy;
+    reader.read(&copy);
+    REQUIRE(copy.host_ == "pi5");
+    REQUIRE(copy.results_.size() == 2);
+    REQUIRE(copy.results_[0].preset_ == report.results_[0].preset_);
+    REQUIRE(copy.results_[0].timing_.p99_ == 200);
+    REQUIRE(copy.results_[0].effects_.size() == 1);
+    REQUIRE(copy.results_[0].snapshots_ == 6);
+    REQUIRE(copy.results_[0].snapshotSwitch_.p99_ == 12.5);
+    REQUIRE(copy.results_[0].effects_[0].uri_ == "http://example.com/plugins/test");
+    REQUIRE(copy.results_[1].error_ == "Plugin not found.");
+    REQUIRE(CompareBenchmarkReports(report, copy, 0, 0).empty());
+}
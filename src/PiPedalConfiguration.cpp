@@ -105,5 +105,17 @@ JSON_MAP_REFERENCE(PiPedalConfiguration, tone3000A2Models)
 JSON_MAP_REFERENCE(PiPedalConfiguration, accessPointGateway)
 JSON_MAP_REFERENCE(PiPedalConfiguration, accessPointServerAddress)
 JSON_MAP_REFERENCE(PiPedalConfiguration, isVst3Enabled)
+JSON_MAP_REFERENCE(PiPedalConfiguration, presetPreloadMemoryBudget)
+JSON_MAP_REFERENCE(PiPedalConfiguration, presetPreloadCount)
+JSON_MAP_REFERENCE(PiPedalConfiguration, lv2WorkerThreads)
+JSON_MAP_REFERENCE(PiPedalConfiguration, lv2WorkerPriority)
+JSON_MAP_REFERENCE(PiPedalConfiguration, hardBypass)
+JSON_MAP_REFERENCE(PiPedalConfiguration, hardBypassSilenceSeconds)
+JSON_MAP_REFERENCE(PiPedalConfiguration, hardBypassThresholdDb)
+JSON_MAP_REFERENCE(PiPedalConfiguration, skipSilentEffects)
+JSON_MAP_REFERENCE(PiPedalConfiguration, silenceTailSeconds)
+JSON_MAP_REFERENCE(PiPedalConfiguration, silenceThresholdDb)
+JSON_MAP_REFERENCE(PiPedalConfiguration, flightRecorderPeriods)
+JSON_MAP_REFERENCE(PiPedalConfiguration, flightRecorderReports)
 JSON_MAP_REFERENCE(PiPedalConfiguration, end)
 JSON_MAP_END()
@@ -49,6 +49,18 @@ private:
     std::string accessPointGateway_;
     std::string accessPointServerAddress_;
     bool isVst3Enabled_ = true;
+    uint64_t presetPreloadMemoryBudget_ = 256*1024*1024;
+    uint32_t presetPreloadCount_ = 4;
+    uint32_t lv2WorkerThreads_ = 2;
+    int32_t lv2WorkerPriority_ = 5;
+    bool hardBypass_ = false;
+    float hardBypassSilenceSeconds_ = 1.0f;
+    float hardBypassThresholdDb_ = -90.0f;
+    bool skipSilentEffects_ = false;
+    float silenceTailSeconds_ = 5.0f;
+    float silenceThresholdDb_ = -120.0f;
+    int32_t flightRecorderPeriods_ = 4096;
+    int32_t flightRecorderReports_ = 20;
     bool end_ = false; // dummy target for /var/pipedal/config/config.json
 
 public:
@@ -67,6 +79,18 @@ public:
     const std::vector<std::string> &GetReactServerAddresses() const { return reactServerAddresses_;}
     bool GetMLock() const { return mlock_; }
     uint64_t GetMaxUploadSize() const { return maxUploadSize_; }
+    uint64_t GetPresetPreloadMemoryBudget() const { return presetPreloadMemoryBudget_; }
+    uint32_t GetPresetPreloadCount() const { return presetPreloadCount_; }
+    uint32_t GetLv2WorkerThreads() const { return lv2WorkerThreads_; }
+    int32_t GetLv2WorkerPriority() const { return lv2WorkerPriority_; }
+    bool GetHardBypass() const { return hardBypass_; }
+    float GetHardBypassSilenceSeconds() const { return hardBypassSilenceSeconds_; }
+    float GetHardBypassThresholdDb() const { return hardBypassThresholdDb_; }
+    bool GetSkipSilentEffects() const { return skipSilentEffects_; }
+    float GetSilenceTailSeconds() const { return silenceTailSeconds_; }
+    float GetSilenceThresholdDb() const { return silenceThresholdDb_; }
+    int32_t GetFlightRecorderPeriods() const { return flightRecorderPeriods_; }
+    int32_t GetFlightRecorderReports() const { return flightRecorderReports_; }
 
     bool GetTone3000A2Models() const { return tone3000A2Models_; }
     LogLevel GetLogLevel() const { return (LogLevel)this->logLevel_; }
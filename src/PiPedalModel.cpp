@@ -131,6 +131,7 @@ void PrepareSnapshostsForSave(Pedalboard &pedalboard)
 void PiPedalModel::Close()
 {
     std::unique_ptr<AudioHost> oldAudioHost;
+    std::unique_ptr<PresetPreloadCache<Lv2Pedalboard>> oldPresetPreloadCache;
     {
         std::lock_guard<std::recursive_mutex> lock(mutex);
 
@@ -160,8 +161,11 @@ void PiPedalModel::Close()
         this->subscribers.resize(0);
 
         oldAudioHost = std::move(this->audioHost);
+        oldPresetPreloadCache = std::move(this->presetPreloadCache);
     } // end lock.
 
+    oldPresetPreloadCache = nullptr; // waits for a preload that's in progress.
+
     // lockless to avoid deadlocks while shutting down the audio thread.
     if (oldAudioHost)
     {
@@ -236,6 +240,8 @@ void PiPedalModel::Init(const PiPedalConfiguration &configuration)
     }
 
     this->channelRouterSettings = storage.GetChannelRouterSettings();
+    pluginHost.SetParallelSplitChains(jackServerSettings.GetParallelSplitChains());
+    pluginHost.SetPipelineStages(jackServerSettings.GetPipelineStages());
     pluginHost.OnConfigurationChanged(
         jackConfiguration,
         storage.GetChannelSelection());
@@ -443,6 +449,11 @@ void PiPedalModel::Load()
 
     this->audioHost->SetNotificationCallbacks(this);
 
+    if (configuration.GetPresetPreloadMemoryBudget() != 0 && configuration.GetPresetPreloadCount() != 0)
+    {
+        this->presetPreloadCache = std::make_unique<PresetPreloadCache<Lv2Pedalboard>>(configuration.GetPresetPreloadMemoryBudget());
+    }
+
     this->systemMidiBindings = storage.GetSystemMidiBindings();
 
     this->audioHost->SetSystemMidiBindings(this->systemMidiBindings);
@@ -713,9 +724,10 @@ void PiPedalModel::SetPedalboard(int64_t clientId, Pedalboard &pedalboard)
     this->SetPresetChanged(clientId, true);
 }
 
-void PiPedalModel::SetSnapshot(int64_t selectedSnapshot)
+void PiPedalModel::SetSnapshot(int64_t selectedSnapshot, bool appliedOnRealtimeThread)
 {
     bool pedalboardChanged = false;
+    bool loadAudioThread = true;
     {
         std::lock_guard<std::recursive_mutex> lock(mutex);
         if (this->pedalboard.ApplySnapshot(selectedSnapshot, pluginHost))
@@ -729,6 +741,15 @@ void PiPedalModel::SetSnapshot(int64_t selectedSnapshot)
                 }
             }
             pedalboardChanged = true;
+            if (appliedOnRealtimeThread && audioHost && audioHost->IsOpen() && previousPedalboardLoaded && pedalboard.IsStructureIdentical(previousPedalboard))
+            {
+                // Only path properties are left to apply. Reapplying control values would overwrite
+                // control changes made since the snapshot was triggered.
+                Snapshot snapshot = pedalboard.MakeSnapshotFromCurrentSettings(previousPedalboard);
+                audioHost->LoadSnapshot(snapshot, pluginHost, SnapshotContents::PathProperties);
+                this->previousPedalboard = this->pedalboard;
+                loadAudioThread = false;
+            }
         } else if (selectedSnapshot == -1) 
         {
             this->pedalboard.selectedSnapshot(-1);
@@ -738,7 +759,7 @@ void PiPedalModel::SetSnapshot(int64_t selectedSnapshot)
     }
     if (pedalboardChanged)
     {
-        FirePedalboardChanged(-1, true);
+        FirePedalboardChanged(-1, loadAudioThread);
     }
 }
 
@@ -750,6 +771,10 @@ void PiPedalModel::SetSnapshots(std::vector<std::shared_ptr<Snapshot>> &snapshot
         UpdateVst3Settings(pedalboard);
 
         this->pedalboard.snapshots(std::move(snapshots));
+        if (audioHost)
+        {
+            audioHost->SetSnapshots(this->pedalboard.snapshots(), pluginHost);
+        }
 
         if (selectedSnapshot != -1)
         {
@@ -792,6 +817,7 @@ void PiPedalModel::UpdateCurrentPedalboard(int64_t clientId, Pedalboard &pedalbo
         previousPedalboard = this->pedalboard;
         previousPedalboardLoaded = true;
         this->pedalboard = pedalboard;
+        audioHost->SetSnapshots(this->pedalboard.snapshots(), pluginHost);
 
         UpdateRealtimeVuSubscriptions();
         UpdateRealtimeMonitorPortSubscriptions();
@@ -950,6 +976,7 @@ void PiPedalModel::FirePresetsChanged(int64_t clientId)
     {
         subscriber->OnPresetsChanged(clientId, presets);
     }
+    UpdatePresetPreloads();
 }
 void PiPedalModel::FirePluginPresetsChanged(const std::string &pluginUri)
 {
@@ -1293,11 +1320,11 @@ void PiPedalModel::OnNotifyNextMidiProgram(const RealtimeNextMidiProgramRequest
     }
 }
 
-void PiPedalModel::OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId)
+void PiPedalModel::OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId, bool appliedOnRealtimeThread)
 {
     try
     {
-        SetSnapshot((int64_t)snapshotIndex);
+        SetSnapshot((int64_t)snapshotIndex, appliedOnRealtimeThread);
     }
     catch (const std::exception &e)
     {
@@ -1642,6 +1669,11 @@ void PiPedalModel::RestartAudio(bool useDummyAudioDriver)
         // do a complete reload.
 
         this->audioHost->SetPedalboard(nullptr);
+        if (presetPreloadCache)
+        {
+            // preloaded pedalboards were built for the old configuration.
+            presetPreloadCache->Clear();
+        }
 
         previousPedalboardLoaded = false;
         auto jackServerSettings = this->jackServerSettings;
@@ -1671,10 +1703,13 @@ void PiPedalModel::RestartAudio(bool useDummyAudioDriver)
 
         this->audioHost->Open(jackServerSettings, channelSelection); 
 
+        this->pluginHost.SetParallelSplitChains(jackServerSettings.GetParallelSplitChains());
+        this->pluginHost.SetPipelineStages(jackServerSettings.GetPipelineStages());
         this->pluginHost.OnConfigurationChanged(jackConfiguration, channelSelection);
 
         FireChannelRouterSettingsChanged(-1);
         LoadCurrentPedalboard();
+        UpdatePresetPreloads();
 
         this->UpdateRealtimeVuSubscriptions();
         UpdateRealtimeMonitorPortSubscriptions();
@@ -1816,6 +1851,24 @@ void PiPedalModel::RemoveVuSubscription(int64_t subscriptionHandle)
     UpdateRealtimeVuSubscriptions();
 }
 
+void PiPedalModel::AddEffectCpuUseSubscription()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (++effectCpuUseSubscriptions == 1 && audioHost)
+    {
+        audioHost->SetEffectCpuUseSubscription(true);
+    }
+}
+
+void PiPedalModel::RemoveEffectCpuUseSubscription()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (effectCpuUseSubscriptions > 0 && --effectCpuUseSubscriptions == 0 && audioHost)
+    {
+        audioHost->SetEffectCpuUseSubscription(false);
+    }
+}
+
 void PiPedalModel::OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
@@ -1892,6 +1945,19 @@ void PiPedalModel::OnNotifyVusSubscription(const std::vector<VuUpdateX> &updates
     }
 }
 
+void PiPedalModel::OnNotifyEffectCpuUse(const EffectCpuUpdate &update)
+{
+    std::vector<IPiPedalModelSubscriber::ptr> subscribers;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        subscribers = this->subscribers;
+    }
+    for (auto &subscriber : subscribers)
+    {
+        subscriber->OnEffectCpuUseUpdate(update);
+    }
+}
+
 static bool isStartOrEndControl(int64_t controlId)
 {
     switch (controlId)
@@ -3090,6 +3156,116 @@ void PiPedalModel::SetSelectedPedalboardPlugin(uint64_t clientId, uint64_t pedal
     pedalboard.selectedPlugin(pedalboardId);
 }
 
+// Everything that a preloaded Lv2Pedalboard depends on.
+static std::string GetPresetPreloadKey(const Pedalboard &pedalboard)
+{
+    std::stringstream s;
+    json_writer writer(s, true);
+    writer.write(pedalboard);
+    return s.str();
+}
+
+void PiPedalModel::UpdatePresetPreloads()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!presetPreloadCache || !audioHost || !audioHost->IsOpen())
+    {
+        return;
+    }
+    PresetIndex presetIndex;
+    storage.GetPresetIndex(&presetIndex);
+    const auto &presets = presetIndex.presets();
+
+    int64_t currentPresetId = presetIndex.selectedInstanceId();
+    if (currentPresetId != preloadCurrentPresetId)
+    {
+        preloadPreviousPresetId = preloadCurrentPresetId;
+        preloadCurrentPresetId = currentPresetId;
+    }
+
+    // In order of priority: the preset we just came from (so that A/B switching is instant),
+    // then the next and previous presets, then the ones after those, and so on.
+    std::vector<int64_t> candidates;
+    if (preloadPreviousPresetId != -1)
+    {
+        candidates.push_back(preloadPreviousPresetId);
+    }
+    int64_t n = (int64_t)presets.size();
+    int64_t currentIndex = -1;
+    for (int64_t i = 0; i < n; ++i)
+    {
+        if (presets[i].instanceId() == currentPresetId)
+        {
+            currentIndex = i;
+            break;
+        }
+    }
+    if (currentIndex != -1)
+    {
+        for (int64_t distance = 1; distance <= n / 2; ++distance)
+        {
+            candidates.push_back(presets[(currentIndex + distance) % n].instanceId());
+            candidates.push_back(presets[(currentIndex - distance + n) % n].instanceId());
+        }
+    }
+
+    std::vector<PresetPreloadCache<Lv2Pedalboard>::Request> requests;
+    std::set<int64_t> requested;
+    size_t maxRequests = configuration.GetPresetPreloadCount();
+    for (int64_t presetId : candidates)
+    {
+        if (requests.size() >= maxRequests)
+        {
+            break;
+        }
+        if (presetId == currentPresetId || requested.contains(presetId))
+        {
+            continue;
+        }
+        requested.insert(presetId);
+        Pedalboard preset;
+        try
+        {
+            preset = storage.GetPreset(presetId);
+        }
+        catch (const std::exception &)
+        {
+            continue; // deleted.
+        }
+        UpdateDefaults(&preset);
+        if (preset.IsStructureIdentical(this->pedalboard))
+        {
+            continue; // loaded with a snapshot update anyway.
+        }
+        std::string key = GetPresetPreloadKey(preset);
+        requests.push_back(PresetPreloadCache<Lv2Pedalboard>::Request{
+            std::move(key),
+            [this, preset = std::move(preset)]() mutable -> std::shared_ptr<Lv2Pedalboard>
+            {
+                Lv2PedalboardErrorList errorMessages;
+                std::shared_ptr<Lv2Pedalboard> result{this->pluginHost.CreateLv2Pedalboard(preset, errorMessages)};
+                result->Activate();
+                return result;
+            }});
+    }
+    presetPreloadCache->Preload(std::move(requests));
+}
+
+PresetPreloadStats PiPedalModel::GetPresetPreloadStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!presetPreloadCache)
+    {
+        return PresetPreloadStats();
+    }
+    return presetPreloadCache->GetStats();
+}
+
+std::vector<Lv2WorkerStats> PiPedalModel::GetLv2WorkerStats()
+{
+    return pluginHost.GetLv2WorkerStats();
+}
+
 bool PiPedalModel::LoadCurrentPedalboard()
 {
     CrashGuardLock crashGuardLock;
@@ -3098,18 +3274,28 @@ bool PiPedalModel::LoadCurrentPedalboard()
         // then we can send a snapshot update instead!
         Snapshot snapshot = pedalboard.MakeSnapshotFromCurrentSettings(previousPedalboard);
         audioHost->LoadSnapshot(snapshot, pluginHost);
+        audioHost->SetSnapshots(this->pedalboard.snapshots(), pluginHost);
         this->previousPedalboard = this->pedalboard;
         return true;
     }
 
-    Lv2PedalboardErrorList errorMessages;
-    std::shared_ptr<Lv2Pedalboard> lv2Pedalboard{this->pluginHost.CreateLv2Pedalboard(this->pedalboard, errorMessages)};
+    std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+    if (presetPreloadCache)
+    {
+        lv2Pedalboard = presetPreloadCache->Take(GetPresetPreloadKey(this->pedalboard));
+    }
+    if (!lv2Pedalboard)
+    {
+        Lv2PedalboardErrorList errorMessages;
+        lv2Pedalboard = std::shared_ptr<Lv2Pedalboard>{this->pluginHost.CreateLv2Pedalboard(this->pedalboard, errorMessages)};
+    }
     this->lv2Pedalboard = lv2Pedalboard;
 
     // apply the error messages to the lv2Pedalboard.
     // return true if the error messages have changed
     CheckForResourceInitialization(this->pedalboard);
     audioHost->SetPedalboard(lv2Pedalboard);
+    audioHost->SetSnapshots(this->pedalboard.snapshots(), pluginHost);
     previousPedalboard = this->pedalboard;
     previousPedalboardLoaded = true;
     return true;
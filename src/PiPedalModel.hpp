@@ -45,6 +45,7 @@
 #include "Tone3000Downloader.hpp"
 #include "Uri.hpp"
 #include "Tone3000Tone.hpp"
+#include "PresetPreloadCache.hpp"
 
 namespace pipedal
 {
@@ -78,6 +79,7 @@ namespace pipedal
         virtual void OnPluginPresetsChanged(const std::string &pluginUri) = 0;
         virtual void OnChannelRouterSettingsChanged(int64_t clientId, const ChannelRouterSettings &channelRouterSettings) = 0;
         virtual void OnVuMeterUpdate(const std::vector<VuUpdateX> &updates) = 0;
+        virtual void OnEffectCpuUseUpdate(const EffectCpuUpdate &update) = 0;
         virtual void OnBankIndexChanged(const BankIndex &bankIndex) = 0;
         virtual void OnJackServerSettingsChanged(const JackServerSettings &jackServerSettings) = 0;
         virtual void OnJackConfigurationChanged(const JackConfiguration &jackServerConfiguration) = 0;
@@ -210,6 +212,11 @@ namespace pipedal
         std::unique_ptr<AudioHost> audioHost;
         JackConfiguration jackConfiguration;
         std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+
+        std::unique_ptr<PresetPreloadCache<Lv2Pedalboard>> presetPreloadCache; // null if preloading is disabled.
+        int64_t preloadCurrentPresetId = -1;
+        int64_t preloadPreviousPresetId = -1;
+        void UpdatePresetPreloads();
         std::filesystem::path webRoot;
 
         using SubscriberList = std::vector<std::shared_ptr<IPiPedalModelSubscriber>>;
@@ -240,6 +247,8 @@ namespace pipedal
 
         std::vector<MonitorPortSubscription> activeMonitorPortSubscriptions;
 
+        int64_t effectCpuUseSubscriptions = 0;
+
         void UpdateRealtimeVuSubscriptions();
         void UpdateRealtimeMonitorPortSubscriptions();
 
@@ -255,12 +264,13 @@ namespace pipedal
         virtual void OnNotifyLv2StateChanged(uint64_t instanceId) override;
         virtual bool OnNotifyMaybeLv2StateChanged(uint64_t instanceId) override;
         virtual void OnNotifyVusSubscription(const std::vector<VuUpdateX> &updates) override;
+        virtual void OnNotifyEffectCpuUse(const EffectCpuUpdate &update) override;
         virtual void OnNotifyMonitorPort(const MonitorPortUpdate &update) override;
         virtual void OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value) override;
         virtual void OnNotifyMidiListen(uint8_t cc0, uint8_t cc1, uint8_t cc2) override;
         virtual void OnPatchSetReply(uint64_t instanceId, LV2_URID patchSetProperty, const LV2_Atom *atomValue) override;
         virtual void OnNotifyMidiRealtimeEvent(RealtimeMidiEventType eventType) override;
-        virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId) override;
+        virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId, bool appliedOnRealtimeThread) override;
         virtual void OnAlsaDriverTerminatedAbnormally() override;
         virtual void OnAlsaSequencerDeviceAdded(int client, const std::string &clientName) override;
         virtual void OnAlsaSequencerDeviceRemoved(int client) override;
@@ -405,7 +415,8 @@ namespace pipedal
         void UpdateCurrentPedalboard(int64_t clientId, Pedalboard &pedalboard);
 
         void SetSnapshots(std::vector<std::shared_ptr<Snapshot>> &snapshots, int64_t selectedSnapshot);
-        void SetSnapshot(int64_t selectedSnapshot);
+        // appliedOnRealtimeThread: the audio thread has already applied the snapshot's control values.
+        void SetSnapshot(int64_t selectedSnapshot, bool appliedOnRealtimeThread = false);
 
         void GetPresets(PresetIndex *pResult);
 
@@ -457,6 +468,13 @@ namespace pipedal
         int64_t AddVuSubscription(int64_t instanceId);
         void RemoveVuSubscription(int64_t subscriptionHandle);
 
+        // Per-effect execution times are only sent by the audio thread while there is at least one subscription.
+        void AddEffectCpuUseSubscription();
+        void RemoveEffectCpuUseSubscription();
+
+        PresetPreloadStats GetPresetPreloadStats();
+        std::vector<Lv2WorkerStats> GetLv2WorkerStats();
+
         void SetSystemMidiBindings(std::vector<MidiBinding> &bindings);
         std::vector<MidiBinding> GetSystemMidiBidings();
 
@@ -23,7 +23,6 @@
 #include "PiPedalSocket.hpp"
 #include "Updater.hpp"
 #include "json.hpp"
-#include "viewstream.hpp"
 #include "PiPedalVersion.hpp"
 #include "Tone3000Downloader.hpp"
 #include <atomic>
@@ -47,6 +46,7 @@
 #include <filesystem>
 #include "FileEntry.hpp"
 #include "Tone3000Downloader.hpp"
+#include "MonitorStream.hpp"
 
 using namespace std;
 using namespace pipedal;
@@ -416,6 +416,19 @@ JSON_MAP_REFERENCE(FileRequestArgs, relativePath)
 JSON_MAP_REFERENCE(FileRequestArgs, fileProperty)
 JSON_MAP_END()
 
+class MonitorStreamBody
+{
+public:
+    bool enabled_ = false;
+    uint32_t credits_ = 0;
+
+    DECLARE_JSON_MAP(MonitorStreamBody);
+};
+JSON_MAP_BEGIN(MonitorStreamBody)
+JSON_MAP_REFERENCE(MonitorStreamBody, enabled)
+JSON_MAP_REFERENCE(MonitorStreamBody, credits)
+JSON_MAP_END()
+
 class MonitorPortBody
 {
 public:
@@ -721,6 +734,8 @@ private:
 
     bool PingTone3000Server();
     std::vector<VuSubscription> activeVuSubscriptions;
+    bool effectCpuUseSubscribed = false;
+    bool effectCpuUseRequestOutstanding = false;
 
     struct PortMonitorSubscription
     {
@@ -763,6 +778,10 @@ private:
 
     std::mutex activePortMonitorsMutex;
     std::vector<std::shared_ptr<PortMonitorSubscription>> activePortMonitors;
+
+    // Binary VU/port value stream, for clients that have opted in with setMonitorStream.
+    // Other clients get JSON onVuUpdate/onMonitorPortOutput messages.
+    MonitorStream monitorStream;
     std::atomic<bool> closed = false;
 
 public:
@@ -793,6 +812,11 @@ public:
             model.RemoveVuSubscription(activeVuSubscriptions[i].subscriptionHandle);
         }
         activeVuSubscriptions.resize(0);
+        if (effectCpuUseSubscribed)
+        {
+            effectCpuUseSubscribed = false;
+            model.RemoveEffectCpuUseSubscription();
+        }
 
         model.RemoveNotificationSubsription(shared_from_this());
         // Warning: potentially deleted after return.
@@ -837,9 +861,12 @@ public:
     }
 
 private:
+    // Messages are formatted in a per-thread buffer which keeps its storage, so steady notification traffic
+    // (control changes, VU updates) doesn't allocate per message.
     void JsonReply(int replyTo, const char *message, const char *json)
     {
-        std::stringstream s(ios_base::out);
+        json_buffer_lease lease;
+        json_output_buffer &s = lease.buffer();
 
         json_writer writer(s, true);
 
@@ -862,7 +889,7 @@ private:
 
         {
             std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
+            this->send(s.view());
         }
     }
     // void JsonSend(const char *message, const char *json)
@@ -872,7 +899,8 @@ private:
     template <typename T>
     void Reply(int replyTo, const char *message, const T &value)
     {
-        std::stringstream s(ios_base::out);
+        json_buffer_lease lease;
+        json_output_buffer &s = lease.buffer();
 
         json_writer writer(s, true);
         writer.start_array();
@@ -893,14 +921,15 @@ private:
         writer.end_array();
         {
             std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
+            this->send(s.view());
         }
     }
     void Reply(int replyTo, const char *message)
     {
         if (replyTo == -1)
             return;
-        std::stringstream s(ios_base::out);
+        json_buffer_lease lease;
+        json_output_buffer &s = lease.buffer();
 
         json_writer writer(s, true);
         writer.start_array();
@@ -920,7 +949,7 @@ private:
 
         {
             std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
+            this->send(s.view());
         }
     }
 
@@ -1017,7 +1046,8 @@ public:
                 std::lock_guard<std::recursive_mutex> lock(requestMutex);
                 requestReservations.push_back(reservation);
             }
-            std::stringstream s(ios_base::out);
+            json_buffer_lease lease;
+            json_output_buffer &s = lease.buffer();
 
             json_writer writer(s, true);
             writer.start_array();
@@ -1035,7 +1065,7 @@ public:
             writer.end_array();
             {
                 std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-                this->send(s.str());
+                this->send(s.view());
             }
         }
         catch (const std::exception &e)
@@ -1081,24 +1111,51 @@ public:
         return result;
     }
 
+    void FlushMonitorStream()
+    {
+        monitorStream.Flush(
+            [this](const uint8_t *data, size_t size)
+            {
+                std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+                this->sendBinary(data, size);
+            });
+    }
+
     void SendMonitorPortMessage(std::shared_ptr<PortMonitorSubscription> &subscription, float value)
     {
         // running on RT_output thread, or on Socket thread.
+        bool streamed = false;
         {
             std::lock_guard lock{subscription->pmMutex};
             if (subscription->closed)
                 return;
             if (value == subscription->currentValue)
                 return;
-            if (subscription->waitingForAck)
+            if (monitorStream.IsEnabled())
+            {
+                // flow control is per-stream, not per-value: no ack.
+                subscription->currentValue = value;
+                subscription->lastValue = value;
+                monitorStream.PostPortValue(subscription->subscriptionHandle, value);
+                streamed = true;
+            }
+            else if (subscription->waitingForAck)
             {
                 subscription->pendingValue = true;
                 subscription->currentValue = value;
                 return;
             }
-            subscription->currentValue = value;
-            subscription->lastValue = value;
-            subscription->waitingForAck = true;
+            else
+            {
+                subscription->currentValue = value;
+                subscription->lastValue = value;
+                subscription->waitingForAck = true;
+            }
+        }
+        if (streamed)
+        {
+            FlushMonitorStream();
+            return;
         }
         SendMonitorPortMessage_Inner(subscription, value);
     }
@@ -1331,6 +1388,20 @@ public:
     }
     REGISTER_MESSAGE_HANDLER(getJackStatus)
 
+    void handle_getPresetPreloadStats(int replyTo, json_reader *pReader)
+    {
+        PresetPreloadStats stats = model.GetPresetPreloadStats();
+        this->Reply(replyTo, "getPresetPreloadStats", stats);
+    }
+    REGISTER_MESSAGE_HANDLER(getPresetPreloadStats)
+
+    void handle_getLv2WorkerStats(int replyTo, json_reader *pReader)
+    {
+        std::vector<Lv2WorkerStats> stats = model.GetLv2WorkerStats();
+        this->Reply(replyTo, "getLv2WorkerStats", stats);
+    }
+    REGISTER_MESSAGE_HANDLER(getLv2WorkerStats)
+
     void handle_getAlsaDevices(int replyTo, json_reader *pReader)
     {
         std::vector<AlsaDeviceInfo> devices = model.GetAlsaDevices();
@@ -1853,6 +1924,7 @@ public:
                     }
                 }
             }
+            monitorStream.RemoveSubscription(subscriptionHandle);
             model.UnmonitorPort(subscriptionHandle);
         }
     }
@@ -1890,10 +1962,73 @@ public:
                 }
             }
         }
+        monitorStream.RemoveSubscription(subscriptionHandle);
         model.RemoveVuSubscription(subscriptionHandle);
     }
     REGISTER_MESSAGE_HANDLER(removeVuSubscription)
 
+    void handle_setMonitorStream(int replyTo, json_reader *pReader)
+    {
+        MonitorStreamBody body;
+        pReader->read(&body);
+        if (body.enabled_)
+        {
+            monitorStream.Enable(body.credits_);
+        }
+        else
+        {
+            monitorStream.Disable();
+        }
+        this->Reply(replyTo, "setMonitorStream", true);
+    }
+    REGISTER_MESSAGE_HANDLER(setMonitorStream)
+
+    void handle_addMonitorStreamCredits(int replyTo, json_reader *pReader)
+    {
+        uint32_t credits = 0;
+        pReader->read(&credits);
+        monitorStream.AddCredits(credits);
+        // send anything that coalesced while the client was out of credits.
+        FlushMonitorStream();
+    }
+    REGISTER_MESSAGE_HANDLER(addMonitorStreamCredits)
+
+    void handle_addEffectCpuUseSubscription(int replyTo, json_reader *pReader)
+    {
+        bool added = false;
+        {
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            if (!effectCpuUseSubscribed)
+            {
+                effectCpuUseSubscribed = true;
+                added = true;
+            }
+        }
+        if (added)
+        {
+            model.AddEffectCpuUseSubscription();
+        }
+    }
+    REGISTER_MESSAGE_HANDLER(addEffectCpuUseSubscription)
+
+    void handle_removeEffectCpuUseSubscription(int replyTo, json_reader *pReader)
+    {
+        bool removed = false;
+        {
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            if (effectCpuUseSubscribed)
+            {
+                effectCpuUseSubscribed = false;
+                removed = true;
+            }
+        }
+        if (removed)
+        {
+            model.RemoveEffectCpuUseSubscription();
+        }
+    }
+    REGISTER_MESSAGE_HANDLER(removeEffectCpuUseSubscription)
+
     void handle_imageList(int replyTo, json_reader *pReader)
     {
         this->Reply(replyTo, "imageList", imageList);
@@ -2202,9 +2337,7 @@ protected:
     }
     virtual void onReceive(const std::string_view &text)
     {
-        view_istream<char> s(text);
-
-        json_reader reader(s);
+        json_reader reader(text);
         // read top level object until we have message
         int64_t replyTo = -1;
         int64_t reply = -1;
@@ -2413,6 +2546,21 @@ private:
     virtual void OnVuMeterUpdate(const std::vector<VuUpdateX> &updates)
     {
         std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+        if (monitorStream.IsEnabled())
+        {
+            for (const VuUpdateX &vuUpdate : updates)
+            {
+                for (const VuSubscription &subscription : activeVuSubscriptions)
+                {
+                    if (subscription.instanceId == vuUpdate.instanceId_)
+                    {
+                        monitorStream.PostVuUpdate(subscription.subscriptionHandle, vuUpdate);
+                    }
+                }
+            }
+            FlushMonitorStream();
+            return;
+        }
         if (updateRequestOutstanding < 1) // throttle to accomodate a web page that can't keep up.
         {
             vuUpdateDropped = false;
@@ -2455,6 +2603,27 @@ private:
         }
     }
 
+    virtual void OnEffectCpuUseUpdate(const EffectCpuUpdate &update)
+    {
+        std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+        if (!effectCpuUseSubscribed || effectCpuUseRequestOutstanding) // drop updates if the web page can't keep up.
+        {
+            return;
+        }
+        effectCpuUseRequestOutstanding = true;
+        this->Request<bool, EffectCpuUpdate>(
+            "onEffectCpuUse",
+            update,
+            [this](const bool &result)
+            {
+                this->effectCpuUseRequestOutstanding = false;
+            },
+            [this](const std::exception &)
+            {
+                this->effectCpuUseRequestOutstanding = false;
+            });
+    }
+
     virtual void OnVst3ControlChanged(int64_t clientId, int64_t instanceId, const std::string &key, float value, const std::string &state)
     {
         Vst3ControlChangedBody body;
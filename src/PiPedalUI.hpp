@@ -77,9 +77,12 @@ namespace pipedal
 
     class PluginHost;
     class ModFileTypes;
+    class Lv2PluginCache;
 
     class UiFileType
     {
+        friend class Lv2PluginCache;
+
     private:
         std::string label_;
         std::string mimeType_;
@@ -107,6 +110,8 @@ namespace pipedal
 
     class UiPortNotification
     {
+        friend class Lv2PluginCache;
+
     private:
         int32_t portIndex_;
         std::string symbol_;
@@ -124,6 +129,8 @@ namespace pipedal
     };
     class UiFileProperty
     {
+        friend class Lv2PluginCache;
+
     private:
         std::string label_;
         std::int32_t index_ = -1;
@@ -188,6 +195,8 @@ namespace pipedal
     };
     class UiFrequencyPlot
     {
+        friend class Lv2PluginCache;
+
     private:
         std::string patchProperty_;
         std::int32_t index_ = -1;
@@ -223,6 +232,8 @@ namespace pipedal
 
     class PiPedalUI
     {
+        friend class Lv2PluginCache;
+
     public:
         using ptr = std::shared_ptr<PiPedalUI>;
         PiPedalUI(PluginHost *pHost, const LilvNode *uiNode, const std::filesystem::path &resourcePath);
@@ -48,9 +48,12 @@
 #include <fstream>
 #include "PiPedalException.hpp"
 #include "StdErrorCapture.hpp"
+#include "Lv2PluginCache.hpp"
 #include "util.hpp"
 #include "ModFileTypes.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 #include "Locale.hpp"
 
@@ -107,7 +110,21 @@ void PluginHost::SetConfiguration(const PiPedalConfiguration &configuration)
 {
     this->vst3CachePath =
         std::filesystem::path(configuration.GetLocalStoragePath()) / "vst3cache.json";
+    this->lv2CachePath =
+        std::filesystem::path(configuration.GetLocalStoragePath()) / "lv2cache.bin";
     this->vst3Enabled = configuration.IsVst3Enabled();
+    this->lv2WorkerThreads = configuration.GetLv2WorkerThreads();
+    this->lv2WorkerPriority = configuration.GetLv2WorkerPriority();
+    this->hardBypass = configuration.GetHardBypass();
+    this->hardBypassSilenceSeconds = std::max(0.0f, configuration.GetHardBypassSilenceSeconds());
+    this->hardBypassThreshold = (float)std::pow(10.0, configuration.GetHardBypassThresholdDb() / 20.0);
+    this->skipSilentEffects = configuration.GetSkipSilentEffects();
+    this->silenceTailSeconds = std::max(0.0f, configuration.GetSilenceTailSeconds());
+    this->silenceThreshold = (float)std::pow(10.0, configuration.GetSilenceThresholdDb() / 20.0);
+    this->flightRecorderPeriods = (size_t)std::max(0, configuration.GetFlightRecorderPeriods());
+    this->flightRecorderReportPath =
+        (std::filesystem::path(configuration.GetLocalStoragePath()) / "xruns").string();
+    this->flightRecorderReports = (size_t)std::max(1, configuration.GetFlightRecorderReports());
 }
 
 void PluginHost::LilvUris::Initialize(LilvWorld *pWorld)
@@ -141,6 +158,7 @@ void PluginHost::LilvUris::Initialize(LilvWorld *pWorld)
     presets__preset = lilv_new_uri(pWorld, LV2_PRESETS__Preset);
     state__state = lilv_new_uri(pWorld, LV2_STATE__state);
     rdfs__label = lilv_new_uri(pWorld, LILV_NS_RDFS "label");
+    rdfs__seeAlso = lilv_new_uri(pWorld, LILV_NS_RDFS "seeAlso");
 
     lv2core__symbol = lilv_new_uri(pWorld, LV2_CORE__symbol);
     lv2core__name = lilv_new_uri(pWorld, LV2_CORE__name);
@@ -328,6 +346,71 @@ void PluginHost::OnConfigurationChanged(const JackConfiguration &configuration,
     this->channelSelection = channelSelection;
 }
 
+RealtimeWorkerPool *PluginHost::GetRealtimeWorkerPool()
+{
+    if (!parallelSplitChains && pipelineStages <= 1)
+    {
+        return nullptr;
+    }
+    // Created on first use, and never released before shutdown, since running pedalboards hold pointers to its workers.
+    std::lock_guard<std::mutex> lock(realtimeWorkerPoolMutex);
+    if (!realtimeWorkerPool)
+    {
+        realtimeWorkerPool = std::make_unique<RealtimeWorkerPool>();
+    }
+    return realtimeWorkerPool.get();
+}
+
+std::shared_ptr<HostWorkerPool> PluginHost::GetHostWorkerPool()
+{
+    // effects are also created by the preset preload thread.
+    std::lock_guard lock{hostWorkerPoolMutex};
+    if (!hostWorkerPool)
+    {
+        hostWorkerPool = std::make_shared<HostWorkerPool>(lv2WorkerThreads, lv2WorkerPriority);
+    }
+    return hostWorkerPool;
+}
+
+std::vector<Lv2WorkerStats> PluginHost::GetLv2WorkerStats()
+{
+    std::shared_ptr<HostWorkerPool> pool;
+    {
+        std::lock_guard lock{hostWorkerPoolMutex};
+        pool = hostWorkerPool;
+    }
+    if (!pool)
+    {
+        return std::vector<Lv2WorkerStats>();
+    }
+    return pool->GetStats();
+}
+
+double PluginHost::GetEffectCost(const std::string &uri)
+{
+    std::lock_guard lock{effectCostMutex};
+    auto f = effectCosts.find(uri);
+    if (f == effectCosts.end())
+    {
+        return -1;
+    }
+    return f->second;
+}
+
+void PluginHost::UpdateEffectCost(const std::string &uri, double averageUs)
+{
+    std::lock_guard lock{effectCostMutex};
+    auto f = effectCosts.find(uri);
+    if (f == effectCosts.end())
+    {
+        effectCosts[uri] = averageUs;
+    }
+    else
+    {
+        f->second = (f->second + averageUs) * 0.5;
+    }
+}
+
 PluginHost::~PluginHost()
 {
     delete lilvUris;
@@ -342,11 +425,17 @@ PluginHost::~PluginHost()
 
 void PluginHost::free_world()
 {
+    delete lilvUris;
+    lilvUris = nullptr;
+    delete mod_gui_uris;
+    mod_gui_uris = nullptr;
     if (pWorld)
     {
         lilv_world_free(pWorld);
         pWorld = nullptr;
     }
+    worldLoaded = false;
+    loadedBundles.clear();
 }
 std::shared_ptr<Lv2PluginClass> PluginHost::GetPluginClass(const std::string &uri) const
 {
@@ -418,6 +507,11 @@ void PluginHost::LoadPluginClassesFromLilv()
         // Get it to pre-populate the map.
         MakePluginClass(pClass);
     }
+    LinkPluginClasses();
+}
+
+void PluginHost::LinkPluginClasses()
+{
     for (auto value : classesMap)
     {
         std::shared_ptr<Lv2PluginClass> lv2Class{value.second};
@@ -438,46 +532,331 @@ void PluginHost::LoadPluginClassesFromLilv()
     }
 }
 
-void PluginHost::LoadLilv(const char *lv2Path)
+static std::string GetLilvBundlePath(const LilvPlugin *lilvPlugin)
 {
-
-    this->plugins_.clear();
-    this->ui_plugins_.clear();
-    if (!classesLoaded)
+    const LilvNode *bundleUriNode = lilv_plugin_get_bundle_uri(lilvPlugin);
+    if (!bundleUriNode)
     {
-        this->classesMap.clear();
+        return "";
+    }
+    char *lilvBundlePath = lilv_file_uri_parse(lilv_node_as_uri(bundleUriNode), nullptr);
+    if (!lilvBundlePath)
+    {
+        return "";
     }
+    std::string result = Lv2PluginCache::NormalizeBundlePath(lilvBundlePath);
+    lilv_free(lilvBundlePath);
+    return result;
+}
 
+void PluginHost::CreateWorld()
+{
     free_world();
 
-    Lv2Log::info("Scanning for LV2 Plugins");
-
-    setenv("LV2_PATH", lv2Path, true);
-    StdErrorCapture stdoutCapture; // captures lilv messages written to STDOUT.
     pWorld = lilv_world_new();
-    {
 
-        lilv_world_load_all(pWorld);
-    }
     // Not a safe pointer,because auto-deleting after freeWorld() would be death.
     this->mod_gui_uris = new ModGuiUris(pWorld, mapFeature);
 
-    // LilvNode*lv2_path = lilv_new_file_uri(pWorld,NULL,lv2Path);
-    // lilv_world_set_option(world,LILV_OPTION_LV2_PATH,lv)
-
     lilvUris = new LilvUris();
     lilvUris->Initialize(pWorld);
+}
 
-    const LilvPlugins *plugins = lilv_world_get_all_plugins(pWorld);
+void PluginHost::LoadWorld()
+{
+    if (worldLoaded)
+    {
+        return;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    if (!pWorld)
+    {
+        CreateWorld();
+    }
+    // bundles that have already been loaded individually are skipped by lilv.
+    lilv_world_load_all(pWorld);
+    worldLoaded = true;
+    loadedBundles.clear();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    Lv2Log::debug(SS("Loaded lilv world in " << ms << "ms."));
+}
+
+LilvWorld *PluginHost::getWorld()
+{
+    std::lock_guard lock{worldMutex};
+    LoadWorld();
+    return pWorld;
+}
+
+std::unique_lock<std::recursive_mutex> PluginHost::LockWorld()
+{
+    return std::unique_lock<std::recursive_mutex>(worldMutex);
+}
+
+void PluginHost::LoadBundle(const std::string &bundlePath)
+{
+    if (!loadedBundles.contains(bundlePath))
+    {
+        AutoLilvNode bundleUri = lilv_new_file_uri(pWorld, nullptr, (bundlePath + "/").c_str());
+        lilv_world_load_bundle(pWorld, bundleUri);
+        loadedBundles.insert(bundlePath);
+        Lv2Log::debug(SS("Loaded LV2 bundle " << bundlePath));
+    }
+}
+
+LilvWorld *PluginHost::GetWorldForPlugin(const std::string &pluginUri)
+{
+    std::lock_guard lock{worldMutex};
+    if (worldLoaded)
+    {
+        return pWorld;
+    }
+    auto pluginInfo = GetPluginInfo(pluginUri);
+    if (!pluginInfo || pluginInfo->bundle_path().empty())
+    {
+        LoadWorld();
+        return pWorld;
+    }
+    // presets may be declared in other bundles. If we don't know which ones, load everything.
+    auto fPresetBundles = presetBundles.find(pluginUri);
+    if (pluginInfo->has_factory_presets() && fPresetBundles == presetBundles.end())
+    {
+        LoadWorld();
+        return pWorld;
+    }
+    if (!pWorld)
+    {
+        CreateWorld();
+    }
+    LoadBundle(Lv2PluginCache::NormalizeBundlePath(pluginInfo->bundle_path()));
+    if (fPresetBundles != presetBundles.end())
+    {
+        for (const auto &bundlePath : fPresetBundles->second)
+        {
+            LoadBundle(bundlePath);
+        }
+    }
+    return pWorld;
+}
+
+bool PluginHost::GetPresetBundles(const LilvPlugin *lilvPlugin, const Lv2BundleStamps &bundleStamps, std::vector<std::string> *result)
+{
+    // Presets are declared in a bundle's manifest, with an rdfs:seeAlso link to the file that contains them.
+    // Returns false if the bundle of any preset can't be determined.
+    result->clear();
+    std::string pluginBundlePath = GetLilvBundlePath(lilvPlugin);
+    bool complete = true;
+    LilvNodes *presets = lilv_plugin_get_related(lilvPlugin, lilvUris->presets__preset);
+    if (!presets)
+    {
+        return true;
+    }
+    LILV_FOREACH(nodes, i, presets)
+    {
+        const LilvNode *preset = lilv_nodes_get(presets, i);
+        AutoLilvNodes files = lilv_world_find_nodes(pWorld, preset, lilvUris->rdfs__seeAlso, nullptr);
+        bool found = false;
+        LILV_FOREACH(nodes, iFile, files)
+        {
+            const LilvNode *file = lilv_nodes_get(files, iFile);
+            if (!lilv_node_is_uri(file))
+            {
+                continue;
+            }
+            char *filePath = lilv_file_uri_parse(lilv_node_as_uri(file), nullptr);
+            if (!filePath)
+            {
+                continue;
+            }
+            std::filesystem::path path = filePath;
+            lilv_free(filePath);
+            for (path = path.parent_path(); !path.empty() && path != path.root_path(); path = path.parent_path())
+            {
+                std::string bundlePath = Lv2PluginCache::NormalizeBundlePath(path.string());
+                if (bundleStamps.contains(bundlePath))
+                {
+                    found = true;
+                    if (bundlePath != pluginBundlePath && std::find(result->begin(), result->end(), bundlePath) == result->end())
+                    {
+                        result->push_back(bundlePath);
+                    }
+                    break;
+                }
+            }
+        }
+        if (!found)
+        {
+            complete = false;
+        }
+    }
+    lilv_nodes_free(presets);
+    return complete;
+}
+
+std::vector<std::shared_ptr<Lv2PluginInfo>> PluginHost::LoadPluginInfos(const std::string &lv2Path)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsedMs = [&startTime]()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    Lv2BundleStamps bundleStamps = Lv2PluginCache::GetBundleStamps(lv2Path);
+
+    Lv2PluginCache cache;
+    bool cacheValid = !lv2CachePath.empty() && cache.Load(lv2CachePath) && cache.lv2Path == lv2Path;
+    if (cacheValid && cache.bundleStamps == bundleStamps)
+    {
+        // Warm start. The lilv world isn't loaded until something actually needs it.
+        {
+            std::lock_guard lock{worldMutex};
+            free_world();
+            this->presetBundles = std::move(cache.presetBundles);
+        }
+        if (!classesLoaded)
+        {
+            for (const auto &pluginClass : cache.pluginClasses)
+            {
+                classesMap[pluginClass.uri] = std::make_shared<Lv2PluginClass>(
+                    pluginClass.displayName.c_str(), pluginClass.uri.c_str(), pluginClass.parentUri.c_str());
+            }
+            LinkPluginClasses();
+        }
+        Lv2Log::info(SS("Loaded " << cache.plugins.size() << " LV2 plugins from cache in " << elapsedMs() << "ms."));
+        return std::move(cache.plugins);
+    }
 
-    LoadPluginClassesFromLilv();
+    Lv2Log::info("Scanning for LV2 Plugins");
+
+    // Plugins from unchanged bundles are reused; everything else is built from lilv data.
+    std::map<std::string, std::shared_ptr<Lv2PluginInfo>> cachedPlugins;
+    size_t changedBundles = bundleStamps.size();
+    if (cacheValid)
+    {
+        changedBundles = 0;
+        for (const auto &bundleStamp : bundleStamps)
+        {
+            auto f = cache.bundleStamps.find(bundleStamp.first);
+            if (f == cache.bundleStamps.end() || f->second != bundleStamp.second)
+            {
+                ++changedBundles;
+            }
+        }
+        for (const auto &plugin : cache.plugins)
+        {
+            std::string bundlePath = Lv2PluginCache::NormalizeBundlePath(plugin->bundle_path());
+            auto fOld = cache.bundleStamps.find(bundlePath);
+            auto fNew = bundleStamps.find(bundlePath);
+            if (fOld != cache.bundleStamps.end() && fNew != bundleStamps.end() && fOld->second == fNew->second)
+            {
+                cachedPlugins[plugin->uri()] = plugin;
+            }
+        }
+    }
 
-    LILV_FOREACH(plugins, iPlugin, plugins)
+    std::vector<std::shared_ptr<Lv2PluginInfo>> result;
+    std::map<std::string, std::vector<std::string>> newPresetBundles;
+    size_t pluginsBuilt = 0;
     {
-        const LilvPlugin *lilvPlugin = lilv_plugins_get(plugins, iPlugin);
+        StdErrorCapture stdoutCapture; // captures lilv messages written to STDOUT.
+        {
+            std::lock_guard lock{worldMutex};
+            CreateWorld();
+            LoadWorld();
+        }
+
+        LoadPluginClassesFromLilv();
+
+        const LilvPlugins *plugins = lilv_world_get_all_plugins(pWorld);
 
-        std::shared_ptr<Lv2PluginInfo> pluginInfo = std::make_shared<Lv2PluginInfo>(this, pWorld, lilvPlugin);
+        LILV_FOREACH(plugins, iPlugin, plugins)
+        {
+            const LilvPlugin *lilvPlugin = lilv_plugins_get(plugins, iPlugin);
 
+            std::shared_ptr<Lv2PluginInfo> pluginInfo;
+            auto f = cachedPlugins.find(nodeAsString(lilv_plugin_get_uri(lilvPlugin)));
+            if (f != cachedPlugins.end() && Lv2PluginCache::NormalizeBundlePath(f->second->bundle_path()) == GetLilvBundlePath(lilvPlugin))
+            {
+                pluginInfo = f->second;
+            }
+            else
+            {
+                pluginInfo = std::make_shared<Lv2PluginInfo>(this, pWorld, lilvPlugin);
+                ++pluginsBuilt;
+            }
+            if (pluginInfo->has_factory_presets())
+            {
+                std::vector<std::string> bundles;
+                if (GetPresetBundles(lilvPlugin, bundleStamps, &bundles))
+                {
+                    newPresetBundles[pluginInfo->uri()] = std::move(bundles);
+                }
+            }
+            result.push_back(pluginInfo);
+        }
+        auto messages = stdoutCapture.GetOutputLines();
+
+        for (const std::string &s : messages)
+        {
+            if (s.length() != 0)
+            {
+                Lv2Log::info("lilv: " + s);
+            }
+        }
+    }
+    Lv2Log::info(SS(
+        "Scanned " << result.size() << " LV2 plugins in " << elapsedMs() << "ms. "
+                   << changedBundles << " of " << bundleStamps.size() << " bundles changed; "
+                   << pluginsBuilt << " plugins rebuilt."));
+
+    if (!lv2CachePath.empty())
+    {
+        try
+        {
+            Lv2PluginCache newCache;
+            newCache.lv2Path = lv2Path;
+            newCache.bundleStamps = std::move(bundleStamps);
+            for (const auto &pluginClass : classesMap)
+            {
+                newCache.pluginClasses.push_back(
+                    Lv2PluginCache::PluginClass{
+                        pluginClass.second->uri(),
+                        pluginClass.second->display_name(),
+                        pluginClass.second->parent_uri()});
+            }
+            newCache.plugins = result;
+            newCache.presetBundles = newPresetBundles;
+            newCache.Save(lv2CachePath);
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS("Unable to write LV2 plugin cache. " << e.what()));
+        }
+    }
+    {
+        std::lock_guard lock{worldMutex};
+        this->presetBundles = std::move(newPresetBundles);
+    }
+    return result;
+}
+
+void PluginHost::LoadLilv(const char *lv2Path)
+{
+
+    this->plugins_.clear();
+    this->ui_plugins_.clear();
+    if (!classesLoaded)
+    {
+        this->classesMap.clear();
+    }
+
+    setenv("LV2_PATH", lv2Path, true);
+
+    std::vector<std::shared_ptr<Lv2PluginInfo>> pluginInfos = LoadPluginInfos(lv2Path);
+
+    for (const auto &pluginInfo : pluginInfos)
+    {
         Lv2Log::debug("Plugin: " + pluginInfo->name());
 
         if (pluginInfo->hasCvPorts())
@@ -512,15 +891,6 @@ void PluginHost::LoadLilv(const char *lv2Path)
             this->plugins_.push_back(pluginInfo);
         }
     }
-    auto messages = stdoutCapture.GetOutputLines();
-
-    for (const std::string &s : messages)
-    {
-        if (s.length() != 0)
-        {
-            Lv2Log::info("lilv: " + s);
-        }
-    }
 
     auto collator = Locale::GetInstance()->GetCollator();
     auto compare = [&collator](
@@ -1543,6 +1913,7 @@ std::shared_ptr<Lv2PluginInfo> PluginHost::GetPluginInfo(const std::string &uri)
 
 Lv2Pedalboard *PluginHost::UpdateLv2PedalboardStructure(Pedalboard &pedalboard, Lv2Pedalboard *existingPedalboard, Lv2PedalboardErrorList &errorList)
 {
+    std::lock_guard lock{createPedalboardMutex};
     ExistingEffectMap existingEffects;
 
     if (existingPedalboard)
@@ -1570,6 +1941,7 @@ Lv2Pedalboard *PluginHost::UpdateLv2PedalboardStructure(Pedalboard &pedalboard,
 
 Lv2Pedalboard *PluginHost::CreateLv2Pedalboard(Pedalboard &pedalboard, Lv2PedalboardErrorList &errorMessages)
 {
+    std::lock_guard lock{createPedalboardMutex};
     Lv2Pedalboard *pPedalboard = new Lv2Pedalboard();
     try
     {
@@ -1612,7 +1984,9 @@ std::vector<ControlValue> PluginHost::LoadFactoryPluginPreset(
 
     std::vector<ControlValue> result;
 
-    const LilvPlugins *plugins = lilv_world_get_all_plugins(this->pWorld);
+    std::lock_guard lock{worldMutex};
+    LilvWorld *pWorld = GetWorldForPlugin(pedalboardItem->uri());
+    const LilvPlugins *plugins = lilv_world_get_all_plugins(pWorld);
 
     AutoLilvNode uriNode = lilv_new_uri(pWorld, pedalboardItem->uri().c_str());
 
@@ -1897,7 +2271,9 @@ bool Lv2PluginInfo::IsPathProperty(const std::string &uri) const {
 
 PluginPresets PluginHost::GetFactoryPluginPresets(const std::string &pluginUri)
 {
-    const LilvPlugins *plugins = lilv_world_get_all_plugins(this->pWorld);
+    std::lock_guard lock{worldMutex};
+    LilvWorld *pWorld = GetWorldForPlugin(pluginUri);
+    const LilvPlugins *plugins = lilv_world_get_all_plugins(pWorld);
 
     AutoLilvNode uriNode = lilv_new_uri(pWorld, pluginUri.c_str());
 
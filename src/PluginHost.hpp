@@ -44,6 +44,9 @@
 #include "MapPathFeature.hpp"
 #include "ModGui.hpp"
 #include "ChannelRouterSettings.hpp"
+#include "RealtimeWorkerPool.hpp"
+#include "Worker.hpp"
+#include "Lv2PluginCache.hpp"
 
 namespace pipedal
 {
@@ -56,6 +59,7 @@ namespace pipedal
     class JackConfiguration;
     class JackChannelSelection;
     class ChannelRouterSettings;
+    class Lv2PluginCache;
 
 #ifndef LV2_PROPERTY_GETSET
 #define LV2_PROPERTY_GETSET(name)             \
@@ -169,6 +173,7 @@ namespace pipedal
         std::string label_;
 
     public:
+        friend class Lv2PluginCache;
         Lv2ScalePoint() {}
         Lv2ScalePoint(float value, std::string label)
             : value_(value), label_(label)
@@ -196,6 +201,7 @@ namespace pipedal
 
     private:
         friend class Lv2PluginInfo;
+        friend class Lv2PluginCache;
 
         uint32_t index_;
         std::string symbol_;
@@ -351,6 +357,7 @@ namespace pipedal
         std::vector<std::string> supportedExtensions_;
 
     public:
+        friend class Lv2PluginCache;
         Lv2PatchPropertyInfo() {}
         Lv2PatchPropertyInfo(PluginHost *pluginHost, const LilvNode *propertyUri);
 
@@ -394,6 +401,7 @@ namespace pipedal
     {
     private:
         friend class PluginHost;
+        friend class Lv2PluginCache;
 
     public:
         using ptr = std::shared_ptr<Lv2PluginInfo>;
@@ -821,6 +829,7 @@ namespace pipedal
             AutoLilvNode presets__preset;
             AutoLilvNode state__state;
             AutoLilvNode rdfs__label;
+            AutoLilvNode rdfs__seeAlso;
             AutoLilvNode lv2core__symbol;
             AutoLilvNode lv2core__name;
             AutoLilvNode lv2core__shortName;
@@ -905,6 +914,29 @@ namespace pipedal
         size_t maxAtomBufferSize = 16 * 1024;
         bool hasMidiInputChannel;
         ChannelSelection channelSelection;
+        bool parallelSplitChains = false;
+        size_t pipelineStages = 1;
+        std::mutex realtimeWorkerPoolMutex;
+        std::unique_ptr<RealtimeWorkerPool> realtimeWorkerPool;
+
+        size_t lv2WorkerThreads = HostWorkerPool::DEFAULT_THREAD_COUNT;
+        int lv2WorkerPriority = HostWorkerPool::DEFAULT_REALTIME_PRIORITY;
+        bool hardBypass = false;
+        double hardBypassSilenceSeconds = 1.0;
+        float hardBypassThreshold = 3.1623e-5f; // -90 dB
+        bool skipSilentEffects = false;
+        double silenceTailSeconds = 5.0;
+        float silenceThreshold = 1e-6f; // -120 dB
+        size_t flightRecorderPeriods = 4096;
+        std::string flightRecorderReportPath;
+        size_t flightRecorderReports = 20;
+        std::mutex hostWorkerPoolMutex;
+        std::shared_ptr<HostWorkerPool> hostWorkerPool;
+
+        std::mutex createPedalboardMutex; // pedalboards are also created by the preset preload thread.
+
+        std::mutex effectCostMutex;
+        std::map<std::string, double> effectCosts;
 
         double sampleRate = 48000;
 
@@ -924,6 +956,20 @@ namespace pipedal
         LilvWorld *pWorld;
         void free_world();
 
+        // The lilv world is loaded lazily when the plugin catalogue comes from the plugin cache.
+        std::recursive_mutex worldMutex;
+        bool worldLoaded = false;
+        std::set<std::string> loadedBundles;
+        // Other bundles that declare presets for a plugin, indexed by plugin uri. See Lv2PluginCache::presetBundles.
+        std::map<std::string, std::vector<std::string>> presetBundles;
+        std::filesystem::path lv2CachePath;
+
+        void CreateWorld();
+        void LoadWorld();
+        void LoadBundle(const std::string &bundlePath);
+        bool GetPresetBundles(const LilvPlugin *lilvPlugin, const Lv2BundleStamps &bundleStamps, std::vector<std::string> *result);
+        std::vector<std::shared_ptr<Lv2PluginInfo>> LoadPluginInfos(const std::string &lv2Path);
+
         std::vector<std::shared_ptr<Lv2PluginInfo>> plugins_;
         std::map<std::string, std::shared_ptr<Lv2PluginInfo>> pluginsByUri;
         std::vector<Lv2PluginUiInfo> ui_plugins_;
@@ -959,10 +1005,11 @@ namespace pipedal
         {
             Lv2Log::debug(message);
         }
-        virtual LilvWorld *getWorld()
-        {
-            return pWorld;
-        }
+        // Loads all LV2 bundles, if they haven't been loaded yet.
+        virtual LilvWorld *getWorld() override;
+        // Loads only the plugin's bundle, if the plugin catalogue came from the plugin cache.
+        virtual LilvWorld *GetWorldForPlugin(const std::string &pluginUri) override;
+        virtual std::unique_lock<std::recursive_mutex> LockWorld() override;
 
     private:
         // IHost implementation.
@@ -972,6 +1019,21 @@ namespace pipedal
         virtual bool HasMidiInputChannel() const override  { return hasMidiInputChannel; }
         virtual LV2_Feature *const *GetLv2Features() const override { return (LV2_Feature *const *)&(this->lv2Features[0]); }
         virtual const ChannelSelection &GetChannelSelection() const override { return this->channelSelection; }
+        virtual RealtimeWorkerPool *GetRealtimeWorkerPool() override;
+        virtual std::shared_ptr<HostWorkerPool> GetHostWorkerPool() override;
+        virtual bool GetParallelSplitChains() const override { return parallelSplitChains; }
+        virtual size_t GetPipelineStages() const override { return pipelineStages; }
+        virtual bool GetHardBypass() const override { return hardBypass; }
+        virtual double GetHardBypassSilenceSeconds() const override { return hardBypassSilenceSeconds; }
+        virtual float GetHardBypassThreshold() const override { return hardBypassThreshold; }
+        virtual bool GetSkipSilentEffects() const override { return skipSilentEffects; }
+        virtual double GetSilenceTailSeconds() const override { return silenceTailSeconds; }
+        virtual float GetSilenceThreshold() const override { return silenceThreshold; }
+        virtual size_t GetFlightRecorderPeriods() const override { return flightRecorderPeriods; }
+        virtual std::string GetFlightRecorderReportPath() const override { return flightRecorderReportPath; }
+        virtual size_t GetFlightRecorderReports() const override { return flightRecorderReports; }
+        virtual double GetEffectCost(const std::string &uri) override;
+        virtual void UpdateEffectCost(const std::string &uri, double averageUs) override;
 
     public:
         virtual MapFeature &GetMapFeature() override { return this->mapFeature; }
@@ -1006,6 +1068,7 @@ namespace pipedal
 
         virtual IEffect *CreateEffect(PedalboardItem &pedalboardItem);
         void LoadPluginClassesFromLilv();
+        void LinkPluginClasses();
         void AddJsonClassesToMap(std::shared_ptr<Lv2PluginClass> pluginClass);
 
     public:
@@ -1038,6 +1101,11 @@ namespace pipedal
         ModGuiUris *mod_gui_uris = nullptr;
 
         void OnConfigurationChanged(const JackConfiguration &configuration, const ChannelSelection &channelSelection);
+        void SetParallelSplitChains(bool value) { parallelSplitChains = value; }
+
+        // Per-plugin-instance LV2 worker statistics.
+        std::vector<Lv2WorkerStats> GetLv2WorkerStats();
+        void SetPipelineStages(size_t value) { pipelineStages = std::max(value, (size_t)1); }
 
 
         std::shared_ptr<Lv2PluginClass> GetPluginClass(const std::string &uri) const;
@@ -0,0 +1,48 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "PresetPreloadCache.hpp"
+#include <fstream>
+#include <unistd.h>
+
+using namespace pipedal;
+
+uint64_t pipedal::GetProcessResidentBytes()
+{
+    std::ifstream f("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (!(f >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+JSON_MAP_BEGIN(PresetPreloadStats)
+JSON_MAP_REFERENCE(PresetPreloadStats, hits)
+JSON_MAP_REFERENCE(PresetPreloadStats, misses)
+JSON_MAP_REFERENCE(PresetPreloadStats, builds)
+JSON_MAP_REFERENCE(PresetPreloadStats, failures)
+JSON_MAP_REFERENCE(PresetPreloadStats, evictions)
+JSON_MAP_REFERENCE(PresetPreloadStats, preloaded)
+JSON_MAP_REFERENCE(PresetPreloadStats, memoryBytes)
+JSON_MAP_REFERENCE(PresetPreloadStats, memoryBudgetBytes)
+JSON_MAP_END()
@@ -0,0 +1,314 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    class PresetPreloadStats
+    {
+    public:
+        uint64_t hits_ = 0;
+        uint64_t misses_ = 0;
+        uint64_t builds_ = 0;    // pedalboards built in the background.
+        uint64_t failures_ = 0;  // builds that failed, or that didn't fit in the memory budget.
+        uint64_t evictions_ = 0; // preloaded pedalboards that were discarded without being used.
+        uint64_t preloaded_ = 0; // pedalboards currently preloaded.
+        uint64_t memoryBytes_ = 0;
+        uint64_t memoryBudgetBytes_ = 0;
+
+        double GetHitRate() const { return hits_ + misses_ == 0 ? 0 : (double)hits_ / (hits_ + misses_); }
+
+        DECLARE_JSON_MAP(PresetPreloadStats);
+    };
+
+    // Resident set size of the current process, or 0 if not available.
+    uint64_t GetProcessResidentBytes();
+
+    /**
+     * @brief Builds pedalboards for presets that are likely to be selected next, on a background thread.
+     *
+     * Entries are identified by a key that captures everything the build depends on (the caller uses
+     * the serialized pedalboard), so a preset that has been edited since it was preloaded simply misses.
+     *
+     * The memory cost of an entry is estimated from the growth of the process's resident set
+     * while it is built. Entries that don't fit in the memory budget are discarded.
+     */
+    template <typename T>
+    class PresetPreloadCache
+    {
+    public:
+        using Builder = std::function<std::shared_ptr<T>()>; // returns null if the build failed.
+
+        struct Request
+        {
+            std::string key;
+            Builder build;
+        };
+
+        PresetPreloadCache(uint64_t memoryBudgetBytes, std::function<uint64_t()> getMemoryUsage = GetProcessResidentBytes)
+            : getMemoryUsage(std::move(getMemoryUsage))
+        {
+            stats.memoryBudgetBytes_ = memoryBudgetBytes;
+            thread = std::thread([this]()
+                                 { ThreadProc(); });
+        }
+        ~PresetPreloadCache()
+        {
+            {
+                std::lock_guard lock(mutex);
+                closed = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+        PresetPreloadCache(const PresetPreloadCache &) = delete;
+        PresetPreloadCache &operator=(const PresetPreloadCache &) = delete;
+
+        // Replace the set of pedalboards to preload, in priority order. Preloaded pedalboards that are no longer wanted are discarded.
+        void Preload(std::vector<Request> &&requests)
+        {
+            {
+                std::lock_guard lock(mutex);
+                this->requests = std::move(requests);
+                for (auto i = entries.begin(); i != entries.end();)
+                {
+                    if (FindRequest(i->key) == nullptr)
+                    {
+                        ++stats.evictions_;
+                        Discard(i);
+                        i = entries.erase(i);
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+            }
+            cv.notify_all();
+        }
+
+        // Remove and return the preloaded pedalboard for key, or null if there isn't one.
+        std::shared_ptr<T> Take(const std::string &key)
+        {
+            std::lock_guard lock(mutex);
+            RemoveRequest(key);
+            for (auto i = entries.begin(); i != entries.end(); ++i)
+            {
+                if (i->key == key)
+                {
+                    ++stats.hits_;
+                    stats.memoryBytes_ -= i->memoryBytes;
+                    std::shared_ptr<T> result = std::move(i->value);
+                    entries.erase(i);
+                    return result;
+                }
+            }
+            ++stats.misses_;
+            return nullptr;
+        }
+
+        // Discard everything (e.g. because the audio configuration is about to change). Waits for a build that's in progress to complete.
+        void Clear()
+        {
+            {
+                std::unique_lock lock(mutex);
+                requests.clear();
+                for (auto i = entries.begin(); i != entries.end(); ++i)
+                {
+                    ++stats.evictions_;
+                    Discard(i);
+                }
+                entries.clear();
+                ++generation; // discard a build that's in progress.
+                cv.notify_all();
+                cv.wait(lock, [this]()
+                        { return closed || !building; });
+            }
+            cv.notify_all();
+        }
+
+        PresetPreloadStats GetStats() const
+        {
+            std::lock_guard lock(mutex);
+            PresetPreloadStats result = stats;
+            result.preloaded_ = entries.size();
+            return result;
+        }
+
+        // Wait until there's no more preloading to do. For testing.
+        void WaitForIdle()
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [this]()
+                    { return closed || (!building && GetNextRequest() == nullptr && discarded.empty()); });
+        }
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            std::shared_ptr<T> value;
+            uint64_t memoryBytes = 0;
+        };
+
+        const Request *FindRequest(const std::string &key) const
+        {
+            for (const auto &request : requests)
+            {
+                if (request.key == key)
+                {
+                    return &request;
+                }
+            }
+            return nullptr;
+        }
+        void RemoveRequest(const std::string &key)
+        {
+            for (auto i = requests.begin(); i != requests.end(); ++i)
+            {
+                if (i->key == key)
+                {
+                    requests.erase(i);
+                    return;
+                }
+            }
+        }
+        bool IsPreloaded(const std::string &key) const
+        {
+            for (const auto &entry : entries)
+            {
+                if (entry.key == key)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        const Request *GetNextRequest() const
+        {
+            if (stats.memoryBytes_ >= stats.memoryBudgetBytes_)
+            {
+                return nullptr;
+            }
+            for (const auto &request : requests)
+            {
+                if (!IsPreloaded(request.key))
+                {
+                    return &request;
+                }
+            }
+            return nullptr;
+        }
+        void Discard(typename std::vector<Entry>::iterator i)
+        {
+            // destroyed on the background thread, since deleting plugins can be slow too.
+            stats.memoryBytes_ -= i->memoryBytes;
+            discarded.push_back(std::move(i->value));
+        }
+
+        void ThreadProc()
+        {
+            std::unique_lock lock(mutex);
+            while (true)
+            {
+                cv.wait(lock, [this]()
+                        { return closed || !discarded.empty() || GetNextRequest() != nullptr; });
+                if (closed)
+                {
+                    break;
+                }
+                if (!discarded.empty())
+                {
+                    std::vector<std::shared_ptr<T>> t = std::move(discarded);
+                    discarded.clear();
+                    lock.unlock();
+                    t.clear();
+                    lock.lock();
+                    cv.notify_all();
+                    continue;
+                }
+                Request request = *GetNextRequest();
+                uint64_t buildGeneration = this->generation;
+                building = true;
+                lock.unlock();
+
+                uint64_t memoryBefore = getMemoryUsage();
+                std::shared_ptr<T> value;
+                try
+                {
+                    value = request.build();
+                }
+                catch (const std::exception &)
+                {
+                }
+                uint64_t memoryAfter = getMemoryUsage();
+                uint64_t memoryBytes = memoryAfter > memoryBefore ? memoryAfter - memoryBefore : 0;
+
+                lock.lock();
+                building = false;
+                ++stats.builds_;
+                if (!value || stats.memoryBytes_ + memoryBytes > stats.memoryBudgetBytes_)
+                {
+                    // don't try again until the next Preload().
+                    ++stats.failures_;
+                    RemoveRequest(request.key);
+                    discarded.push_back(std::move(value));
+                }
+                else if (buildGeneration != this->generation || FindRequest(request.key) == nullptr)
+                {
+                    ++stats.evictions_;
+                    discarded.push_back(std::move(value));
+                }
+                else
+                {
+                    stats.memoryBytes_ += memoryBytes;
+                    entries.push_back(Entry{request.key, std::move(value), memoryBytes});
+                }
+                cv.notify_all();
+            }
+            std::vector<std::shared_ptr<T>> t = std::move(discarded);
+            discarded.clear();
+            lock.unlock();
+        }
+
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::function<uint64_t()> getMemoryUsage;
+        std::vector<Request> requests;
+        std::vector<Entry> entries;
+        std::vector<std::shared_ptr<T>> discarded;
+        PresetPreloadStats stats;
+        uint64_t generation = 0;
+        bool building = false;
+        bool closed = false;
+        std::thread thread;
+    };
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PresetPreloadCache.hpp"
+#include <atomic>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    struct TestPedalboard
+    {
+        TestPedalboard(std::string name, std::atomic<int> *liveCount) : name(std::move(name)), liveCount(liveCount) { ++*liveCount; }
+        ~TestPedalboard() { --*liveCount; }
+        std::string name;
+        std::atomic<int> *liveCount;
+    };
+
+    // Each build "uses" a fixed amount of memory.
+    struct TestEnvironment
+    {
+        std::atomic<int> liveCount{0};
+        std::atomic<uint64_t> memory{0};
+        std::atomic<int> buildCount{0};
+        uint64_t memoryPerBuild = 1000;
+
+        PresetPreloadCache<TestPedalboard>::Request MakeRequest(const std::string &key, bool fail = false)
+        {
+            return PresetPreloadCache<TestPedalboard>::Request{
+                key,
+                [this, key, fail]() -> std::shared_ptr<TestPedalboard>
+                {
+                    ++buildCount;
+                    if (fail)
+                    {
+                        return nullptr;
+                    }
+                    memory += memoryPerBuild;
+                    return std::make_shared<TestPedalboard>(key, &liveCount);
+                }};
+        }
+        std::function<uint64_t()> GetMemoryUsage()
+        {
+            return [this]()
+            { return memory.load(); };
+        }
+    };
+}
+
+TEST_CASE("Preset preload cache hits and misses", "[preset_preload_cache][Build]")
+{
+    TestEnvironment environment;
+    {
+        PresetPreloadCache<TestPedalboard> cache(10000, environment.GetMemoryUsage());
+        std::vector<PresetPreloadCache<TestPedalboard>::Request> requests;
+        requests.push_back(environment.MakeRequest("next"));
+        requests.push_back(environment.MakeRequest("previous"));
+        cache.Preload(std::move(requests));
+        cache.WaitForIdle();
+
+        PresetPreloadStats stats = cache.GetStats();
+        REQUIRE(stats.preloaded_ == 2);
+        REQUIRE(stats.builds_ == 2);
+        REQUIRE(stats.memoryBytes_ == 2000);
+
+        auto pedalboard = cache.Take("next");
+        REQUIRE(pedalboard);
+        REQUIRE(pedalboard->name == "next");
+        REQUIRE(!cache.Take("next"));       // taken already.
+        REQUIRE(!cache.Take("elsewhere")); // never requested.
+
+        stats = cache.GetStats();
+        REQUIRE(stats.hits_ == 1);
+        REQUIRE(stats.misses_ == 2);
+        REQUIRE(stats.preloaded_ == 1);
+        REQUIRE(stats.memoryBytes_ == 1000);
+        REQUIRE(stats.GetHitRate() == Approx(1.0 / 3));
+
+        // the taken pedalboard is not rebuilt.
+        cache.WaitForIdle();
+        REQUIRE(environment.buildCount == 2);
+    }
+    REQUIRE(environment.liveCount == 0);
+}
+
+TEST_CASE("Preset preload cache eviction", "[preset_preload_cache][Build]")
+{
+    TestEnvironment environment;
+    PresetPreloadCache<TestPedalboard> cache(10000, environment.GetMemoryUsage());
+
+    std::vector<PresetPreloadCache<TestPedalboard>::Request> requests;
+    requests.push_back(environment.MakeRequest("a"));
+    requests.push_back(environment.MakeRequest("b"));
+    cache.Preload(std::move(requests));
+    cache.WaitForIdle();
+    REQUIRE(environment.liveCount == 2);
+
+    // "a" is no longer a neighbour; "b" is kept without being rebuilt.
+    requests.clear();
+    requests.push_back(environment.MakeRequest("b"));
+    requests.push_back(environment.MakeRequest("c"));
+    cache.Preload(std::move(requests));
+    cache.WaitForIdle();
+
+    PresetPreloadStats stats = cache.GetStats();
+    REQUIRE(stats.evictions_ == 1);
+    REQUIRE(stats.preloaded_ == 2);
+    REQUIRE(environment.buildCount == 3);
+    REQUIRE(environment.liveCount == 2);
+    REQUIRE(!cache.Take("a"));
+    REQUIRE(cache.Take("c"));
+
+    cache.Clear();
+    cache.WaitForIdle();
+    stats = cache.GetStats();
+    REQUIRE(stats.preloaded_ == 0);
+    REQUIRE(stats.memoryBytes_ == 0);
+    REQUIRE(environment.liveCount == 0);
+}
+
+TEST_CASE("Preset preload cache memory budget", "[preset_preload_cache][Build]")
+{
+    TestEnvironment environment;
+    PresetPreloadCache<TestPedalboard> cache(2500, environment.GetMemoryUsage());
+
+    std::vector<PresetPreloadCache<TestPedalboard>::Request> requests;
+    requests.push_back(environment.MakeRequest("a"));
+    requests.push_back(environment.MakeRequest("failed", true));
+    requests.push_back(environment.MakeRequest("b"));
+    requests.push_back(environment.MakeRequest("c"));
+    requests.push_back(environment.MakeRequest("d"));
+    cache.Preload(std::move(requests));
+    cache.WaitForIdle();
+
+    // neither "c" nor "d" fit.
+    PresetPreloadStats stats = cache.GetStats();
+    REQUIRE(stats.preloaded_ == 2);
+    REQUIRE(stats.memoryBytes_ == 2000);
+    REQUIRE(stats.failures_ == 3);
+    REQUIRE(environment.buildCount == 5);
+    auto a = cache.Take("a");
+    auto b = cache.Take("b");
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(!cache.Take("failed"));
+    REQUIRE(!cache.Take("c"));
+    cache.WaitForIdle();
+    REQUIRE(environment.liveCount == 2);
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "RealtimeWorkerPool.hpp"
+#include "SchedulerPriority.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+static inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+RealtimeWorker::RealtimeWorker(int index, const char *threadName)
+    : index(index), threadName(threadName)
+{
+    thread = std::make_unique<std::jthread>([this]()
+                                            { ThreadProc(); });
+}
+
+RealtimeWorker::~RealtimeWorker()
+{
+    Close();
+}
+
+void RealtimeWorker::Close()
+{
+    if (thread)
+    {
+        closing.store(true, std::memory_order_release);
+        requestSequence.fetch_add(1, std::memory_order_release);
+        requestSequence.notify_one();
+        thread->join();
+        thread = nullptr;
+    }
+}
+
+void RealtimeWorker::Post(JobFunction fn, void *data, uint32_t frames)
+{
+    this->jobFunction = fn;
+    this->jobData = data;
+    this->jobFrames = frames;
+    // release: publishes the job parameters (and the job's input buffers) to the worker.
+    requestSequence.fetch_add(1, std::memory_order_release);
+    requestSequence.notify_one();
+}
+
+void RealtimeWorker::Wait()
+{
+    uint32_t target = requestSequence.load(std::memory_order_relaxed);
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (completedSequence.load(std::memory_order_acquire) == target)
+        {
+            return;
+        }
+        CpuRelax();
+    }
+    while (true)
+    {
+        uint32_t completed = completedSequence.load(std::memory_order_acquire);
+        if (completed == target)
+        {
+            return;
+        }
+        completedSequence.wait(completed, std::memory_order_acquire);
+    }
+}
+
+void RealtimeWorker::ThreadProc()
+{
+    SetThreadName(SS(threadName << index));
+    SetThreadPriority(SchedulerPriority::RealtimeAudio);
+
+    uint32_t lastRequest = 0;
+    while (true)
+    {
+        uint32_t request = requestSequence.load(std::memory_order_acquire);
+        for (int i = 0; i < SPIN_COUNT && request == lastRequest; ++i)
+        {
+            CpuRelax();
+            request = requestSequence.load(std::memory_order_acquire);
+        }
+        if (request == lastRequest)
+        {
+            requestSequence.wait(lastRequest, std::memory_order_acquire);
+            continue;
+        }
+        lastRequest = request;
+        if (closing.load(std::memory_order_acquire))
+        {
+            break;
+        }
+        jobFunction(jobData, jobFrames);
+
+        // release: publishes the job's output buffers to the waiting thread.
+        completedSequence.store(request, std::memory_order_release);
+        completedSequence.notify_one();
+    }
+}
+
+size_t RealtimeWorkerPool::DefaultWorkerCount()
+{
+    size_t nCores = std::thread::hardware_concurrency();
+    if (nCores <= 1)
+    {
+        return 1;
+    }
+    return std::min(nCores - 1, (size_t)3);
+}
+
+RealtimeWorkerPool::RealtimeWorkerPool(size_t nWorkers)
+    : workerCount(nWorkers)
+{
+    // enough for the first pedalboard. Pedalboards that overlap it get more as they need them.
+    for (size_t i = 0; i < nWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<RealtimeWorker>((int)i));
+        freeWorkers.push_back(workers.back().get());
+    }
+    std::reverse(freeWorkers.begin(), freeWorkers.end()); // worker 0 is handed out first.
+    Lv2Log::debug(SS("RealtimeWorkerPool: " << nWorkers << " worker(s) started."));
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    for (auto &worker : workers)
+    {
+        worker->Close();
+    }
+}
+
+size_t RealtimeWorkerPool::GetThreadCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return workers.size();
+}
+
+RealtimeWorker *RealtimeWorkerPool::AcquireWorker()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeWorkers.empty())
+    {
+        workers.push_back(std::make_unique<RealtimeWorker>((int)workers.size()));
+        Lv2Log::debug(SS("RealtimeWorkerPool: " << workers.size() << " worker(s) started."));
+        return workers.back().get();
+    }
+    // most recently used first, since its thread is most likely to still be spinning.
+    RealtimeWorker *result = freeWorkers.back();
+    freeWorkers.pop_back();
+    return result;
+}
+
+void RealtimeWorkerPool::ReleaseWorker(RealtimeWorker *worker)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    freeWorkers.push_back(worker);
+}
+
+RealtimeWorkerPool::WorkerSet::WorkerSet(RealtimeWorkerPool *pool)
+    : pool(pool), workers(pool->GetWorkerCount(), nullptr)
+{
+}
+
+RealtimeWorkerPool::WorkerSet::~WorkerSet()
+{
+    // release in reverse, so that the next set gets the same workers in the same order.
+    for (auto i = workers.rbegin(); i != workers.rend(); ++i)
+    {
+        if (*i != nullptr)
+        {
+            pool->ReleaseWorker(*i);
+        }
+    }
+}
+
+RealtimeWorker *RealtimeWorkerPool::WorkerSet::GetWorker(size_t index)
+{
+    RealtimeWorker *&worker = workers.at(index);
+    if (worker == nullptr)
+    {
+        worker = pool->AcquireWorker();
+    }
+    return worker;
+}
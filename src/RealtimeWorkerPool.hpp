@@ -0,0 +1,139 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+
+    /**
+     * @brief A small pool of realtime helper threads for the audio thread.
+     *
+     * Each RealtimeWorker executes at most one job at a time. The audio thread posts a job
+     * with Post(), does its own share of the work, and then joins with Wait(). Post() and
+     * Wait() are lock-free, and do not allocate memory. Workers spin briefly before falling
+     * back to a futex wait, so a job posted once per audio period is usually picked up
+     * without a kernel round trip.
+     *
+     * Worker threads run with realtime audio priority.
+     *
+     * Callers must guarantee that a given worker is never used by two jobs at once. Each Lv2Pedalboard
+     * reserves its own RealtimeWorkerPool::WorkerSet when it becomes the current pedalboard, and
+     * assigns each parallel split section and pipeline stage its own worker from that set.
+     */
+    class RealtimeWorker
+    {
+    public:
+        using JobFunction = void (*)(void *data, uint32_t frames);
+
+        RealtimeWorker(int index, const char *threadName = "rtworker");
+        ~RealtimeWorker();
+
+        RealtimeWorker(const RealtimeWorker &) = delete;
+        RealtimeWorker &operator=(const RealtimeWorker &) = delete;
+
+        // audio thread.
+        void Post(JobFunction fn, void *data, uint32_t frames);
+        // audio thread. Returns once the job posted by the last call to Post() has completed.
+        void Wait();
+
+        void Close();
+
+    private:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+        static constexpr int SPIN_COUNT = 20000;
+
+        void ThreadProc();
+
+        int index;
+        const char *threadName;
+        JobFunction jobFunction = nullptr;
+        void *jobData = nullptr;
+        uint32_t jobFrames = 0;
+
+        // request and completion counters live on separate cache lines, since they
+        // are written by different threads.
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> requestSequence{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> completedSequence{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> closing{false};
+        std::unique_ptr<std::jthread> thread;
+    };
+
+    class RealtimeWorkerPool
+    {
+    public:
+        // nWorkers: the number of workers that one pedalboard may use.
+        RealtimeWorkerPool(size_t nWorkers = DefaultWorkerCount());
+        ~RealtimeWorkerPool();
+
+        RealtimeWorkerPool(const RealtimeWorkerPool &) = delete;
+        RealtimeWorkerPool &operator=(const RealtimeWorkerPool &) = delete;
+
+        // One fewer than the number of cores (the audio thread gets the last one), at most 3.
+        static size_t DefaultWorkerCount();
+
+        // The number of workers in a WorkerSet.
+        size_t GetWorkerCount() const { return workerCount; }
+
+        /**
+         * @brief Workers reserved for one pedalboard.
+         *
+         * No two live WorkerSets share a worker, so pedalboards that run at the same time (e.g. during
+         * a preset transition) never post to the same worker. Workers are taken from the pool on first
+         * use, and returned to it when the set is destroyed. The pool starts more threads if
+         * all of its workers are in use.
+         */
+        class WorkerSet
+        {
+        public:
+            WorkerSet(RealtimeWorkerPool *pool);
+            ~WorkerSet();
+            WorkerSet(const WorkerSet &) = delete;
+            WorkerSet &operator=(const WorkerSet &) = delete;
+
+            // Not realtime-safe. Call while preparing the pedalboard. index < GetWorkerCount().
+            RealtimeWorker *GetWorker(size_t index);
+
+        private:
+            RealtimeWorkerPool *pool;
+            std::vector<RealtimeWorker *> workers;
+        };
+
+        std::unique_ptr<WorkerSet> AcquireWorkerSet() { return std::make_unique<WorkerSet>(this); }
+
+        // The total number of worker threads started so far.
+        size_t GetThreadCount();
+
+    private:
+        RealtimeWorker *AcquireWorker();
+        void ReleaseWorker(RealtimeWorker *worker);
+
+        size_t workerCount;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<RealtimeWorker>> workers;
+        std::vector<RealtimeWorker *> freeWorkers;
+    };
+}
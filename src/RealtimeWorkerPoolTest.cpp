@@ -0,0 +1,71 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RealtimeWorkerPool.hpp"
+#include <atomic>
+#include <set>
+
+using namespace pipedal;
+
+static void CountJob(void *data, uint32_t frames)
+{
+    ((std::atomic<uint32_t> *)data)->fetch_add(frames);
+}
+
+TEST_CASE("Overlapping pedalboards get separate realtime workers", "[realtime_worker_pool][Build]")
+{
+    RealtimeWorkerPool pool(2);
+    REQUIRE(pool.GetThreadCount() == 2);
+
+    std::set<RealtimeWorker *> firstWorkers;
+    {
+        auto outgoing = pool.AcquireWorkerSet();
+        auto incoming = pool.AcquireWorkerSet();
+        std::set<RealtimeWorker *> workers;
+        for (size_t i = 0; i < pool.GetWorkerCount(); ++i)
+        {
+            firstWorkers.insert(outgoing->GetWorker(i));
+            workers.insert(outgoing->GetWorker(i));
+            workers.insert(incoming->GetWorker(i));
+        }
+        REQUIRE(workers.size() == 2 * pool.GetWorkerCount());
+        REQUIRE(pool.GetThreadCount() == 4);
+
+        // both sets run jobs at the same time.
+        std::atomic<uint32_t> count{0};
+        for (int period = 0; period < 100; ++period)
+        {
+            for (RealtimeWorker *worker : workers)
+            {
+                worker->Post(&CountJob, &count, 1);
+            }
+            for (RealtimeWorker *worker : workers)
+            {
+                worker->Wait();
+            }
+        }
+        REQUIRE(count == 400);
+    }
+    // released workers are reused.
+    auto next = pool.AcquireWorkerSet();
+    REQUIRE(firstWorkers.count(next->GetWorker(0)) + firstWorkers.count(next->GetWorker(1)) != 0);
+    REQUIRE(pool.GetThreadCount() == 4);
+}
@@ -23,6 +23,10 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 
 #ifndef NO_MLOCK
 #include <sys/mman.h>
@@ -37,19 +41,75 @@ namespace pipedal
         TimedOut,
         Closed
     };
+    /**
+     * @brief Lock-free ring buffer for passing messages between the realtime thread and host threads.
+     *
+     * MULTI_WRITER=false: a single producer and a single consumer. Data is published by a release-store of the
+     * write position, and space is returned by a release-store of the read position.
+     *
+     * MULTI_WRITER=true: any number of producers, and a single consumer. Producers claim space with a CAS on
+     * the write position, copy their data, and then publish it by release-storing a record header, so a producer
+     * never waits for another producer. Each write() is a single record, so the reader never sees a partially
+     * written message. The reader consumes records strictly in the order in which space was reserved, and stops at
+     * the first record that hasn't been committed yet: a producer that is preempted between reserve() and commit()
+     * holds back every record reserved after it (including records that are already committed) until it commits.
+     * The reader doesn't block on this; it sees less data in readSpace() until the record is committed.
+     *
+     * Positions are 64-bit, and never wrap. Reader and writer indices live on separate cache lines.
+     *
+     * SEMAPHORE_READER=true allows the reader to block until data is available. Writers only touch the mutex
+     * when a reader is actually waiting.
+     *
+     * Variable-length records can be written in place with reserve()/write(reservation,...)/commit(), instead of being
+     * assembled in a temporary buffer.
+     */
     template <bool MULTI_WRITER = false, bool SEMAPHORE_READER = false>
     class RingBuffer
     {
+    public:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        // Space reserved for a single write.
+        class Reservation
+        {
+        public:
+            bool IsValid() const { return valid; }
+            size_t Size() const { return size; }
+
+        private:
+            friend class RingBuffer;
+            uint64_t position = 0; // position of the data.
+            uint64_t header = 0;   // MULTI_WRITER: position of the record header.
+            size_t size = 0;
+            bool valid = false;
+        };
+
+    private:
+        // MULTI_WRITER record header: the data size, with COMMITTED set once the data has been written.
+        // Unused memory is always zero, so that the reader can tell a committed record from one that hasn't been written yet.
+        static constexpr uint32_t COMMITTED = 0x80000000u;
+        static constexpr size_t HEADER_SIZE = sizeof(uint32_t);
+        static size_t RecordSize(size_t bytes) { return HEADER_SIZE + ((bytes + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1)); }
+
         char *buffer;
         bool mlocked = false;
         size_t ringBufferSize;
         size_t ringBufferMask;
-        int64_t readPosition = 0;  // volatile = ordering barrier wrt writePosition
-        int64_t writePosition = 0; // volatile = ordering barrier wrt/ readPosition
-        std::mutex mutex;
-        std::mutex writeMutex;
 
-        bool is_open = true;
+        // Producer side. MULTI_WRITER: end of reserved space. Otherwise: end of published data.
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> writePosition = 0;
+
+        // Consumer side. Everything before readPosition may be reused by writers.
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> readPosition = 0;
+        // MULTI_WRITER reader state.
+        uint64_t readCursor = 0;          // next byte to read (in a record header, or in record data).
+        size_t recordRemaining = 0;       // unread data in the current record.
+        uint64_t scanPosition = 0;        // header of the first record that hasn't been seen as committed.
+        size_t scannedBytes = 0;          // committed data between readCursor and scanPosition.
+
+        alignas(CACHE_LINE_SIZE) std::atomic<int> waitingReaders = 0;
+        std::atomic<bool> is_open = true;
+        std::mutex mutex;
         std::condition_variable cvRead;
 
         size_t nextPowerOfTwo(size_t size)
@@ -61,13 +121,138 @@ namespace pipedal
             }
             return v;
         }
+        std::atomic_ref<uint32_t> HeaderAt(uint64_t position)
+        {
+            return std::atomic_ref<uint32_t>(*(uint32_t *)(buffer + (position & ringBufferMask)));
+        }
+        void CopyIn(uint64_t position, const void *data, size_t bytes)
+        {
+            size_t index = position & ringBufferMask;
+            size_t firstPart = std::min(bytes, ringBufferSize - index);
+            memcpy(buffer + index, data, firstPart);
+            memcpy(buffer, (const char *)data + firstPart, bytes - firstPart);
+        }
+        void CopyOut(uint64_t position, void *data, size_t bytes)
+        {
+            size_t index = position & ringBufferMask;
+            size_t firstPart = std::min(bytes, ringBufferSize - index);
+            memcpy(data, buffer + index, firstPart);
+            memcpy((char *)data + firstPart, buffer, bytes - firstPart);
+        }
+        void Zero(uint64_t position, size_t bytes)
+        {
+            size_t index = position & ringBufferMask;
+            size_t firstPart = std::min(bytes, ringBufferSize - index);
+            memset(buffer + index, 0, firstPart);
+            memset(buffer, 0, bytes - firstPart);
+        }
+        void SignalReader()
+        {
+            if constexpr (SEMAPHORE_READER)
+            {
+                // pairs with the fence in WaitForReader.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waitingReaders.load(std::memory_order_relaxed) != 0)
+                {
+                    std::lock_guard lock(mutex);
+                    cvRead.notify_all();
+                }
+            }
+        }
+
+        template <typename READY, typename WAIT>
+        RingBufferStatus WaitForReader(READY ready, WAIT wait)
+        {
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            std::unique_lock lock(mutex);
+            ++waitingReaders;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            RingBufferStatus result;
+            while (true)
+            {
+                if (ready())
+                {
+                    result = RingBufferStatus::Ready;
+                    break;
+                }
+                if (!is_open)
+                {
+                    result = RingBufferStatus::Closed;
+                    break;
+                }
+                if (!wait(lock))
+                {
+                    result = RingBufferStatus::TimedOut;
+                    break;
+                }
+            }
+            --waitingReaders;
+            return result;
+        }
+
+        // Copy data from the consumer's position, optionally consuming it.
+        bool ReadData(size_t bytes, uint8_t *data, bool consume)
+        {
+            if (readSpace() < bytes)
+            {
+                return false;
+            }
+            if constexpr (!MULTI_WRITER)
+            {
+                uint64_t position = readPosition.load(std::memory_order_relaxed);
+                CopyOut(position, data, bytes);
+                if (consume)
+                {
+                    readPosition.store(position + bytes, std::memory_order_release);
+                }
+            }
+            else
+            {
+                uint64_t cursor = readCursor;
+                size_t remaining = recordRemaining;
+                size_t bytesLeft = bytes;
+                while (bytesLeft != 0)
+                {
+                    if (remaining == 0)
+                    {
+                        remaining = HeaderAt(cursor).load(std::memory_order_acquire) & ~COMMITTED;
+                        cursor += HEADER_SIZE;
+                    }
+                    size_t thisTime = std::min(bytesLeft, remaining);
+                    CopyOut(cursor, data, thisTime);
+                    data += thisTime;
+                    cursor += thisTime;
+                    bytesLeft -= thisTime;
+                    remaining -= thisTime;
+                    if (remaining == 0)
+                    {
+                        cursor = (cursor + HEADER_SIZE - 1) & ~(uint64_t)(HEADER_SIZE - 1);
+                    }
+                }
+                if (consume)
+                {
+                    // Consumed memory must be zero before writers can reuse it. A writer's header word only becomes
+                    // non-zero when the writer commits, and record boundaries move from lap to lap, so any consumed word
+                    // may be read as a header by the next scan; stale data there could look like a committed record.
+                    // The cost is a memset of the bytes that were just copied out (cache-hot, bounded by the size of
+                    // the read), which is cheaper than having writers publish an uncommitted header under a lock.
+                    uint64_t released = readPosition.load(std::memory_order_relaxed);
+                    Zero(released, cursor - released);
+                    readCursor = cursor;
+                    recordRemaining = remaining;
+                    scannedBytes -= bytes;
+                    readPosition.store(cursor, std::memory_order_release);
+                }
+            }
+            return true;
+        }
 
     public:
         RingBuffer(size_t ringBufferSize = 65536, bool mLock = true)
         {
-            this->ringBufferSize = ringBufferSize = nextPowerOfTwo(ringBufferSize);
+            this->ringBufferSize = ringBufferSize = nextPowerOfTwo(std::max(ringBufferSize, CACHE_LINE_SIZE));
             ringBufferMask = ringBufferSize - 1;
-            buffer = new char[ringBufferSize];
+            buffer = new char[ringBufferSize]();
 
 #ifndef NO_MLOCK
             if (mLock)
@@ -80,19 +265,47 @@ namespace pipedal
             }
 #endif
         }
+        ~RingBuffer()
+        {
+#ifndef NO_MLOCK
+            if (this->mlocked)
+            {
+                munlock(buffer, ringBufferSize);
+            }
+#endif
+
+            delete[] buffer;
+        }
+        RingBuffer(const RingBuffer &) = delete;
+        RingBuffer &operator=(const RingBuffer &) = delete;
 
+        // Not thread-safe. Only call when neither readers nor writers are active.
         void reset()
         {
             this->readPosition = 0;
             this->writePosition = 0;
-            this->is_open = true;
+            this->readCursor = 0;
+            this->recordRemaining = 0;
+            this->scanPosition = 0;
+            this->scannedBytes = 0;
+            if (MULTI_WRITER)
+            {
+                memset(buffer, 0, ringBufferSize);
+            }
+            {
+                std::lock_guard lock(mutex);
+                this->is_open = true;
+            }
             cvRead.notify_all();
         }
         void close()
         {
             if (SEMAPHORE_READER)
             {
-                this->is_open = false;
+                {
+                    std::lock_guard lock(mutex);
+                    this->is_open = false;
+                }
                 cvRead.notify_all();
             }
         }
@@ -100,245 +313,170 @@ namespace pipedal
         template <class Rep, class Period>
         RingBufferStatus readWait_for(const std::chrono::duration<Rep, Period> &timeout)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
-
-                    auto status = cvRead.wait_for(lock, timeout);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+            return WaitForReader(
+                [this]()
+                { return isReadReady_(); },
+                [this, &timeout](std::unique_lock<std::mutex> &lock)
+                { return cvRead.wait_for(lock, timeout) != std::cv_status::timeout; });
         }
 
         template <class Clock, class Duration>
         RingBufferStatus readWait_until(const std::chrono::time_point<Clock, Duration> &time_point)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
-
-                    auto status = cvRead.wait_until(lock, time_point);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+            return WaitForReader(
+                [this]()
+                { return isReadReady_(); },
+                [this, &time_point](std::unique_lock<std::mutex> &lock)
+                { return cvRead.wait_until(lock, time_point) != std::cv_status::timeout; });
         }
         template <class Clock, class Duration>
         RingBufferStatus readWait_until(size_t size, const std::chrono::time_point<Clock, Duration> &time_point)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    size_t available = readSpace_();
-                    if (available >= size)
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
-
-                    auto status = cvRead.wait_until(lock, time_point);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+            return WaitForReader(
+                [this, size]()
+                { return readSpace() >= size; },
+                [this, &time_point](std::unique_lock<std::mutex> &lock)
+                { return cvRead.wait_until(lock, time_point) != std::cv_status::timeout; });
         }
 
+        // Wait for a packet. false if the ring buffer was closed.
         bool readWait()
         {
-            if (SEMAPHORE_READER)
-            {
-                while (true)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return true;
-                    }
-
-                    if (!is_open)
-                        return false;
-                    cvRead.wait(lock);
-                }
-            }
-            else
-            {
-                static_assert("SEMAPHORE_READER is not set to true.");
-            }
+            return WaitForReader(
+                       [this]()
+                       { return isReadReady_(); },
+                       [this](std::unique_lock<std::mutex> &lock)
+                       { cvRead.wait(lock); return true; }) == RingBufferStatus::Ready;
         }
+
+        // Space available for a single write. Approximate if there are multiple writers.
         size_t writeSpace()
         {
-            // at most ringBufferSize-1 in order to
-            // to distinguish the empty buffer from the full buffer.
-            std::unique_lock lock(mutex);
-
-            int64_t size = readPosition - 1 - writePosition;
-            if (size < 0)
-                size += this->ringBufferSize;
-            return (size_t)size;
+            uint64_t used = writePosition.load(std::memory_order_relaxed) - readPosition.load(std::memory_order_acquire);
+            size_t available = ringBufferSize - (size_t)used;
+            if constexpr (MULTI_WRITER)
+            {
+                return available >= RecordSize(0) + HEADER_SIZE ? available - RecordSize(0) - HEADER_SIZE : 0;
+            }
+            return available;
         }
 
+        // Bytes available to read. Consumer thread only.
         size_t readSpace()
         {
-            std::unique_lock lock(mutex);
-            return readSpace_();
+            if constexpr (!MULTI_WRITER)
+            {
+                return (size_t)(writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_relaxed));
+            }
+            else
+            {
+                // pick up records committed since the last call.
+                uint64_t released = readPosition.load(std::memory_order_relaxed);
+                while (scanPosition - released < ringBufferSize)
+                {
+                    uint32_t header = HeaderAt(scanPosition).load(std::memory_order_acquire);
+                    if ((header & COMMITTED) == 0)
+                    {
+                        break;
+                    }
+                    size_t size = header & ~COMMITTED;
+                    scannedBytes += size;
+                    scanPosition += RecordSize(size);
+                }
+                return scannedBytes;
+            }
         }
 
- 
-        bool write(size_t bytes, uint8_t *data)
+        /**
+         * @brief Reserve space for a write of the given size.
+         *
+         * Fill the reservation with write(reservation,...), and then publish it with commit(). With a single writer,
+         * a reservation must be committed before the next one is made.
+         *
+         * @returns false if there is not enough space.
+         */
+        bool reserve(size_t bytes, Reservation &reservation)
         {
-            if (MULTI_WRITER)
+            reservation.valid = false;
+            if constexpr (MULTI_WRITER)
             {
-                std::lock_guard writeLock{writeMutex};
-                if (writeSpace() < bytes + sizeof(bytes))
+                if (bytes >= COMMITTED)
                 {
                     return false;
                 }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
+                size_t recordSize = RecordSize(bytes);
+                uint64_t position = writePosition.load(std::memory_order_relaxed);
+                do
                 {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                {
-                    std::lock_guard lock(mutex);
-                    this->writePosition = (index + bytes) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
-                {
-                    cvRead.notify_all();
-                }
-                return true;
+                    if (position + recordSize - readPosition.load(std::memory_order_acquire) > ringBufferSize)
+                    {
+                        return false;
+                    }
+                } while (!writePosition.compare_exchange_weak(position, position + recordSize, std::memory_order_relaxed));
+                reservation.header = position;
+                reservation.position = position + HEADER_SIZE;
             }
             else
             {
-                if (writeSpace() < sizeof(bytes) + bytes)
+                uint64_t position = writePosition.load(std::memory_order_relaxed);
+                if (position + bytes - readPosition.load(std::memory_order_acquire) > ringBufferSize)
                 {
                     return false;
                 }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
-                {
-                    cvRead.notify_all();
-                }
-                return true;
+                reservation.position = position;
             }
+            reservation.size = bytes;
+            reservation.valid = true;
+            return true;
         }
-        // Write two disjoint areas of memory atomically.
-        bool write(size_t bytes, uint8_t *data, size_t bytes2, uint8_t *data2)
+        // Copy data into a reservation.
+        void write(Reservation &reservation, size_t offset, size_t bytes, const void *data)
         {
-            if (MULTI_WRITER)
+            if (offset + bytes > reservation.size)
             {
-                std::lock_guard guard(writeMutex);
-                if (writeSpace() <= sizeof(bytes) + bytes + bytes2)
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                index = (index + bytes) & ringBufferMask;
-
-                for (size_t i = 0; i < sizeof(bytes2); ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = ((char *)&bytes2)[i];
-                }
-                index = (index + sizeof(bytes2)) & ringBufferMask;
-
-                for (size_t i = 0; i < bytes2; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data2[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes2) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
-                {
-                    cvRead.notify_all();
-                }
-                return true;
+                throw std::logic_error("Write exceeds ring buffer reservation.");
+            }
+            CopyIn(reservation.position + offset, data, bytes);
+        }
+        // Publish a reservation to the reader.
+        void commit(Reservation &reservation)
+        {
+            if constexpr (MULTI_WRITER)
+            {
+                HeaderAt(reservation.header).store((uint32_t)reservation.size | COMMITTED, std::memory_order_release);
             }
             else
             {
-                if (writeSpace() <= sizeof(bytes2) + bytes + bytes2)
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                index = (index + bytes) & ringBufferMask;
-
-                for (size_t i = 0; i < sizeof(bytes2); ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = ((char *)&bytes2)[i];
-                }
-                index = (index + sizeof(bytes2)) & ringBufferMask;
-
-                for (size_t i = 0; i < bytes2; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data2[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes2) & ringBufferMask;
-                }
+                writePosition.store(reservation.position + reservation.size, std::memory_order_release);
+            }
+            reservation.valid = false;
+            SignalReader();
+        }
 
-                if (SEMAPHORE_READER)
-                {
-                    cvRead.notify_all();
-                }
-                return true;
+        bool write(size_t bytes, uint8_t *data)
+        {
+            Reservation reservation;
+            if (!reserve(bytes, reservation))
+            {
+                return false;
+            }
+            write(reservation, 0, bytes, data);
+            commit(reservation);
+            return true;
+        }
+        // Write two disjoint areas of memory atomically, with the size of the second area in between.
+        bool write(size_t bytes, uint8_t *data, size_t bytes2, uint8_t *data2)
+        {
+            Reservation reservation;
+            if (!reserve(bytes + sizeof(bytes2) + bytes2, reservation))
+            {
+                return false;
             }
+            write(reservation, 0, bytes, data);
+            write(reservation, bytes, sizeof(bytes2), &bytes2);
+            write(reservation, bytes + sizeof(bytes2), bytes2, data2);
+            commit(reservation);
+            return true;
         }
 
         size_t read_packet(size_t maxSize, void*data) {
@@ -358,35 +496,13 @@ namespace pipedal
             return packet_size;
         }
 
+        // Consumer thread only.
         bool read(size_t bytes, uint8_t *data)
         {
-            if (readSpace() < bytes)
-                return false;
-            int64_t readPosition = this->readPosition;
-            for (size_t i = 0; i < bytes; ++i)
-            {
-                data[i] = this->buffer[(readPosition + i) & this->ringBufferMask];
-            }
-            {
-                std::lock_guard lock{mutex};
-                this->readPosition = (readPosition + bytes) & this->ringBufferMask;
-            }
-            return true;
-        }
-        ~RingBuffer()
-        {
-#ifdef USE_MLOCK
-            if (this->mlocked)
-            {
-                munlock(buffer, ringBufferSize);
-            }
-#endif
-
-            delete[] buffer;
+            return ReadData(bytes, data, true);
         }
         bool isReadReady()
         {
-            std::lock_guard lock(mutex);
             if (isReadReady_())
                 return true;
             return !this->is_open;
@@ -398,34 +514,16 @@ namespace pipedal
         }
 
     private:
-        size_t readSpace_()
-        {
-            int64_t size = writePosition - readPosition;
-            if (size < 0)
-                size += this->ringBufferSize;
-            return size_t(size);
-        }
-
-        uint32_t peekSize()
-        {
-            volatile uint32_t result;
-            uint8_t *p = (uint8_t *)&result;
-            size_t ix = this->readPosition;
-            for (size_t i = 0; i < sizeof(result); ++i)
-            {
-                *p++ = this->buffer[(ix++) & ringBufferMask];
-            }
-            return result;
-        }
+        // true if a complete packet (uint32_t size, followed by data) is available.
         bool isReadReady_()
         {
-            size_t available = readSpace_();
+            size_t available = readSpace();
             if (available < sizeof(uint32_t))
                 return false;
-            // peak to get the size!
-            uint32_t packetSize = peekSize();
+            // peek to get the size!
+            uint32_t packetSize;
+            ReadData(sizeof(packetSize), (uint8_t *)&packetSize, false);
             return packetSize + sizeof(uint32_t) <= available;
         }
     };
-
 };
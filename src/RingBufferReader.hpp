@@ -30,6 +30,7 @@
 namespace pipedal
 {
     class IndexedSnapshot;
+    class SnapshotTable;
 
     class MidiNotifyBody
     {
@@ -51,7 +52,6 @@ namespace pipedal
         Invalid = 0,
         ReplaceEffect,
         EffectReplaced,
-        SetValue,
         SetBypass,
         // AudioStopped,
         AudioTerminatedAbnormally, // specifically for an ALSA loss of connection.
@@ -60,6 +60,8 @@ namespace pipedal
 
         LoadSnapshot,
         FreeSnapshot,
+        SetSnapshotTable,
+        FreeSnapshotTable,
 
         SendVuUpdate,
         AckVuUpdate,
@@ -96,6 +98,9 @@ namespace pipedal
 
         SendPathPropertyBuffer,
 
+        SendEffectCpuUpdate,
+        AckEffectCpuUpdate,
+
     };
 
     struct RealtimePedalboardItemIndex {
@@ -123,6 +128,7 @@ namespace pipedal
     {
         int32_t snapshotIndex;
         int64_t snapshotRequestId;
+        bool appliedOnRealtimeThread; // the control values of a precompiled snapshot have already been applied.
     };
 
     struct RealtimeNextMidiProgramRequest
@@ -170,6 +176,7 @@ namespace pipedal
         {
             for (size_t i = 0; i < vuUpdateWorkingData.size(); ++i)
             {
+                vuUpdateWorkingData[i].UpdateRms();
                 vuUpdateResponseData[i] = vuUpdateWorkingData[i];
                 vuUpdateResponseData[i].sampleTime_ = currentSample;
                 vuUpdateWorkingData[i].reset();
@@ -210,13 +217,6 @@ namespace pipedal
         float value;
     };
 
-    class SetControlValueBody
-    {
-    public:
-        int effectIndex;
-        int controlIndex;
-        float value;
-    };
     class SetVolumeBody
     {
     public:
@@ -346,6 +346,36 @@ namespace pipedal
         }
 
         void Reset() { ringBuffer->reset(); }
+
+        /**
+         * @brief Move messages from a deferred ring buffer into this one.
+         *
+         * Used by Lv2Pedalboard to collect messages written by effects running on realtime
+         * worker threads. The deferred buffer contains complete messages only, so the whole
+         * of it is forwarded in a single write.
+         *
+         * @param source The deferred ring buffer.
+         * @param scratch Working storage, at least as large as the deferred ring buffer.
+         */
+        template <bool SRC_MULTI_WRITER, bool SRC_SEMAPHORE_READER>
+        void Forward(RingBuffer<SRC_MULTI_WRITER, SRC_SEMAPHORE_READER> *source, std::vector<uint8_t> &scratch)
+        {
+            size_t available = source->readSpace();
+            if (available == 0)
+            {
+                return;
+            }
+            if (available > scratch.size())
+            {
+                available = scratch.size();
+            }
+            source->read(available, scratch.data());
+            if (!ringBuffer->write(available, scratch.data()))
+            {
+                Lv2Log::error("No space in audio service ringbuffer.");
+            }
+        }
+
         template <typename T>
         void write(RingBufferCommand command, const T &value)
         {
@@ -428,9 +458,9 @@ namespace pipedal
             RealtimeMidiEventRequest msg{eventType};
             write(RingBufferCommand::RealtimeMidiEvent, msg);
         }
-        void OnRealtimeMidiSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId)
+        void OnRealtimeMidiSnapshotRequest(int32_t snapshotIndex, int64_t snapshotRequestId, bool appliedOnRealtimeThread)
         {
-            RealtimeMidiSnapshotRequest msg{snapshotIndex, snapshotRequestId};
+            RealtimeMidiSnapshotRequest msg{snapshotIndex, snapshotRequestId, appliedOnRealtimeThread};
 
             write(RingBufferCommand::RealtimeMidiSnapshotRequest, msg);
         }
@@ -451,14 +481,6 @@ namespace pipedal
             write(RingBufferCommand::NextMidiSnapshot, msg);
         }
 
-        void SetControlValue(int effectIndex, int controlIndex, float value)
-        {
-            SetControlValueBody body;
-            body.effectIndex = effectIndex;
-            body.controlIndex = controlIndex;
-            body.value = value;
-            write(RingBufferCommand::SetValue, body);
-        }
         void SetInputVolume(float value)
         {
             SetVolumeBody body;
@@ -500,6 +522,15 @@ namespace pipedal
             bool value = true;
             write(RingBufferCommand::AckVuUpdate, value);
         }
+        void SendEffectCpuUpdate(const EffectCpuUpdate *pUpdate)
+        {
+            write(RingBufferCommand::SendEffectCpuUpdate, pUpdate);
+        }
+        void AckEffectCpuUpdate()
+        {
+            bool value = true;
+            write(RingBufferCommand::AckEffectCpuUpdate, value);
+        }
         void AckMonitorPortUpdate(int64_t subscriptionHandle)
         {
             // we assume no padding between the command and the data, so we can do an atomic write.
@@ -514,6 +545,10 @@ namespace pipedal
         {
             write(RingBufferCommand::LoadSnapshot, snapshot);
         }
+        void SetSnapshotTable(SnapshotTable *table)
+        {
+            write(RingBufferCommand::SetSnapshotTable, table);
+        }
 
         void AckMidiProgramRequest(int64_t requestId)
         {
@@ -562,6 +597,10 @@ namespace pipedal
         {
             write(RingBufferCommand::FreeSnapshot, snapshot);
         }
+        void FreeSnapshotTable(SnapshotTable *table)
+        {
+            write(RingBufferCommand::FreeSnapshotTable, table);
+        }
 
         void WriteLv2ErrorMessage(int64_t instanceId, const char *message)
         {
@@ -0,0 +1,360 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RingBuffer.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    // A variable-length test message: header, followed by `size` bytes of a pattern derived from the header.
+    struct MessageHeader
+    {
+        uint32_t writer;
+        uint32_t sequence;
+        uint32_t size;
+    };
+
+    uint8_t PatternByte(const MessageHeader &header, size_t i)
+    {
+        return (uint8_t)(header.writer * 31 + header.sequence * 7 + i);
+    }
+    uint32_t MessageSize(uint32_t writer, uint32_t sequence)
+    {
+        return (writer * 13 + sequence * 37) % 200;
+    }
+
+    template <bool MULTI_WRITER, bool SEMAPHORE_READER>
+    void WriteMessage(RingBuffer<MULTI_WRITER, SEMAPHORE_READER> &ringBuffer, uint32_t writer, uint32_t sequence)
+    {
+        MessageHeader header{writer, sequence, MessageSize(writer, sequence)};
+        uint8_t data[256];
+        for (size_t i = 0; i < header.size; ++i)
+        {
+            data[i] = PatternByte(header, i);
+        }
+        typename RingBuffer<MULTI_WRITER, SEMAPHORE_READER>::Reservation reservation;
+        while (!ringBuffer.reserve(sizeof(header) + header.size, reservation))
+        {
+            std::this_thread::yield();
+        }
+        ringBuffer.write(reservation, 0, sizeof(header), &header);
+        ringBuffer.write(reservation, sizeof(header), header.size, data);
+        ringBuffer.commit(reservation);
+    }
+
+    // Read messages from all writers, checking that each writer's messages arrive intact and in order.
+    template <bool MULTI_WRITER, bool SEMAPHORE_READER>
+    void ReadMessages(RingBuffer<MULTI_WRITER, SEMAPHORE_READER> &ringBuffer, size_t writers, uint32_t messagesPerWriter)
+    {
+        std::vector<uint32_t> nextSequence(writers);
+        size_t remaining = writers * messagesPerWriter;
+        bool ok = true;
+        while (remaining != 0)
+        {
+            if (ringBuffer.readSpace() < sizeof(MessageHeader))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            MessageHeader header;
+            uint8_t data[256];
+            ok = ringBuffer.read(sizeof(header), (uint8_t *)&header);
+            // the rest of the message must be available as soon as the header is.
+            ok = ok && header.size <= sizeof(data) && ringBuffer.read(header.size, data);
+            ok = ok && header.writer < writers;
+            ok = ok && header.sequence == nextSequence[header.writer];
+            ok = ok && header.size == MessageSize(header.writer, header.sequence);
+            for (size_t i = 0; ok && i < header.size; ++i)
+            {
+                ok = data[i] == PatternByte(header, i);
+            }
+            if (!ok)
+            {
+                break;
+            }
+            ++nextSequence[header.writer];
+            --remaining;
+        }
+        REQUIRE(ok);
+        REQUIRE(ringBuffer.readSpace() == 0);
+    }
+
+    template <bool MULTI_WRITER>
+    void StressTest(size_t writers, uint32_t messagesPerWriter)
+    {
+        // small, so that writers frequently run out of space, and records frequently wrap.
+        RingBuffer<MULTI_WRITER, false> ringBuffer(1024, false);
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < writers; ++w)
+        {
+            threads.emplace_back([&ringBuffer, w, messagesPerWriter]()
+                                 {
+                for (uint32_t i = 0; i < messagesPerWriter; ++i)
+                {
+                    WriteMessage(ringBuffer, (uint32_t)w, i);
+                } });
+        }
+        ReadMessages(ringBuffer, writers, messagesPerWriter);
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+TEST_CASE("Ring buffer single writer stress test", "[ring_buffer][Build]")
+{
+    StressTest<false>(1, 200000);
+}
+
+TEST_CASE("Ring buffer multiple writer stress test", "[ring_buffer][Build]")
+{
+    for (size_t writers : {1, 2, 8})
+    {
+        INFO(writers << " writers");
+        StressTest<true>(writers, 50000);
+    }
+}
+
+TEST_CASE("Ring buffer packets", "[ring_buffer][Build]")
+{
+    RingBuffer<true, false> ringBuffer(256, false);
+    REQUIRE(!ringBuffer.isReadReady());
+
+    uint32_t size = 8;
+    uint64_t value = 0x0102030405060708;
+    REQUIRE(ringBuffer.write(sizeof(size), (uint8_t *)&size));
+    // size, but no data yet.
+    REQUIRE(!ringBuffer.isReadReady());
+    REQUIRE(ringBuffer.write(sizeof(value), (uint8_t *)&value));
+    REQUIRE(ringBuffer.isReadReady());
+
+    uint32_t sizeOut;
+    uint64_t valueOut;
+    REQUIRE(ringBuffer.read(sizeof(sizeOut), (uint8_t *)&sizeOut));
+    REQUIRE(ringBuffer.read(sizeof(valueOut), (uint8_t *)&valueOut));
+    REQUIRE(sizeOut == size);
+    REQUIRE(valueOut == value);
+
+    // overflow fails without writing anything.
+    std::vector<uint8_t> big(300);
+    REQUIRE(!ringBuffer.write(big.size(), big.data()));
+    REQUIRE(ringBuffer.readSpace() == 0);
+}
+
+TEST_CASE("Ring buffer uncommitted reservation", "[ring_buffer][Build]")
+{
+    RingBuffer<true, false> ringBuffer(256, false);
+
+    // a writer that has reserved, but not committed, holds back records reserved after it.
+    RingBuffer<true, false>::Reservation first;
+    REQUIRE(ringBuffer.reserve(sizeof(uint32_t), first));
+    uint32_t second = 2;
+    REQUIRE(ringBuffer.write(sizeof(second), (uint8_t *)&second));
+    REQUIRE(ringBuffer.readSpace() == 0);
+
+    uint32_t value = 1;
+    ringBuffer.write(first, 0, sizeof(value), &value);
+    ringBuffer.commit(first);
+    REQUIRE(ringBuffer.readSpace() == 2 * sizeof(uint32_t));
+
+    uint32_t out;
+    REQUIRE(ringBuffer.read(sizeof(out), (uint8_t *)&out));
+    REQUIRE(out == 1);
+    REQUIRE(ringBuffer.read(sizeof(out), (uint8_t *)&out));
+    REQUIRE(out == 2);
+}
+
+TEST_CASE("Ring buffer reader wait", "[ring_buffer][Build]")
+{
+    RingBuffer<true, true> ringBuffer(1024, false);
+
+    auto status = ringBuffer.readWait_for(std::chrono::milliseconds(10));
+    REQUIRE(status == RingBufferStatus::TimedOut);
+
+    std::thread writer([&ringBuffer]()
+                       {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint32_t packet[2] = { 4, 1234};
+        ringBuffer.write(sizeof(packet), (uint8_t *)packet); });
+    REQUIRE(ringBuffer.readWait());
+    writer.join();
+    uint32_t packet[2];
+    REQUIRE(ringBuffer.read(sizeof(packet), (uint8_t *)packet));
+    REQUIRE(packet[1] == 1234);
+
+    std::thread closer([&ringBuffer]()
+                       {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ringBuffer.close(); });
+    REQUIRE(!ringBuffer.readWait());
+    closer.join();
+}
+
+namespace
+{
+    // The multi-writer RingBuffer that the lock-free implementation replaced (write, read and readSpace only),
+    // kept so that the benchmark measures against what was actually there: writers serialized by a write mutex,
+    // and positions guarded by a second mutex that the reader also takes.
+    class PreviousRingBuffer
+    {
+    public:
+        PreviousRingBuffer(size_t size)
+        {
+            ringBufferSize = size;
+            ringBufferMask = size - 1;
+            buffer = new char[size];
+        }
+        ~PreviousRingBuffer() { delete[] buffer; }
+
+        bool write(size_t bytes, uint8_t *data)
+        {
+            std::lock_guard writeLock{writeMutex};
+            if (writeSpace() < bytes + sizeof(bytes))
+            {
+                return false;
+            }
+            size_t index = this->writePosition;
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                buffer[(index + i) & ringBufferMask] = data[i];
+            }
+            {
+                std::lock_guard lock(mutex);
+                this->writePosition = (index + bytes) & ringBufferMask;
+            }
+            return true;
+        }
+        size_t readSpace()
+        {
+            std::unique_lock lock(mutex);
+            int64_t size = writePosition - readPosition;
+            if (size < 0)
+                size += this->ringBufferSize;
+            return size_t(size);
+        }
+        bool read(size_t bytes, uint8_t *data)
+        {
+            if (readSpace() < bytes)
+                return false;
+            int64_t readPosition = this->readPosition;
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                data[i] = this->buffer[(readPosition + i) & this->ringBufferMask];
+            }
+            {
+                std::lock_guard lock{mutex};
+                this->readPosition = (readPosition + bytes) & this->ringBufferMask;
+            }
+            return true;
+        }
+
+    private:
+        size_t writeSpace()
+        {
+            std::unique_lock lock(mutex);
+            int64_t size = readPosition - 1 - writePosition;
+            if (size < 0)
+                size += this->ringBufferSize;
+            return (size_t)size;
+        }
+        char *buffer;
+        size_t ringBufferSize;
+        size_t ringBufferMask;
+        int64_t readPosition = 0;
+        int64_t writePosition = 0;
+        std::mutex mutex;
+        std::mutex writeMutex;
+    };
+
+    // Messages per second, with `writers` threads each writing 16-byte messages (the size of a typical control change).
+    template <typename RING_BUFFER>
+    double MeasureThroughput(size_t writers, size_t messagesPerWriter)
+    {
+        RING_BUFFER ringBuffer(64 * 1024);
+        std::atomic<bool> start = false;
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < writers; ++w)
+        {
+            threads.emplace_back([&]()
+                                 {
+                uint8_t message[16] = {};
+                while (!start)
+                {
+                    std::this_thread::yield();
+                }
+                for (size_t i = 0; i < messagesPerWriter; ++i)
+                {
+                    while (!ringBuffer.write(sizeof(message), message))
+                    {
+                        std::this_thread::yield();
+                    }
+                } });
+        }
+        auto startTime = std::chrono::steady_clock::now();
+        start = true;
+        size_t remaining = writers * messagesPerWriter;
+        uint8_t message[16];
+        while (remaining != 0)
+        {
+            if (ringBuffer.readSpace() >= sizeof(message))
+            {
+                ringBuffer.read(sizeof(message), message);
+                --remaining;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        return writers * messagesPerWriter / seconds;
+    }
+}
+
+// Not run by default. Compares the lock-free multi-writer RingBuffer with the implementation it replaced, for increasing numbers of (UI client) writer threads.
+TEST_CASE("Ring buffer benchmark", "[ring_buffer_benchmark]")
+{
+    const size_t MESSAGES = 1000000;
+    cout << "Ring buffer throughput, millions of messages/s" << endl;
+    cout << setw(10) << "writers" << setw(12) << "previous" << setw(12) << "lock-free" << endl;
+    cout << fixed << setprecision(2);
+    for (size_t writers : {1, 2, 4, 8, 16})
+    {
+        double previousRate = MeasureThroughput<PreviousRingBuffer>(writers, MESSAGES / writers);
+        double lockFreeRate = MeasureThroughput<RingBuffer<true, false>>(writers, MESSAGES / writers);
+        cout << setw(10) << writers << setw(12) << previousRate * 1E-6 << setw(12) << lockFreeRate * 1E-6 << endl;
+    }
+}
@@ -114,6 +114,13 @@ static void SetPriority(int realtimePriority, const char *priorityName)
     }
 }
 
+void pipedal::SetThreadRealtimePriority(int realtimePriority, const char *name)
+{
+#if defined(__linux__)
+    SetPriority(realtimePriority, name);
+#endif
+}
+
 void pipedal::SetThreadPriority(SchedulerPriority priority)
 {
 
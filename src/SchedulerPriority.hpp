@@ -30,4 +30,6 @@ namespace pipedal {
     bool IsRtPreemptKernel(SchedulerPriority priority);
 
     void SetThreadPriority(SchedulerPriority priority);
+    // SCHED_RR priority for the current thread. -1 -> leave the thread at normal priority.
+    void SetThreadRealtimePriority(int realtimePriority, const char *name);
 }
\ No newline at end of file
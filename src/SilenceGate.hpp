@@ -0,0 +1,80 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace pipedal
+{
+    /**
+     * @brief Decides when an effect can skip running because its input is silent.
+     *
+     * An effect is skipped once its input is silent, and its output has stayed silent for the tail time
+     * (so that reverb and delay tails play out). Anything else that might make the effect produce output
+     * (a control change, an incoming event) must call Wake(), which makes the effect run for at least
+     * another tail.
+     *
+     * Audio thread only.
+     */
+    class SilenceGate
+    {
+    public:
+        void SetTailSamples(uint64_t tailSamples) { this->tailSamples = tailSamples; }
+
+        // Call before running the effect. Returns true if the effect should not be run this period.
+        bool Skip(bool inputSilent)
+        {
+            skipping = inputSilent && !woken && silentOutputSamples >= tailSamples;
+            woken = false;
+            if (skipping)
+            {
+                ++skippedPeriods;
+            }
+            return skipping;
+        }
+        // Call after running the effect.
+        void Update(bool inputSilent, bool outputSilent, uint32_t samples)
+        {
+            if (inputSilent && outputSilent)
+            {
+                silentOutputSamples += samples;
+            }
+            else
+            {
+                silentOutputSamples = 0;
+            }
+        }
+        void Wake()
+        {
+            silentOutputSamples = 0;
+            woken = true;
+        }
+
+        bool IsSkipping() const { return skipping; }
+        uint64_t GetSkippedPeriods() const { return skippedPeriods; }
+
+    private:
+        uint64_t tailSamples = 0;
+        uint64_t silentOutputSamples = 0;
+        uint64_t skippedPeriods = 0;
+        bool skipping = false;
+        bool woken = false;
+    };
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SilenceGate.hpp"
+#include "ControlValueTable.hpp"
+
+using namespace pipedal;
+
+static constexpr uint32_t PERIOD = 64;
+
+// Run periods of silence until the gate skips. Returns the number of periods the effect ran.
+static int RunUntilSkipped(SilenceGate &gate)
+{
+    int periodsRun = 0;
+    while (!gate.Skip(true))
+    {
+        ++periodsRun;
+        REQUIRE(periodsRun < 100);
+        gate.Update(true, true, PERIOD);
+    }
+    return periodsRun;
+}
+
+TEST_CASE("Silence gate waits for the tail", "[silence_gate][Build]")
+{
+    SilenceGate gate;
+    gate.SetTailSamples(PERIOD * 4);
+
+    REQUIRE(RunUntilSkipped(gate) == 4);
+    REQUIRE(gate.IsSkipping());
+    REQUIRE(gate.GetSkippedPeriods() == 1);
+
+    // audio input wakes the effect; output must then decay again.
+    REQUIRE(!gate.Skip(false));
+    REQUIRE(!gate.IsSkipping());
+    gate.Update(false, false, PERIOD);
+    REQUIRE(RunUntilSkipped(gate) == 4);
+}
+
+TEST_CASE("A control change wakes a skipped effect", "[silence_gate][Build]")
+{
+    for (uint64_t tailPeriods : {0, 4})
+    {
+        SilenceGate gate;
+        gate.SetTailSamples(PERIOD * tailPeriods);
+        RunUntilSkipped(gate);
+
+        // as Lv2Pedalboard::ApplyControlValues -> Lv2Effect::SetControl.
+        ControlValueTable table;
+        table.Prepare({2});
+        table.Set(0, 1, 0.5f);
+        table.Apply([&gate](int, int, float)
+                    { gate.Wake(); });
+
+        // the effect runs at least once, and for a full tail before it is skipped again.
+        REQUIRE(!gate.Skip(true));
+        gate.Update(true, true, PERIOD);
+        REQUIRE(RunUntilSkipped(gate) == (int)std::max(tailPeriods, (uint64_t)1) - 1);
+    }
+}
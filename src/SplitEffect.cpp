@@ -294,6 +294,17 @@ void SplitEffect::SetChainBuffers(
     outputBuffers.resize(numberOfOutputPorts);
 }
 
+void SplitEffect::RemapAudioBuffers(const std::function<float *(float *)> &remap)
+{
+    for (auto *buffers : {&inputs, &topInputs, &bottomInputs, &topOutputs, &bottomOutputs, &mixTopInputs, &mixBottomInputs, &outputBuffers})
+    {
+        for (auto &buffer : *buffers)
+        {
+            buffer = remap(buffer);
+        }
+    }
+}
+
 void SplitEffect::snapToMixTarget()
 {
     this->blendLTop = targetBlendLTop;
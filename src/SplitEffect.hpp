@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <string>
 #include <unordered_map>
+#include <functional>
 
 namespace pipedal
 {
@@ -346,6 +347,9 @@ namespace pipedal
             const std::vector<float *> &bottomOutputs,
             bool forceStereoOutput);
 
+        // Replace every audio buffer pointer with remap(pointer).
+        void RemapAudioBuffers(const std::function<float *(float *)> &remap);
+
         virtual void ResetAtomBuffers() {}
 
 
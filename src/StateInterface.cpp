@@ -65,6 +65,7 @@ LV2_State_Status StateInterface::StateStoreFunction(
     std::string atomType = map.UridToString(type);
     entry.atomType_ = atomType;
     entry.flags_ = flags;
+    entry.blob_ = nullptr;
     entry.value_.resize(size);
     uint8_t *p = (uint8_t*)value;
 
@@ -199,10 +200,10 @@ const void *StateInterface::StateRetrieveFunction(
     }
 
     const Lv2PluginStateEntry& entry = iEntry->second;
-    *size = entry.value_.size();
+    *size = entry.Size();
     *type = map.GetUrid(entry.atomType_.c_str());
     *flags = entry.flags_;
-    return entry.value_.data();
+    return entry.Data();
 
 }
 
@@ -248,8 +249,21 @@ void Lv2PluginStateEntry::write_json(json_writer &writer) const
         }
         writer.write_member("value",*(float*)&(value_[0]));
     } else {
-        std::string base64 = macaron::Base64::Encode(value_);
-        writer.write_member("value",base64);
+        BlobStore *blobStore = BlobStore::GetCurrent();
+        if (blobStore && Size() >= BlobStore::MIN_BLOB_SIZE)
+        {
+            std::string hash;
+            if (blob_ && blobStore->Contains(blob_->hash()))
+            {
+                hash = blob_->hash();
+            } else {
+                hash = blobStore->Put(Data(),Size());
+            }
+            writer.write_member("blob",hash);
+        } else {
+            std::string base64 = macaron::Base64::Encode(Size(),Data());
+            writer.write_member("value",base64);
+        }
     }
     writer.end_object();
 }
@@ -278,9 +292,27 @@ void Lv2PluginStateEntry::read_json(json_reader &reader)
         float *pVal = (float*)&(value_[0]);
         *pVal = v;
     } else {
-        std::string v;
-        reader.read_member("value",&v);
-        value_ = macaron::Base64::Decode(v);
+        std::string memberName = reader.read_string();
+        reader.consume(':');
+        if (memberName == "blob")
+        {
+            std::string hash;
+            reader.read(&hash);
+            BlobStore *blobStore = BlobStore::GetCurrent();
+            if (!blobStore)
+            {
+                throw std::logic_error("LV2 state refers to a blob, but no blob store is available.");
+            }
+            value_.clear();
+            blob_ = blobStore->Get(hash);
+        } else if (memberName == "value") {
+            std::string v;
+            reader.read(&v);
+            value_ = macaron::Base64::Decode(v);
+            blob_ = nullptr;
+        } else {
+            throw std::logic_error("Expecting property 'value'");
+        }
     }
     reader.end_object();
 }
@@ -312,7 +344,15 @@ std::string Lv2PluginState::ToString() const {
 
 bool Lv2PluginStateEntry::operator==(const Lv2PluginStateEntry&other) const
 {
-    return this->atomType_ == other.atomType_ && this->value_ == other.value_;
+    if (this->atomType_ != other.atomType_ || this->Size() != other.Size())
+    {
+        return false;
+    }
+    if (this->blob_ && other.blob_ && this->blob_->hash() == other.blob_->hash())
+    {
+        return true;
+    }
+    return Size() == 0 || memcmp(this->Data(), other.Data(), Size()) == 0;
 }
 
 bool Lv2PluginState::IsEqual(const Lv2PluginState&other) const
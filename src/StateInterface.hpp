@@ -24,6 +24,7 @@
 #include "json_variant.hpp"
 #include "MapFeature.hpp"
 #include "IHost.hpp"
+#include "BlobStore.hpp"
 #include <lilv/lilv.h>
 
 namespace pipedal
@@ -33,6 +34,11 @@ namespace pipedal
         std::int32_t flags_ = 0;
         std::string atomType_;
         std::vector<uint8_t> value_;
+        // Large values read from a BlobStore refer to the blob instead of being copied into value_.
+        std::shared_ptr<const Blob> blob_;
+
+        const uint8_t *Data() const { return blob_ ? blob_->data() : value_.data(); }
+        size_t Size() const { return blob_ ? blob_->size() : value_.size(); }
 
         bool operator==(const Lv2PluginStateEntry&other) const;
     private:
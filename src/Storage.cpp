@@ -50,7 +50,9 @@ using namespace pipedal;
 using namespace ::pipedal::implementation;
 namespace fs = std::filesystem;
 
-const char* BANK_EXTENSION = ".bank";
+const char* BANK_EXTENSION = ".bank"; // legacy single-file banks.
+const char* BANK_DIRECTORY_EXTENSION = ".bankdir";
+const char* MIGRATED_BANK_EXTENSION = ".migrated";
 const char* BANKS_FILENAME = "index.banks";
 
 #define USER_SETTINGS_FILENAME "userSettings.json";
@@ -317,7 +319,7 @@ void Storage::UpgradeV3FactoryPresets()
     };
 
 
-    fs::path factoryPresetPath = GetBankFileName("Factory Presets");
+    fs::path factoryPresetPath = GetBankPath("Factory Presets");
 
     UpgradeBank(
         *this->model,
@@ -338,7 +340,7 @@ void Storage::AddNewFactoryPresets()
 
     };
 
-    fs::path factoryPresetPath = GetBankFileName("Factory Presets");
+    fs::path factoryPresetPath = GetBankPath("Factory Presets");
 
     UpgradeBank(
         *this->model,
@@ -372,15 +374,15 @@ void Storage::CopyFactoryPresetsToDefaultBank()
     {
         throw std::runtime_error("Internal error: CopyFactoryPresetsToDefaultBank: Default Bank already exists.");
     }
-    fs::path factoryPresetPath = GetBankFileName("Factory Presets");
-    fs::path defaultBankPath = GetBankFileName("Default Bank");
+    fs::path factoryPresetPath = GetBankPath("Factory Presets");
+    fs::path defaultBankPath = GetBankPath("Default Bank");
     if (!fs::exists(factoryPresetPath)) {
         throw std::runtime_error("Internal error: CopyFactoryPresetsToDefaultBank: Factory Presets file does not exist.");
     }
     auto instanceId = bankIndex.addBank(-2, "Default Bank");
 
 
-    fs::copy(factoryPresetPath, defaultBankPath);
+    fs::copy(factoryPresetPath, defaultBankPath, fs::copy_options::recursive);
 
     bankIndex.selectedBank(instanceId);
     SaveBankIndex();
@@ -592,11 +594,14 @@ void Storage::Initialize(PiPedalModel* model)
     }
     CleanWorkingDirectories();
 
+    blobStore = std::make_unique<BlobStore>(GetBlobsDirectory());
+    MigrateBankFiles();
     ProvisionDefaultBanks();
 
     LoadPluginPresetIndex();
     LoadBankIndex();
     LoadCurrentBank();
+    CollectBlobGarbage();
     try
     {
         LoadJackChannelSelection();
@@ -629,7 +634,7 @@ void Storage::LoadBank(int64_t instanceId)
     }
     catch (const std::exception& e)
     {
-        throw std::logic_error(SS("Bank file corrupted. " << e.what() << "(" << GetBankFileName(indexEntry.name()) << ")"));
+        throw std::logic_error(SS("Bank file corrupted. " << e.what() << "(" << GetBankPath(indexEntry.name()) << ")"));
     }
 }
 
@@ -668,12 +673,71 @@ std::filesystem::path Storage::GetIndexFileName() const
 {
     return this->GetPresetsDirectory() / BANKS_FILENAME;
 }
-std::filesystem::path Storage::GetBankFileName(const std::string& name) const
+std::filesystem::path Storage::GetBankPath(const std::string& name) const
 {
-    std::string fileName = SafeEncodeName(name) + BANK_EXTENSION;
+    std::string fileName = SafeEncodeName(name) + BANK_DIRECTORY_EXTENSION;
     return this->GetPresetsDirectory() / fileName;
 }
 
+std::filesystem::path Storage::GetBlobsDirectory() const
+{
+    return this->dataRoot / "preset_blobs";
+}
+
+void Storage::CollectBlobGarbage()
+{
+    try
+    {
+        // every bank directory, including any that have dropped out of the index.
+        std::set<std::string> referencedBlobs;
+        for (const auto& dirEntry : std::filesystem::directory_iterator(GetPresetsDirectory()))
+        {
+            if (dirEntry.is_directory() && dirEntry.path().extension() == BANK_DIRECTORY_EXTENSION)
+            {
+                BankStore(dirEntry.path()).FindBlobReferences(&referencedBlobs);
+            }
+        }
+        size_t removed = blobStore->CollectGarbage(referencedBlobs);
+        if (removed != 0)
+        {
+            Lv2Log::info(SS("Removed " << removed << " unreferenced preset blob(s)."));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        Lv2Log::error(SS("Preset blob garbage collection failed. " << e.what()));
+    }
+}
+
+void Storage::MigrateBankFiles()
+{
+    // Convert legacy single-file banks to bank directories (once; the legacy file is renamed when done).
+    for (const auto& dirEntry : std::filesystem::directory_iterator(GetPresetsDirectory()))
+    {
+        auto path = dirEntry.path();
+        if (dirEntry.is_directory() || path.extension() != BANK_EXTENSION)
+        {
+            continue;
+        }
+        fs::path bankDirectory = path;
+        bankDirectory.replace_extension(BANK_DIRECTORY_EXTENSION);
+        try
+        {
+            if (!BankStore(bankDirectory).Exists())
+            {
+                Lv2Log::info(SS("Converting bank file " << path << "."));
+                BankStore::ConvertBankFile(path, bankDirectory, blobStore.get());
+            }
+            fs::path migratedPath = path.string() + MIGRATED_BANK_EXTENSION;
+            fs::rename(path, migratedPath);
+        }
+        catch (const std::exception& e)
+        {
+            Lv2Log::error(SS("Unable to convert bank file " << path << ". " << e.what()));
+        }
+    }
+}
+
 void Storage::LoadBankIndex()
 {
     try
@@ -759,10 +823,10 @@ void Storage::ReIndex()
             Lv2Log::warning("Skipping invalid UTF-8 path: %s", dirEntry.path().string().c_str());
             continue;
         }
-        if (!dirEntry.is_directory())
+        if (dirEntry.is_directory())
         {
             auto path = dirEntry.path();
-            if (path.extension() == BANK_EXTENSION)
+            if (path.extension() == BANK_DIRECTORY_EXTENSION && BankStore(path).Exists())
             {
                 std::string name = SafeDecodeName(path.stem());
                 bankIndex.addBank(-1, name);
@@ -794,60 +858,38 @@ void Storage::CreateBank(const std::string& name)
 void Storage::GetBankFile(int64_t instanceId, BankFile* pBank) const
 {
     auto indexEntry = this->bankIndex.getBankIndexEntry(instanceId);
-    auto name = indexEntry.name();
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::ifstream is(fileName);
-    json_reader reader(is);
-    reader.read(pBank);
+    BankStore(GetBankPath(indexEntry.name()), blobStore.get()).Load(pBank);
     pBank->name(indexEntry.name());
 }
 
 void Storage::LoadBankFile(const std::string& name, BankFile* pBank)
 {
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::ifstream is(fileName);
-    json_reader reader(is);
-    reader.read(pBank);
+    BankStore(GetBankPath(name), blobStore.get()).Load(pBank);
 }
 
 void Storage::SaveBankFile(const std::string& name, const BankFile& bankFile)
 {
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::filesystem::path backupFile = ((std::string)fileName) + ".$$$";
-    if (std::filesystem::exists(backupFile))
-    {
-        std::filesystem::remove(backupFile);
-    }
-    if (std::filesystem::exists(fileName))
-    {
-        std::filesystem::rename(fileName, backupFile);
-    }
-    try
-    {
-        pipedal::ofstream_synced s;
-        s.open(fileName, std::ios_base::trunc);
-        json_writer writer(s, true);
-        writer.write(bankFile);
-        if (std::filesystem::exists(backupFile))
-        {
-            std::filesystem::remove(backupFile);
-        }
-    }
-    catch (const std::exception& e)
+    BankStore(GetBankPath(name), blobStore.get()).Save(bankFile);
+}
+
+void Storage::SaveCurrentBankIndex(int64_t newPresetsAfter)
+{
+    auto indexEntry = this->bankIndex.getBankIndexEntry(this->bankIndex.selectedBank());
+    BankStore bankStore(GetBankPath(indexEntry.name()), blobStore.get());
+    for (const auto& preset : currentBank.presets())
     {
-        std::filesystem::remove(fileName);
-        if (std::filesystem::exists(backupFile))
+        if (preset->instanceId() > newPresetsAfter)
         {
-            std::filesystem::rename(backupFile, fileName);
+            bankStore.SavePreset(preset->instanceId(), preset->preset());
         }
-        throw;
     }
+    bankStore.SaveIndex(this->currentBank);
 }
 
-void Storage::SaveCurrentBank()
+void Storage::SaveCurrentBankPreset(int64_t instanceId)
 {
     auto indexEntry = this->bankIndex.getBankIndexEntry(this->bankIndex.selectedBank());
-    SaveBankFile(indexEntry.name(), this->currentBank);
+    BankStore(GetBankPath(indexEntry.name()), blobStore.get()).SavePreset(instanceId, currentBank.getItem(instanceId).preset());
 }
 
 const Pedalboard& Storage::GetCurrentPreset()
@@ -863,15 +905,20 @@ bool Storage::LoadPreset(int64_t instanceId)
     if (instanceId != currentBank.selectedPreset())
     {
         currentBank.selectedPreset(instanceId);
-        SaveCurrentBank();
+        SaveCurrentBankIndex();
     }
     return true;
 }
 void Storage::SaveCurrentPreset(const Pedalboard& pedalboard)
 {
     auto& item = currentBank.getItem(currentBank.selectedPreset());
+    bool nameChanged = item.preset().name() != pedalboard.name();
     item.preset(pedalboard);
-    SaveCurrentBank();
+    SaveCurrentBankPreset(item.instanceId());
+    if (nameChanged)
+    {
+        SaveCurrentBankIndex();
+    }
 }
 int64_t Storage::SaveCurrentPresetAs(const Pedalboard& pedalboard, int64_t bankInstanceId, const std::string& name, int64_t saveAfterInstanceId)
 {
@@ -880,9 +927,10 @@ int64_t Storage::SaveCurrentPresetAs(const Pedalboard& pedalboard, int64_t bankI
 
     if (bankInstanceId == this->bankIndex.selectedBank())
     {
+        int64_t newPresetsAfter = currentBank.nextInstanceId();
         int64_t newInstanceId = currentBank.addPreset(newPedalboard, saveAfterInstanceId);
         currentBank.selectedPreset(newInstanceId);
-        SaveCurrentBank();
+        SaveCurrentBankIndex(newPresetsAfter);
         return newInstanceId;
     }
     else
@@ -891,15 +939,18 @@ int64_t Storage::SaveCurrentPresetAs(const Pedalboard& pedalboard, int64_t bankI
 
         try
         {
-            BankFile bankFile;
-            LoadBankFile(indexEntry.name(), &(bankFile));
-            int64_t newInstanceId = bankFile.addPreset(newPedalboard, -1);
-            SaveBankFile(indexEntry.name(), bankFile);
+            // only the index of the other bank is read.
+            BankStore bankStore(GetBankPath(indexEntry.name()), blobStore.get());
+            BankStoreIndex bankStoreIndex;
+            bankStore.LoadIndex(&bankStoreIndex);
+            int64_t newInstanceId = bankStoreIndex.AddPreset(newPedalboard.name(), -1);
+            bankStore.SavePreset(newInstanceId, newPedalboard);
+            bankStore.SaveIndex(bankStoreIndex);
             return -1;
         }
         catch (const std::exception& e)
         {
-            throw std::logic_error(SS("Bank file corrupted. " << e.what() << "(" << GetBankFileName(indexEntry.name()) << ")"));
+            throw std::logic_error(SS("Bank file corrupted. " << e.what() << "(" << GetBankPath(indexEntry.name()) << ")"));
         }
     }
 }
@@ -977,21 +1028,24 @@ int64_t Storage::ImportPresetsFromBank(int64_t bankInstanceId, const std::vector
     {
         existingNames.insert(preset->preset().name());
     }
-    BankFile bankFile;
-    LoadBankFile(indexEntry.name(), &bankFile);
+    // only the selected presets are read from the other bank.
+    BankStore bankStore(GetBankPath(indexEntry.name()), blobStore.get());
+    BankStoreIndex bankStoreIndex;
+    bankStore.LoadIndex(&bankStoreIndex);
+    int64_t newPresetsAfter = this->currentBank.nextInstanceId();
     int64_t lastPresetId = -1;
-    for (auto& presetEntry : bankFile.presets())
+    for (auto& presetEntry : bankStoreIndex.presets_)
     {
-        if (presetsSet.contains(presetEntry->instanceId()))
+        if (presetsSet.contains(presetEntry.instanceId()))
         {
-            std::string uniqueName = makeUniqueName(presetEntry->preset().name(), existingNames);
+            std::string uniqueName = makeUniqueName(presetEntry.name(), existingNames);
             existingNames.insert(uniqueName);
-            Pedalboard t = presetEntry->preset();
+            Pedalboard t = bankStore.LoadPreset(presetEntry.instanceId());
             t.name(uniqueName);
             lastPresetId = this->currentBank.addPreset(t);
         }
     }
-    SaveCurrentBank();
+    SaveCurrentBankIndex(newPresetsAfter);
     return lastPresetId;
 }
 int64_t Storage::CopyPresetsToBank(int64_t bankInstanceId, const std::vector<int64_t>& presets)
@@ -1002,16 +1056,18 @@ int64_t Storage::CopyPresetsToBank(int64_t bankInstanceId, const std::vector<int
     }
 
     auto indexEntry = this->bankIndex.getBankIndexEntry(bankInstanceId);
-    BankFile bankFile;
-    LoadBankFile(indexEntry.name(), &bankFile);
+    // only the index of the other bank is read.
+    BankStore bankStore(GetBankPath(indexEntry.name()), blobStore.get());
+    BankStoreIndex bankStoreIndex;
+    bankStore.LoadIndex(&bankStoreIndex);
 
     std::set<int64_t> presetsSet{ presets.begin(), presets.end() };
 
     std::set<std::string> existingNames;
 
-    for (auto& preset : bankFile.presets())
+    for (auto& preset : bankStoreIndex.presets_)
     {
-        existingNames.insert(preset->preset().name());
+        existingNames.insert(preset.name());
     }
     for (auto& presetEntry : this->currentBank.presets())
     {
@@ -1021,10 +1077,11 @@ int64_t Storage::CopyPresetsToBank(int64_t bankInstanceId, const std::vector<int
             existingNames.insert(uniqueName);
             Pedalboard t = presetEntry->preset();
             t.name(uniqueName);
-            bankFile.addPreset(t);
+            int64_t newInstanceId = bankStoreIndex.AddPreset(uniqueName);
+            bankStore.SavePreset(newInstanceId, t);
         }
     }
-    SaveBankFile(indexEntry.name(), bankFile);
+    bankStore.SaveIndex(bankStoreIndex);
     return -1;
 }
 
@@ -1032,15 +1089,9 @@ std::vector<PresetIndexEntry> Storage::RequestBankPresets(int64_t bankInstanceId
 {
     auto indexEntry = this->bankIndex.getBankIndexEntry(bankInstanceId);
 
-    std::vector<PresetIndexEntry> result;
-    BankFile bankFile;
-    LoadBankFile(indexEntry.name(), &bankFile);
-    for (auto& preset : bankFile.presets())
-    {
-        result.push_back(
-            PresetIndexEntry(preset->instanceId(), preset->preset().name()));
-    }
-    return result;
+    BankStoreIndex bankStoreIndex;
+    BankStore(GetBankPath(indexEntry.name()), blobStore.get()).LoadIndex(&bankStoreIndex);
+    return bankStoreIndex.presets_;
 }
 
 void Storage::SetPresetIndex(const PresetIndex& presets)
@@ -1075,7 +1126,7 @@ void Storage::SetPresetIndex(const PresetIndex& presets)
     bankFile.selectedPreset(currentBank.selectedPreset());
 
     this->currentBank = std::move(bankFile); // deleting any stray presets while we're at it.
-    this->SaveCurrentBank();
+    this->SaveCurrentBankIndex();
 }
 
 void Storage::GetPresetIndex(PresetIndex* pResult)
@@ -1116,11 +1167,13 @@ Pedalboard Storage::GetPreset(int64_t instanceId) const
 int64_t Storage::DeletePresets(const std::vector<int64_t>& presetInstanceIds)
 {
     int64_t newSelection = currentBank.selectedPreset();
+    // deleting the last preset adds a default preset.
+    int64_t newPresetsAfter = currentBank.nextInstanceId();
     for (auto presetId : presetInstanceIds)
     {
         newSelection = currentBank.deletePreset(presetId);
     }
-    SaveCurrentBank();
+    SaveCurrentBankIndex(newPresetsAfter);
     return newSelection;
 }
 
@@ -1128,7 +1181,8 @@ bool Storage::RenamePreset(int64_t presetId, const std::string& name)
 {
     if (this->currentBank.renamePreset(presetId, name))
     {
-        SaveCurrentBank();
+        SaveCurrentBankPreset(presetId);
+        SaveCurrentBankIndex();
         return true;
     }
     return false;
@@ -1209,8 +1263,9 @@ int64_t Storage::CreateNewPreset()
         }
     }
     newPedalboard.name(name);
+    int64_t newPresetsAfter = currentBank.nextInstanceId();
     auto t = this->currentBank.addPreset(newPedalboard, -1);
-    SaveCurrentBank();
+    SaveCurrentBankIndex(newPresetsAfter);
     return t;
 }
 
@@ -1223,15 +1278,18 @@ int64_t Storage::CopyPreset(int64_t fromId, int64_t toId)
         Pedalboard newPedalboard = fromItem.preset();
         std::string name = GetPresetCopyName(fromItem.preset().name());
         newPedalboard.name(name);
+        int64_t newPresetsAfter = currentBank.nextInstanceId();
         result = this->currentBank.addPreset(newPedalboard, fromId);
+        SaveCurrentBankIndex(newPresetsAfter);
     }
     else
     {
         auto& toItem = this->currentBank.getItem(toId);
         toItem.preset(fromItem.preset());
         result = toId;
+        SaveCurrentBankPreset(toId);
+        SaveCurrentBankIndex();
     }
-    SaveCurrentBank();
     return result;
 }
 
@@ -1395,8 +1453,8 @@ void Storage::RenameBank(int64_t bankId, const std::string& newName)
         throw PiPedalStateException("A bank by that name already exists.");
     }
     auto& entry = this->bankIndex.getBankIndexEntry(bankId);
-    std::filesystem::path oldPath = this->GetBankFileName(entry.name());
-    std::filesystem::path newPath = this->GetBankFileName(newName);
+    std::filesystem::path oldPath = this->GetBankPath(entry.name());
+    std::filesystem::path newPath = this->GetBankPath(newName);
     try
     {
         std::filesystem::rename(oldPath, newPath);
@@ -1419,11 +1477,11 @@ int64_t Storage::SaveBankAs(int64_t bankId, const std::string& newName)
         throw PiPedalStateException("A bank by that name already exists.");
     }
     auto& entry = this->bankIndex.getBankIndexEntry(bankId);
-    std::filesystem::path oldPath = this->GetBankFileName(entry.name());
-    std::filesystem::path newPath = this->GetBankFileName(newName);
+    std::filesystem::path oldPath = this->GetBankPath(entry.name());
+    std::filesystem::path newPath = this->GetBankPath(newName);
     try
     {
-        std::filesystem::copy(oldPath, newPath);
+        std::filesystem::copy(oldPath, newPath, std::filesystem::copy_options::recursive);
     }
     catch (std::exception& e)
     {
@@ -1463,7 +1521,7 @@ int64_t Storage::DeleteBank(int64_t bankId)
 
         if (entry.instanceId() == bankId)
         {
-            std::filesystem::path fileName = this->GetBankFileName(entry.name());
+            std::filesystem::path fileName = this->GetBankPath(entry.name());
             entries.erase(entries.begin() + i);
 
             int64_t newSelection;
@@ -1496,7 +1554,8 @@ int64_t Storage::DeleteBank(int64_t bankId)
                 this->bankIndex.selectedBank(newSelection);
             }
             this->SaveBankIndex();
-            std::filesystem::remove(fileName);
+            std::filesystem::remove_all(fileName);
+            CollectBlobGarbage();
             return newSelection;
         }
     }
@@ -1511,6 +1570,7 @@ int64_t Storage::GetCurrentPresetId() const
 int64_t Storage::UploadPreset(const BankFile& bankFile, int64_t uploadAfter)
 {
     int64_t lastPreset = this->currentBank.selectedPreset();
+    int64_t newPresetsAfter = this->currentBank.nextInstanceId();
     if (uploadAfter != -1)
     {
         lastPreset = uploadAfter;
@@ -1535,7 +1595,7 @@ int64_t Storage::UploadPreset(const BankFile& bankFile, int64_t uploadAfter)
 
         lastPreset = this->currentBank.addPreset(preset, lastPreset);
     }
-    this->SaveCurrentBank();
+    this->SaveCurrentBankIndex(newPresetsAfter);
     return lastPreset;
 }
 int64_t Storage::UploadBank(BankFile& bankFile, int64_t uploadAfter)
@@ -1560,14 +1620,7 @@ int64_t Storage::UploadBank(BankFile& bankFile, int64_t uploadAfter)
         s << baseName << "(" << n++ << ")";
         bankFile.name(s.str());
     }
-    std::filesystem::path path = this->GetBankFileName(bankFile.name());
-    pipedal::ofstream_synced f(path);
-    if (!f.is_open())
-    {
-        throw PiPedalException("Can't write to bank file.");
-    }
-    json_writer writer(f, true);
-    writer.write(bankFile);
+    SaveBankFile(bankFile.name(), bankFile);
 
     lastBank = this->bankIndex.addBank(lastBank, bankFile.name());
     this->SaveBankIndex();
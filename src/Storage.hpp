@@ -24,6 +24,7 @@
 #include "Presets.hpp"
 #include "PluginPreset.hpp"
 #include "Banks.hpp"
+#include "BankStore.hpp"
 #include "JackConfiguration.hpp"
 #include "JackServerSettings.hpp"
 #include "WifiConfigSettings.hpp"
@@ -77,6 +78,7 @@ private:
     std::filesystem::path configRoot;
     BankIndex bankIndex;
     BankFile currentBank;
+    std::unique_ptr<BlobStore> blobStore;
     PluginPresetIndex pluginPresetIndex;
     
 private:
@@ -96,7 +98,8 @@ private:
     std::filesystem::path GetPresetsDirectory() const;
     std::filesystem::path GetPluginPresetsDirectory() const;
     std::filesystem::path GetIndexFileName() const;
-    std::filesystem::path GetBankFileName(const std::string & name) const;
+    std::filesystem::path GetBankPath(const std::string & name) const;
+    std::filesystem::path GetBlobsDirectory() const;
     std::filesystem::path GetChannelSelectionFileName();
     std::filesystem::path GetAlsaSequencerConfigurationFileName();
     std::filesystem::path GetCurrentPresetPath() const;
@@ -105,7 +108,11 @@ private:
     void SaveBankIndex();
     void ReIndex();
     void LoadCurrentBank();
-    void SaveCurrentBank();
+    // Writes the current bank's index, preceded by the bodies of presets whose instance ids are greater than newPresetsAfter.
+    void SaveCurrentBankIndex(int64_t newPresetsAfter = INT64_MAX);
+    void SaveCurrentBankPreset(int64_t instanceId);
+    void MigrateBankFiles();
+    void CollectBlobGarbage();
 
     void LoadJackChannelSelection();
     void SaveChannelSelection();
@@ -155,6 +162,7 @@ public:
     //std::vector<std::string> GetPedalboards();
 
     const BankIndex & GetBanks() const { return bankIndex; }
+    BlobStore *GetBlobStore() { return blobStore.get(); }
 
     JackServerSettings GetJackServerSettings();
     void SetJackServerSettings(const pipedal::JackServerSettings&jackServerSettings);
@@ -0,0 +1,261 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "VuMeterKernels.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VU_METER_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VU_METER_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace pipedal;
+
+namespace
+{
+    float MaxAbsScalar(const float *input, size_t samples, float initialValue)
+    {
+        float peak = initialValue;
+        for (size_t i = 0; i < samples; ++i)
+        {
+            float t = std::fabs(input[i]);
+            if (t > peak)
+            {
+                peak = t;
+            }
+        }
+        return peak;
+    }
+
+    VuLevel MeasureScalar(const float *input, size_t samples)
+    {
+        VuLevel result;
+        float peak = 0;
+        float sumOfSquares = 0;
+        for (size_t i = 0; i < samples; ++i)
+        {
+            float v = input[i];
+            float t = std::fabs(v);
+            if (t > peak)
+            {
+                peak = t;
+            }
+            sumOfSquares += v * v;
+        }
+        result.peak = peak;
+        result.sumOfSquares = sumOfSquares;
+        return result;
+    }
+
+#ifdef VU_METER_X86
+    ////////////////////////////////////////////////////////////////////////////////
+    // SSE2 kernels. _mm_max_ps(a,b) returns b if either argument is a NaN, so the
+    // running maximum is always passed as the second argument.
+
+    inline __m128 AbsSse2(__m128 v)
+    {
+        return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+    }
+    inline float HorizontalMaxSse2(__m128 v)
+    {
+        v = _mm_max_ps(_mm_movehl_ps(v, v), v);
+        v = _mm_max_ss(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), v);
+        return _mm_cvtss_f32(v);
+    }
+    inline float HorizontalSumSse2(__m128 v)
+    {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    float MaxAbsSse2(const float *input, size_t samples, float initialValue)
+    {
+        __m128 peak0 = _mm_set1_ps(initialValue);
+        __m128 peak1 = peak0;
+        size_t i = 0;
+        for (; i + 8 <= samples; i += 8)
+        {
+            peak0 = _mm_max_ps(AbsSse2(_mm_loadu_ps(input + i)), peak0);
+            peak1 = _mm_max_ps(AbsSse2(_mm_loadu_ps(input + i + 4)), peak1);
+        }
+        float peak = HorizontalMaxSse2(_mm_max_ps(peak0, peak1));
+        return MaxAbsScalar(input + i, samples - i, peak);
+    }
+
+    VuLevel MeasureSse2(const float *input, size_t samples)
+    {
+        __m128 peak0 = _mm_setzero_ps();
+        __m128 peak1 = peak0;
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = sum0;
+        size_t i = 0;
+        for (; i + 8 <= samples; i += 8)
+        {
+            __m128 v0 = _mm_loadu_ps(input + i);
+            __m128 v1 = _mm_loadu_ps(input + i + 4);
+            peak0 = _mm_max_ps(AbsSse2(v0), peak0);
+            peak1 = _mm_max_ps(AbsSse2(v1), peak1);
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(v0, v0));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(v1, v1));
+        }
+        VuLevel tail = MeasureScalar(input + i, samples - i);
+        VuLevel result;
+        result.peak = std::max(HorizontalMaxSse2(_mm_max_ps(peak0, peak1)), tail.peak);
+        result.sumOfSquares = HorizontalSumSse2(_mm_add_ps(sum0, sum1)) + tail.sumOfSquares;
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // AVX2 kernels. Selected at runtime, so they are compiled with a target attribute rather than -mavx2.
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+    AVX2_TARGET inline __m256 AbsAvx2(__m256 v)
+    {
+        return _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)));
+    }
+    AVX2_TARGET inline __m128 MaxHalvesAvx2(__m256 v)
+    {
+        return _mm_max_ps(_mm256_extractf128_ps(v, 1), _mm256_castps256_ps128(v));
+    }
+    AVX2_TARGET inline __m128 SumHalvesAvx2(__m256 v)
+    {
+        return _mm_add_ps(_mm256_extractf128_ps(v, 1), _mm256_castps256_ps128(v));
+    }
+
+    AVX2_TARGET float MaxAbsAvx2(const float *input, size_t samples, float initialValue)
+    {
+        __m256 peak0 = _mm256_set1_ps(initialValue);
+        __m256 peak1 = peak0;
+        size_t i = 0;
+        for (; i + 16 <= samples; i += 16)
+        {
+            peak0 = _mm256_max_ps(AbsAvx2(_mm256_loadu_ps(input + i)), peak0);
+            peak1 = _mm256_max_ps(AbsAvx2(_mm256_loadu_ps(input + i + 8)), peak1);
+        }
+        float peak = HorizontalMaxSse2(MaxHalvesAvx2(_mm256_max_ps(peak0, peak1)));
+        return MaxAbsScalar(input + i, samples - i, peak);
+    }
+
+    AVX2_TARGET VuLevel MeasureAvx2(const float *input, size_t samples)
+    {
+        __m256 peak0 = _mm256_setzero_ps();
+        __m256 peak1 = peak0;
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = sum0;
+        size_t i = 0;
+        for (; i + 16 <= samples; i += 16)
+        {
+            __m256 v0 = _mm256_loadu_ps(input + i);
+            __m256 v1 = _mm256_loadu_ps(input + i + 8);
+            peak0 = _mm256_max_ps(AbsAvx2(v0), peak0);
+            peak1 = _mm256_max_ps(AbsAvx2(v1), peak1);
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(v0, v0));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(v1, v1));
+        }
+        VuLevel tail = MeasureScalar(input + i, samples - i);
+        VuLevel result;
+        result.peak = std::max(HorizontalMaxSse2(MaxHalvesAvx2(_mm256_max_ps(peak0, peak1))), tail.peak);
+        result.sumOfSquares = HorizontalSumSse2(SumHalvesAvx2(_mm256_add_ps(sum0, sum1))) + tail.sumOfSquares;
+        return result;
+    }
+#endif
+
+#ifdef VU_METER_NEON
+    ////////////////////////////////////////////////////////////////////////////////
+    // NEON kernels. vmaxnmq_f32 returns the numeric argument if one argument is a NaN.
+
+    float MaxAbsNeon(const float *input, size_t samples, float initialValue)
+    {
+        float32x4_t peak0 = vdupq_n_f32(initialValue);
+        float32x4_t peak1 = peak0;
+        size_t i = 0;
+        for (; i + 8 <= samples; i += 8)
+        {
+            peak0 = vmaxnmq_f32(peak0, vabsq_f32(vld1q_f32(input + i)));
+            peak1 = vmaxnmq_f32(peak1, vabsq_f32(vld1q_f32(input + i + 4)));
+        }
+        float peak = vmaxnmvq_f32(vmaxnmq_f32(peak0, peak1));
+        return MaxAbsScalar(input + i, samples - i, peak);
+    }
+
+    VuLevel MeasureNeon(const float *input, size_t samples)
+    {
+        float32x4_t peak0 = vdupq_n_f32(0);
+        float32x4_t peak1 = peak0;
+        float32x4_t sum0 = vdupq_n_f32(0);
+        float32x4_t sum1 = sum0;
+        size_t i = 0;
+        for (; i + 8 <= samples; i += 8)
+        {
+            float32x4_t v0 = vld1q_f32(input + i);
+            float32x4_t v1 = vld1q_f32(input + i + 4);
+            peak0 = vmaxnmq_f32(peak0, vabsq_f32(v0));
+            peak1 = vmaxnmq_f32(peak1, vabsq_f32(v1));
+            sum0 = vmlaq_f32(sum0, v0, v0);
+            sum1 = vmlaq_f32(sum1, v1, v1);
+        }
+        VuLevel tail = MeasureScalar(input + i, samples - i);
+        VuLevel result;
+        result.peak = std::max(vmaxnmvq_f32(vmaxnmq_f32(peak0, peak1)), tail.peak);
+        result.sumOfSquares = vaddvq_f32(vaddq_f32(sum0, sum1)) + tail.sumOfSquares;
+        return result;
+    }
+#endif
+}
+
+VuMeterKernels pipedal::GetVuMeterKernels(SimdLevel level)
+{
+    VuMeterKernels result;
+    result.maxAbs = &MaxAbsScalar;
+    result.measure = &MeasureScalar;
+    switch (level)
+    {
+#ifdef VU_METER_X86
+    case SimdLevel::Avx2:
+        result.maxAbs = &MaxAbsAvx2;
+        result.measure = &MeasureAvx2;
+        break;
+    case SimdLevel::Sse2:
+        result.maxAbs = &MaxAbsSse2;
+        result.measure = &MeasureSse2;
+        break;
+#endif
+#ifdef VU_METER_NEON
+    case SimdLevel::Neon:
+        result.maxAbs = &MaxAbsNeon;
+        result.measure = &MeasureNeon;
+        break;
+#endif
+    default:
+        break;
+    }
+    return result;
+}
+
+const VuMeterKernels &pipedal::GetDefaultVuMeterKernels()
+{
+    static VuMeterKernels kernels = GetVuMeterKernels(GetBestSimdLevel());
+    return kernels;
+}
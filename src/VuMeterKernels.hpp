@@ -0,0 +1,66 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include "AlsaFormatConversion.hpp" // SimdLevel
+
+namespace pipedal
+{
+    // Peak absolute value and sum of squares of a block of samples.
+    struct VuLevel
+    {
+        float peak = 0;
+        float sumOfSquares = 0;
+    };
+
+    /**
+     * @brief Level metering kernels.
+     *
+     * maxAbs returns the larger of initialValue and the peak absolute value of a buffer. measure computes
+     * the peak absolute value and the sum of squares of a buffer in a single pass. NaNs are ignored.
+     *
+     * Peak values are identical for every SimdLevel. Sums of squares are accumulated in a different order,
+     * so may differ in the last few bits.
+     */
+    struct VuMeterKernels
+    {
+        using MaxAbsFunction = float (*)(const float *input, size_t samples, float initialValue);
+        using MeasureFunction = VuLevel (*)(const float *input, size_t samples);
+
+        MaxAbsFunction maxAbs = nullptr;
+        MeasureFunction measure = nullptr;
+    };
+
+    // Kernels for the requested instruction set. Falls back to Scalar kernels if level is not available on this architecture.
+    VuMeterKernels GetVuMeterKernels(SimdLevel level);
+
+    // Kernels for the best instruction set supported by the current CPU.
+    const VuMeterKernels &GetDefaultVuMeterKernels();
+
+    inline float MaxAbs(const float *input, size_t samples, float initialValue = 0)
+    {
+        return GetDefaultVuMeterKernels().maxAbs(input, samples, initialValue);
+    }
+    inline VuLevel MeasureVuLevel(const float *input, size_t samples)
+    {
+        return GetDefaultVuMeterKernels().measure(input, samples);
+    }
+}
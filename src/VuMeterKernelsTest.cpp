@@ -0,0 +1,162 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "VuMeterKernels.hpp"
+#include "VuUpdate.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <random>
+
+using namespace pipedal;
+using namespace std;
+
+static std::vector<float> MakeVuTestSignal(size_t samples, std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+    std::vector<float> result(samples);
+    for (size_t i = 0; i < samples; ++i)
+    {
+        result[i] = distribution(random);
+    }
+    return result;
+}
+
+static double ReferenceSumOfSquares(const std::vector<float> &signal)
+{
+    double result = 0;
+    for (float v : signal)
+    {
+        result += (double)v * v;
+    }
+    return result;
+}
+
+TEST_CASE("VU meter kernels match scalar kernels", "[vu_meter_kernels][Build]")
+{
+    std::mt19937 random(1234);
+    // odd sizes exercise the scalar tails of the SIMD kernels.
+    const size_t sampleCounts[] = {0, 1, 7, 8, 31, 64, 129, 1027};
+    VuMeterKernels scalar = GetVuMeterKernels(SimdLevel::Scalar);
+
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        INFO(GetSimdLevelName(level));
+        VuMeterKernels kernels = GetVuMeterKernels(level);
+        for (size_t samples : sampleCounts)
+        {
+            INFO("samples: " << samples);
+            std::vector<float> signal = MakeVuTestSignal(samples, random);
+            if (samples > 5)
+            {
+                // place the peak in the tail, and a negative peak in the body.
+                signal[samples - 1] = 1.75f;
+                signal[samples / 2] = -1.625f;
+            }
+            REQUIRE(kernels.maxAbs(signal.data(), samples, 0) == scalar.maxAbs(signal.data(), samples, 0));
+            REQUIRE(kernels.maxAbs(signal.data(), samples, 2.0f) == 2.0f);
+
+            VuLevel expected = scalar.measure(signal.data(), samples);
+            VuLevel actual = kernels.measure(signal.data(), samples);
+            REQUIRE(actual.peak == expected.peak);
+            REQUIRE(actual.sumOfSquares == Approx(ReferenceSumOfSquares(signal)).epsilon(1E-5).margin(1E-6));
+        }
+    }
+}
+
+TEST_CASE("VU meter kernels ignore NaNs", "[vu_meter_kernels][Build]")
+{
+    std::vector<float> signal(37, 0.25f);
+    signal[3] = std::numeric_limits<float>::quiet_NaN();
+    signal[20] = -0.5f;
+    signal[33] = std::numeric_limits<float>::quiet_NaN();
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        INFO(GetSimdLevelName(level));
+        VuMeterKernels kernels = GetVuMeterKernels(level);
+        REQUIRE(kernels.maxAbs(signal.data(), signal.size(), 0) == 0.5f);
+        REQUIRE(kernels.measure(signal.data(), signal.size()).peak == 0.5f);
+    }
+}
+
+TEST_CASE("VU updates accumulate peak and RMS levels", "[vu_meter_kernels][Build]")
+{
+    std::vector<float> loud(64, 0.5f);
+    std::vector<float> quiet(64, -0.25f);
+
+    VuUpdateX vuUpdate;
+    vuUpdate.AccumulateInputs(loud.data(), 64);
+    vuUpdate.AccumulateInputs(quiet.data(), 64);
+    vuUpdate.AccumulateOutputs(quiet.data(), quiet.data(), 64);
+    vuUpdate.UpdateRms();
+
+    REQUIRE(vuUpdate.inputMaxValueL_ == 0.5f);
+    REQUIRE(vuUpdate.inputRmsValueL_ == Approx(std::sqrt((0.25 + 0.0625) / 2)));
+    REQUIRE(vuUpdate.outputMaxValueL_ == 0.25f);
+    REQUIRE(vuUpdate.outputMaxValueR_ == 0.25f);
+    REQUIRE(vuUpdate.outputRmsValueR_ == Approx(0.25));
+
+    vuUpdate.reset();
+    vuUpdate.UpdateRms();
+    REQUIRE(vuUpdate.inputMaxValueL_ == 0);
+    REQUIRE(vuUpdate.inputRmsValueL_ == 0);
+}
+
+// Not run by default. Reports the cost of metering one buffer.
+TEST_CASE("VU meter kernels benchmark", "[vu_meter_kernels_benchmark]")
+{
+    using clock_t = std::chrono::steady_clock;
+    constexpr size_t FRAMES = 64;
+    constexpr size_t ITERATIONS = 1000000;
+
+    std::mt19937 random(1234);
+    std::vector<float> signal = MakeVuTestSignal(FRAMES, random);
+
+    cout << "VU meter kernels, ns/buffer (" << FRAMES << " frames)" << endl;
+    cout << setw(10) << "simd" << setw(10) << "peak" << setw(12) << "peak+rms" << endl;
+    cout << fixed << setprecision(2);
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        VuMeterKernels kernels = GetVuMeterKernels(level);
+        volatile float sink = 0;
+
+        auto start = clock_t::now();
+        for (size_t i = 0; i < ITERATIONS; ++i)
+        {
+            sink = kernels.maxAbs(signal.data(), FRAMES, 0);
+        }
+        double peakNs = std::chrono::duration<double, std::nano>(clock_t::now() - start).count();
+
+        start = clock_t::now();
+        for (size_t i = 0; i < ITERATIONS; ++i)
+        {
+            sink = kernels.measure(signal.data(), FRAMES).sumOfSquares;
+        }
+        double measureNs = std::chrono::duration<double, std::nano>(clock_t::now() - start).count();
+
+        cout << setw(10) << GetSimdLevelName(level)
+             << setw(10) << peakNs / ITERATIONS
+             << setw(12) << measureNs / ITERATIONS
+             << endl;
+    }
+}
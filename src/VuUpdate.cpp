@@ -32,5 +32,9 @@ JSON_MAP_BEGIN(VuUpdateX)
     JSON_MAP_REFERENCE(VuUpdateX,inputMaxValueR)
     JSON_MAP_REFERENCE(VuUpdateX,outputMaxValueL)
     JSON_MAP_REFERENCE(VuUpdateX,outputMaxValueR)
+    JSON_MAP_REFERENCE(VuUpdateX,inputRmsValueL)
+    JSON_MAP_REFERENCE(VuUpdateX,inputRmsValueR)
+    JSON_MAP_REFERENCE(VuUpdateX,outputRmsValueL)
+    JSON_MAP_REFERENCE(VuUpdateX,outputRmsValueR)
 JSON_MAP_END()
 
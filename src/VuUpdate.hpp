@@ -21,6 +21,8 @@
 
 #include "json.hpp"
 #include "Pedalboard.hpp"
+#include "VuMeterKernels.hpp"
+#include <cmath>
 
 namespace pipedal
 {
@@ -35,6 +37,32 @@ namespace pipedal
         float inputMaxValueR_ = 0;
         float outputMaxValueL_ = 0;
         float outputMaxValueR_ = 0;
+        // RMS levels since the last update. Computed by UpdateRms().
+        float inputRmsValueL_ = 0;
+        float inputRmsValueR_ = 0;
+        float outputRmsValueL_ = 0;
+        float outputRmsValueR_ = 0;
+
+    private:
+        double inputSumOfSquaresL = 0;
+        double inputSumOfSquaresR = 0;
+        double outputSumOfSquaresL = 0;
+        double outputSumOfSquaresR = 0;
+        uint64_t inputSamples = 0;
+        uint64_t outputSamples = 0;
+
+        static void Accumulate(float *maxValue, double *sumOfSquares, const VuLevel &level)
+        {
+            if (level.peak > *maxValue)
+            {
+                *maxValue = level.peak;
+            }
+            *sumOfSquares += level.sumOfSquares;
+        }
+        static float Rms(double sumOfSquares, uint64_t samples)
+        {
+            return samples == 0 ? 0.0f : (float)std::sqrt(sumOfSquares / samples);
+        }
 
     public:
         void reset() {
@@ -42,43 +70,89 @@ namespace pipedal
             inputMaxValueR_ = 0;
             outputMaxValueL_ = 0;
             outputMaxValueR_ = 0;
+            inputSumOfSquaresL = 0;
+            inputSumOfSquaresR = 0;
+            outputSumOfSquaresL = 0;
+            outputSumOfSquaresR = 0;
+            inputSamples = 0;
+            outputSamples = 0;
+        }
+
+        void UpdateRms()
+        {
+            inputRmsValueL_ = Rms(inputSumOfSquaresL, inputSamples);
+            inputRmsValueR_ = Rms(inputSumOfSquaresR, inputSamples);
+            outputRmsValueL_ = Rms(outputSumOfSquaresL, outputSamples);
+            outputRmsValueR_ = Rms(outputSumOfSquaresR, outputSamples);
+        }
+
+        // Accumulate levels that have already been measured (see MeasureVuLevel).
+        void AccumulateInputs(const VuLevel &level, uint32_t samples)
+        {
+            Accumulate(&inputMaxValueL_, &inputSumOfSquaresL, level);
+            inputSamples += samples;
+        }
+        void AccumulateInputs(const VuLevel &levelL, const VuLevel &levelR, uint32_t samples)
+        {
+            Accumulate(&inputMaxValueL_, &inputSumOfSquaresL, levelL);
+            Accumulate(&inputMaxValueR_, &inputSumOfSquaresR, levelR);
+            inputSamples += samples;
+        }
+        void AccumulateOutputs(const VuLevel &level, uint32_t samples)
+        {
+            Accumulate(&outputMaxValueL_, &outputSumOfSquaresL, level);
+            outputSamples += samples;
+        }
+        void AccumulateOutputs(const VuLevel &levelL, const VuLevel &levelR, uint32_t samples)
+        {
+            Accumulate(&outputMaxValueL_, &outputSumOfSquaresL, levelL);
+            Accumulate(&outputMaxValueR_, &outputSumOfSquaresR, levelR);
+            outputSamples += samples;
         }
-        
+
         void AccumulateVu(float *value,float *input, uint32_t samples)
         {
             if (input == nullptr) {
                 *value = 0;
                 return;               
             }
-            float v = *value;
-            for (uint32_t i = 0; i < samples; ++i)
-            {
-                float t = std::abs(input[i]);
-                if (t > v) {
-                    v = t;
-                }
-            }
-            *value = v;
+            *value = MaxAbs(input, samples, *value);
         }
         void AccumulateInputs(float* input, uint32_t samples)
         {
-            AccumulateVu(&inputMaxValueL_,input,samples);
-
+            if (input == nullptr) {
+                inputMaxValueL_ = 0;
+                return;
+            }
+            AccumulateInputs(MeasureVuLevel(input, samples), samples);
         }
         void AccumulateInputs(float* inputL, float*inputR, uint32_t samples)
         {
-            AccumulateVu(&inputMaxValueL_,inputL,samples);
-            AccumulateVu(&inputMaxValueR_,inputR,samples);
+            if (inputL == nullptr || inputR == nullptr) {
+                AccumulateVu(&inputMaxValueL_,inputL,samples);
+                AccumulateVu(&inputMaxValueR_,inputR,samples);
+                return;
+            }
+            VuLevel levelL = MeasureVuLevel(inputL, samples);
+            AccumulateInputs(levelL, inputR == inputL ? levelL : MeasureVuLevel(inputR, samples), samples);
         }
         void AccumulateOutputs(float* output, uint32_t samples)
         {
-            AccumulateVu(&outputMaxValueL_,output,samples);
-
+            if (output == nullptr) {
+                outputMaxValueL_ = 0;
+                return;
+            }
+            AccumulateOutputs(MeasureVuLevel(output, samples), samples);
         }
         void AccumulateOutputs(float* outputL, float*outputR, uint32_t samples)
         {
-            AccumulateVu(&outputMaxValueL_,outputL,samples);
-            AccumulateVu(&outputMaxValueR_,outputR,samples);
+            if (outputL == nullptr || outputR == nullptr) {
+                AccumulateVu(&outputMaxValueL_,outputL,samples);
+                AccumulateVu(&outputMaxValueR_,outputR,samples);
+                return;
+            }
+            VuLevel levelL = MeasureVuLevel(outputL, samples);
+            AccumulateOutputs(levelL, outputR == outputL ? levelL : MeasureVuLevel(outputR, samples), samples);
         }
 
         DECLARE_JSON_MAP(VuUpdateX);
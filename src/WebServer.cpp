@@ -796,11 +796,19 @@ namespace pipedal
                 webSocket = nullptr;
             }
 
-            virtual void writeCallback(const std::string& text)
+            virtual void writeCallback(std::string_view text)
             {
                 if (webSocket)
                 {
-                    webSocket->send(text, websocketpp::frame::opcode::text);
+                    // copied once, directly into the outgoing message.
+                    webSocket->send(text.data(), text.size(), websocketpp::frame::opcode::text);
+                }
+            }
+            virtual void writeBinaryCallback(const void *data, size_t size)
+            {
+                if (webSocket)
+                {
+                    webSocket->send(data, size, websocketpp::frame::opcode::binary);
                 }
             }
             virtual std::string getFromAddress() const
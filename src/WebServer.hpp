@@ -90,7 +90,8 @@ public:
     public:
         virtual void close() = 0;
 
-        virtual void writeCallback(const std::string& text) = 0;
+        virtual void writeCallback(std::string_view text) = 0;
+        virtual void writeBinaryCallback(const void *data, size_t size) = 0;
         virtual std::string getFromAddress() const = 0;
     };
 
@@ -111,12 +112,18 @@ public:
     void receive(const std::string_view&text) {
         onReceive(text);
     }
-    void send(const std::string &text) {
+    void send(std::string_view text) {
         if (writeCallback_ != nullptr)
         {
             writeCallback_->writeCallback(text);
         }
     }
+    void sendBinary(const void *data, size_t size) {
+        if (writeCallback_ != nullptr)
+        {
+            writeCallback_->writeBinaryCallback(data, size);
+        }
+    }
     virtual void OnSocketClosed()
     {
         writeCallback_ = nullptr;
@@ -25,6 +25,7 @@
 #include "PiPedalConfiguration.hpp"
 #include "PiPedalModel.hpp"
 #include "Banks.hpp"
+#include "BankStore.hpp"
 #include "Ipv6Helpers.hpp"
 #include <memory>
 #include "ZipFile.hpp"
@@ -217,14 +218,11 @@ namespace pipedal::implementation {
         }
 
         BankFile existingBankFile;
-        {
-            std::ifstream ifs{ existingBankFilePath };
-            if (!ifs.is_open()) {
-                return;
-            }
-            json_reader reader{ ifs };
-            reader.read(&existingBankFile);
+        BankStore existingBankStore{ existingBankFilePath, model.GetStorage().GetBlobStore() };
+        if (!existingBankStore.Exists()) {
+            return;
         }
+        existingBankStore.Load(&existingBankFile);
         // Overwrite specified presets.
         for (const std::string& presetToOverwrite : presetsToOverwrite)
         {
@@ -245,11 +243,7 @@ namespace pipedal::implementation {
                 existingBankFile.addPreset(newPreset->preset());
             }
         }
-        {
-            std::ofstream ofs{ existingBankFilePath };
-            json_writer writer{ ofs };
-            writer.write(existingBankFile);
-        }
+        existingBankStore.Save(existingBankFile);
 
 
     }
@@ -40,6 +40,7 @@
 #include "Lv2Log.hpp"
 #include <iostream>
 #include <utility>
+#include <cstring>
 #include "util.hpp"
 #include "SchedulerPriority.hpp"
 
@@ -47,14 +48,31 @@ using namespace pipedal;
 
 const int RING_BUFFER_SIZE = 64 * 1024;
 
-Worker::Worker(const std::shared_ptr<HostWorkerThread> &pHostWorker, LilvInstance *lilvInstance_, const LV2_Worker_Interface *workerInterface_)
+namespace
+{
+    struct RequestHeader
+    {
+        uint32_t size;
+        int64_t scheduledTime; // steady_clock, in nanoseconds.
+    };
+    int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+Worker::Worker(const std::shared_ptr<HostWorkerPool> &pHostWorker, LilvInstance *lilvInstance_, const LV2_Worker_Interface *workerInterface_, const std::string &name, int64_t instanceId)
     : lilvInstance(lilvInstance_),
       pHostWorker(pHostWorker),
-      responseRingBuffer(RING_BUFFER_SIZE),
-      workerInterface(workerInterface_)
+      workerInterface(workerInterface_),
+      requestRingBuffer(RING_BUFFER_SIZE),
+      responseRingBuffer(RING_BUFFER_SIZE)
 {
 
     responseBuffer.resize(16 * 1024);
+    stats.name_ = name;
+    stats.instanceId_ = instanceId;
+    pHostWorker->Register(this);
 }
 
 void Worker::Close()
@@ -71,6 +89,7 @@ void Worker::Close()
 Worker::~Worker()
 {
     Close();
+    pHostWorker->Unregister(this);
 }
 
 LV2_Worker_Status Worker::worker_respond_fn(LV2_Worker_Respond_Handle handle, uint32_t size, const void *data)
@@ -85,8 +104,8 @@ LV2_Worker_Status Worker::WorkerRespond(uint32_t size, const void *data)
         std::lock_guard lock(outstandingRequestMutex);
         ++outstandingResponses;
     }
-    LV2_Worker_Status status;
-    if (responseRingBuffer.writeSpace() < sizeof(size) + size)
+    RingBuffer<true, false>::Reservation reservation;
+    if (!responseRingBuffer.reserve(sizeof(size) + size, reservation))
     {
         {
             Lv2Log::warning(SS("LV2 Worker response too large: " << size << " bytes."));
@@ -98,14 +117,9 @@ LV2_Worker_Status Worker::WorkerRespond(uint32_t size, const void *data)
     }
     else
     {
-        if (!responseRingBuffer.write(sizeof(size), (uint8_t *)&size))
-        {
-            throw std::logic_error("Response queue sync lost.");
-        }
-        if (!responseRingBuffer.write(size, (uint8_t *)data))
-        {
-            throw std::logic_error("Response queue sync lost.");
-        }
+        responseRingBuffer.write(reservation, 0, sizeof(size), &size);
+        responseRingBuffer.write(reservation, sizeof(size), size, data);
+        responseRingBuffer.commit(reservation);
         return LV2_WORKER_SUCCESS;
     }
 }
@@ -177,8 +191,24 @@ LV2_Worker_Status Worker::ScheduleWork(
     {
         std::lock_guard lock(outstandingRequestMutex);
         ++outstandingRequests;
+        if (outstandingRequests > maxOutstandingRequests)
+        {
+            maxOutstandingRequests = outstandingRequests;
+        }
+    }
+    LV2_Worker_Status status = LV2_Worker_Status::LV2_WORKER_SUCCESS;
+    RequestHeader header{size, Now()};
+    RingBuffer<true, false>::Reservation reservation;
+    if (pHostWorker->closed || !requestRingBuffer.reserve(sizeof(header) + size, reservation))
+    {
+        status = LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+    }
+    else
+    {
+        requestRingBuffer.write(reservation, 0, sizeof(header), &header);
+        requestRingBuffer.write(reservation, sizeof(header), size, data);
+        requestRingBuffer.commit(reservation);
     }
-    LV2_Worker_Status status = this->pHostWorker->ScheduleWork(this, size, data);
     if (status != LV2_Worker_Status::LV2_WORKER_SUCCESS)
     {
         {
@@ -188,160 +218,211 @@ LV2_Worker_Status Worker::ScheduleWork(
             return status; 
         }
     }
+    pHostWorker->Schedule(this);
     return status;
 }
 
-void HostWorkerThread::ThreadProc() noexcept
+bool Worker::RunNextRequest(std::vector<uint8_t> &dataBuffer)
 {
-    // run nice +2 (priority -2 on Windows)
-    SetThreadName("lv2_worker");
-    SetThreadPriority(SchedulerPriority::Lv2Scheduler);
-
+    // requests are written as a single ring buffer record, so the data is always available once the header is.
+    RequestHeader header;
+    if (!requestRingBuffer.read(sizeof(header), (uint8_t *)&header))
+    {
+        return false;
+    }
+    if (header.size > dataBuffer.size())
+    {
+        dataBuffer.resize(header.size);
+    }
+    if (!requestRingBuffer.read(header.size, dataBuffer.data()))
+    {
+        throw PiPedalStateException("Worker ringbuffer read failed.");
+    }
+    int64_t startTime = Now();
+    RunBackgroundTask(header.size, dataBuffer.data());
+    int64_t endTime = Now();
+
+    std::lock_guard lock(pHostWorker->mutex);
+    double latencyMs = (startTime - header.scheduledTime) * 1E-6;
+    double workMs = (endTime - startTime) * 1E-6;
+    ++stats.requests_;
+    totalLatencyMs += latencyMs;
+    totalWorkMs += workMs;
+    stats.maxLatencyMs_ = std::max(stats.maxLatencyMs_, latencyMs);
+    stats.maxWorkMs_ = std::max(stats.maxWorkMs_, workMs);
+    return true;
+}
 
-    try
+void Worker::RunBackgroundTask(size_t size, uint8_t *data)
+{
+    try {
+        workerInterface->work(lilvInstance->lv2_handle, worker_respond_fn, (LV2_Handle)this, size, data);
+    } catch (const std::exception &e) 
     {
-        while (true)
+        Lv2Log::error(SS("Unhandled exception on LV2 Worker thread: " << e.what()));
+    }
+    {
+        std::lock_guard lock { this->outstandingRequestMutex};
+        --this->outstandingRequests;
+        if (this->outstandingRequests == 0)
         {
-            if (!requestRingBuffer.readWait())
-            {
-                return;
-            }
-            uint32_t size;
-
-            Worker *pWorker;
+            this->cvOutstandingRequests.notify_all();
+        }
 
-            if (!requestRingBuffer.read(sizeof(size), (uint8_t *)&size))
-            {
-                throw PiPedalStateException("Working ringbuffer read failed.");
-            }
+    }
 
-            if (!requestRingBuffer.read(sizeof(pWorker), (uint8_t *)&pWorker))
-            {
-                throw PiPedalStateException("Worker ringbuffer read failed.");
-            }
-            size -= sizeof(pWorker);
+}
 
-            if (size > dataBuffer.size())
-            {
-                dataBuffer.resize(size);
-            }
-            uint8_t *pData = &(dataBuffer[0]);
-            if (!requestRingBuffer.read(size, pData))
-            {
-                throw PiPedalStateException("Worker ringbuffer read failed.");
-            }
-            if (pWorker == nullptr) // signals close.
-            {
-                break;
-            }
-            pWorker->RunBackgroundTask(size, pData);
-        }
+HostWorkerPool::HostWorkerPool(size_t threadCount, int realtimePriority)
+    : realtimePriority(realtimePriority)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
     }
-    catch (const std::exception &e)
+    for (size_t i = 0; i < threadCount; ++i)
     {
-        Lv2Log::error("Lv2 Worker thread proc exited abnormally. (%s)", e.what());
+        threads.emplace_back([this, i]()
+                             { this->ThreadProc(i); });
     }
-    requestRingBuffer.close();
 }
 
-HostWorkerThread::HostWorkerThread()
+HostWorkerPool::~HostWorkerPool()
 {
-    this->dataBuffer.resize(16*1024);
+    Close();
 }
 
-bool HostWorkerThread::StartThread()
+void HostWorkerPool::Close()
 {
-    if (!pThread)
+    if (closed.exchange(true))
     {
-        if (closed) {
-            return false;
-        }
-        pThread = std::make_unique<std::thread>([this]()
-                                                { this->ThreadProc(); });
-    }    
-    return true;
+        return;
+    }
+    readyRingBuffer.close();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 }
 
-void HostWorkerThread::Close()
+void HostWorkerPool::Register(Worker *worker)
 {
+    std::lock_guard lock{mutex};
+    workers.insert(worker);
+}
 
-    {
-        std::lock_guard lock{submitMutex};
-        if (pThread) {
-            if (!closed)
-            {
-                closed = true;
-                ScheduleWorkNoLock(nullptr, 0, nullptr);
-            }
-        }
-    }
+void HostWorkerPool::Unregister(Worker *worker)
+{
+    std::unique_lock lock{mutex};
+    cvIdle.wait(lock, [worker]()
+                { return !worker->running; });
+    workers.erase(worker);
 }
-HostWorkerThread::~HostWorkerThread()
+
+void HostWorkerPool::Schedule(Worker *worker)
 {
-    if (pThread)
+    if (!worker->scheduled.exchange(true))
     {
-        // ask worker thread to terminate.
-        Close();
-        pThread->join();
-        pThread = nullptr;
+        // a single write, so that the reader never sees a partial packet.
+        uint32_t size = sizeof(worker);
+        uint8_t packet[sizeof(size) + sizeof(worker)];
+        memcpy(packet, &size, sizeof(size));
+        memcpy(packet + sizeof(size), &worker, sizeof(worker));
+        if (!readyRingBuffer.write(sizeof(packet), packet))
+        {
+            // Not expected, since a Worker is queued at most once. Pending requests run when the worker next schedules work.
+            worker->scheduled = false;
+        }
     }
 }
 
-LV2_Worker_Status HostWorkerThread::ScheduleWork(Worker *worker, size_t size, const void *data)
+void HostWorkerPool::ThreadProc(size_t threadIndex) noexcept
 {
-    std::lock_guard lock(submitMutex);
+    SetThreadName(SS("lv2worker" << threadIndex));
+    SetThreadRealtimePriority(realtimePriority, "Lv2 worker");
 
-    if (!StartThread()) { // ensures thread is running, when plugins haven't declared they want a worker thread.
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
-    }
-    if (exiting )
+    std::vector<uint8_t> dataBuffer(16 * 1024);
+    try
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+        while (true)
+        {
+            Worker *worker = nullptr;
+            {
+                std::lock_guard lock{readMutex};
+                if (!readyRingBuffer.readWait())
+                {
+                    break; // closed.
+                }
+                uint32_t size;
+                if (!readyRingBuffer.read(sizeof(size), (uint8_t *)&size) || size != sizeof(worker) || !readyRingBuffer.read(sizeof(worker), (uint8_t *)&worker))
+                {
+                    throw PiPedalStateException("Worker ringbuffer read failed.");
+                }
+            }
+            RunWorker(worker, dataBuffer);
+        }
     }
-    if (worker == nullptr)
+    catch (const std::exception &e)
     {
-        exiting = true;
+        Lv2Log::error(SS("Lv2 Worker thread proc exited abnormally. (" << e.what() << ")"));
     }
-    return ScheduleWorkNoLock(worker, size, data);
-
 }
-LV2_Worker_Status HostWorkerThread::ScheduleWorkNoLock(Worker *worker, size_t size, const void *data)
-{
 
-    if (requestRingBuffer.writeSpace() < sizeof(worker) + sizeof(size) + size)
+void HostWorkerPool::RunWorker(Worker *worker, std::vector<uint8_t> &dataBuffer)
+{
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+        std::lock_guard lock{mutex};
+        // A worker that is no longer registered was deleted after it was queued.
+        if (!workers.contains(worker) || worker->running)
+        {
+            return;
+        }
+        worker->running = true;
     }
-    size_t packetSizeL = (size + sizeof(worker));
-    uint32_t packetSize = (uint32_t)(packetSizeL);
-    if (packetSizeL != packetSize)
+    // One request per turn, so that workers with pending requests are serviced round-robin.
+    worker->RunNextRequest(dataBuffer);
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+        std::lock_guard lock{mutex};
+        worker->running = false;
+        worker->scheduled = false;
+        if (worker->requestRingBuffer.readSpace() != 0)
+        {
+            Schedule(worker);
+        }
+        cvIdle.notify_all();
     }
-
-    requestRingBuffer.write(sizeof(packetSize), (uint8_t *)&packetSize);
-    requestRingBuffer.write(sizeof(worker), (uint8_t *)&worker);
-    requestRingBuffer.write(size, (uint8_t *)data);
-    
-    return LV2_Worker_Status::LV2_WORKER_SUCCESS;
 }
 
-void Worker::RunBackgroundTask(size_t size, uint8_t *data)
+std::vector<Lv2WorkerStats> HostWorkerPool::GetStats()
 {
-    try {
-        workerInterface->work(lilvInstance->lv2_handle, worker_respond_fn, (LV2_Handle)this, size, data);
-    } catch (const std::exception &e) 
+    std::vector<Lv2WorkerStats> result;
+    std::lock_guard lock{mutex};
+    for (Worker *worker : workers)
     {
-        Lv2Log::error(SS("Unhandled exception on LV2 Worker thread: " << e.what()));
-    }
-    {
-        std::lock_guard lock { this->outstandingRequestMutex};
-        --this->outstandingRequests;
-        if (this->outstandingRequests == 0)
+        Lv2WorkerStats stats = worker->stats;
         {
-            this->cvOutstandingRequests.notify_all();
+            std::lock_guard requestLock{worker->outstandingRequestMutex};
+            stats.queueDepth_ = (uint64_t)std::max(worker->outstandingRequests, (int64_t)0);
+            stats.maxQueueDepth_ = (uint64_t)worker->maxOutstandingRequests;
         }
-
+        if (stats.requests_ != 0)
+        {
+            stats.averageLatencyMs_ = worker->totalLatencyMs / stats.requests_;
+            stats.averageWorkMs_ = worker->totalWorkMs / stats.requests_;
+        }
+        result.push_back(std::move(stats));
     }
-
+    return result;
 }
+
+JSON_MAP_BEGIN(Lv2WorkerStats)
+JSON_MAP_REFERENCE(Lv2WorkerStats, name)
+JSON_MAP_REFERENCE(Lv2WorkerStats, instanceId)
+JSON_MAP_REFERENCE(Lv2WorkerStats, requests)
+JSON_MAP_REFERENCE(Lv2WorkerStats, queueDepth)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxQueueDepth)
+JSON_MAP_REFERENCE(Lv2WorkerStats, averageLatencyMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxLatencyMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, averageWorkMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxWorkMs)
+JSON_MAP_END()
@@ -43,42 +43,88 @@
 #include "inverting_mutex.hpp"
 
 
+#include "json.hpp"
+#include <set>
+#include <vector>
+
+
 namespace pipedal {
 
     class Worker;
 
-    class HostWorkerThread {
+    // Work statistics for one plugin instance.
+    class Lv2WorkerStats {
+    public:
+        std::string name_;
+        int64_t instanceId_ = -1;
+        uint64_t requests_ = 0;      // requests completed.
+        uint64_t queueDepth_ = 0;    // requests waiting or running.
+        uint64_t maxQueueDepth_ = 0;
+        double averageLatencyMs_ = 0; // time from ScheduleWork to the start of work.
+        double maxLatencyMs_ = 0;
+        double averageWorkMs_ = 0;
+        double maxWorkMs_ = 0;
+
+        DECLARE_JSON_MAP(Lv2WorkerStats);
+    };
+
+    /**
+     * @brief Runs LV2 worker requests for all plugin instances, on a shared pool of threads.
+     *
+     * Each Worker has its own request queue. A Worker's requests run one at a time, in the order
+     * in which they were scheduled, as LV2 requires; requests from different Workers run concurrently.
+     * Workers with pending requests take turns, one request at a time, so that a long-running request
+     * (e.g. loading a model file) only delays the plugin that scheduled it.
+     */
+    class HostWorkerPool {
     public:
-        HostWorkerThread();
-        ~HostWorkerThread();
+        static constexpr size_t DEFAULT_THREAD_COUNT = 2;
+        static constexpr int DEFAULT_REALTIME_PRIORITY = 5;
+
+        // realtimePriority: SCHED_RR priority of the worker threads; -1 to use normal scheduling.
+        HostWorkerPool(size_t threadCount = DEFAULT_THREAD_COUNT, int realtimePriority = DEFAULT_REALTIME_PRIORITY);
+        ~HostWorkerPool();
 
-        bool StartThread();
         void Close();
-        bool Closed() const { return closed || pThread == nullptr; }
-        LV2_Worker_Status ScheduleWork(Worker*worker, size_t size, const void*data);
+        size_t GetThreadCount() const { return threads.size(); }
+
+        std::vector<Lv2WorkerStats> GetStats();
     private:
-        LV2_Worker_Status ScheduleWorkNoLock(Worker*worker, size_t size, const void*data);
-        std::atomic<bool> closed = false;
-        std::unique_ptr<std::thread> pThread;
-        void ThreadProc() noexcept;
+        friend class Worker;
 
-        RingBuffer<false,true> requestRingBuffer;
-        bool exiting = false;
-        inverting_mutex submitMutex;
+        void Register(Worker *worker);
+        // Waits for a running request to complete. Requests that haven't started yet are discarded.
+        void Unregister(Worker *worker);
+        // Queue the worker for service, if it isn't already queued. Callable from the realtime thread.
+        void Schedule(Worker *worker);
 
-        std::vector<uint8_t> dataBuffer;
+        void ThreadProc(size_t threadIndex) noexcept;
+        void RunWorker(Worker *worker, std::vector<uint8_t> &dataBuffer);
 
+        int realtimePriority;
+        std::vector<std::thread> threads;
+        std::atomic<bool> closed = false;
+
+        RingBuffer<true,true> readyRingBuffer; // Workers waiting for service.
+        std::mutex readMutex;
+
+        std::mutex mutex;
+        std::condition_variable cvIdle;
+        std::set<Worker*> workers;
     };
 
 	class Worker {
 
 	private:
-        std::shared_ptr<HostWorkerThread> pHostWorker = nullptr;
+        friend class HostWorkerPool;
+
+        std::shared_ptr<HostWorkerPool> pHostWorker = nullptr;
         LilvInstance*lilvInstance;
         const LV2_Worker_Interface*workerInterface;
 
         std::atomic<bool> closed = false;
         std::atomic<bool> exiting = false;
+        RingBuffer<true,false> requestRingBuffer; // written by any realtime thread that runs the plugin.
         RingBuffer<true,false> responseRingBuffer;
 
         std::vector<uint8_t> responseBuffer;
@@ -92,9 +138,21 @@ namespace pipedal {
         std::condition_variable cvOutstandingRequests;
         int64_t outstandingRequests = 0;
         int64_t outstandingResponses = 0;
+        int64_t maxOutstandingRequests = 0;
         void WaitForAllResponses();
+
+        // Protected by HostWorkerPool::mutex.
+        bool running = false;
+        Lv2WorkerStats stats;
+        double totalLatencyMs = 0;
+        double totalWorkMs = 0;
+
+        std::atomic<bool> scheduled = false; // queued in the HostWorkerPool.
+
+        // Pool threads only.
+        bool RunNextRequest(std::vector<uint8_t> &dataBuffer);
 	public:
-		Worker(const std::shared_ptr<HostWorkerThread>& pHostWorker,LilvInstance *instance, const LV2_Worker_Interface *iface);
+		Worker(const std::shared_ptr<HostWorkerPool>& pHostWorker,LilvInstance *instance, const LV2_Worker_Interface *iface, const std::string &name = "", int64_t instanceId = -1);
         ~Worker();
         
         void Close();
@@ -109,4 +167,4 @@ namespace pipedal {
 
 
 	};
-}
\ No newline at end of file
+}
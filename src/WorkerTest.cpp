@@ -0,0 +1,175 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Worker.hpp"
+#include <lilv/lilv.h>
+#include <lv2/worker/worker.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    // Stands in for a plugin that implements the LV2 worker extension.
+    class TestPlugin
+    {
+    public:
+        TestPlugin(const std::shared_ptr<HostWorkerPool> &pool, const std::string &name, std::chrono::milliseconds workTime = std::chrono::milliseconds(0))
+            : name(name), workTime(workTime)
+        {
+            instance.lv2_descriptor = nullptr;
+            instance.lv2_handle = (LV2_Handle)this;
+            instance.pimpl = nullptr;
+            workerInterface.work = &TestPlugin::Work;
+            workerInterface.work_response = &TestPlugin::WorkResponse;
+            workerInterface.end_run = nullptr;
+            worker = std::make_unique<Worker>(pool, &instance, &workerInterface, name);
+        }
+
+        void Schedule(uint32_t value)
+        {
+            REQUIRE(worker->ScheduleWork(sizeof(value), &value) == LV2_WORKER_SUCCESS);
+        }
+        // Pump responses, as the realtime thread would.
+        void WaitForResponses(size_t count)
+        {
+            auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (responses.size() < count && std::chrono::steady_clock::now() < timeout)
+            {
+                worker->EmitResponses();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        std::unique_ptr<Worker> worker;
+        std::vector<uint32_t> responses;
+        std::atomic<int> running = 0;
+        std::atomic<bool> overlapped = false;
+
+        static std::mutex completionMutex;
+        static std::vector<std::string> completions; // names of plugins, in order of request completion.
+
+    private:
+        std::string name;
+        std::chrono::milliseconds workTime;
+        LilvInstance instance;
+        LV2_Worker_Interface workerInterface;
+
+        static LV2_Worker_Status Work(LV2_Handle handle, LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle respondHandle, uint32_t size, const void *data)
+        {
+            TestPlugin *this_ = (TestPlugin *)handle;
+            if (++this_->running != 1)
+            {
+                this_->overlapped = true;
+            }
+            std::this_thread::sleep_for(this_->workTime);
+            {
+                std::lock_guard lock{completionMutex};
+                completions.push_back(this_->name);
+            }
+            --this_->running;
+            return respond(respondHandle, size, data);
+        }
+        static LV2_Worker_Status WorkResponse(LV2_Handle handle, uint32_t size, const void *data)
+        {
+            TestPlugin *this_ = (TestPlugin *)handle;
+            this_->responses.push_back(*(const uint32_t *)data);
+            return LV2_WORKER_SUCCESS;
+        }
+    };
+    std::mutex TestPlugin::completionMutex;
+    std::vector<std::string> TestPlugin::completions;
+}
+
+TEST_CASE("LV2 worker pool preserves request order", "[lv2_worker_pool][Build]")
+{
+    auto pool = std::make_shared<HostWorkerPool>(4, -1);
+    std::vector<std::unique_ptr<TestPlugin>> plugins;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        plugins.push_back(std::make_unique<TestPlugin>(pool, SS("plugin" << i)));
+    }
+    const uint32_t REQUESTS = 500;
+    for (uint32_t i = 0; i < REQUESTS; ++i)
+    {
+        for (auto &plugin : plugins)
+        {
+            plugin->Schedule(i);
+        }
+    }
+    for (auto &plugin : plugins)
+    {
+        plugin->WaitForResponses(REQUESTS);
+        REQUIRE(plugin->responses.size() == REQUESTS);
+        for (uint32_t i = 0; i < REQUESTS; ++i)
+        {
+            REQUIRE(plugin->responses[i] == i);
+        }
+        // a plugin's requests never run concurrently.
+        REQUIRE(!plugin->overlapped);
+    }
+
+    std::vector<Lv2WorkerStats> stats = pool->GetStats();
+    REQUIRE(stats.size() == 4);
+    for (auto &stat : stats)
+    {
+        REQUIRE(stat.requests_ == REQUESTS);
+        REQUIRE(stat.queueDepth_ == 0);
+        REQUIRE(stat.maxQueueDepth_ >= 1);
+        REQUIRE(stat.maxQueueDepth_ <= REQUESTS);
+    }
+    plugins.clear();
+    REQUIRE(pool->GetStats().size() == 0);
+}
+
+TEST_CASE("LV2 worker pool shares threads fairly", "[lv2_worker_pool][Build]")
+{
+    // One thread, so that a slow plugin would block every other plugin without round-robin scheduling.
+    auto pool = std::make_shared<HostWorkerPool>(1, -1);
+    TestPlugin slow(pool, "slow", std::chrono::milliseconds(20));
+    TestPlugin fast(pool, "fast");
+    {
+        std::lock_guard lock{TestPlugin::completionMutex};
+        TestPlugin::completions.clear();
+    }
+
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        slow.Schedule(i);
+    }
+    fast.Schedule(0);
+
+    slow.WaitForResponses(5);
+    fast.WaitForResponses(1);
+    REQUIRE(slow.responses.size() == 5);
+    REQUIRE(fast.responses.size() == 1);
+
+    std::lock_guard lock{TestPlugin::completionMutex};
+    REQUIRE(TestPlugin::completions.size() == 6);
+    // at most one slow request (the one already running) completes before the fast request.
+    auto position = std::find(TestPlugin::completions.begin(), TestPlugin::completions.end(), "fast") - TestPlugin::completions.begin();
+    REQUIRE(position <= 1);
+}
@@ -22,6 +22,10 @@
 #include <sstream>
 #include <cstdint>
 #include <string>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
 
 #include "json.hpp"
 #include "json_variant.hpp"
@@ -333,3 +337,285 @@ TEST_CASE("json variants", "[json_variants][Build][Dev]")
     REQUIRE(json_object::allocation_count() == 0);
     REQUIRE(json_array::allocation_count() == 0);
 }
+
+static json_variant ReadFromStream(const std::string &json)
+{
+    std::stringstream s(json);
+    json_reader reader(s);
+    json_variant result;
+    reader.read(&result);
+    REQUIRE(reader.is_complete());
+    return result;
+}
+
+static json_variant ReadFromBuffer(const std::string &json)
+{
+    json_reader reader{std::string_view(json)};
+    json_variant result;
+    reader.read(&result);
+    REQUIRE(reader.is_complete());
+    return result;
+}
+
+TEST_CASE("json buffer reader", "[json_buffer_reader][Build][Dev]")
+{
+    const char *documents[] = {
+        "0",
+        "  -1.5e3  ",
+        "\"\"",
+        "\"abc\\\"def\\\\ghi\\/\\r\\n\\t\\b\\f\"",
+        "\"\\u00e9\\u4e2d\\uD83D\\uDE00 and some plain text that is longer than sixteen bytes\"",
+        "[1, 2,3 ,\t\r\n 4]",
+        "{ \"a\": null, \"b\": true, \"c\": false, \"d\": [ {}, [], \"x\" ] }",
+        "// line comment\n{ /* block /* nested */ comment */ \"a\": 1 }",
+        "{\n                                        \"indented\": [\n                                            1.25,\n                                            -7\n                                        ]\n}",
+    };
+    for (const char *document : documents)
+    {
+        INFO(document);
+        json_variant fromStream = ReadFromStream(document);
+        json_variant fromBuffer = ReadFromBuffer(document);
+        REQUIRE(fromStream == fromBuffer);
+    }
+
+    {
+        JsonTestTarget source;
+        source.ints_ = {1, 7, 4};
+        source.string_ = "a \"quoted\" string that is long enough to need more than one block\n";
+        source.double_ = 99483.1837;
+        std::stringstream os;
+        json_writer writer(os);
+        writer.write(source);
+        std::string json = os.str();
+
+        json_reader reader{std::string_view(json)};
+        JsonTestTarget dest;
+        reader.read(&dest);
+        REQUIRE(reader.is_complete());
+        REQUIRE(source == dest);
+    }
+    {
+        std::string truncated = "{ \"a\": \"abc";
+        json_reader reader{std::string_view(truncated)};
+        json_variant result;
+        REQUIRE_THROWS(reader.read(&result));
+    }
+}
+
+template <typename T>
+static T ReadNumber(const std::string &json, bool fromStream)
+{
+    T value{};
+    if (fromStream)
+    {
+        std::stringstream s(json);
+        json_reader reader(s);
+        reader.read(&value);
+    }
+    else
+    {
+        json_reader reader{std::string_view(json)};
+        reader.read(&value);
+    }
+    return value;
+}
+
+template <typename T>
+static void TestNumber(const std::string &json, T expected)
+{
+    INFO(json);
+    REQUIRE(ReadNumber<T>(json, true) == expected);
+    REQUIRE(ReadNumber<T>(json, false) == expected);
+}
+
+template <typename T>
+static void TestInvalidNumber(const std::string &json)
+{
+    INFO(json);
+    REQUIRE_THROWS(ReadNumber<T>(json, true));
+    REQUIRE_THROWS(ReadNumber<T>(json, false));
+}
+
+template <typename T>
+static void TestNumberRoundTrip(T value)
+{
+    std::stringstream s;
+    json_writer writer(s);
+    writer.write(value);
+    TestNumber<T>(s.str(), value);
+}
+
+TEST_CASE("json number reading", "[json_buffer_reader][Build][Dev]")
+{
+    TestNumber<uint8_t>("7", 7);
+    TestNumber<uint8_t>("255", 255);
+    TestNumber<int8_t>("-128", -128);
+    TestNumber<int>(" +12", 12);
+    TestNumber<int>("-12", -12);
+    TestNumber<unsigned int>("-1", std::numeric_limits<unsigned int>::max());
+    TestNumber<uint64_t>("18446744073709551615", std::numeric_limits<uint64_t>::max());
+    TestNumber<int64_t>("-9223372036854775808", std::numeric_limits<int64_t>::min());
+    TestNumber<double>("+1.5", 1.5);
+    TestNumber<double>("-.25", -0.25);
+    TestNumber<float>("3.25e2", 325.0f);
+
+    TestInvalidNumber<uint8_t>("256");
+    TestInvalidNumber<int8_t>("128");
+    TestInvalidNumber<int>("x");
+    TestInvalidNumber<int>("+-1");
+    TestInvalidNumber<int64_t>("9223372036854775808");
+    TestInvalidNumber<double>("+-1");
+    TestInvalidNumber<double>("inf");
+
+    TestNumberRoundTrip<uint8_t>(200);
+    TestNumberRoundTrip<int8_t>(-100);
+    TestNumberRoundTrip<short>(-32768);
+    TestNumberRoundTrip<unsigned long long>(std::numeric_limits<unsigned long long>::max());
+    TestNumberRoundTrip<long long>(std::numeric_limits<long long>::min());
+    TestNumberRoundTrip<float>(1.0f / 3);
+    TestNumberRoundTrip<double>(-1e-300);
+}
+
+TEST_CASE("json member hash", "[json_buffer_reader][Build][Dev]")
+{
+    for (size_t count : {1, 2, 7, 40})
+    {
+        std::vector<std::string> strings;
+        std::vector<const char *> names;
+        for (size_t i = 0; i < count; ++i)
+        {
+            strings.push_back("member" + std::to_string(i));
+        }
+        for (const auto &s : strings)
+        {
+            names.push_back(s.c_str());
+        }
+        json_member_hash hash;
+        hash.build(names);
+        REQUIRE(hash.valid());
+        for (size_t i = 0; i < count; ++i)
+        {
+            REQUIRE(hash.find(names[i]) == (int)i);
+        }
+        int index = hash.find("notAMember");
+        REQUIRE((index == -1 || strcmp(names[index], "notAMember") != 0));
+    }
+}
+
+// Not run by default. Compares stream and buffer parsing of bank-like documents and websocket messages.
+// Set PIPEDAL_BENCHMARK_BANK to the path of a real bank file to include it.
+TEST_CASE("json reader benchmark", "[json_benchmark]")
+{
+    using clock_t = std::chrono::steady_clock;
+
+    std::vector<std::pair<std::string, std::string>> documents;
+    {
+        std::stringstream s;
+        json_writer writer(s, false);
+        json_variant bank = json_variant::make_array();
+        for (int preset = 0; preset < 50; ++preset)
+        {
+            json_variant plugin = json_variant::make_object();
+            plugin["uri"] = std::string("http://two-play.com/plugins/toob-amp");
+            plugin["instanceId"] = (double)preset;
+            json_variant controls = json_variant::make_array();
+            for (int i = 0; i < 20; ++i)
+            {
+                json_variant control = json_variant::make_object();
+                control["key"] = "control" + std::to_string(i);
+                control["value"] = i * 0.125;
+                controls.as_array()->push_back(std::move(control));
+            }
+            plugin["controlValues"] = std::move(controls);
+            bank.as_array()->push_back(std::move(plugin));
+        }
+        writer.write(bank);
+        documents.push_back({"synthetic bank", s.str()});
+    }
+    documents.push_back({"socket message",
+                         "{\"message\":\"setControl\",\"replyTo\":-1,\"body\":{\"clientId\":3,\"instanceId\":12,\"symbol\":\"gain\",\"value\":0.5}}"});
+    if (const char *bankFile = std::getenv("PIPEDAL_BENCHMARK_BANK"))
+    {
+        std::ifstream f(bankFile);
+        std::stringstream s;
+        s << f.rdbuf();
+        documents.push_back({bankFile, s.str()});
+    }
+
+    std::cout << "json reader, us/document" << std::endl;
+    std::cout << std::setw(40) << "document" << std::setw(12) << "stream" << std::setw(12) << "buffer" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto &[name, json] : documents)
+    {
+        size_t iterations = std::max((size_t)10, (size_t)20000000 / (json.size() + 1));
+
+        auto start = clock_t::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            std::stringstream s(json);
+            json_reader reader(s);
+            json_variant result;
+            reader.read(&result);
+        }
+        double streamUs = std::chrono::duration<double, std::micro>(clock_t::now() - start).count() / iterations;
+
+        start = clock_t::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            json_reader reader{std::string_view(json)};
+            json_variant result;
+            reader.read(&result);
+        }
+        double bufferUs = std::chrono::duration<double, std::micro>(clock_t::now() - start).count() / iterations;
+
+        std::cout << std::setw(40) << name << std::setw(12) << streamUs << std::setw(12) << bufferUs << std::endl;
+    }
+}
+
+TEST_CASE("json output buffer", "[json_output_buffer][Build][Dev]")
+{
+    JsonTestTarget source;
+    source.string_ = std::string(5000, 'x');
+    source.double_ = 0.1;
+    source.float_ = 1.0f / 3;
+
+    std::stringstream expected;
+    json_writer(expected, false).write(source);
+
+    json_output_buffer buffer;
+    for (int i = 0; i < 3; ++i)
+    {
+        buffer.clear();
+        json_writer writer(buffer, false);
+        writer.write(source);
+        REQUIRE(buffer.view() == expected.str());
+    }
+
+    // numbers round-trip through the shortest representation.
+    {
+        buffer.clear();
+        json_writer writer(buffer);
+        writer.write(source);
+        std::string json{buffer.view()};
+        JsonTestTarget dest;
+        json_reader reader{std::string_view(json)};
+        reader.read(&dest);
+        REQUIRE(source == dest);
+    }
+
+    {
+        json_buffer_lease outer;
+        outer.buffer() << "outer";
+        {
+            json_buffer_lease inner;
+            REQUIRE(&inner.buffer() != &outer.buffer());
+            inner.buffer() << "inner";
+            REQUIRE(inner.buffer().view() == "inner");
+        }
+        REQUIRE(outer.buffer().view() == "outer");
+    }
+    {
+        json_buffer_lease lease;
+        REQUIRE(lease.buffer().size() == 0);
+    }
+}
@@ -8,6 +8,14 @@
 #include <chrono>
 #include "ss.hpp"
 #include "PresetBundle.hpp"
+#include "PedalboardBenchmark.hpp"
+#include "IndexedSnapshot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <unistd.h>
 
 // apt install google-perftools
 #include <gperftools/profiler.h>
@@ -104,20 +112,28 @@ struct ProfileOptions
     bool noProfile = false;
     bool waitForWork = false;
     size_t frameSize = 64;
+
+    // benchmark suite options.
+    std::string suiteDirectory;
+    std::vector<uint32_t> bufferSizes;
+    std::vector<double> sampleRates;
+    float warmupSeconds = 2;
+    size_t midiEventsPerPeriod = 0;
+    std::string jsonFilename;
+    std::string csvFilename;
+    std::string baselineFilename;
+    double tolerancePercent = 5;
+    double noiseFloorUs = 2;
+
+    bool IsBenchmark() const
+    {
+        return !suiteDirectory.empty() || !bufferSizes.empty() || !sampleRates.empty() || !jsonFilename.empty() || !csvFilename.empty() || !baselineFilename.empty();
+    }
 };
 
-void profilePlugin(const ProfileOptions &profileOptions)
+static void InitModel(PiPedalModel &model, size_t maxBufferSize)
 {
-
-#ifdef PIPEDAL_AARCH64
-    CacheMissCounter cacheMissCounter;
-#endif
-
-    size_t nFrames = profileOptions.frameSize;
-    Lv2Log::log_level(LogLevel::Info);
-
     /*** Initialize the model */
-    PiPedalModel model;
     Lv2Log::log_level(LogLevel::Error);
     fs::path doc_root = "/etc/pipedal/config";
     PiPedalConfiguration configuration;
@@ -134,17 +150,17 @@ void profilePlugin(const ProfileOptions &profileOptions)
 
     model.EnableUpdater(false);
     model.Init(configuration);
-    model.GetPluginHost().asIHost()->SetMaxAudioBufferSize(64);
+    model.GetPluginHost().asIHost()->SetMaxAudioBufferSize(maxBufferSize);
 
     model.LoadLv2PluginInfo();
 
     // model.Load(); don't start audio.
+}
 
-    /* *** Load the preset.  */
-
-    bool presetValid = false;
-
-    if (profileOptions.presetName.length() != 0)
+// Load a preset by name, or from a preset file, into the model's current pedalboard.
+static void LoadPreset(PiPedalModel &model, const std::string &presetName, const std::string &presetFileName)
+{
+    if (presetName.length() != 0)
     {
 
         PresetIndex presetIndex;
@@ -154,7 +170,7 @@ void profilePlugin(const ProfileOptions &profileOptions)
         bool presetIndexFound = false;
         for (const auto &preset : presetIndex.presets())
         {
-            if (preset.name() == profileOptions.presetName)
+            if (preset.name() == presetName)
             {
                 presetIndexId = preset.instanceId();
                 presetIndexFound = true;
@@ -167,9 +183,9 @@ void profilePlugin(const ProfileOptions &profileOptions)
         }
         model.LoadPreset(-1, presetIndexId);
     }
-    else if (profileOptions.presetFileName.length() != 0)
+    else if (presetFileName.length() != 0)
     {
-        std::filesystem::path filePath = profileOptions.presetFileName;
+        std::filesystem::path filePath = presetFileName;
 
         if (IsZipFile(filePath))
         {
@@ -192,10 +208,10 @@ void profilePlugin(const ProfileOptions &profileOptions)
         else
         {
 
-            std::ifstream f(profileOptions.presetFileName);
+            std::ifstream f(presetFileName);
             if (!f.is_open())
             {
-                throw std::runtime_error(SS("Unable to load preset file " << profileOptions.presetFileName << "."));
+                throw std::runtime_error(SS("Unable to load preset file " << presetFileName << "."));
             }
             try
             {
@@ -211,7 +227,7 @@ void profilePlugin(const ProfileOptions &profileOptions)
             }
             catch (const std::exception &e)
             {
-                throw std::runtime_error(SS("Invalid file format:  " << profileOptions.presetFileName << ". " << e.what()));
+                throw std::runtime_error(SS("Invalid file format:  " << presetFileName << ". " << e.what()));
             }
         }
     }
@@ -219,6 +235,22 @@ void profilePlugin(const ProfileOptions &profileOptions)
     {
         throw std::runtime_error("You must specify either a preset name or a preset file.");
     }
+}
+
+void profilePlugin(const ProfileOptions &profileOptions)
+{
+
+#ifdef PIPEDAL_AARCH64
+    CacheMissCounter cacheMissCounter;
+#endif
+
+    size_t nFrames = profileOptions.frameSize;
+    Lv2Log::log_level(LogLevel::Info);
+
+    PiPedalModel model;
+    InitModel(model, 64);
+
+    LoadPreset(model, profileOptions.presetName, profileOptions.presetFileName);
 
     auto pedalboard = model.GetCurrentPedalboardCopy();
     cout << "uri: " << pedalboard.items()[0].uri() << endl;
@@ -306,6 +338,427 @@ void profilePlugin(const ProfileOptions &profileOptions)
     lv2Pedalboard->Deactivate();
 }
 
+/* *** Benchmark suite */
+
+static std::vector<std::string> SplitList(const std::string &value)
+{
+    std::vector<std::string> result;
+    std::stringstream s(value);
+    std::string item;
+    while (std::getline(s, item, ','))
+    {
+        if (!item.empty())
+        {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+// A repeatable guitar-like test signal: decaying plucked tones with a little noise, in [-0.5,0.5].
+static std::vector<float> MakeBenchmarkSignal(double sampleRate, size_t length)
+{
+    std::vector<float> result(length);
+    std::minstd_rand random(1234);
+    std::uniform_real_distribution<float> noise(-0.001f, 0.001f);
+
+    const double frequencies[] = {82.41, 110.0, 146.83, 196.0, 246.94, 329.63};
+    size_t pluckLength = (size_t)(sampleRate / 2);
+    for (size_t i = 0; i < length; ++i)
+    {
+        size_t pluck = i / pluckLength;
+        double t = (i % pluckLength) / sampleRate;
+        double f = frequencies[pluck % std::size(frequencies)];
+        double value = 0.5 * std::exp(-4 * t) * std::sin(2 * M_PI * f * t);
+        result[i] = (float)value + noise(random);
+    }
+    return result;
+}
+
+// MIDI control change numbers bound to controls of the pedalboard.
+static std::vector<uint8_t> GetBoundControllers(Pedalboard &pedalboard)
+{
+    std::vector<uint8_t> result;
+    for (PedalboardItem *item : pedalboard.GetAllPlugins())
+    {
+        for (const MidiBinding &binding : item->midiBindings())
+        {
+            if (binding.bindingType() == BINDING_TYPE_CONTROL)
+            {
+                result.push_back((uint8_t)binding.control());
+            }
+        }
+    }
+    return result;
+}
+
+static void OnBenchmarkMidiValue(void *data, uint64_t instanceId, int controlIndex, float value)
+{
+}
+
+static BenchmarkResult RunBenchmark(
+    PiPedalModel &model,
+    const ProfileOptions &profileOptions,
+    const std::string &presetName,
+    double sampleRate,
+    uint32_t bufferSize)
+{
+    using clock_t = std::chrono::steady_clock;
+
+    BenchmarkResult result;
+    result.preset_ = presetName;
+    result.sampleRate_ = sampleRate;
+    result.bufferSize_ = bufferSize;
+
+    model.GetPluginHost().setSampleRate(sampleRate);
+    model.GetPluginHost().asIHost()->SetMaxAudioBufferSize(bufferSize);
+
+    std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+    try
+    {
+        lv2Pedalboard = model.GetLv2Pedalboard();
+    }
+    catch (const std::exception &e)
+    {
+        result.error_ = e.what();
+        return result;
+    }
+    Pedalboard pedalboard = model.GetCurrentPedalboardCopy();
+    std::vector<uint8_t> controllers = GetBoundControllers(pedalboard);
+
+    lv2Pedalboard->EnableEffectCostMeasurement();
+    lv2Pedalboard->Activate();
+    auto effectCounters = lv2Pedalboard->GetEffectCostCounters();
+
+    // Loop a few seconds of test signal.
+    std::vector<float> signal = MakeBenchmarkSignal(sampleRate, (size_t)(sampleRate * 3));
+    size_t signalPeriods = signal.size() / bufferSize;
+
+    std::vector<float> outputBufferVectorL(bufferSize);
+    std::vector<float> outputBufferVectorR(bufferSize);
+    float *inputBuffers[3]{nullptr, nullptr, nullptr};
+    float *outputBuffers[3] = {outputBufferVectorL.data(), outputBufferVectorR.data(), nullptr};
+
+    WriterRingbuffer writerRingbuffer;
+    RealtimeRingBufferWriter ringBufferWriter(&writerRingbuffer);
+    RingBufferSink ringBufferSink(writerRingbuffer);
+
+    size_t period = 0;
+    size_t midiEvent = 0;
+    uint8_t midiData[3];
+    auto runPeriod = [&]()
+    {
+        float *input = signal.data() + (period % signalPeriods) * bufferSize;
+        inputBuffers[0] = input;
+        inputBuffers[1] = input;
+        ++period;
+
+        lv2Pedalboard->ResetAtomBuffers();
+        if (!controllers.empty())
+        {
+            for (size_t i = 0; i < profileOptions.midiEventsPerPeriod; ++i)
+            {
+                midiData[0] = 0xB0;
+                midiData[1] = controllers[midiEvent % controllers.size()];
+                midiData[2] = (uint8_t)((midiEvent * 7) & 0x7F);
+                ++midiEvent;
+
+                MidiEvent event;
+                event.frame = (uint32_t)(i * bufferSize / profileOptions.midiEventsPerPeriod);
+                event.size = 3;
+                event.buffer = midiData;
+                lv2Pedalboard->OnMidiMessage(event, nullptr, OnBenchmarkMidiValue);
+            }
+        }
+        lv2Pedalboard->Run(inputBuffers, outputBuffers, bufferSize, &ringBufferWriter);
+    };
+
+    // Warm up: lets plugins finish loading models on the scheduler thread, and fills caches.
+    size_t warmupPeriods = (size_t)(sampleRate * profileOptions.warmupSeconds / bufferSize);
+    for (size_t i = 0; i < warmupPeriods; ++i)
+    {
+        runPeriod();
+        if (profileOptions.waitForWork && (i % 64) == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    size_t periods = std::max((size_t)1, (size_t)(sampleRate * profileOptions.benchmark_seconds / bufferSize));
+    PeriodTimeRecorder total;
+    total.Reserve(periods);
+    std::vector<PeriodTimeRecorder> effectTimes(effectCounters.size());
+    std::vector<uint64_t> lastEffectNs(effectCounters.size());
+    for (size_t i = 0; i < effectCounters.size(); ++i)
+    {
+        effectTimes[i].Reserve(periods);
+        lastEffectNs[i] = effectCounters[i].pTotalNs->load(std::memory_order_relaxed);
+    }
+
+    for (size_t p = 0; p < periods; ++p)
+    {
+        auto start = clock_t::now();
+        runPeriod();
+        auto elapsed = clock_t::now() - start;
+        total.Add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+        for (size_t i = 0; i < effectCounters.size(); ++i)
+        {
+            uint64_t ns = effectCounters[i].pTotalNs->load(std::memory_order_relaxed);
+            effectTimes[i].Add(ns - lastEffectNs[i]);
+            lastEffectNs[i] = ns;
+        }
+    }
+
+    // Snapshot switches, as MIDI snapshot requests apply them: precompiled in the background,
+    // then applied on the audio thread at the start of a period.
+    std::vector<std::shared_ptr<Snapshot>> &snapshots = pedalboard.snapshots();
+    PeriodTimeRecorder snapshotCompile;
+    std::vector<std::shared_ptr<IndexedSnapshot>> indexedSnapshots;
+    for (auto &snapshot : snapshots)
+    {
+        if (snapshot)
+        {
+            auto start = clock_t::now();
+            indexedSnapshots.push_back(std::make_shared<IndexedSnapshot>(
+                snapshot.get(), lv2Pedalboard.get(), model.GetPluginHost(), false));
+            snapshotCompile.Add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - start).count());
+        }
+    }
+    if (!indexedSnapshots.empty())
+    {
+        constexpr size_t SNAPSHOT_SWITCHES = 200;
+        constexpr size_t PERIODS_PER_SWITCH = 8;
+        PeriodTimeRecorder snapshotSwitch;
+        snapshotSwitch.Reserve(SNAPSHOT_SWITCHES);
+        for (size_t i = 0; i < SNAPSHOT_SWITCHES; ++i)
+        {
+            auto start = clock_t::now();
+            indexedSnapshots[i % indexedSnapshots.size()]->Apply(lv2Pedalboard->GetEffects());
+            snapshotSwitch.Add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - start).count());
+            for (size_t p = 0; p < PERIODS_PER_SWITCH; ++p)
+            {
+                runPeriod();
+            }
+        }
+        result.snapshots_ = (uint32_t)indexedSnapshots.size();
+        result.snapshotCompile_ = snapshotCompile.Summarize();
+        result.snapshotSwitch_ = snapshotSwitch.Summarize();
+    }
+
+    ringBufferSink.Close();
+    lv2Pedalboard->Deactivate();
+
+    result.periods_ = periods;
+    result.SetTiming(total.Summarize());
+    for (size_t i = 0; i < effectCounters.size(); ++i)
+    {
+        BenchmarkEffectResult effectResult;
+        effectResult.instanceId_ = effectCounters[i].instanceId;
+        effectResult.uri_ = effectCounters[i].uri;
+        effectResult.timing_ = effectTimes[i].Summarize();
+        result.effects_.push_back(std::move(effectResult));
+    }
+    return result;
+}
+
+static void PrintBenchmarkResult(const BenchmarkResult &result)
+{
+    cout << result.preset_ << " @ " << result.sampleRate_ << "Hz/" << result.bufferSize_ << ": ";
+    if (!result.error_.empty())
+    {
+        cout << "Error: " << result.error_ << endl;
+        return;
+    }
+    cout << std::fixed << std::setprecision(1)
+         << "p50 " << result.timing_.p50_ << "us"
+         << " p99 " << result.timing_.p99_ << "us"
+         << " max " << result.timing_.max_ << "us"
+         << " (load p50 " << result.loadP50_ << "%, p99 " << result.loadP99_ << "%)"
+         << std::defaultfloat << endl;
+    if (result.snapshots_ != 0)
+    {
+        cout << "    " << result.snapshots_ << " snapshots: "
+             << std::fixed << std::setprecision(1)
+             << "compile p50 " << result.snapshotCompile_.p50_ << "us"
+             << " switch p50 " << result.snapshotSwitch_.p50_ << "us"
+             << " p99 " << result.snapshotSwitch_.p99_ << "us"
+             << " max " << result.snapshotSwitch_.max_ << "us"
+             << std::defaultfloat << endl;
+    }
+    for (const auto &effect : result.effects_)
+    {
+        cout << "    " << effect.instanceId_ << " " << effect.uri_ << ": "
+             << std::fixed << std::setprecision(1)
+             << "p50 " << effect.timing_.p50_ << "us"
+             << " p99 " << effect.timing_.p99_ << "us"
+             << " max " << effect.timing_.max_ << "us"
+             << std::defaultfloat << endl;
+    }
+}
+
+// Returns the number of regressions against the baseline (or zero if there is no baseline).
+static size_t benchmarkSuite(const ProfileOptions &profileOptions)
+{
+    // Benchmark presets, as (display name, preset name, preset file).
+    struct BenchmarkPreset
+    {
+        std::string name;
+        std::string presetName;
+        std::string presetFileName;
+    };
+    std::vector<BenchmarkPreset> presets;
+    if (!profileOptions.suiteDirectory.empty())
+    {
+        std::vector<fs::path> files;
+        for (const auto &entry : fs::directory_iterator(profileOptions.suiteDirectory))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".json")
+            {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto &file : files)
+        {
+            presets.push_back(BenchmarkPreset{file.stem().string(), "", file.string()});
+        }
+        if (presets.empty())
+        {
+            throw std::runtime_error(SS("No presets found in " << profileOptions.suiteDirectory << "."));
+        }
+    }
+    else if (!profileOptions.presetName.empty())
+    {
+        presets.push_back(BenchmarkPreset{profileOptions.presetName, profileOptions.presetName, ""});
+    }
+    else
+    {
+        fs::path path = profileOptions.presetFileName;
+        presets.push_back(BenchmarkPreset{path.stem().string(), "", profileOptions.presetFileName});
+    }
+
+    std::vector<double> sampleRates = profileOptions.sampleRates;
+    if (sampleRates.empty())
+    {
+        sampleRates.push_back(48000);
+    }
+    std::vector<uint32_t> bufferSizes = profileOptions.bufferSizes;
+    if (bufferSizes.empty())
+    {
+        bufferSizes.push_back((uint32_t)profileOptions.frameSize);
+    }
+    uint32_t maxBufferSize = *std::max_element(bufferSizes.begin(), bufferSizes.end());
+
+    PiPedalModel model;
+    InitModel(model, maxBufferSize);
+    Lv2Log::log_level(LogLevel::Error);
+
+    BenchmarkReport report;
+    {
+        char hostName[256];
+        if (gethostname(hostName, sizeof(hostName)) == 0)
+        {
+            hostName[sizeof(hostName) - 1] = 0;
+            report.host_ = hostName;
+        }
+    }
+
+    for (const auto &preset : presets)
+    {
+        std::string loadError;
+        try
+        {
+            LoadPreset(model, preset.presetName, preset.presetFileName);
+        }
+        catch (const std::exception &e)
+        {
+            loadError = e.what();
+        }
+        for (double sampleRate : sampleRates)
+        {
+            for (uint32_t bufferSize : bufferSizes)
+            {
+                BenchmarkResult result;
+                if (loadError.empty())
+                {
+                    result = RunBenchmark(model, profileOptions, preset.name, sampleRate, bufferSize);
+                }
+                else
+                {
+                    result.preset_ = preset.name;
+                    result.sampleRate_ = sampleRate;
+                    result.bufferSize_ = bufferSize;
+                    result.error_ = loadError;
+                }
+                PrintBenchmarkResult(result);
+                report.results_.push_back(std::move(result));
+            }
+        }
+    }
+
+    if (!profileOptions.jsonFilename.empty())
+    {
+        std::ofstream f(profileOptions.jsonFilename);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't write to " << profileOptions.jsonFilename << "."));
+        }
+        json_writer writer(f, false);
+        writer.write(report);
+    }
+    if (!profileOptions.csvFilename.empty())
+    {
+        std::ofstream f(profileOptions.csvFilename);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't write to " << profileOptions.csvFilename << "."));
+        }
+        WriteBenchmarkCsv(f, report);
+    }
+
+    if (profileOptions.baselineFilename.empty())
+    {
+        return 0;
+    }
+    BenchmarkReport baseline;
+    {
+        std::ifstream f(profileOptions.baselineFilename);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't read " << profileOptions.baselineFilename << "."));
+        }
+        json_reader reader(f);
+        reader.read(&baseline);
+    }
+    if (!baseline.host_.empty() && baseline.host_ != report.host_)
+    {
+        cout << "Warning: the baseline was recorded on " << baseline.host_ << "." << endl;
+    }
+    auto regressions = CompareBenchmarkReports(baseline, report, profileOptions.tolerancePercent, profileOptions.noiseFloorUs);
+    for (const auto &regression : regressions)
+    {
+        cout << "Regression: " << regression.preset << " @ " << regression.sampleRate << "Hz/" << regression.bufferSize << " ";
+        if (regression.instanceId == -1)
+        {
+            cout << "(pedalboard)";
+        }
+        else
+        {
+            cout << regression.instanceId << " " << regression.uri;
+        }
+        cout << " " << regression.metric << ": "
+             << std::fixed << std::setprecision(1)
+             << regression.baseline << "us -> " << regression.current << "us (+"
+             << regression.GetChangePercent() << "%)" << std::defaultfloat << endl;
+    }
+    if (regressions.empty())
+    {
+        cout << "No regressions." << endl;
+    }
+    return regressions.size();
+}
+
 int main(int argc, char **argv)
 {
     try
@@ -321,10 +774,31 @@ int main(int argc, char **argv)
         commandLineParser.AddOption("s", "seconds", &profileOptions.benchmark_seconds);
         commandLineParser.AddOption("h", "help", &help);
 
+        std::string bufferSizes, sampleRates;
+        commandLineParser.AddOption("", "suite", &profileOptions.suiteDirectory);
+        commandLineParser.AddOption("", "buffer-sizes", &bufferSizes);
+        commandLineParser.AddOption("", "sample-rates", &sampleRates);
+        commandLineParser.AddOption("", "warmup", &profileOptions.warmupSeconds);
+        commandLineParser.AddOption("", "midi-events", &profileOptions.midiEventsPerPeriod);
+        commandLineParser.AddOption("", "json", &profileOptions.jsonFilename);
+        commandLineParser.AddOption("", "csv", &profileOptions.csvFilename);
+        commandLineParser.AddOption("", "baseline", &profileOptions.baselineFilename);
+        commandLineParser.AddOption("", "tolerance", &profileOptions.tolerancePercent);
+        commandLineParser.AddOption("", "noise-floor", &profileOptions.noiseFloorUs);
+
         commandLineParser.Parse(argc, (const char **)argv);
 
+        for (const auto &value : SplitList(bufferSizes))
+        {
+            profileOptions.bufferSizes.push_back((uint32_t)std::stoul(value));
+        }
+        for (const auto &value : SplitList(sampleRates))
+        {
+            profileOptions.sampleRates.push_back(std::stod(value));
+        }
+
         bool argumentError = false;
-        if (commandLineParser.Arguments().size() == 1 && presetFileName.length() == 0)
+        if (commandLineParser.Arguments().size() == 0 && presetFileName.length() == 0 && profileOptions.suiteDirectory.length() == 0)
         {
             cerr << "Error: You must supply either a preset name, or a preset file name" << endl;
             argumentError = true;
@@ -357,6 +831,34 @@ int main(int argc, char **argv)
             cout << "          The number of seconds of audio to process." << endl;
             cout << "    -h, --help:  display this message." << endl;
             cout << endl;
+            cout << "Benchmark options:" << endl;
+            cout << "    Any of the following options runs a benchmark instead of a profile," << endl;
+            cout << "    reporting p50/p99/max execution time per period for the pedalboard," << endl;
+            cout << "    and for each of its effects." << endl;
+            cout << endl;
+            cout << "    --suite directory:" << endl;
+            cout << "          Benchmark every preset file (*.json) in the directory." << endl;
+            cout << "          See benchmark_presets/ in the source tree." << endl;
+            cout << "    --buffer-sizes n,n,...:" << endl;
+            cout << "          Buffer sizes to benchmark (default 64)." << endl;
+            cout << "    --sample-rates n,n,...:" << endl;
+            cout << "          Sample rates to benchmark (default 48000)." << endl;
+            cout << "    --warmup time_in_seconds:" << endl;
+            cout << "          Audio to process before measuring (default 2)." << endl;
+            cout << "    --midi-events n:" << endl;
+            cout << "          MIDI CC messages per period, sent to controls with MIDI bindings." << endl;
+            cout << "    --json filename:" << endl;
+            cout << "          Write results to a json file." << endl;
+            cout << "    --csv filename:" << endl;
+            cout << "          Write results to a csv file." << endl;
+            cout << "    --baseline filename:" << endl;
+            cout << "          Compare against results previously written with --json." << endl;
+            cout << "          Exits with a non-zero status if there are regressions." << endl;
+            cout << "    --tolerance percent:" << endl;
+            cout << "          Allowable increase in p50 and p99 times (default 5)." << endl;
+            cout << "    --noise-floor time_in_microseconds:" << endl;
+            cout << "          Ignore increases smaller than this (default 2)." << endl;
+            cout << endl;
             return help ? EXIT_SUCCESS : EXIT_FAILURE;
         }
 
@@ -366,7 +868,17 @@ int main(int argc, char **argv)
         }
         profileOptions.presetFileName = presetFileName;
 
-        profilePlugin(profileOptions);
+        if (profileOptions.IsBenchmark())
+        {
+            if (benchmarkSuite(profileOptions) != 0)
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            profilePlugin(profileOptions);
+        }
     }
     catch (const std::exception &e)
     {
@@ -72,6 +72,9 @@ export default class JackHostStatus {
         this.errorMessage = input.errorMessage;
         this.underruns = input.underruns;
         this.cpuUsage = input.cpuUsage;
+        this.periods = input.periods ?? 0;
+        this.silentPeriods = input.silentPeriods ?? 0;
+        this.lastXrun = input.lastXrun ?? "";
         this.msSinceLastUnderrun = input.msSinceLastUnderrun;
         this.temperaturemC = input.temperaturemC;
         this.cpuFreqMax = input.cpuFreqMax;
@@ -88,6 +91,9 @@ export default class JackHostStatus {
     restarting: boolean = false;
     underruns: number = 0;
     cpuUsage: number = 0;
+    periods: number = 0;
+    silentPeriods: number = 0; // periods in which no plugins ran because of silence.
+    lastXrun: string = ""; // the flight recorder's explanation of the most recent xrun.
     msSinceLastUnderrun: number = -5000 * 1000;
     temperaturemC: number = -1000000;
     cpuFreqMax: number = 0;
@@ -171,12 +177,17 @@ export default class JackHostStatus {
             return (
                 <div style={{ whiteSpace: "nowrap" }}>
                     <Typography variant="caption" color="inherit">{label}</Typography>
-                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}>
+                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}
+                        title={status.lastXrun === "" ? undefined : status.lastXrun}
+                    >
                         <Typography variant="caption" color="inherit">
                             XRuns:&nbsp;{status.underruns + ""}&nbsp;&nbsp;
                         </Typography>
                     </span>
-                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}>
+                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}
+                        title={status.periods === 0 ? undefined :
+                            "Silent periods skipped: " + (status.silentPeriods * 100 / status.periods).toFixed(1) + "%"}
+                    >
                         <Typography variant="caption" color="inherit">
                             CPU:&nbsp;{cpuDisplay(status.cpuUsage)}&nbsp;&nbsp;
                         </Typography>
@@ -225,7 +236,9 @@ export default class JackHostStatus {
             return (
                 <div style={{ whiteSpace: "nowrap" }}>
                     <Typography variant="caption" color="inherit">{label}</Typography>
-                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}>
+                    <span style={{ color: underrunError ? RED_COLOR : GREEN_COLOR }}
+                        title={status.lastXrun === "" ? undefined : status.lastXrun}
+                    >
                         <Typography variant="caption" color="inherit">
                             XRuns:&nbsp;{status.underruns + ""}&nbsp;&nbsp;
                         </Typography>
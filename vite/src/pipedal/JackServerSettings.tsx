@@ -32,6 +32,11 @@ export default class JackServerSettings {
         this.sampleRate = input.sampleRate;
         this.bufferSize = input.bufferSize;
         this.numberOfBuffers = input.numberOfBuffers;
+        this.parallelSplitChains = input.parallelSplitChains ?? false;
+        this.pipelineStages = input.pipelineStages ?? 1;
+        this.alsaMmapAccess = input.alsaMmapAccess ?? false;
+        this.presetTransitionMs = input.presetTransitionMs ?? 0;
+        this.presetTransitionParallel = input.presetTransitionParallel ?? false;
         return this;
     }
     // constructor(alsaDevice: string, sampleRate?: number, bufferSize?: number, numberOfBuffers?: number)
@@ -57,6 +62,11 @@ export default class JackServerSettings {
     sampleRate = 48000;
     bufferSize = 64;
     numberOfBuffers = 3;
+    parallelSplitChains = false;
+    pipelineStages = 1;
+    alsaMmapAccess = false;
+    presetTransitionMs = 0;
+    presetTransitionParallel = false;
 
     /**
      * Configure this instance to use the dummy audio device. This mirrors the
@@ -18,7 +18,8 @@
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 import React from 'react';
-import { PiPedalModel, PiPedalModelFactory,State } from './PiPedalModel';
+import Typography from '@mui/material/Typography';
+import { PiPedalModel, PiPedalModelFactory,State, EffectCpuUpdate } from './PiPedalModel';
 import JackHostStatus from './JackHostStatus';
 
 
@@ -30,6 +31,7 @@ interface JackStatusViewProps {
 
 interface JackStatusViewState {
     jackStatus?: JackHostStatus;
+    effectCpuUse?: EffectCpuUpdate;
 }
 
 
@@ -44,6 +46,11 @@ export default class JackStatusView extends React.Component<JackStatusViewProps,
         };
         this.model = PiPedalModelFactory.getInstance();
         this.tick = this.tick.bind(this);
+        this.onEffectCpuUse = this.onEffectCpuUse.bind(this);
+    }
+
+    onEffectCpuUse(update: EffectCpuUpdate) {
+        this.setState({ effectCpuUse: update });
     }
 
     private waitingForTick: boolean = false;
@@ -67,14 +74,48 @@ export default class JackStatusView extends React.Component<JackStatusViewProps,
     timerHandle?: number;
     componentDidMount() {
         this.timerHandle = setInterval(this.tick, 1000);
+        this.model.addEffectCpuUseHandler(this.onEffectCpuUse);
     }
     componentWillUnmount() {
+        this.model.removeEffectCpuUseHandler(this.onEffectCpuUse);
         if (this.timerHandle) {
             clearTimeout(this.timerHandle);
             this.timerHandle = undefined;
         }
     }
 
+    // The effect that uses the most CPU time.
+    renderEffectCpuUse() {
+        let update = this.state.effectCpuUse;
+        if (!update || update.periodUs === 0 || update.effects.length === 0) {
+            return null;
+        }
+        let busiest = update.effects[0];
+        for (let effect of update.effects) {
+            if (effect.averageUs > busiest.averageUs) {
+                busiest = effect;
+            }
+        }
+        let item = this.model.pedalboard.get().maybeGetItem(busiest.instanceId);
+        if (!item) {
+            return null;
+        }
+        let name = item.title !== "" ? item.title : (item.pluginName ?? "");
+        let percent = busiest.averageUs * 100 / update.periodUs;
+        let suspended = 0;
+        for (let effect of update.effects) {
+            if (effect.suspended) {
+                ++suspended;
+            }
+        }
+        return (
+            <Typography variant="caption" color="inherit" title={"max " + busiest.maxUs.toFixed(0) + "\u00B5s"}>
+                &nbsp;&nbsp;{name}:&nbsp;{percent.toFixed(1)}%
+                {suspended !== 0 && (<span title="Bypassed effects that are no longer running">&nbsp;&nbsp;Suspended:&nbsp;{suspended}</span>)}
+            </Typography>
+        );
+    }
+
     render() {
         return (
             <div style={{
@@ -82,7 +123,10 @@ export default class JackStatusView extends React.Component<JackStatusViewProps,
                 paddingRight: 20, paddingBottom: 6,
                 textAlign: "center", opacity: 0.7, whiteSpace: "nowrap", fontSize: 12, zIndex: 10, fontWeight: 900
             }}>
-                {JackHostStatus.getDisplayView("",this.state.jackStatus) }
+                <div style={{ display: "flex", flexFlow: "row nowrap", justifyContent: "center" }}>
+                    {JackHostStatus.getDisplayView("",this.state.jackStatus) }
+                    {this.renderEffectCpuUse()}
+                </div>
             </div>
         );
 
@@ -267,8 +267,28 @@ export interface VuUpdateInfo {
     inputMaxValueR: number;
     outputMaxValueL: number;
     outputMaxValueR: number;
+    inputRmsValueL: number;
+    inputRmsValueR: number;
+    outputRmsValueL: number;
+    outputRmsValueR: number;
 };
 
+export interface EffectCpuUse {
+    instanceId: number;
+    averageUs: number; // mean execution time per period.
+    maxUs: number; // worst-case execution time of a single period.
+    suspended: boolean; // bypassed, and no longer running.
+    silentPeriods: number; // periods skipped because input and output were silent.
+};
+
+export interface EffectCpuUpdate {
+    periodUs: number;
+    periods: number;
+    effects: EffectCpuUse[];
+};
+
+export type EffectCpuUseHandler = (update: EffectCpuUpdate) => void;
+
 export interface MonitorPortHandle {
 };
 export interface ControlValueChangedHandle {
@@ -635,6 +655,7 @@ export class PiPedalModel //implements PiPedalModel
 
         this.onSocketError = this.onSocketError.bind(this);
         this.onSocketMessage = this.onSocketMessage.bind(this);
+        this.onMonitorStreamFrame = this.onMonitorStreamFrame.bind(this);
         this.onSocketReconnecting = this.onSocketReconnecting.bind(this);
         this.onSocketReconnected = this.onSocketReconnected.bind(this);
         this.onVisibilityChanged = this.onVisibilityChanged.bind(this);
@@ -1021,6 +1042,14 @@ export class PiPedalModel //implements PiPedalModel
             if (header.replyTo) {
                 this.webSocket?.reply(header.replyTo, "onVuUpdate", true);
             }
+        } else if (message === "onEffectCpuUse") {
+            let update = body as EffectCpuUpdate;
+            for (let handler of this.effectCpuUseHandlers) {
+                handler(update);
+            }
+            if (header.replyTo) {
+                this.webSocket?.reply(header.replyTo, "onEffectCpuUse", true);
+            }
         } else if (message === "onSystemMidiBindingsChanged") {
             let bindings = MidiBinding.deserialize_array(body);
             this.systemMidiBindings.set(bindings);
@@ -1283,6 +1312,10 @@ export class PiPedalModel //implements PiPedalModel
 
         // anything could have changed while we were disconnected.
         await this.loadServerState();
+
+        if (this.effectCpuUseHandlers.length !== 0) {
+            this.webSocket?.send("addEffectCpuUseSubscription");
+        }
     }
     private makeSocketServerUrl(hostName: string, port: number): string {
         return "ws://" + hostName + ":" + port + "/pipedal";
@@ -1433,6 +1466,7 @@ export class PiPedalModel //implements PiPedalModel
             this.socketServerUrl,
             {
                 onMessageReceived: this.onSocketMessage,
+                onBinaryMessageReceived: this.onMonitorStreamFrame,
                 onError: this.onSocketError,
                 onConnectionLost: this.onSocketConnectionLost,
                 onReconnect: this.onSocketReconnected,
@@ -1529,6 +1563,8 @@ export class PiPedalModel //implements PiPedalModel
 
             this.systemMidiBindings.set(MidiBinding.deserialize_array(await this.getWebSocket().request<MidiBinding[]>("getSystemMidiBindings")));
 
+            await this.enableMonitorStream();
+
             // load at lest once before we allow a reconnect.
             this.getWebSocket().canReconnect = true;
 
@@ -2641,6 +2677,92 @@ export class PiPedalModel //implements PiPedalModel
 
     vuSubscriptions: (VuSubscriptionTarget | undefined)[] = [];
 
+    // Number of monitor stream frames the server may send before it has to wait for more credits.
+    private static readonly MONITOR_STREAM_CREDITS = 2;
+    private monitorStreamCreditsUsed: number = 0;
+    private monitorStreamCreditRequested: boolean = false;
+
+    // Ask the server to send VU updates and monitored port values as binary frames, instead of
+    // acknowledged JSON messages. If the request fails, the server keeps using JSON messages.
+    private async enableMonitorStream(): Promise<void> {
+        this.monitorStreamCreditsUsed = 0;
+        this.monitorStreamCreditRequested = false;
+        try {
+            await this.getWebSocket().request<boolean>("setMonitorStream",
+                { enabled: true, credits: PiPedalModel.MONITOR_STREAM_CREDITS });
+        } catch (error) {
+            console.log("Monitor stream not available. " + getErrorMessage(error));
+        }
+    }
+
+    // Return credits once per animation frame, so the server batches and coalesces values
+    // while the UI is busy (or hidden), rather than queueing them.
+    private grantMonitorStreamCredits() {
+        if (this.monitorStreamCreditRequested) return;
+        this.monitorStreamCreditRequested = true;
+        requestAnimationFrame(() => {
+            this.monitorStreamCreditRequested = false;
+            let credits = this.monitorStreamCreditsUsed;
+            this.monitorStreamCreditsUsed = 0;
+            if (credits !== 0) {
+                this.webSocket?.send("addMonitorStreamCredits", credits);
+            }
+        });
+    }
+
+    // Binary monitor stream frame (see MonitorStream.hpp for the format).
+    onMonitorStreamFrame(data: ArrayBuffer): void {
+        const VU_UPDATE = 1;
+        const PORT_VALUE = 2;
+
+        let view = new DataView(data);
+        let recordCount = view.getUint16(2, true);
+        let offset = 8;
+        for (let i = 0; i < recordCount; ++i) {
+            let subscriptionHandle = view.getUint32(offset, true);
+            let recordType = view.getUint8(offset + 4);
+            let flags = view.getUint8(offset + 5);
+            let valueCount = view.getUint16(offset + 6, true);
+            let values = offset + 8;
+            offset = values + valueCount * 4;
+
+            if (recordType === VU_UPDATE && valueCount >= 8) {
+                this.vuSubscriptions.forEach((item, instanceId) => {
+                    if (item && item.serverSubscriptionHandle === subscriptionHandle) {
+                        let vuUpdate: VuUpdateInfo = {
+                            instanceId: instanceId,
+                            sampleTime: 0,
+                            isStereoInput: (flags & 1) !== 0,
+                            isStereoOutput: (flags & 2) !== 0,
+                            inputMaxValueL: view.getFloat32(values, true),
+                            inputMaxValueR: view.getFloat32(values + 4, true),
+                            outputMaxValueL: view.getFloat32(values + 8, true),
+                            outputMaxValueR: view.getFloat32(values + 12, true),
+                            inputRmsValueL: view.getFloat32(values + 16, true),
+                            inputRmsValueR: view.getFloat32(values + 20, true),
+                            outputRmsValueL: view.getFloat32(values + 24, true),
+                            outputRmsValueR: view.getFloat32(values + 28, true),
+                        };
+                        for (let j = 0; j < item.subscribers.length; ++j) {
+                            item.subscribers[j].callback(vuUpdate);
+                        }
+                    }
+                });
+            } else if (recordType === PORT_VALUE && valueCount >= 1) {
+                let value = view.getFloat32(values, true);
+                for (let j = 0; j < this.monitorPortSubscriptions.length; ++j) {
+                    let subscription = this.monitorPortSubscriptions[j];
+                    if (subscription.subscriptionHandle === subscriptionHandle) {
+                        subscription.onUpdated(value);
+                        break;
+                    }
+                }
+            }
+        }
+        ++this.monitorStreamCreditsUsed;
+        this.grantMonitorStreamCredits();
+    }
+
 
     addVuSubscription(instanceId: number, vuChangedHandler: VuChangedHandler): VuSubscriptionHandle {
 
@@ -2694,6 +2816,25 @@ export class PiPedalModel //implements PiPedalModel
         }
 
     }
+    private effectCpuUseHandlers: EffectCpuUseHandler[] = [];
+
+    // Per-effect execution times, updated twice a second.
+    addEffectCpuUseHandler(handler: EffectCpuUseHandler): void {
+        this.effectCpuUseHandlers.push(handler);
+        if (this.effectCpuUseHandlers.length === 1) {
+            this.webSocket?.send("addEffectCpuUseSubscription");
+        }
+    }
+    removeEffectCpuUseHandler(handler: EffectCpuUseHandler): void {
+        let index = this.effectCpuUseHandlers.indexOf(handler);
+        if (index !== -1) {
+            this.effectCpuUseHandlers.splice(index, 1);
+            if (this.effectCpuUseHandlers.length === 0) {
+                this.webSocket?.send("removeEffectCpuUseSubscription");
+            }
+        }
+    }
+
     private isClosed = false;
     close() {
         if (!this.isClosed) {
@@ -38,6 +38,7 @@ type ReplyHandler = (header: PiPedalMessageHeader, body: any | null) => void;
 
 export interface PiPedalSocketListener {
     onMessageReceived: (header: PiPedalMessageHeader, body: any | null) => void;
+    onBinaryMessageReceived?: (data: ArrayBuffer) => void;
     onError: (message: string, exception?: Error) => void;
     onConnectionLost: () => void;
     onReconnect: () => void;
@@ -138,7 +139,15 @@ class PiPedalSocket {
             }
         });
     }
-    handleMessage(event: MessageEvent<string>): any {
+    handleMessage(event: MessageEvent<string | ArrayBuffer>): any {
+        if (event.data instanceof ArrayBuffer) {
+            try {
+                this.listener.onBinaryMessageReceived?.(event.data);
+            } catch (error) {
+                this.listener.onError("Invalid server response. " + error, error as Error);
+            }
+            return;
+        }
         try {
             let message: any = JSON.parse(event.data);
             if (!Array.isArray(message)) {
@@ -269,6 +278,7 @@ class PiPedalSocket {
         return new Promise<WebSocket>((resolve, reject) => {
             try {
                 let ws = new WebSocket(this.url);
+                ws.binaryType = "arraybuffer";
 
                 let self = this;
 
@@ -59,6 +59,7 @@ import { Theme } from '@mui/material/styles';
 import { withStyles } from "tss-react/mui";
 import WithStyles from './WithStyles';
 import { canScaleWindow, getWindowScaleOptions, getWindowScaleText, setWindowScale, getWindowScale } from './WindowScale';
+import { getVuMeterMode, getVuMeterModeOptions, getVuMeterModeText, setVuMeterMode, VuMeterMode } from './VuMeterMode';
 import OptionsDialog from './OptionsDialog';
 import { css } from '@emotion/react';
 import ScreenOrientation from './ScreenOrientation';
@@ -92,6 +93,7 @@ interface SettingsDialogState {
     wifiDirectConfigSettings: WifiDirectConfigSettings;
 
     showWindowScaleDialog: boolean;
+    showVuMeterModeDialog: boolean;
     showWifiConfigDialog: boolean;
     showWifiDirectConfigDialog: boolean;
     showGovernorSettingsDialog: boolean;
@@ -206,6 +208,7 @@ const SettingsDialog = withStyles(
                 keepScreenOn: this.model.keepScreenOn.get(),
                 screenOrientation: this.model.getScreenOrientation(),
                 showWindowScaleDialog: false,
+                showVuMeterModeDialog: false,
                 showWifiConfigDialog: false,
                 showWifiDirectConfigDialog: false,
                 showGovernorSettingsDialog: false,
@@ -885,6 +888,19 @@ const SettingsDialog = withStyles(
                                             )
                                         }
 
+                                        <ButtonBase
+                                            className={classes.setting}
+                                            onClick={() => { this.setState({ showVuMeterModeDialog: true }); }}  >
+                                            <SelectHoverBackground selected={false} showHover={true} />
+                                            <div style={{ width: "100%" }}>
+                                                <Typography className={classes.primaryItem} display="block" variant="body2" color="textPrimary" noWrap>
+                                                    VU Meters</Typography>
+                                                <Typography className={classes.secondaryItem} display="block" variant="caption" color="textSecondary" noWrap>
+                                                    {getVuMeterModeText()}
+                                                </Typography>
+                                            </div>
+                                        </ButtonBase>
+
 
                                         <ButtonBase
                                             className={classes.setting}
@@ -1156,6 +1172,16 @@ const SettingsDialog = withStyles(
                         />
 
                     )}
+                    {this.state.showVuMeterModeDialog && (
+                        <OptionsDialog open={this.state.showVuMeterModeDialog} options={getVuMeterModeOptions()} value={getVuMeterMode()}
+                            onClose={(() => this.setState({ showVuMeterModeDialog: false }))}
+                            title="VU Meters"
+                            onOk={(item) => {
+                                setVuMeterMode(item.key as VuMeterMode);
+                                this.setState({ showVuMeterModeDialog: false });
+                            }}
+                        />
+                    )}
                 </DialogEx >
 
             );
@@ -24,6 +24,7 @@ import { withStyles } from "tss-react/mui";
 import { css } from '@emotion/react';
 
 import { PiPedalModel, State,PiPedalModelFactory, VuUpdateInfo, VuSubscriptionHandle } from './PiPedalModel';
+import { getVuMeterMode, VuMeterMode } from './VuMeterMode';
 
 
 const DISPLAY_HEIGHT = 110;
@@ -318,14 +319,15 @@ export const VuMeter =
 
                 let isStereo: boolean;
 
+                let rms = getVuMeterMode() === VuMeterMode.Rms;
                 if (this.props.display === "input") {
-                    value = vuInfo.inputMaxValueL;
-                    valueR = vuInfo.inputMaxValueR;
+                    value = rms ? vuInfo.inputRmsValueL : vuInfo.inputMaxValueL;
+                    valueR = rms ? vuInfo.inputRmsValueR : vuInfo.inputMaxValueR;
                     isStereo = vuInfo.isStereoInput;
                 } else {
                     isStereo = vuInfo.isStereoOutput;
-                    value = vuInfo.outputMaxValueL;
-                    valueR = vuInfo.outputMaxValueR;
+                    value = rms ? vuInfo.outputRmsValueL : vuInfo.outputMaxValueL;
+                    valueR = rms ? vuInfo.outputRmsValueR : vuInfo.outputMaxValueR;
                 }
                 if (this.state.isStereo !== isStereo)
                 {
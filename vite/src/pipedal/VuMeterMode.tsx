@@ -0,0 +1,52 @@
+// Copyright (c) 2026 Robin Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Whether VU meters display peak levels, or RMS levels. Stored per-browser.
+
+export enum VuMeterMode {
+    Peak = "peak",
+    Rms = "rms"
+}
+
+const VU_METER_MODE_KEY = "pipedalVuMeterMode";
+
+let currentVuMeterMode: VuMeterMode | undefined = undefined;
+
+export function getVuMeterMode(): VuMeterMode {
+    if (currentVuMeterMode === undefined) {
+        currentVuMeterMode = localStorage.getItem(VU_METER_MODE_KEY) === VuMeterMode.Rms ? VuMeterMode.Rms : VuMeterMode.Peak;
+    }
+    return currentVuMeterMode;
+}
+
+export function setVuMeterMode(mode: VuMeterMode): void {
+    currentVuMeterMode = mode;
+    localStorage.setItem(VU_METER_MODE_KEY, mode);
+}
+
+export function getVuMeterModeText(mode?: VuMeterMode): string {
+    return (mode ?? getVuMeterMode()) === VuMeterMode.Rms ? "RMS" : "Peak";
+}
+
+export function getVuMeterModeOptions(): { key: string, text: string }[] {
+    return [
+        { key: VuMeterMode.Peak, text: getVuMeterModeText(VuMeterMode.Peak) },
+        { key: VuMeterMode.Rms, text: getVuMeterModeText(VuMeterMode.Rms) }
+    ];
+}